@@ -33,11 +33,23 @@ G_DEFINE_TYPE (CarrickNetworkModel, carrick_network_model, GTK_TYPE_LIST_STORE)
 #define NETWORK_MODEL_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), CARRICK_TYPE_NETWORK_MODEL, CarrickNetworkModelPrivate))
 
+/* How often queued up Strength changes are applied to the model, in ms */
+#define STRENGTH_UPDATE_INTERVAL 2000
+
 struct _CarrickNetworkModelPrivate
 {
   DBusGConnection *connection;
   DBusGProxy      *manager;
   GList           *services;
+
+  /*
+   * Service path -> GtkTreeIter of its row; list store iters stay valid for
+   * as long as the row exists, whatever the sort order does.
+   */
+  GHashTable      *rows;
+
+  GHashTable      *pending_strength; /* service path -> strength */
+  guint            strength_update_id;
 };
 
 /*
@@ -48,6 +60,8 @@ static void network_model_manager_changed_cb (DBusGProxy *service, const gchar *
 static void network_model_manager_get_properties_cb (DBusGProxy *manager, GHashTable *properties, GError *error, gpointer user_data);
 static void carrick_network_model_dispose (GObject *object);
 static gboolean network_model_have_service_by_path (GtkListStore *store, GtkTreeIter  *iter, const gchar  *path);
+static void network_model_index_service (CarrickNetworkModel *self, GtkTreeIter *iter, DBusGProxy *service);
+static void network_model_remove_service (CarrickNetworkModel *self, GtkTreeIter *iter, const gchar *path);
 /* end */
 
 static void
@@ -68,6 +82,11 @@ carrick_network_model_init (CarrickNetworkModel *self)
 
   priv = self->priv = NETWORK_MODEL_PRIVATE (self);
   priv->services = NULL;
+  priv->rows = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                      g_free,
+                                      (GDestroyNotify) gtk_tree_iter_free);
+  priv->pending_strength = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free, NULL);
   priv->connection = dbus_g_bus_get (DBUS_BUS_SYSTEM, &error);
   if (error)
     {
@@ -171,6 +190,12 @@ carrick_network_model_dispose (GObject *object)
       priv->connection = NULL;
     }
 
+  if (priv->strength_update_id)
+    {
+      g_source_remove (priv->strength_update_id);
+      priv->strength_update_id = 0;
+    }
+
   for (list_iter = priv->services;
        list_iter != NULL;
        list_iter = list_iter->next)
@@ -178,7 +203,7 @@ carrick_network_model_dispose (GObject *object)
       path = list_iter->data;
 
       if (network_model_have_service_by_path (store, &iter, path) == TRUE)
-        gtk_list_store_remove (store, &iter);
+        network_model_remove_service (self, &iter, path);
 
       g_free (path);
     }
@@ -189,6 +214,18 @@ carrick_network_model_dispose (GObject *object)
       priv->services = NULL;
     }
 
+  if (priv->rows)
+    {
+      g_hash_table_destroy (priv->rows);
+      priv->rows = NULL;
+    }
+
+  if (priv->pending_strength)
+    {
+      g_hash_table_destroy (priv->pending_strength);
+      priv->pending_strength = NULL;
+    }
+
   G_OBJECT_CLASS (carrick_network_model_parent_class)->dispose(object);
 }
 
@@ -208,34 +245,49 @@ network_model_have_service_in_store (GtkListStore *store,
                                      GtkTreeIter  *iter,
                                      const gchar  *path)
 {
-  gboolean    cont, found = FALSE;
-  DBusGProxy *service;
+  CarrickNetworkModelPrivate *priv = CARRICK_NETWORK_MODEL (store)->priv;
+  GtkTreeIter                *row;
 
-  cont = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store),
-                                        iter);
+  if (!priv->rows)
+    return FALSE;
 
-  while (cont)
-    {
-      gtk_tree_model_get (GTK_TREE_MODEL (store),
-                          iter,
-                          CARRICK_COLUMN_PROXY, &service,
-                          -1);
+  row = g_hash_table_lookup (priv->rows, path);
 
-      if (!service)
-        break;
+  if (!row)
+    return FALSE;
 
-      found = g_str_equal (path,
-                           dbus_g_proxy_get_path (service));
-      g_object_unref (service);
+  *iter = *row;
 
-      if (found)
-        break;
+  return TRUE;
+}
 
-      cont = gtk_tree_model_iter_next (GTK_TREE_MODEL (store),
-                                       iter);
-    }
+/*
+ * Every row inserted must be indexed with the former, and every row removed
+ * through the latter, to keep the path index in sync with the store.
+ */
+static void
+network_model_index_service (CarrickNetworkModel *self,
+                             GtkTreeIter         *iter,
+                             DBusGProxy          *service)
+{
+  CarrickNetworkModelPrivate *priv = self->priv;
 
-  return found;
+  g_hash_table_insert (priv->rows,
+                       g_strdup (dbus_g_proxy_get_path (service)),
+                       gtk_tree_iter_copy (iter));
+}
+
+static void
+network_model_remove_service (CarrickNetworkModel *self,
+                              GtkTreeIter         *iter,
+                              const gchar         *path)
+{
+  CarrickNetworkModelPrivate *priv = self->priv;
+
+  g_hash_table_remove (priv->pending_strength, path);
+  g_hash_table_remove (priv->rows, path);
+
+  gtk_list_store_remove (GTK_LIST_STORE (self), iter);
 }
 
 static gboolean
@@ -459,6 +511,10 @@ network_model_service_get_properties_cb (DBusGProxy     *service,
           config_proxy_excludes = get_boxed (dict, "Excludes");
         }
 
+      /* Fresh value, supersedes any queued up change */
+      g_hash_table_remove (self->priv->pending_strength,
+                           dbus_g_proxy_get_path (service));
+
       if (network_model_have_service_by_proxy (store,
                                                &iter,
                                                service))
@@ -548,6 +604,7 @@ network_model_service_get_properties_cb (DBusGProxy     *service,
              CARRICK_COLUMN_PROXY_CONFIGURED_SERVERS, config_proxy_servers,
              CARRICK_COLUMN_PROXY_CONFIGURED_EXCLUDES, config_proxy_excludes,
              -1);
+          network_model_index_service (self, &iter, service);
         }
     }
 }
@@ -565,6 +622,63 @@ remove_provider_cb (DBusGProxy *proxy,
     }
 }
 
+static gboolean
+network_model_update_strength_cb (gpointer user_data)
+{
+  CarrickNetworkModel        *self = user_data;
+  CarrickNetworkModelPrivate *priv = self->priv;
+  GtkListStore               *store = GTK_LIST_STORE (self);
+  GHashTableIter              hash_iter;
+  gpointer                    path, strength;
+
+  priv->strength_update_id = 0;
+
+  g_hash_table_iter_init (&hash_iter, priv->pending_strength);
+  while (g_hash_table_iter_next (&hash_iter, &path, &strength))
+    {
+      GtkTreeIter iter;
+      guint       current_strength;
+
+      if (!network_model_have_service_in_store (store, &iter, path))
+        continue;
+
+      /* Avoid change notification when the rounded value stays the same */
+      gtk_tree_model_get (GTK_TREE_MODEL (self), &iter,
+                          CARRICK_COLUMN_STRENGTH, &current_strength,
+                          -1);
+      if (current_strength != GPOINTER_TO_UINT (strength))
+        gtk_list_store_set (store, &iter,
+                            CARRICK_COLUMN_STRENGTH, GPOINTER_TO_UINT (strength),
+                            -1);
+    }
+
+  g_hash_table_remove_all (priv->pending_strength);
+
+  return FALSE;
+}
+
+/*
+ * Strength changes come in all the time for every service in range, so they
+ * are collected and applied to the model in one go every now and then.
+ */
+static void
+network_model_queue_strength (CarrickNetworkModel *self,
+                              const gchar         *path,
+                              guint                strength)
+{
+  CarrickNetworkModelPrivate *priv = self->priv;
+
+  g_hash_table_replace (priv->pending_strength,
+                        g_strdup (path),
+                        GUINT_TO_POINTER (strength));
+
+  if (!priv->strength_update_id)
+    priv->strength_update_id =
+      g_timeout_add (STRENGTH_UPDATE_INTERVAL,
+                     network_model_update_strength_cb,
+                     self);
+}
+
 static void
 network_model_service_changed_cb (DBusGProxy  *service,
                                   const gchar *property,
@@ -616,18 +730,13 @@ network_model_service_changed_cb (DBusGProxy  *service,
     }
   else if (g_str_equal (property, "Strength"))
     {
-      guint current_strength;
       /* This is the most common change, and fairly unimportant...
-       * Round to nearest ten, and avoid change notification */
+       * Round to nearest ten, and apply it with the next batch */
       guint strength = 10 * ((g_value_get_uchar (value) + 5) / 10);
 
-      gtk_tree_model_get (GTK_TREE_MODEL (self), &iter,
-                          CARRICK_COLUMN_STRENGTH, &current_strength,
-                          -1);
-      if (current_strength != strength)
-        gtk_list_store_set (store, &iter,
-                            CARRICK_COLUMN_STRENGTH, strength,
-                            -1);
+      network_model_queue_strength (self,
+                                    dbus_g_proxy_get_path (service),
+                                    strength);
     }
   else if (g_str_equal (property, "Name"))
     {
@@ -861,6 +970,7 @@ network_model_update_property (const gchar *property,
                                                  CARRICK_COLUMN_PROXY, service,
                                                  CARRICK_COLUMN_INDEX, index,
                                                  -1);
+              network_model_index_service (self, &iter, service);
 
               dbus_g_proxy_add_signal (service,
                                        "PropertyChanged",
@@ -908,7 +1018,7 @@ network_model_update_property (const gchar *property,
           path = list_iter->data;
 
           if (network_model_have_service_by_path (store, &iter, path) == TRUE)
-            gtk_list_store_remove (store, &iter);
+            network_model_remove_service (self, &iter, path);
 
           g_free (path);
         }
@@ -45,6 +45,20 @@
 
 #define RECONNECT_DELAY 5
 
+/* Change events arriving within one frame are folded into a single
+ * introspection request per object */
+#define FLUSH_DELAY_MS 16
+
+enum {
+        DIRTY_SINK,
+        DIRTY_SOURCE,
+        DIRTY_SINK_INPUT,
+        DIRTY_SOURCE_OUTPUT,
+        DIRTY_CLIENT,
+        DIRTY_CARD,
+        N_DIRTY
+};
+
 enum {
         PROP_0,
         PROP_NAME
@@ -78,6 +92,15 @@ struct GvcMixerControlPrivate
         GHashTable       *cards;
 
         GvcMixerStream   *new_default_stream; /* new default stream, used in gvc_mixer_control_set_default_sink () */
+
+        GHashTable       *dirty[N_DIRTY]; /* indexes waiting for an update */
+        gboolean          server_dirty;
+        guint             flush_id;
+
+        gint64            stats_start;
+        guint             n_events;
+        guint             n_introspections;
+        guint             n_property_changes;
 };
 
 enum {
@@ -590,6 +613,14 @@ update_server (GvcMixerControl      *control,
         }
 }
 
+static void
+on_stream_notify (GvcMixerStream  *stream,
+                  GParamSpec      *pspec,
+                  GvcMixerControl *control)
+{
+        control->priv->n_property_changes++;
+}
+
 static void
 remove_stream (GvcMixerControl *control,
                GvcMixerStream  *stream)
@@ -598,6 +629,10 @@ remove_stream (GvcMixerControl *control,
 
         g_object_ref (stream);
 
+        g_signal_handlers_disconnect_by_func (stream,
+                                              on_stream_notify,
+                                              control);
+
         id = gvc_mixer_stream_get_id (stream);
 
         if (id == control->priv->default_sink_id) {
@@ -619,6 +654,8 @@ static void
 add_stream (GvcMixerControl *control,
             GvcMixerStream  *stream)
 {
+        g_signal_connect_object (stream, "notify",
+                                 G_CALLBACK (on_stream_notify), control, 0);
         g_hash_table_insert (control->priv->all_streams,
                              GUINT_TO_POINTER (gvc_mixer_stream_get_id (stream)),
                              stream);
@@ -1393,6 +1430,7 @@ req_update_server_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1417,6 +1455,7 @@ req_update_client_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1441,6 +1480,7 @@ req_update_card (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1465,6 +1505,7 @@ req_update_sink_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1489,6 +1530,7 @@ req_update_source_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1513,6 +1555,7 @@ req_update_sink_input_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1537,6 +1580,7 @@ req_update_source_output_info (GvcMixerControl *control,
                 return;
         }
         pa_operation_unref (o);
+        control->priv->n_introspections++;
 }
 
 static void
@@ -1643,6 +1687,112 @@ remove_source_output (GvcMixerControl *control,
         remove_stream (control, stream);
 }
 
+static void
+gvc_mixer_control_report_stats (GvcMixerControl *control)
+{
+        gint64 now = g_get_monotonic_time ();
+        gint64 elapsed = now - control->priv->stats_start;
+
+        if (elapsed < G_USEC_PER_SEC)
+                return;
+
+        g_debug ("Mixer: %.1f change events/s, %.1f introspection calls/s, "
+                 "%.1f property changes/s",
+                 control->priv->n_events * (gdouble) G_USEC_PER_SEC / elapsed,
+                 control->priv->n_introspections * (gdouble) G_USEC_PER_SEC / elapsed,
+                 control->priv->n_property_changes * (gdouble) G_USEC_PER_SEC / elapsed);
+
+        control->priv->stats_start = now;
+        control->priv->n_events = 0;
+        control->priv->n_introspections = 0;
+        control->priv->n_property_changes = 0;
+}
+
+static void
+clear_dirty (GvcMixerControl *control)
+{
+        int i;
+
+        for (i = 0; i < N_DIRTY; i++)
+                g_hash_table_remove_all (control->priv->dirty[i]);
+        control->priv->server_dirty = FALSE;
+
+        if (control->priv->flush_id != 0) {
+                g_source_remove (control->priv->flush_id);
+                control->priv->flush_id = 0;
+        }
+}
+
+static gboolean
+flush_dirty_cb (gpointer data)
+{
+        static void (* const req_update[N_DIRTY]) (GvcMixerControl *, int) = {
+                [DIRTY_SINK]          = req_update_sink_info,
+                [DIRTY_SOURCE]        = req_update_source_info,
+                [DIRTY_SINK_INPUT]    = req_update_sink_input_info,
+                [DIRTY_SOURCE_OUTPUT] = req_update_source_output_info,
+                [DIRTY_CLIENT]        = req_update_client_info,
+                [DIRTY_CARD]          = req_update_card,
+        };
+        GvcMixerControl *control = GVC_MIXER_CONTROL (data);
+        GHashTableIter   iter;
+        gpointer         key;
+        int              i;
+
+        control->priv->flush_id = 0;
+
+        if (control->priv->pa_context == NULL
+            || pa_context_get_state (control->priv->pa_context) != PA_CONTEXT_READY) {
+                clear_dirty (control);
+                return FALSE;
+        }
+
+        if (control->priv->server_dirty) {
+                control->priv->server_dirty = FALSE;
+                req_update_server_info (control, -1);
+        }
+
+        for (i = 0; i < N_DIRTY; i++) {
+                g_hash_table_iter_init (&iter, control->priv->dirty[i]);
+                while (g_hash_table_iter_next (&iter, &key, NULL)) {
+                        req_update[i] (control, GPOINTER_TO_UINT (key));
+                        g_hash_table_iter_remove (&iter);
+                }
+        }
+
+        gvc_mixer_control_report_stats (control);
+
+        return FALSE;
+}
+
+static void
+queue_update (GvcMixerControl *control,
+              int              facility,
+              uint32_t         index)
+{
+        if (facility < 0)
+                control->priv->server_dirty = TRUE;
+        else
+                g_hash_table_insert (control->priv->dirty[facility],
+                                     GUINT_TO_POINTER (index),
+                                     GUINT_TO_POINTER (index));
+
+        if (control->priv->flush_id == 0)
+                control->priv->flush_id = g_timeout_add (FLUSH_DELAY_MS,
+                                                         flush_dirty_cb,
+                                                         control);
+}
+
+/* An object that goes away must not be queried afterwards */
+static void
+unqueue_update (GvcMixerControl *control,
+                int              facility,
+                uint32_t         index)
+{
+        g_hash_table_remove (control->priv->dirty[facility],
+                             GUINT_TO_POINTER (index));
+}
+
 static void
 _pa_context_subscribe_cb (pa_context                  *context,
                           pa_subscription_event_type_t t,
@@ -1650,57 +1800,68 @@ _pa_context_subscribe_cb (pa_context                  *context,
                           void                        *userdata)
 {
         GvcMixerControl *control = GVC_MIXER_CONTROL (userdata);
+        gboolean         is_remove;
+
+        control->priv->n_events++;
+
+        is_remove = (t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE;
 
         switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
         case PA_SUBSCRIPTION_EVENT_SINK:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_SINK, index);
                         remove_sink (control, index);
                 } else {
-                        req_update_sink_info (control, index);
+                        queue_update (control, DIRTY_SINK, index);
                 }
                 break;
 
         case PA_SUBSCRIPTION_EVENT_SOURCE:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_SOURCE, index);
                         remove_source (control, index);
                 } else {
-                        req_update_source_info (control, index);
+                        queue_update (control, DIRTY_SOURCE, index);
                 }
                 break;
 
         case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_SINK_INPUT, index);
                         remove_sink_input (control, index);
                 } else {
-                        req_update_sink_input_info (control, index);
+                        queue_update (control, DIRTY_SINK_INPUT, index);
                 }
                 break;
 
         case PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_SOURCE_OUTPUT, index);
                         remove_source_output (control, index);
                 } else {
-                        req_update_source_output_info (control, index);
+                        queue_update (control, DIRTY_SOURCE_OUTPUT, index);
                 }
                 break;
 
         case PA_SUBSCRIPTION_EVENT_CLIENT:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_CLIENT, index);
                         remove_client (control, index);
                 } else {
-                        req_update_client_info (control, index);
+                        queue_update (control, DIRTY_CLIENT, index);
                 }
                 break;
 
         case PA_SUBSCRIPTION_EVENT_SERVER:
-                req_update_server_info (control, index);
+                queue_update (control, -1, index);
                 break;
 
         case PA_SUBSCRIPTION_EVENT_CARD:
-                if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+                if (is_remove) {
+                        unqueue_update (control, DIRTY_CARD, index);
                         remove_card (control, index);
                 } else {
-                        req_update_card (control, index);
+                        queue_update (control, DIRTY_CARD, index);
                 }
                 break;
         }
@@ -1824,6 +1985,8 @@ idle_reconnect (gpointer data)
                 gvc_mixer_new_pa_context (control);
         }
 
+        clear_dirty (control);
+
         remove_all_streams (control, control->priv->sinks);
         remove_all_streams (control, control->priv->sources);
         remove_all_streams (control, control->priv->sink_inputs);
@@ -1906,6 +2069,18 @@ static void
 gvc_mixer_control_dispose (GObject *object)
 {
         GvcMixerControl *control = GVC_MIXER_CONTROL (object);
+        int              i;
+
+        if (control->priv->flush_id != 0) {
+                g_source_remove (control->priv->flush_id);
+                control->priv->flush_id = 0;
+        }
+        for (i = 0; i < N_DIRTY; i++) {
+                if (control->priv->dirty[i] != NULL) {
+                        g_hash_table_destroy (control->priv->dirty[i]);
+                        control->priv->dirty[i] = NULL;
+                }
+        }
 
         if (control->priv->pa_context != NULL) {
                 pa_context_unref (control->priv->pa_context);
@@ -2105,6 +2280,8 @@ gvc_mixer_control_class_init (GvcMixerControlClass *klass)
 static void
 gvc_mixer_control_init (GvcMixerControl *control)
 {
+        int i;
+
         control->priv = GVC_MIXER_CONTROL_GET_PRIVATE (control);
 
         control->priv->pa_mainloop = pa_glib_mainloop_new (g_main_context_default ());
@@ -2121,6 +2298,10 @@ gvc_mixer_control_init (GvcMixerControl *control)
         control->priv->cards = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_object_unref);
 
         control->priv->clients = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_free);
+
+        for (i = 0; i < N_DIRTY; i++)
+                control->priv->dirty[i] = g_hash_table_new (NULL, NULL);
+        control->priv->stats_start = g_get_monotonic_time ();
 }
 
 static void
@@ -61,6 +61,7 @@ main (int     argc,
   bool lock_shared = false;
   bool watch = false;
   bool dump = false;
+  bool compact = false;
   GOptionEntry _options[] = {
     { "add", 'a', 0, G_OPTION_ARG_STRING, (void **) &add,
       "Add launch of <executable> at current time to database", "<executable>" },
@@ -80,6 +81,8 @@ main (int     argc,
       "Watch database for changes", NULL },
     { "dump", 'd', 0, G_OPTION_ARG_NONE, &dump,
       "Dump database", NULL },
+    { "compact", 'c', 0, G_OPTION_ARG_NONE, &compact,
+      "Merge journalled launches into database", NULL },
     { NULL }
   };
 
@@ -112,6 +115,15 @@ main (int     argc,
       g_clear_error (&error);
     }
 
+  } else if (compact) {
+
+    mpl_app_launches_store_compact (store, &error);
+    if (error)
+    {
+      g_critical ("%s\n\t%s", G_STRLOC, error->message);
+      g_clear_error (&error);
+    }
+
   } else if (dump) {
 
     mpl_app_launches_store_dump (store, &error);
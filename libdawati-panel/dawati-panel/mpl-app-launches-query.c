@@ -153,3 +153,28 @@ mpl_app_launches_query_lookup (MplAppLaunchesQuery   *self,
                                         error);
 }
 
+/**
+ * mpl_app_launches_query_lookup_many: (skip)
+ *
+ * Look up a batch of executables in one pass, see
+ * mpl_app_launches_store_lookup_many().
+ */
+unsigned
+mpl_app_launches_query_lookup_many (MplAppLaunchesQuery   *self,
+                                    char const * const    *executables,
+                                    unsigned               n_executables,
+                                    time_t                *last_launched_out,
+                                    uint32_t              *n_launches_out,
+                                    GError               **error)
+{
+  MplAppLaunchesQueryPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (MPL_IS_APP_LAUNCHES_QUERY (self), 0);
+
+  return mpl_app_launches_store_lookup_many (priv->store,
+                                             executables,
+                                             n_executables,
+                                             last_launched_out,
+                                             n_launches_out,
+                                             error);
+}
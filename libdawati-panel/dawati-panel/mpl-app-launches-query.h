@@ -66,6 +66,14 @@ mpl_app_launches_query_lookup (MplAppLaunchesQuery   *self,
                                uint32_t              *n_launches_out,
                                GError               **error);
 
+unsigned
+mpl_app_launches_query_lookup_many (MplAppLaunchesQuery   *self,
+                                    char const * const    *executables,
+                                    unsigned               n_executables,
+                                    time_t                *last_launched_out,
+                                    uint32_t              *n_launches_out,
+                                    GError               **error);
+
 G_END_DECLS
 
 #endif /* MPL_APP_LAUNCHES_QUERY_H */
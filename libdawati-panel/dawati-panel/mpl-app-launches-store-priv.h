@@ -34,5 +34,9 @@ bool
 mpl_app_launches_store_close (MplAppLaunchesStore  *self,
                               GError              **error_out);
 
+bool
+mpl_app_launches_store_compact (MplAppLaunchesStore  *self,
+                                GError              **error_out);
+
 #endif /* MPL_APP_LAUNCHES_STORE_PRIV_H */
 
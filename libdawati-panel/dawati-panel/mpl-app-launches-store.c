@@ -21,10 +21,17 @@
  */
 
 /*
- * FIXME
- * Maybe create an "mpl-app-launches-store-insert" executable that
- * can be spawned from any process that wants to insert. This would
- * delegate the queueing to the kernel.
+ * The store consists of two files. The database proper is a table of
+ * fixed-size binary records sorted by hash, which readers mmap and search. Launches are not
+ * inserted into that table directly but appended to a journal next to it,
+ * so recording a launch costs one small write. Once the journal has grown
+ * past MPL_APP_LAUNCHES_JOURNAL_COMPACT_THRESHOLD records it is merged into
+ * the table by mpl_app_launches_store_compact().
+ *
+ * Locking: the journal's flock serialises writers against compaction.
+ * Readers hold a shared lock on it while mapping the table and loading the
+ * journal, so they never see a table and journal from different
+ * generations.
  */
 
 #define _GNU_SOURCE /* for comparison_fn_t from stdlib.h */
@@ -63,7 +70,32 @@ enum
 };
 
 /*
- * Record as persisted to disk.
+ * On-disk table: a header padded to a cache line, followed by records
+ * sorted by hash. Journal entries use the same record layout.
+ */
+#define MPL_APP_LAUNCHES_MAGIC "MplAppL"
+#define MPL_APP_LAUNCHES_VERSION 2
+
+typedef struct
+{
+  char      magic[8];       /* MPL_APP_LAUNCHES_MAGIC, incl. '\0' */
+  uint32_t  version;
+  uint32_t  n_records;
+  char      padding[48];
+} MplAppLaunchesHeader;
+
+typedef struct
+{
+  uint32_t  hash;           /* g_str_hash of executable name */
+  uint32_t  n_launches;
+  int64_t   last_launched;  /* time_t */
+} MplAppLaunchesRecord;
+
+G_STATIC_ASSERT (sizeof (MplAppLaunchesHeader) == 64);
+G_STATIC_ASSERT (sizeof (MplAppLaunchesRecord) == 16);
+
+/*
+ * Record as persisted by version 1, migrated on open.
  */
 typedef struct
 {
@@ -71,19 +103,39 @@ typedef struct
   char    last_launched[9]; /* Hash of time_t as hex-string, incl. '\n' */
   char    n_launches[9];    /* Hash of total launches as hex string, incl. '\n' */
   char    newline;
-} MplAppLaunchesRecord;
+} MplAppLaunchesTextRecord;
+
+/*
+ * Journalled launches of one executable, accumulated in memory.
+ */
+typedef struct
+{
+  time_t    last_launched;
+  uint32_t  n_launches;
+} MplAppLaunchesDelta;
 
 typedef struct
 {
   char                  *database_file;
+  char                  *journal_file;
   GFileMonitor          *monitor;
+  GFileMonitor          *journal_monitor;
   int                    fd;
-  MplAppLaunchesRecord  *data;
+  MplAppLaunchesHeader  *data;
   size_t                 size;
+  MplAppLaunchesRecord const *records;
+  size_t                 n_records;
+  GHashTable            *journal;
   unsigned               mmap_reference_count;
   bool                   for_writing;
 } MplAppLaunchesStorePrivate;
 
+/* Merge the journal into the table after this many launches. */
+#define MPL_APP_LAUNCHES_JOURNAL_COMPACT_THRESHOLD 64
+
+/* Interpolation steps before table lookups fall back to bisection. */
+#define MPL_APP_LAUNCHES_MAX_INTERPOLATION_PROBES 4
+
 #define PROPAGATE_ERROR_AND_RETURN_IF_FAIL(condition_, error_, error_ptr_)  \
           if (!(condition_))                                                \
           {                                                                 \
@@ -167,22 +219,38 @@ _set_property (GObject      *object,
   }
 }
 
-static void
-_constructed (GObject *object)
+static GFileMonitor *
+monitor_file (char const  *path,
+              GObject     *object)
 {
-  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (object);
-  GFile   *file;
-  GError  *error = NULL;
+  GFile         *file;
+  GFileMonitor  *monitor;
+  GError        *error = NULL;
 
-  file = g_file_new_for_path (priv->database_file);
-  priv->monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, &error);
+  file = g_file_new_for_path (path);
+  monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, &error);
   if (error)
   {
     g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
   } else {
-    g_signal_connect (priv->monitor, "changed",
+    g_signal_connect (monitor, "changed",
                       G_CALLBACK (_database_file_changed_cb), object);
   }
+  g_object_unref (file);
+
+  return monitor;
+}
+
+static void
+_constructed (GObject *object)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (object);
+
+  priv->journal_file = g_strdup_printf ("%s.journal", priv->database_file);
+
+  priv->monitor = monitor_file (priv->database_file, object);
+  priv->journal_monitor = monitor_file (priv->journal_file, object);
 }
 
 static void
@@ -196,12 +264,30 @@ _dispose (GObject *object)
     priv->database_file = NULL;
   }
 
+  if (priv->journal_file)
+  {
+    g_free (priv->journal_file);
+    priv->journal_file = NULL;
+  }
+
   if (priv->monitor)
   {
     g_object_unref (priv->monitor);
     priv->monitor = NULL;
   }
 
+  if (priv->journal_monitor)
+  {
+    g_object_unref (priv->journal_monitor);
+    priv->journal_monitor = NULL;
+  }
+
+  if (priv->journal)
+  {
+    g_hash_table_destroy (priv->journal);
+    priv->journal = NULL;
+  }
+
   G_OBJECT_CLASS (mpl_app_launches_store_parent_class)->dispose (object);
 }
 
@@ -251,6 +337,9 @@ mpl_app_launches_store_class_init (MplAppLaunchesStoreClass *klass)
 static void
 mpl_app_launches_store_init (MplAppLaunchesStore *self)
 {
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+
+  priv->fd = -1;
 }
 
 MplAppLaunchesStore *
@@ -259,117 +348,351 @@ mpl_app_launches_store_new (void)
   return g_object_new (MPL_TYPE_APP_LAUNCHES_STORE, NULL);
 }
 
-static int
-_compare_cb (MplAppLaunchesRecord const *a,
-             MplAppLaunchesRecord const *b)
+static void
+record_set (MplAppLaunchesRecord *record,
+            uint32_t              hash,
+            time_t                last_launched,
+            uint32_t              n_launches)
 {
-  int ret;
-
-  /* strncmp ought to work for padded '\0' terminated hex strings  */
-  ret = strncmp (a->hash, b->hash, sizeof (a->hash) - 1);
-  return ret;
+  record->hash = hash;
+  record->n_launches = n_launches;
+  record->last_launched = last_launched;
 }
 
 static void
-record_read (MplAppLaunchesRecord const *record,
-             uint32_t                   *hash_out,
-             time_t                     *last_launched_out,
-             uint32_t                   *n_launches_out)
+text_record_read (MplAppLaunchesTextRecord const *text_record,
+                  MplAppLaunchesRecord           *record)
 {
-  if (hash_out)
-    sscanf (record->hash, "%x", hash_out);
+  char buf[sizeof (text_record->hash)];
 
-  if (last_launched_out)
-    sscanf (record->last_launched, "%lx", last_launched_out);
+  /* Fields are only '\0' terminated if the file is well-formed. */
+  memcpy (buf, text_record->hash, sizeof (buf) - 1);
+  buf[sizeof (buf) - 1] = '\0';
+  record->hash = strtoul (buf, NULL, 16);
 
-  if (n_launches_out)
-    sscanf (record->n_launches, "%x", n_launches_out);
+  memcpy (buf, text_record->last_launched, sizeof (buf) - 1);
+  record->last_launched = strtoul (buf, NULL, 16);
+
+  memcpy (buf, text_record->n_launches, sizeof (buf) - 1);
+  record->n_launches = strtoul (buf, NULL, 16);
 }
 
-static void
-record_update (MplAppLaunchesRecord *record,
-               int32_t               hash,
-               time_t                timestamp)
+/*
+ * Find the first record in [lo, hi) whose hash is not less than `hash'.
+ * Keys are g_str_hash values and thus close to uniformly distributed,
+ * so interpolating the probe position usually hits within a couple of
+ * steps. Fall back to bisection should the distribution be skewed.
+ */
+static size_t
+table_lower_bound (MplAppLaunchesRecord const *records,
+                   size_t                      lo,
+                   size_t                      hi,
+                   uint32_t                    hash)
 {
-  uint32_t n_launches = 0;
+  unsigned n_probes = 0;
+
+  while (lo < hi)
+  {
+    uint32_t  lo_hash = records[lo].hash;
+    uint32_t  hi_hash = records[hi - 1].hash;
+    size_t    mid;
 
-  if (hash)
-    snprintf (record->hash, sizeof (record->hash), "%08x", hash);
+    if (lo_hash >= hash)
+      return lo;
 
-  if (timestamp)
-    snprintf (record->last_launched, sizeof (record->last_launched),
-              "%08lx", timestamp);
+    if (hi_hash < hash)
+      return hi;
 
-  record_read (record, NULL, NULL, &n_launches);
-  snprintf (record->n_launches, sizeof (record->n_launches),
-            "%08x", n_launches + 1);
+    /* Now lo_hash < hash <= hi_hash, so lo < mid < hi for any mid
+     * picked below. */
+    if (n_probes++ < MPL_APP_LAUNCHES_MAX_INTERPOLATION_PROBES)
+    {
+      mid = lo + (size_t) ((uint64_t) (hash - lo_hash) * (hi - 1 - lo) /
+                           (hi_hash - lo_hash));
+      mid = CLAMP (mid, lo + 1, hi - 1);
+    } else {
+      mid = lo + (hi - lo) / 2;
+    }
+
+    if (records[mid].hash < hash)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
 }
 
 static bool
-record_write (MplAppLaunchesRecord   *record,
-              int                     fd,
-              GError                **error_out)
+write_all (int          fd,
+           void const  *buf,
+           size_t       count,
+           GError     **error_out)
 {
-  ssize_t n_bytes;
+  char const *p = buf;
+
+  while (count > 0)
+  {
+    ssize_t n_bytes = write (fd, p, count);
+    if (n_bytes < 0)
+    {
+      if (EINTR == errno)
+        continue;
+
+      if (error_out)
+        *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                  MPL_APP_LAUNCHES_STORE_ERROR_WRITING_DATABASE,
+                                  "%s : %s",
+                                  G_STRLOC, strerror (errno));
+      return false;
+    }
+    p += n_bytes;
+    count -= n_bytes;
+  }
+
+  return true;
+}
+
+/*
+ * Open and lock the journal. When creating, the cache directory is created
+ * as needed. Returns -1 if the journal does not exist and `create' is
+ * false, without setting an error.
+ */
+static int
+journal_open (MplAppLaunchesStore  *self,
+              bool                  create,
+              int                   lock_flags,
+              GError              **error_out)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+  int fd;
+
+  if (create)
+  {
+    fd = open (priv->journal_file, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (-1 == fd && ENOENT == errno)
+    {
+      char *dir = g_path_get_dirname (priv->journal_file);
+      g_mkdir_with_parents (dir, 0700);
+      g_free (dir);
+      fd = open (priv->journal_file, O_RDWR | O_APPEND | O_CREAT, 0644);
+    }
+  } else {
+    fd = open (priv->journal_file, O_RDONLY);
+    if (-1 == fd && ENOENT == errno)
+      return -1;
+  }
+
+  if (-1 == fd)
+  {
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    return -1;
+  }
+
+  if (-1 == flock (fd, lock_flags))
+  {
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    close (fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static void
+journal_close (int fd)
+{
+  if (-1 == flock (fd, LOCK_UN))
+  {
+    g_warning ("%s : %s", G_STRLOC, strerror (errno));
+  }
+
+  if (-1 == close (fd))
+  {
+    g_warning ("%s : %s", G_STRLOC, strerror (errno));
+  }
+}
+
+/*
+ * Read the (locked) journal into a hash -> MplAppLaunchesDelta table.
+ */
+static GHashTable *
+journal_load (int       fd,
+              GError  **error_out)
+{
+  GHashTable            *journal;
+  MplAppLaunchesRecord  *records;
+  struct stat            sb;
+  size_t                 n_records;
+  size_t                 i;
+  ssize_t                n_bytes;
+
+  if (-1 == fstat (fd, &sb))
+  {
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    return NULL;
+  }
 
-  n_bytes = write (fd, record, sizeof (*record));
+  journal = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                   NULL, g_free);
+
+  n_records = sb.st_size / sizeof (MplAppLaunchesRecord);
+  if (0 == n_records)
+    return journal;
+
+  records = g_new (MplAppLaunchesRecord, n_records);
+  n_bytes = pread (fd, records, n_records * sizeof (MplAppLaunchesRecord), 0);
   if (n_bytes < 0)
   {
     if (error_out)
       *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
-                                MPL_APP_LAUNCHES_STORE_ERROR_WRITING_DATABASE,
+                                MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
-    return false;
+    g_free (records);
+    g_hash_table_destroy (journal);
+    return NULL;
   }
 
-  return true;
+  /* Ignore a partially written trailing record. */
+  n_records = n_bytes / sizeof (MplAppLaunchesRecord);
+  for (i = 0; i < n_records; i++)
+  {
+    MplAppLaunchesDelta *delta;
+
+    delta = g_hash_table_lookup (journal, GUINT_TO_POINTER (records[i].hash));
+    if (NULL == delta)
+    {
+      delta = g_new0 (MplAppLaunchesDelta, 1);
+      g_hash_table_insert (journal, GUINT_TO_POINTER (records[i].hash), delta);
+    }
+
+    delta->last_launched = MAX (delta->last_launched,
+                                (time_t) records[i].last_launched);
+    delta->n_launches += records[i].n_launches;
+  }
+
+  g_free (records);
+
+  return journal;
 }
 
 /*
- * Open the store for reading or writing.
- * This is private API, the one-shot functions handle opening and closing
- * the store.
+ * Append a single launch to the (locked) journal, returning the number of
+ * records now in it.
  */
-bool
-mpl_app_launches_store_open (MplAppLaunchesStore  *self,
-                             bool                  for_writing,
-                             GError              **error_out)
+static size_t
+journal_append (int                   fd,
+                uint32_t              hash,
+                time_t                timestamp,
+                GError              **error_out)
 {
-  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
-  int         open_mode;
-  int         mmap_protect;
-  int         lock_flags;
-  struct stat sb;
-  bool        ret = true;
+  MplAppLaunchesRecord  record;
+  struct stat           sb;
 
-  if (priv->mmap_reference_count > 0)
+  record_set (&record, hash, timestamp, 1);
+
+  if (!write_all (fd, &record, sizeof (record), error_out))
+    return 0;
+
+  if (-1 == fstat (fd, &sb))
   {
-    /* Already mapped. */
-    if (priv->for_writing)
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    return 0;
+  }
+
+  return sb.st_size / sizeof (MplAppLaunchesRecord);
+}
+
+typedef enum
+{
+  TABLE_FORMAT_INVALID,
+  TABLE_FORMAT_TEXT,
+  TABLE_FORMAT_BINARY
+} TableFormat;
+
+/*
+ * Check a mapped table. Text tables are what earlier versions wrote and
+ * need migrating.
+ */
+static TableFormat
+table_check_format (void const  *data,
+                    size_t       size,
+                    GError     **error_out)
+{
+  MplAppLaunchesHeader const *header = data;
+
+  if (size >= sizeof (*header) &&
+      0 == memcmp (header->magic, MPL_APP_LAUNCHES_MAGIC, sizeof (header->magic)))
+  {
+    if (header->version != MPL_APP_LAUNCHES_VERSION)
     {
       if (error_out)
         *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
-                                  MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
-                                  "Database opened for writing and locked");
-      return false;
-
-    } else {
+                                  MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                                  "%s : Unsupported database version %u",
+                                  G_STRLOC, header->version);
+      return TABLE_FORMAT_INVALID;
+    }
 
-      priv->mmap_reference_count++;
-      return true;
+    if (sizeof (*header) + (size_t) header->n_records *
+                           sizeof (MplAppLaunchesRecord) > size)
+    {
+      if (error_out)
+        *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                  MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                                  "%s : Database truncated",
+                                  G_STRLOC);
+      return TABLE_FORMAT_INVALID;
     }
+
+    return TABLE_FORMAT_BINARY;
   }
 
-  priv->data = NULL;
-  priv->size = 0;
-  priv->for_writing = for_writing;
+  if (0 == size % sizeof (MplAppLaunchesTextRecord))
+    return TABLE_FORMAT_TEXT;
 
-  /* Empty (non existant) store is fine. */
-  if (!g_file_test (priv->database_file, G_FILE_TEST_IS_REGULAR))
-  {
-    return true;
-  }
+  if (error_out)
+    *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                              MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                              "%s : Unknown database format",
+                              G_STRLOC);
+  return TABLE_FORMAT_INVALID;
+}
+
+/*
+ * Map the table. `needs_migration_out' is set if the table is in the old
+ * text format, in which case nothing is kept open.
+ */
+static bool
+table_open (MplAppLaunchesStore  *self,
+            bool                 *needs_migration_out,
+            GError              **error_out)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+  int         open_mode;
+  int         mmap_protect;
+  int         lock_flags;
+  struct stat sb;
+  TableFormat format;
+
+  *needs_migration_out = false;
 
   if (priv->for_writing)
   {
@@ -385,6 +708,10 @@ mpl_app_launches_store_open (MplAppLaunchesStore  *self,
   priv->fd = open (priv->database_file, open_mode);
   if (-1 == priv->fd)
   {
+    /* Empty (non existant) store is fine. */
+    if (ENOENT == errno)
+      return true;
+
     if (error_out)
       *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
                                 MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
@@ -400,6 +727,8 @@ mpl_app_launches_store_open (MplAppLaunchesStore  *self,
                                 MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
+    close (priv->fd);
+    priv->fd = -1;
     return false;
   }
 
@@ -410,10 +739,15 @@ mpl_app_launches_store_open (MplAppLaunchesStore  *self,
                                 MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
+    close (priv->fd);
+    priv->fd = -1;
     return false;
   }
 
-  priv->size = sb.st_size;
+  /* Zero-length mappings are not allowed. */
+  if (0 == sb.st_size)
+    return true;
+
   priv->data = mmap (0, sb.st_size, mmap_protect, MAP_SHARED, priv->fd, 0);
   if ((void *) -1 == priv->data)
   {
@@ -422,15 +756,183 @@ mpl_app_launches_store_open (MplAppLaunchesStore  *self,
                                 MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
-    priv->fd = 0;
+    close (priv->fd);
+    priv->fd = -1;
     priv->data = NULL;
-    priv->size = 0;
-    ret = false;
-  } else {
-    priv->mmap_reference_count = 1;
+    return false;
   }
 
-  return ret;
+  format = table_check_format (priv->data, sb.st_size, error_out);
+  if (TABLE_FORMAT_BINARY != format)
+  {
+    munmap (priv->data, sb.st_size);
+    close (priv->fd);
+    priv->fd = -1;
+    priv->data = NULL;
+    *needs_migration_out = (TABLE_FORMAT_TEXT == format);
+    return TABLE_FORMAT_TEXT == format;
+  }
+
+  priv->size = sb.st_size;
+  priv->records = (MplAppLaunchesRecord const *) (priv->data + 1);
+  priv->n_records = priv->data->n_records;
+
+  return true;
+}
+
+/*
+ * Read the table at `path' in either format into a newly allocated array,
+ * independently of any mapping held by open queries.
+ */
+static MplAppLaunchesRecord *
+table_read (char const  *path,
+            size_t      *n_records_out,
+            GError     **error_out)
+{
+  MplAppLaunchesRecord  *records = NULL;
+  void                  *data;
+  struct stat            sb;
+  size_t                 i;
+  int                    fd;
+
+  *n_records_out = 0;
+
+  fd = open (path, O_RDONLY);
+  if (-1 == fd)
+  {
+    if (ENOENT == errno)
+      return NULL;
+
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    return NULL;
+  }
+
+  if (-1 == fstat (fd, &sb) || 0 == sb.st_size)
+  {
+    close (fd);
+    return NULL;
+  }
+
+  data = mmap (0, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if ((void *) -1 == data)
+  {
+    if (error_out)
+      *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                MPL_APP_LAUNCHES_STORE_ERROR_READING_DATABASE,
+                                "%s : %s",
+                                G_STRLOC, strerror (errno));
+    return NULL;
+  }
+
+  switch (table_check_format (data, sb.st_size, error_out))
+  {
+  case TABLE_FORMAT_BINARY:
+    *n_records_out = ((MplAppLaunchesHeader const *) data)->n_records;
+    records = g_memdup ((MplAppLaunchesHeader const *) data + 1,
+                        *n_records_out * sizeof (MplAppLaunchesRecord));
+    break;
+  case TABLE_FORMAT_TEXT:
+    *n_records_out = sb.st_size / sizeof (MplAppLaunchesTextRecord);
+    records = g_new (MplAppLaunchesRecord, *n_records_out);
+    for (i = 0; i < *n_records_out; i++)
+    {
+      text_record_read ((MplAppLaunchesTextRecord const *) data + i,
+                        &records[i]);
+    }
+    break;
+  case TABLE_FORMAT_INVALID:
+    break;
+  }
+
+  munmap (data, sb.st_size);
+
+  return records;
+}
+
+static bool
+store_compact (MplAppLaunchesStore  *self,
+               bool                  migrate,
+               GError              **error_out);
+
+/*
+ * Open the store for reading or writing.
+ * This is private API, the one-shot functions handle opening and closing
+ * the store.
+ */
+bool
+mpl_app_launches_store_open (MplAppLaunchesStore  *self,
+                             bool                  for_writing,
+                             GError              **error_out)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+  int     journal_fd;
+  bool    needs_migration;
+  GError *error = NULL;
+
+  if (priv->mmap_reference_count > 0)
+  {
+    /* Already mapped. */
+    if (priv->for_writing)
+    {
+      if (error_out)
+        *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                                  MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
+                                  "Database opened for writing and locked");
+      return false;
+
+    } else {
+
+      priv->mmap_reference_count++;
+      return true;
+    }
+  }
+
+  priv->fd = -1;
+  priv->data = NULL;
+  priv->size = 0;
+  priv->records = NULL;
+  priv->n_records = 0;
+  priv->for_writing = for_writing;
+
+  /* Keep compaction out while we look at both the table and the journal. */
+  journal_fd = journal_open (self, false, LOCK_SH, &error);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
+  if (!table_open (self, &needs_migration, &error))
+  {
+    if (journal_fd > -1)
+      journal_close (journal_fd);
+    PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+  }
+
+  if (needs_migration)
+  {
+    if (journal_fd > -1)
+      journal_close (journal_fd);
+
+    /* Rewriting converts the table to the binary format, try again. */
+    store_compact (self, true, &error);
+    PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
+    return mpl_app_launches_store_open (self, for_writing, error_out);
+  }
+
+  if (journal_fd > -1)
+  {
+    priv->journal = journal_load (journal_fd, &error);
+    journal_close (journal_fd);
+    PROPAGATE_ERROR_AND_RETURN_IF_FAIL_WITH_CODE (!error, error, error_out,
+                                                  mpl_app_launches_store_close (self, NULL));
+  }
+
+  priv->mmap_reference_count = 1;
+
+  return true;
 }
 
 /*
@@ -453,8 +955,6 @@ mpl_app_launches_store_close (MplAppLaunchesStore  *self,
 
   if (priv->data && priv->size)
   {
-    /* Store is not empty/non-exist, close it. */
-
     if (-1 == munmap ((void *) priv->data, priv->size))
     {
       error = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
@@ -462,7 +962,10 @@ mpl_app_launches_store_close (MplAppLaunchesStore  *self,
                            "%s : %s",
                            G_STRLOC, strerror (errno));
     }
+  }
 
+  if (priv->fd > -1)
+  {
     if (-1 == flock (priv->fd, LOCK_UN))
     {
       g_warning ("%s : %s", G_STRLOC, strerror (errno));
@@ -472,51 +975,198 @@ mpl_app_launches_store_close (MplAppLaunchesStore  *self,
     {
       g_warning ("%s : %s", G_STRLOC, strerror (errno));
     }
+  }
 
-    priv->fd = 0;
-    priv->data = NULL;
-    priv->size = 0;
-    priv->mmap_reference_count = 0;
-
-    PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+  if (priv->journal)
+  {
+    g_hash_table_destroy (priv->journal);
+    priv->journal = NULL;
   }
 
+  priv->fd = -1;
+  priv->data = NULL;
+  priv->size = 0;
+  priv->records = NULL;
+  priv->n_records = 0;
+  priv->mmap_reference_count = 0;
+
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
   return true;
 }
 
-static MplAppLaunchesRecord *
+static MplAppLaunchesRecord const *
 store_lookup_hash (MplAppLaunchesStore  *self,
-                   uint32_t              hash,
-                   GError              **error_out)
+                   uint32_t              hash)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+  size_t i;
+
+  i = table_lower_bound (priv->records, 0, priv->n_records, hash);
+  if (i < priv->n_records && priv->records[i].hash == hash)
+    return &priv->records[i];
+
+  return NULL;
+}
+
+/*
+ * Combine a table record with launches still sitting in the journal.
+ */
+static bool
+store_merge_journal (MplAppLaunchesStore        *self,
+                     uint32_t                    hash,
+                     MplAppLaunchesRecord const *record,
+                     time_t                     *last_launched_out,
+                     uint32_t                   *n_launches_out)
 {
   MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
-  MplAppLaunchesRecord  *record;
-  MplAppLaunchesRecord   key;
+  MplAppLaunchesDelta   *delta = NULL;
+  time_t                 last_launched = 0;
+  uint32_t               n_launches = 0;
+
+  if (priv->journal)
+    delta = g_hash_table_lookup (priv->journal, GUINT_TO_POINTER (hash));
 
-  snprintf (key.hash, sizeof (key.hash), "%08x", hash);
+  if (record)
+  {
+    last_launched = record->last_launched;
+    n_launches = record->n_launches;
+  }
+
+  if (delta)
+  {
+    last_launched = MAX (last_launched, delta->last_launched);
+    n_launches += delta->n_launches;
+  }
 
-  record = bsearch (&key, priv->data,
-                    priv->size / sizeof (MplAppLaunchesRecord),
-                    sizeof (MplAppLaunchesRecord),
-                    (comparison_fn_t) _compare_cb);
+  if (last_launched_out)
+    *last_launched_out = last_launched;
 
-  return record;
+  if (n_launches_out)
+    *n_launches_out = n_launches;
+
+  return record || delta;
+}
+
+static int
+_compare_hash_cb (void const *a,
+                  void const *b)
+{
+  uint32_t hash_a = GPOINTER_TO_UINT (*(void * const *) a);
+  uint32_t hash_b = GPOINTER_TO_UINT (*(void * const *) b);
+
+  return hash_a < hash_b ? -1 : hash_a > hash_b;
 }
 
-static char *
-store_insert (MplAppLaunchesStore   *self,
-              uint32_t               hash,
-              time_t                 timestamp,
-              GError               **error_out)
+/*
+ * Merge the journal into a new table and atomically replace the old one.
+ * The journal must be open and locked exclusively. With `migrate' the
+ * table is rewritten even if the journal is empty.
+ */
+static bool
+store_compact_locked (MplAppLaunchesStore  *self,
+                      int                   journal_fd,
+                      bool                  migrate,
+                      GError              **error_out)
 {
   MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
-  char       template[] = "/tmp/dawati-app-launches-store-XXXXXX";
-  int        fd;
-  unsigned   n_elements;
-  unsigned   i;
-  GError    *error = NULL;
+  MplAppLaunchesRecord  *table;
+  MplAppLaunchesHeader  *header;
+  MplAppLaunchesRecord  *merged;
+  GHashTable            *journal = NULL;
+  GList                 *hashes;
+  GList                 *iter;
+  void                 **keys;
+  char                  *tmp_database_file;
+  size_t                 n_table;
+  size_t                 n_journal = 0;
+  size_t                 n_merged;
+  size_t                 i;
+  size_t                 j;
+  int                    fd;
+  bool                   ret;
+  GError                *error = NULL;
+
+  if (journal_fd > -1)
+  {
+    journal = journal_load (journal_fd, &error);
+    PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+    n_journal = g_hash_table_size (journal);
+  }
+
+  if (0 == n_journal && !migrate)
+  {
+    if (journal)
+      g_hash_table_destroy (journal);
+    return true;
+  }
+
+  table = table_read (priv->database_file, &n_table, &error);
+  if (error && journal)
+    g_hash_table_destroy (journal);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
+  /* Journal hashes in table order. */
+  keys = g_new (void *, n_journal);
+  if (journal)
+  {
+    hashes = g_hash_table_get_keys (journal);
+    for (iter = hashes, i = 0; iter; iter = iter->next, i++)
+      keys[i] = iter->data;
+    g_list_free (hashes);
+    qsort (keys, n_journal, sizeof (void *), _compare_hash_cb);
+  }
+
+  /* Header and records go out in a single write. */
+  header = g_malloc0 (sizeof (MplAppLaunchesHeader) +
+                      (n_table + n_journal) * sizeof (MplAppLaunchesRecord));
+  merged = (MplAppLaunchesRecord *) (header + 1);
+  n_merged = 0;
+  i = 0;
+  j = 0;
+  while (i < n_table || j < n_journal)
+  {
+    uint32_t journal_hash = j < n_journal ? GPOINTER_TO_UINT (keys[j]) : 0;
+
+    if (j >= n_journal ||
+        (i < n_table && table[i].hash < journal_hash))
+    {
+      /* Untouched record. */
+      merged[n_merged++] = table[i++];
+
+    } else {
+
+      MplAppLaunchesDelta *delta = g_hash_table_lookup (journal, keys[j]);
+      time_t    last_launched = 0;
+      uint32_t  n_launches = 0;
+
+      if (i < n_table && table[i].hash == journal_hash)
+      {
+        last_launched = table[i].last_launched;
+        n_launches = table[i].n_launches;
+        i++;
+      }
+
+      record_set (&merged[n_merged++],
+                  journal_hash,
+                  MAX (last_launched, delta->last_launched),
+                  n_launches + delta->n_launches);
+      j++;
+    }
+  }
 
-  fd = mkstemp (template);
+  memcpy (header->magic, MPL_APP_LAUNCHES_MAGIC, sizeof (header->magic));
+  header->version = MPL_APP_LAUNCHES_VERSION;
+  header->n_records = n_merged;
+
+  g_free (table);
+  if (journal)
+    g_hash_table_destroy (journal);
+  g_free (keys);
+
+  /* Write next to the database so the rename stays on one file system. */
+  tmp_database_file = g_strdup_printf ("%s.XXXXXX", priv->database_file);
+  fd = mkstemp (tmp_database_file);
   if (-1 == fd)
   {
     if (error_out)
@@ -524,53 +1174,89 @@ store_insert (MplAppLaunchesStore   *self,
                                 MPL_APP_LAUNCHES_STORE_ERROR_OPENING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
-    return NULL;
+    g_free (tmp_database_file);
+    g_free (header);
+    return false;
   }
 
-  n_elements = priv->size / sizeof (MplAppLaunchesRecord);
-  for (i = 0; i < n_elements; i++)
-  {
-    if (hash)
-    {
-      /* Test for insert position. */
-      uint32_t current_hash;
-      record_read (&priv->data[i], &current_hash, NULL, NULL);
-      if (current_hash > hash)
-      {
-        /* Insert new record here. */
-        MplAppLaunchesRecord record = { "00000000", "00000000", "00000000", '\n' };
-        record_update (&record, hash, timestamp);
-        hash = 0;
-        if (!record_write (&record, fd, &error))
-          break;
-      }
-    }
+  ret = write_all (fd, header,
+                   sizeof (MplAppLaunchesHeader) +
+                   n_merged * sizeof (MplAppLaunchesRecord),
+                   &error);
+  g_free (header);
 
-    if (!record_write (&priv->data[i], fd, &error))
-      break;
+  if (-1 == close (fd) && ret)
+  {
+    error = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                         MPL_APP_LAUNCHES_STORE_ERROR_CLOSING_DATABASE,
+                         "%s : %s",
+                         G_STRLOC, strerror (errno));
   }
 
-  if (hash)
+  if (!error && -1 == rename (tmp_database_file, priv->database_file))
   {
-    /* Insert new record at the end. */
-    MplAppLaunchesRecord record = { "00000000", "00000000", "00000000", '\n' };
-    record_update (&record, hash, timestamp);
-    record_write (&record, fd, &error);
+    error = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
+                         MPL_APP_LAUNCHES_STORE_ERROR_WRITING_DATABASE,
+                         "%s : %s",
+                         G_STRLOC, strerror (errno));
   }
 
-  PROPAGATE_ERROR_AND_RETURN_IF_FAIL_WITH_CODE (!error, error, error_out, close (fd));
+  if (error)
+    unlink (tmp_database_file);
+  g_free (tmp_database_file);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
-  if (-1 == close (fd))
+  if (journal_fd > -1 && -1 == ftruncate (journal_fd, 0))
   {
+    /* The table already holds the journalled launches, so they would be
+     * counted twice. Bail out loudly. */
     if (error_out)
       *error_out = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
-                                MPL_APP_LAUNCHES_STORE_ERROR_CLOSING_DATABASE,
+                                MPL_APP_LAUNCHES_STORE_ERROR_WRITING_DATABASE,
                                 "%s : %s",
                                 G_STRLOC, strerror (errno));
-    return NULL;
+    return false;
+  }
+
+  return true;
+}
+
+static bool
+store_compact (MplAppLaunchesStore  *self,
+               bool                  migrate,
+               GError              **error_out)
+{
+  int     journal_fd;
+  bool    ret;
+  GError *error = NULL;
+
+  /* Always create the journal, it is also the lock for migrating. */
+  journal_fd = journal_open (self, migrate, LOCK_EX, &error);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
+  if (-1 == journal_fd)
+  {
+    /* Nothing to do. */
+    return true;
   }
 
-  return g_strdup (template);
+  ret = store_compact_locked (self, journal_fd, migrate, error_out);
+  journal_close (journal_fd);
+
+  return ret;
+}
+
+/*
+ * Merge journalled launches into the database table.
+ * This is private API, adding to the store compacts automatically.
+ */
+bool
+mpl_app_launches_store_compact (MplAppLaunchesStore  *self,
+                                GError              **error_out)
+{
+  g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), false);
+
+  return store_compact (self, false, error_out);
 }
 
 /*
@@ -583,70 +1269,69 @@ mpl_app_launches_store_add (MplAppLaunchesStore  *self,
                             time_t                timestamp,
                             GError              **error_out)
 {
-  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
-  MplAppLaunchesRecord  *record = NULL;
-  uint32_t               hash;
-  GError                *error = NULL;
+  int        journal_fd;
+  size_t     n_records;
+  GError    *error = NULL;
 
   g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), FALSE);
 
-  mpl_app_launches_store_open (self, true, &error);
+  journal_fd = journal_open (self, true, LOCK_EX, &error);
   PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
-  hash = g_str_hash (executable);
-
-  /* Already got a record for this executable? */
-  record = store_lookup_hash (self, hash, &error);
-  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+  n_records = journal_append (journal_fd,
+                              g_str_hash (executable),
+                              timestamp ? timestamp : time (NULL),
+                              &error);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL_WITH_CODE (!error, error, error_out,
+                                                journal_close (journal_fd));
 
-  if (record)
+  if (n_records >= MPL_APP_LAUNCHES_JOURNAL_COMPACT_THRESHOLD)
   {
-    record_update (record, 0, timestamp ? timestamp : time (NULL));
-
-  } else {
-
-    char *tmp_database_file = store_insert (self,
-                                            hash,
-                                            timestamp ? timestamp : time (NULL),
-                                            &error);
-    PROPAGATE_ERROR_AND_RETURN_IF_FAIL_WITH_CODE (tmp_database_file,
-                                                  error,
-                                                  error_out,
-                                                  mpl_app_launches_store_close (self, NULL));
-
-    if (-1 == rename (tmp_database_file, priv->database_file))
-    {
-      error = g_error_new (MPL_APP_LAUNCHES_STORE_ERROR,
-                           MPL_APP_LAUNCHES_STORE_ERROR_WRITING_DATABASE,
-                           "%s : %s",
-                           G_STRLOC, strerror (errno));
-    }
-
-    g_free (tmp_database_file);
+    store_compact_locked (self, journal_fd, false, &error);
   }
 
-  mpl_app_launches_store_close (self, &error);
+  journal_close (journal_fd);
   PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
   return TRUE;
 }
 
+/*
+ * Like mpl_app_launches_store_add(), but compaction, when due, is left to
+ * a helper process so the caller never has to rewrite the table.
+ */
 gboolean
 mpl_app_launches_store_add_async (MplAppLaunchesStore  *self,
                                   char const           *executable,
                                   time_t                timestamp,
-                                  GError              **error)
+                                  GError              **error_out)
 {
-  char  *command_line;
-  gboolean   ret;
+  int        journal_fd;
+  size_t     n_records;
+  gboolean   ret = TRUE;
+  GError    *error = NULL;
+
+  g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), FALSE);
+
+  journal_fd = journal_open (self, true, LOCK_EX, &error);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
-  command_line = g_strdup_printf ("%s --add %s --timestamp %li",
-                                  DAWATI_APP_LAUNCHES_STORE,
-                                  executable,
-                                  timestamp ? timestamp : time (NULL));
+  n_records = journal_append (journal_fd,
+                              g_str_hash (executable),
+                              timestamp ? timestamp : time (NULL),
+                              &error);
+  journal_close (journal_fd);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
-  ret = g_spawn_command_line_async (command_line, error);
-  g_free (command_line);
+  /* Kick compaction when crossing the threshold, and again every so often
+   * should an earlier compaction have failed. */
+  if (n_records % MPL_APP_LAUNCHES_JOURNAL_COMPACT_THRESHOLD == 0)
+  {
+    char *command_line = g_strdup_printf ("%s --compact",
+                                          DAWATI_APP_LAUNCHES_STORE);
+    ret = g_spawn_command_line_async (command_line, error_out);
+    g_free (command_line);
+  }
 
   return ret;
 }
@@ -666,8 +1351,9 @@ mpl_app_launches_store_lookup (MplAppLaunchesStore   *self,
                                uint32_t              *n_launches_out,
                                GError               **error_out)
 {
-  MplAppLaunchesRecord  *record;
+  MplAppLaunchesRecord const *record;
   uint32_t               hash;
+  bool                   ret;
   GError                *error = NULL;
 
   g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), FALSE);
@@ -676,19 +1362,115 @@ mpl_app_launches_store_lookup (MplAppLaunchesStore   *self,
   PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
   hash = g_str_hash (executable);
-  record = store_lookup_hash (self, hash, &error);
-  PROPAGATE_ERROR_AND_RETURN_IF_FAIL_WITH_CODE (!error, error, error_out,
-                                                mpl_app_launches_store_close (self, NULL));
+  record = store_lookup_hash (self, hash);
+  ret = store_merge_journal (self, hash, record,
+                             last_launched_out, n_launches_out);
 
-  if (record)
+  mpl_app_launches_store_close (self, &error);
+  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+
+  return ret;
+}
+
+typedef struct
+{
+  uint32_t  hash;
+  unsigned  index;
+} LookupKey;
+
+static int
+_compare_lookup_key_cb (LookupKey const *a,
+                        LookupKey const *b)
+{
+  return a->hash < b->hash ? -1 : a->hash > b->hash;
+}
+
+/**
+ * mpl_app_launches_store_lookup_many: (skip)
+ *
+ * Look up a batch of executables in a single pass over the database.
+ * Executables that have never been launched get 0 for both outputs.
+ *
+ * Returns: the number of executables found.
+ */
+unsigned
+mpl_app_launches_store_lookup_many (MplAppLaunchesStore   *self,
+                                    char const * const    *executables,
+                                    unsigned               n_executables,
+                                    time_t                *last_launched_out,
+                                    uint32_t              *n_launches_out,
+                                    GError               **error_out)
+{
+  MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
+  LookupKey *keys;
+  size_t     cursor = 0;
+  unsigned   n_found = 0;
+  unsigned   i;
+  GError    *error = NULL;
+
+  g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), 0);
+
+  if (0 == n_executables)
+    return 0;
+
+  mpl_app_launches_store_open (self, false, &error);
+  if (error)
+  {
+    g_critical ("%s\n\t%s", G_STRLOC, error->message);
+    g_propagate_error (error_out, error);
+    return 0;
+  }
+
+  /* Walk the table front to back by visiting the keys in hash order. */
+  keys = g_new (LookupKey, n_executables);
+  for (i = 0; i < n_executables; i++)
+  {
+    keys[i].hash = g_str_hash (executables[i]);
+    keys[i].index = i;
+  }
+  qsort (keys, n_executables, sizeof (LookupKey),
+         (comparison_fn_t) _compare_lookup_key_cb);
+
+  for (i = 0; i < n_executables; i++)
   {
-    record_read (record, NULL, last_launched_out, n_launches_out);
+    MplAppLaunchesRecord const *record = NULL;
+    unsigned index = keys[i].index;
+
+    cursor = table_lower_bound (priv->records, cursor, priv->n_records,
+                                keys[i].hash);
+    if (cursor < priv->n_records && priv->records[cursor].hash == keys[i].hash)
+      record = &priv->records[cursor];
+
+    if (store_merge_journal (self, keys[i].hash, record,
+                             last_launched_out ? &last_launched_out[index] : NULL,
+                             n_launches_out ? &n_launches_out[index] : NULL))
+      n_found++;
   }
 
+  g_free (keys);
+
   mpl_app_launches_store_close (self, &error);
-  PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
+  if (error)
+  {
+    g_critical ("%s\n\t%s", G_STRLOC, error->message);
+    g_propagate_error (error_out, error);
+  }
 
-  return record != NULL;
+  return n_found;
+}
+
+static void
+print_record (uint32_t  hash,
+              time_t    last_launched,
+              uint32_t  n_launches)
+{
+  struct tm last_launched_tm;
+  char last_launched_str[64] = { 0, };
+
+  localtime_r (&last_launched, &last_launched_tm);
+  strftime (last_launched_str, sizeof (last_launched_str),
+            "%Y-%m-%d %H:%M:%S", &last_launched_tm);
+  printf ("%08x\t%s\t%i\n", hash, last_launched_str, n_launches);
 }
 
 /*
@@ -699,8 +1481,7 @@ mpl_app_launches_store_dump (MplAppLaunchesStore   *self,
                              GError               **error_out)
 {
   MplAppLaunchesStorePrivate *priv = GET_PRIVATE (self);
-  unsigned               n_elements;
-  unsigned               i;
+  size_t                 i;
   GError                *error = NULL;
 
   g_return_val_if_fail (MPL_IS_APP_LAUNCHES_STORE (self), FALSE);
@@ -708,21 +1489,30 @@ mpl_app_launches_store_dump (MplAppLaunchesStore   *self,
   mpl_app_launches_store_open (self, false, &error);
   PROPAGATE_ERROR_AND_RETURN_IF_FAIL (!error, error, error_out);
 
-  n_elements = priv->size / sizeof (MplAppLaunchesRecord);
-  for (i = 0; i < n_elements; i++)
+  for (i = 0; i < priv->n_records; i++)
   {
-    uint32_t hash;
     time_t  last_launched;
     uint32_t n_launches;
-    struct tm last_launched_tm;
-    char last_launched_str[64] = { 0, };
 
-    record_read (&priv->data[i], &hash, &last_launched, &n_launches);
+    store_merge_journal (self, priv->records[i].hash, &priv->records[i],
+                         &last_launched, &n_launches);
+    print_record (priv->records[i].hash, last_launched, n_launches);
+  }
 
-    localtime_r (&last_launched, &last_launched_tm);
-    strftime (last_launched_str, sizeof (last_launched_str),
-              "%Y-%m-%d %H:%M:%S", &last_launched_tm);
-    printf ("%08x\t%s\t%i\n", hash, last_launched_str, n_launches);
+  /* Executables only found in the journal. */
+  if (priv->journal)
+  {
+    GHashTableIter       iter;
+    void                *key;
+    MplAppLaunchesDelta *delta;
+
+    g_hash_table_iter_init (&iter, priv->journal);
+    while (g_hash_table_iter_next (&iter, &key, (void **) &delta))
+    {
+      uint32_t hash = GPOINTER_TO_UINT (key);
+      if (NULL == store_lookup_hash (self, hash))
+        print_record (hash, delta->last_launched, delta->n_launches);
+    }
   }
 
   mpl_app_launches_store_close (self, &error);
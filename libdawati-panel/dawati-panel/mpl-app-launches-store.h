@@ -89,6 +89,14 @@ mpl_app_launches_store_lookup (MplAppLaunchesStore   *self,
                                uint32_t              *n_launches_out,
                                GError               **error);
 
+unsigned
+mpl_app_launches_store_lookup_many (MplAppLaunchesStore   *self,
+                                    char const * const    *executables,
+                                    unsigned               n_executables,
+                                    time_t                *last_launched_out,
+                                    uint32_t              *n_launches_out,
+                                    GError               **error);
+
 gboolean
 mpl_app_launches_store_dump (MplAppLaunchesStore   *self,
                              GError               **error);
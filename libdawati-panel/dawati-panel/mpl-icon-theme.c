@@ -40,6 +40,89 @@
 #define FALLBACK_ICON       "applications-other"
 #define FALLBACK_ICON_FILE  "/usr/share/icons/netbook/48x48/categories/applications-other.png"
 
+/* How long a preload may keep the main loop busy in one go. */
+#define PRELOAD_SLICE_US  (5 * 1000)
+
+/*
+ * Resolved icon files, per theme, keyed by size and name. Every lookup
+ * ends up with a file, failed ones with a fallback, so misses are cached
+ * just the same. The cache is emptied when the theme changes, before
+ * anybody else hears about it, and `serial' is bumped.
+ */
+typedef struct
+{
+  GHashTable  *files;       /* "size:name" -> icon file */
+  guint        serial;
+
+  /* Preloading. */
+  GPtrArray   *preload_names;
+  gint         preload_size;
+  guint        preload_index;
+  guint        preload_serial;
+  guint        preload_id;
+  gint64       preload_start;
+} IconCache;
+
+static GQuark icon_cache_quark = 0;
+
+static void
+icon_cache_free (IconCache *cache)
+{
+  if (cache->preload_id)
+    g_source_remove (cache->preload_id);
+  if (cache->preload_names)
+    g_ptr_array_free (cache->preload_names, TRUE);
+  g_hash_table_destroy (cache->files);
+  g_free (cache);
+}
+
+static gboolean
+_theme_changed_hook (GSignalInvocationHint *hint,
+                     guint                  n_param_values,
+                     const GValue          *param_values,
+                     gpointer               data)
+{
+  GObject   *theme = g_value_get_object (&param_values[0]);
+  IconCache *cache = g_object_get_qdata (theme, icon_cache_quark);
+
+  if (cache)
+  {
+    g_hash_table_remove_all (cache->files);
+    cache->serial++;
+  }
+
+  return TRUE;
+}
+
+static IconCache *
+icon_cache_get (GtkIconTheme *theme)
+{
+  IconCache *cache;
+
+  if (G_UNLIKELY (icon_cache_quark == 0))
+  {
+    icon_cache_quark = g_quark_from_static_string ("mpl-icon-cache");
+
+    /* An emission hook runs ahead of all handlers, so they can
+     * not get stale results from us while they react to the change. */
+    g_signal_add_emission_hook (g_signal_lookup ("changed",
+                                                 GTK_TYPE_ICON_THEME),
+                                0, _theme_changed_hook, NULL, NULL);
+  }
+
+  cache = g_object_get_qdata (G_OBJECT (theme), icon_cache_quark);
+  if (NULL == cache)
+  {
+    cache = g_new0 (IconCache, 1);
+    cache->files = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, g_free);
+    g_object_set_qdata_full (G_OBJECT (theme), icon_cache_quark, cache,
+                             (GDestroyNotify) icon_cache_free);
+  }
+
+  return cache;
+}
+
 static guint
 get_n_parts (const gchar *icon_name)
 {
@@ -80,44 +163,14 @@ lookup_in_well_known_places (const gchar  **paths,
   return icon_file;
 }
 
-/**
- * mpl_icon_theme_lookup_icon_file:
- * @theme: #GtkIconTheme
- * @icon_name: name of the icon
- * @icon_size: size of the icon
- *
- * Looks up icon of given name and size in the supplied #GtkIconTheme,
- * prioritizing Dawati-specific icons: if an icon exists that matches 'netbook-'
- * + icon_name, this is returned instead of an icon for the unprefixed name. If
- * the icon_name is an absolute path, no lookup is performed, and a copy of
- * icon_name is returned.
- *
- * Return value: path to the icon, or %NULL if suitable icon was not found in
- * the theme. The returned string must be freed with g_free() when no longer
- * needed.
- */
-gchar *
-mpl_icon_theme_lookup_icon_file (GtkIconTheme *theme,
-                                 const gchar  *icon_name,
-                                 gint          icon_size)
+static gchar *
+resolve_icon_file (GtkIconTheme *theme,
+                   const gchar  *icon_name,
+                   gint          icon_size)
 {
   GIcon *icon = NULL;
   gchar *icon_file = NULL;
 
-  g_return_val_if_fail (theme, NULL);
-
-  if (NULL == icon_name)
-  {
-    icon_name = FALLBACK_ICON;
-  }
-
-  /* Shortcut absolute paths.
-   * Used e.g. in ~/.local installed desktop files. */
-  if (g_path_is_absolute (icon_name))
-  {
-    return g_strdup (icon_name);
-  }
-
   /* Look up with "netbook-" prefix as requested by hbons. */
   if (g_str_has_prefix (icon_name, ICON_PREFIX))
   {
@@ -193,3 +246,149 @@ mpl_icon_theme_lookup_icon_file (GtkIconTheme *theme,
   return icon_file;
 }
 
+static const gchar *
+lookup_icon_file (GtkIconTheme *theme,
+                  IconCache    *cache,
+                  const gchar  *icon_name,
+                  gint          icon_size)
+{
+  gchar *key;
+  gchar *icon_file;
+
+  key = g_strdup_printf ("%d:%s", icon_size, icon_name);
+  icon_file = g_hash_table_lookup (cache->files, key);
+  if (icon_file)
+  {
+    g_free (key);
+    return icon_file;
+  }
+
+  icon_file = resolve_icon_file (theme, icon_name, icon_size);
+  g_hash_table_insert (cache->files, key, icon_file);
+
+  return icon_file;
+}
+
+/**
+ * mpl_icon_theme_lookup_icon_file:
+ * @theme: #GtkIconTheme
+ * @icon_name: name of the icon
+ * @icon_size: size of the icon
+ *
+ * Looks up icon of given name and size in the supplied #GtkIconTheme,
+ * prioritizing Dawati-specific icons: if an icon exists that matches 'netbook-'
+ * + icon_name, this is returned instead of an icon for the unprefixed name. If
+ * the icon_name is an absolute path, no lookup is performed, and a copy of
+ * icon_name is returned.
+ *
+ * Results are cached until the theme changes, so looking up the same icon
+ * again is cheap.
+ *
+ * Return value: path to the icon, or %NULL if suitable icon was not found in
+ * the theme. The returned string must be freed with g_free() when no longer
+ * needed.
+ */
+gchar *
+mpl_icon_theme_lookup_icon_file (GtkIconTheme *theme,
+                                 const gchar  *icon_name,
+                                 gint          icon_size)
+{
+  g_return_val_if_fail (theme, NULL);
+
+  if (NULL == icon_name)
+  {
+    icon_name = FALLBACK_ICON;
+  }
+
+  /* Shortcut absolute paths.
+   * Used e.g. in ~/.local installed desktop files. */
+  if (g_path_is_absolute (icon_name))
+  {
+    return g_strdup (icon_name);
+  }
+
+  return g_strdup (lookup_icon_file (theme,
+                                     icon_cache_get (theme),
+                                     icon_name,
+                                     icon_size));
+}
+
+static gboolean
+_preload_cb (GtkIconTheme *theme)
+{
+  IconCache *cache = icon_cache_get (theme);
+  gint64     start = g_get_monotonic_time ();
+
+  /* Start over if the theme changed under us. */
+  if (cache->preload_serial != cache->serial)
+  {
+    cache->preload_serial = cache->serial;
+    cache->preload_index = 0;
+  }
+
+  while (cache->preload_index < cache->preload_names->len)
+  {
+    const gchar *icon_name =
+      g_ptr_array_index (cache->preload_names, cache->preload_index++);
+
+    lookup_icon_file (theme, cache, icon_name, cache->preload_size);
+
+    if (g_get_monotonic_time () - start > PRELOAD_SLICE_US)
+      return TRUE;
+  }
+
+  g_debug ("%s : Preloaded %u icons in %.3f ms",
+           G_STRLOC,
+           cache->preload_names->len,
+           (g_get_monotonic_time () - cache->preload_start) / 1000.);
+
+  g_ptr_array_free (cache->preload_names, TRUE);
+  cache->preload_names = NULL;
+  cache->preload_id = 0;
+
+  return FALSE;
+}
+
+/**
+ * mpl_icon_theme_preload:
+ * @theme: #GtkIconTheme
+ * @icon_names: %NULL terminated array of icon names
+ * @icon_size: size of the icons
+ *
+ * Resolves the given icons in the background, whenever the main loop is
+ * idle, so that later calls to mpl_icon_theme_lookup_icon_file() for them
+ * are answered from the cache. A preload replaces one still in progress on
+ * the same theme.
+ */
+void
+mpl_icon_theme_preload (GtkIconTheme        *theme,
+                        const gchar * const *icon_names,
+                        gint                 icon_size)
+{
+  IconCache *cache;
+  guint      i;
+
+  g_return_if_fail (theme);
+  g_return_if_fail (icon_names);
+
+  cache = icon_cache_get (theme);
+
+  if (cache->preload_names)
+    g_ptr_array_free (cache->preload_names, TRUE);
+  cache->preload_names = g_ptr_array_new_with_free_func (g_free);
+
+  for (i = 0; icon_names[i]; i++)
+    if (!g_path_is_absolute (icon_names[i]))
+      g_ptr_array_add (cache->preload_names, g_strdup (icon_names[i]));
+
+  cache->preload_size = icon_size;
+  cache->preload_index = 0;
+  cache->preload_serial = cache->serial;
+  cache->preload_start = g_get_monotonic_time ();
+
+  if (0 == cache->preload_id)
+    cache->preload_id = g_idle_add_full (G_PRIORITY_LOW,
+                                         (GSourceFunc) _preload_cb,
+                                         theme, NULL);
+}
+
@@ -31,6 +31,10 @@ gchar * mpl_icon_theme_lookup_icon_file (GtkIconTheme *theme,
                                          const gchar  *icon_name,
                                          gint          icon_size);
 
+void    mpl_icon_theme_preload          (GtkIconTheme        *theme,
+                                         const gchar * const *icon_names,
+                                         gint                 icon_size);
+
 G_END_DECLS
 
 #endif /* MPL_ICON_THEME_H */
@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "mpl-timer.h"
+
+/**
+ * SECTION:mpl-timer
+ * @short_description: Shared, wakeup aligned periodic timers.
+ * @Title: Timers
+ *
+ * Periodic timers for clocks, refreshers and pollers. Instead of every
+ * timer waking the process up on its own schedule, timers fire on
+ * boundaries of the wall clock that are multiples of their interval, so
+ * that timers with the same period -- also across the shell and the panel
+ * processes -- fire together. Each timer also declares how late it may
+ * run (its slack), which lets the service serve everything that has come
+ * due within that window with a single wakeup.
+ *
+ * A timer can be tied to an actor; while the actor is not mapped the
+ * callback is not run, and it is run once as soon as the actor is mapped
+ * again if a tick was missed in the meantime. The timer is removed when
+ * the actor is destroyed.
+ */
+
+/* How often the wakeup statistics are reported */
+#define STATS_INTERVAL (60 * G_USEC_PER_SEC)
+
+typedef struct
+{
+  guint           id;
+  guint           interval; /* ms */
+  guint           slack;    /* ms */
+  gint64          due;      /* monotonic time, us */
+
+  ClutterActor   *actor;
+  gulong          mapped_id;
+  gulong          destroy_id;
+
+  GSourceFunc     function;
+  gpointer        data;
+  GDestroyNotify  notify;
+
+  guint           removed : 1;
+} MplTimer;
+
+typedef struct
+{
+  GHashTable *timers;      /* id -> MplTimer */
+  GList      *graveyard;   /* removed while dispatching */
+  guint       next_id;
+  guint       source_id;
+  gint64      wakeup;      /* monotonic time the source is armed for */
+  gboolean    dispatching;
+
+  gint64      stats_start;
+  guint       n_wakeups;
+  guint       n_callbacks;
+} MplTimerService;
+
+static MplTimerService *service = NULL;
+
+static void schedule (void);
+
+/*
+ * The next multiple of @interval on the wall clock, expressed in monotonic
+ * time; using the wall clock is what makes unrelated processes agree on
+ * the boundaries.
+ */
+static gint64
+next_boundary (guint interval)
+{
+  gint64 real_ms = g_get_real_time () / 1000;
+
+  return g_get_monotonic_time () +
+         (interval - real_ms % interval) * (gint64) 1000;
+}
+
+static gboolean
+timer_is_suspended (MplTimer *timer)
+{
+  return timer->actor && !CLUTTER_ACTOR_IS_MAPPED (timer->actor);
+}
+
+static void
+report_stats (gint64 now)
+{
+  GHashTableIter  iter;
+  gpointer        value;
+  gint64          elapsed = now - service->stats_start;
+  guint           n_suspended = 0;
+
+  if (elapsed < STATS_INTERVAL)
+    return;
+
+  g_hash_table_iter_init (&iter, service->timers);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    if (timer_is_suspended (value))
+      n_suspended++;
+
+  g_debug ("Timers: %.3f wakeups/s, %.3f callbacks/s "
+           "(%u timers, %u suspended)",
+           service->n_wakeups * (gdouble) G_USEC_PER_SEC / elapsed,
+           service->n_callbacks * (gdouble) G_USEC_PER_SEC / elapsed,
+           g_hash_table_size (service->timers),
+           n_suspended);
+
+  service->stats_start = now;
+  service->n_wakeups = 0;
+  service->n_callbacks = 0;
+}
+
+/*
+ * Done as soon as the timer is removed, not when it is freed: a timer
+ * removed while dispatching may outlive its actor.
+ */
+static void
+timer_release_actor (MplTimer *timer)
+{
+  if (timer->actor)
+  {
+    g_signal_handler_disconnect (timer->actor, timer->mapped_id);
+    g_signal_handler_disconnect (timer->actor, timer->destroy_id);
+    timer->actor = NULL;
+  }
+}
+
+static void
+timer_free (MplTimer *timer)
+{
+  if (timer->notify)
+    timer->notify (timer->data);
+
+  g_slice_free (MplTimer, timer);
+}
+
+static gboolean
+dispatch_cb (gpointer data)
+{
+  GList  *timers, *l;
+  gint64  now;
+
+  service->source_id = 0;
+  service->dispatching = TRUE;
+  service->n_wakeups++;
+
+  now = g_get_monotonic_time ();
+
+  /* Callbacks are free to add and remove timers, so work on a snapshot */
+  timers = g_hash_table_get_values (service->timers);
+
+  for (l = timers; l; l = l->next)
+  {
+    MplTimer *timer = l->data;
+
+    /* A suspended timer keeps its expired deadline, which makes it run as
+     * soon as its actor is mapped again. */
+    if (timer->removed || timer->due > now || timer_is_suspended (timer))
+      continue;
+
+    timer->due = next_boundary (timer->interval);
+    service->n_callbacks++;
+
+    if (!timer->function (timer->data) && !timer->removed)
+      mpl_timer_remove (timer->id);
+  }
+
+  g_list_free (timers);
+
+  service->dispatching = FALSE;
+  g_list_foreach (service->graveyard, (GFunc) timer_free, NULL);
+  g_list_free (service->graveyard);
+  service->graveyard = NULL;
+
+  report_stats (now);
+  schedule ();
+
+  return FALSE;
+}
+
+/*
+ * Arms the single source for the latest time that still honours the slack
+ * of every timer, so that all the timers that come due before then are
+ * served by the same wakeup. Suspended timers do not wake us up at all.
+ */
+static void
+schedule (void)
+{
+  GHashTableIter  iter;
+  gpointer        value;
+  gint64          wakeup = G_MAXINT64;
+  gint64          now;
+  guint           delay;
+
+  g_hash_table_iter_init (&iter, service->timers);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+  {
+    MplTimer *timer = value;
+    gint64    deadline;
+
+    if (timer_is_suspended (timer))
+      continue;
+
+    deadline = timer->due + timer->slack * (gint64) 1000;
+    if (deadline < wakeup)
+      wakeup = deadline;
+  }
+
+  if (service->source_id)
+  {
+    if (service->wakeup == wakeup)
+      return;
+
+    g_source_remove (service->source_id);
+    service->source_id = 0;
+  }
+
+  if (wakeup == G_MAXINT64)
+    return;
+
+  now = g_get_monotonic_time ();
+  delay = wakeup > now ? (wakeup - now + 999) / 1000 : 0;
+
+  service->wakeup = wakeup;
+  service->source_id = g_timeout_add (delay, dispatch_cb, NULL);
+}
+
+static void
+actor_mapped_cb (ClutterActor *actor,
+                 GParamSpec   *pspec,
+                 MplTimer     *timer)
+{
+  if (!service->dispatching)
+    schedule ();
+}
+
+static void
+actor_destroy_cb (ClutterActor *actor,
+                  MplTimer     *timer)
+{
+  mpl_timer_remove (timer->id);
+}
+
+/**
+ * mpl_timer_add_full:
+ * @interval: the period of the timer, in milliseconds
+ * @slack: how much later than the boundary the callback may run, in
+ *   milliseconds
+ * @actor: (allow-none): actor whose visibility the timer follows, or %NULL
+ * @function: function to call
+ * @data: data to pass to @function
+ * @notify: (allow-none): function to call when the timer is removed
+ *
+ * Adds a periodic timer. @function is called on every multiple of
+ * @interval on the wall clock, up to @slack milliseconds late, until it
+ * returns %FALSE or the timer is removed with mpl_timer_remove().
+ *
+ * If @actor is given, @function is not called while the actor is
+ * unmapped; a tick that was skipped that way is delivered as soon as the
+ * actor gets mapped. The timer is removed when @actor is destroyed.
+ *
+ * Return value: the id of the timer, greater than 0.
+ */
+guint
+mpl_timer_add_full (guint           interval,
+                    guint           slack,
+                    ClutterActor   *actor,
+                    GSourceFunc     function,
+                    gpointer        data,
+                    GDestroyNotify  notify)
+{
+  MplTimer *timer;
+
+  g_return_val_if_fail (interval > 0, 0);
+  g_return_val_if_fail (function, 0);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), 0);
+
+  if (G_UNLIKELY (service == NULL))
+  {
+    service = g_new0 (MplTimerService, 1);
+    service->timers = g_hash_table_new (NULL, NULL);
+    service->stats_start = g_get_monotonic_time ();
+  }
+
+  timer = g_slice_new0 (MplTimer);
+  timer->id = ++service->next_id;
+  timer->interval = interval;
+  timer->slack = slack;
+  timer->due = next_boundary (interval);
+  timer->function = function;
+  timer->data = data;
+  timer->notify = notify;
+
+  if (actor)
+  {
+    timer->actor = actor;
+    timer->mapped_id = g_signal_connect (actor, "notify::mapped",
+                                         G_CALLBACK (actor_mapped_cb),
+                                         timer);
+    timer->destroy_id = g_signal_connect (actor, "destroy",
+                                          G_CALLBACK (actor_destroy_cb),
+                                          timer);
+  }
+
+  g_hash_table_insert (service->timers, GUINT_TO_POINTER (timer->id), timer);
+
+  if (!service->dispatching)
+    schedule ();
+
+  return timer->id;
+}
+
+/**
+ * mpl_timer_add:
+ * @interval: the period of the timer, in milliseconds
+ * @slack: how much later than the boundary the callback may run, in
+ *   milliseconds
+ * @actor: (allow-none): actor whose visibility the timer follows, or %NULL
+ * @function: function to call
+ * @data: data to pass to @function
+ *
+ * Adds a periodic timer; see mpl_timer_add_full().
+ *
+ * Return value: the id of the timer, greater than 0.
+ */
+guint
+mpl_timer_add (guint         interval,
+               guint         slack,
+               ClutterActor *actor,
+               GSourceFunc   function,
+               gpointer      data)
+{
+  return mpl_timer_add_full (interval, slack, actor, function, data, NULL);
+}
+
+/**
+ * mpl_timer_add_seconds:
+ * @interval: the period of the timer, in seconds
+ * @actor: (allow-none): actor whose visibility the timer follows, or %NULL
+ * @function: function to call
+ * @data: data to pass to @function
+ *
+ * Adds a periodic timer with a granularity of a second, the counterpart of
+ * g_timeout_add_seconds(); the callback may run up to a second late. A
+ * timer with an interval of 60 fires at the start of every minute.
+ *
+ * Return value: the id of the timer, greater than 0.
+ */
+guint
+mpl_timer_add_seconds (guint         interval,
+                       ClutterActor *actor,
+                       GSourceFunc   function,
+                       gpointer      data)
+{
+  return mpl_timer_add_full (interval * 1000, 1000, actor, function, data,
+                             NULL);
+}
+
+/**
+ * mpl_timer_remove:
+ * @id: id of the timer, as returned by mpl_timer_add()
+ *
+ * Removes a timer; it is safe to call this from within the callback of
+ * any timer.
+ */
+void
+mpl_timer_remove (guint id)
+{
+  MplTimer *timer;
+
+  g_return_if_fail (service);
+
+  timer = g_hash_table_lookup (service->timers, GUINT_TO_POINTER (id));
+  g_return_if_fail (timer);
+
+  g_hash_table_remove (service->timers, GUINT_TO_POINTER (id));
+  timer->removed = TRUE;
+  timer_release_actor (timer);
+
+  if (service->dispatching)
+  {
+    service->graveyard = g_list_prepend (service->graveyard, timer);
+  }
+  else
+  {
+    timer_free (timer);
+    schedule ();
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef MPL_TIMER_H
+#define MPL_TIMER_H
+
+#include <glib.h>
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+guint mpl_timer_add      (guint           interval,
+                          guint           slack,
+                          ClutterActor   *actor,
+                          GSourceFunc     function,
+                          gpointer        data);
+
+guint mpl_timer_add_full (guint           interval,
+                          guint           slack,
+                          ClutterActor   *actor,
+                          GSourceFunc     function,
+                          gpointer        data,
+                          GDestroyNotify  notify);
+
+guint mpl_timer_add_seconds (guint        interval,
+                             ClutterActor *actor,
+                             GSourceFunc  function,
+                             gpointer     data);
+
+void  mpl_timer_remove   (guint           id);
+
+G_END_DECLS
+
+#endif /* MPL_TIMER_H */
@@ -21,6 +21,7 @@
 #include <glib/gi18n.h>
 
 #include "mpl-utils.h"
+#include "mpl-utils-priv.h"
 
 /**
  * SECTION:mpl-utils
@@ -30,6 +31,233 @@
  * Miscellaneous utility functions and macros for Panels.
  */
 
+/*
+ * Thumbnail paths are looked up a lot, by the same few callers for the same
+ * few URIs, and every miss costs up to three stat() calls. Results,
+ * including the absence of a thumbnail, are cached process-wide, keyed by
+ * URI. The thumbnail directories are monitored and an entry is dropped as
+ * soon as a file with its checksum appears or goes away.
+ *
+ * Lookups may come from any thread; the monitors are set up by the first
+ * caller and deliver their events to the main loop.
+ */
+
+/* Keep the cache bounded; it is simply emptied when full. */
+#define THUMBNAIL_CACHE_SIZE 1024
+
+/* How often the cache statistics are reported */
+#define STATS_INTERVAL (60 * G_USEC_PER_SEC)
+
+enum
+{
+  THUMBNAIL_DIR_BKL,
+  THUMBNAIL_DIR_LARGE,
+  THUMBNAIL_DIR_NORMAL,
+
+  N_THUMBNAIL_DIRS
+};
+
+typedef struct
+{
+  GMutex        lock;
+  GHashTable   *paths;        /* uri -> path, NULL for no thumbnail */
+  GHashTable   *uris;         /* checksum -> uri, not owned */
+  guint         generation;   /* bumped whenever entries are dropped */
+  gchar        *dirs[N_THUMBNAIL_DIRS];
+  GFileMonitor *monitors[N_THUMBNAIL_DIRS];
+
+  gint64        stats_start;
+  guint         n_lookups;
+  guint         n_hits;
+  guint         n_stats;
+
+  /* Since startup, for tests */
+  guint         total_lookups;
+  guint         total_hits;
+  guint         total_stats;
+} ThumbnailCache;
+
+static ThumbnailCache *thumbnail_cache = NULL;
+
+static void
+thumbnail_cache_report_stats (ThumbnailCache *cache)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 elapsed = now - cache->stats_start;
+
+  if (elapsed < STATS_INTERVAL)
+    return;
+
+  g_debug ("Thumbnail paths: %.3f lookups/s, %.1f%% hits, %.3f stats/s "
+           "(%u cached)",
+           cache->n_lookups * (gdouble) G_USEC_PER_SEC / elapsed,
+           cache->n_lookups ? 100.0 * cache->n_hits / cache->n_lookups : 0,
+           cache->n_stats * (gdouble) G_USEC_PER_SEC / elapsed,
+           g_hash_table_size (cache->paths));
+
+  cache->stats_start = now;
+  cache->total_lookups += cache->n_lookups;
+  cache->total_hits += cache->n_hits;
+  cache->total_stats += cache->n_stats;
+  cache->n_lookups = 0;
+  cache->n_hits = 0;
+  cache->n_stats = 0;
+}
+
+static void
+thumbnail_cache_clear (ThumbnailCache *cache)
+{
+  g_hash_table_remove_all (cache->uris);
+  g_hash_table_remove_all (cache->paths);
+  cache->generation++;
+}
+
+static void
+_thumbnail_dir_changed_cb (GFileMonitor      *monitor,
+                           GFile             *file,
+                           GFile             *other_file,
+                           GFileMonitorEvent  event,
+                           ThumbnailCache    *cache)
+{
+  gchar       *basename;
+  gchar       *csum;
+  const gchar *uri;
+
+  if (event != G_FILE_MONITOR_EVENT_CREATED &&
+      event != G_FILE_MONITOR_EVENT_DELETED &&
+      event != G_FILE_MONITOR_EVENT_MOVED)
+    return;
+
+  g_mutex_lock (&cache->lock);
+
+  basename = g_file_get_basename (file);
+  if (g_str_has_suffix (basename, ".png"))
+    csum = g_strndup (basename, strlen (basename) - strlen (".png"));
+  else
+    csum = g_strdup (basename);
+
+  uri = g_hash_table_lookup (cache->uris, csum);
+  if (uri)
+    {
+      /* Removing the path frees the uri, which is also the key. */
+      g_hash_table_remove (cache->uris, csum);
+      g_hash_table_remove (cache->paths, uri);
+      cache->generation++;
+    }
+  else if (g_str_has_prefix (basename, "."))
+    {
+      /* Temporary files are renamed into place, nothing to do. */
+    }
+  else if (event == G_FILE_MONITOR_EVENT_DELETED &&
+           g_file_equal (file, g_file_monitor_get_file (monitor)))
+    {
+      /* The directory itself went away. */
+      thumbnail_cache_clear (cache);
+    }
+
+  g_free (csum);
+  g_free (basename);
+
+  g_mutex_unlock (&cache->lock);
+}
+
+static ThumbnailCache *
+thumbnail_cache_get (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      ThumbnailCache *cache = g_new0 (ThumbnailCache, 1);
+      guint           i;
+
+      g_mutex_init (&cache->lock);
+      cache->paths = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, g_free);
+      cache->uris = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, NULL);
+      cache->dirs[THUMBNAIL_DIR_BKL] =
+        g_build_filename (g_get_home_dir (), ".bkl-thumbnails", NULL);
+      cache->dirs[THUMBNAIL_DIR_LARGE] =
+        g_build_filename (g_get_home_dir (), ".thumbnails", "large", NULL);
+      cache->dirs[THUMBNAIL_DIR_NORMAL] =
+        g_build_filename (g_get_home_dir (), ".thumbnails", "normal", NULL);
+      cache->stats_start = g_get_monotonic_time ();
+
+      for (i = 0; i < N_THUMBNAIL_DIRS; i++)
+        {
+          GFile  *dir = g_file_new_for_path (cache->dirs[i]);
+          GError *error = NULL;
+
+          cache->monitors[i] = g_file_monitor_directory (dir,
+                                                         G_FILE_MONITOR_NONE,
+                                                         NULL,
+                                                         &error);
+          if (error)
+            {
+              g_warning ("%s : %s", G_STRLOC, error->message);
+              g_clear_error (&error);
+            }
+          else
+            {
+              g_signal_connect (cache->monitors[i], "changed",
+                                G_CALLBACK (_thumbnail_dir_changed_cb),
+                                cache);
+            }
+
+          g_object_unref (dir);
+        }
+
+      thumbnail_cache = cache;
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return thumbnail_cache;
+}
+
+static gchar *
+thumbnail_cache_resolve (ThumbnailCache *cache,
+                         const gchar    *csum,
+                         guint          *n_stats)
+{
+  gchar *thumbnail_path;
+  gchar *thumbnail_filename;
+
+  thumbnail_path = g_build_filename (cache->dirs[THUMBNAIL_DIR_BKL],
+                                     csum,
+                                     NULL);
+
+  (*n_stats)++;
+  if (g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
+    return thumbnail_path;
+
+  g_free (thumbnail_path);
+
+  thumbnail_filename = g_strconcat (csum, ".png", NULL);
+  thumbnail_path = g_build_filename (cache->dirs[THUMBNAIL_DIR_LARGE],
+                                     thumbnail_filename,
+                                     NULL);
+
+  (*n_stats)++;
+  if (!g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
+    {
+      g_free (thumbnail_path);
+      thumbnail_path = g_build_filename (cache->dirs[THUMBNAIL_DIR_NORMAL],
+                                         thumbnail_filename,
+                                         NULL);
+
+      (*n_stats)++;
+      if (!g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
+        {
+          g_free (thumbnail_path);
+          thumbnail_path = NULL;
+        }
+    }
+
+  g_free (thumbnail_filename);
+  return thumbnail_path;
+}
+
 /**
  * mpl_utils_get_thumbnail_path:
  * @uri: image uri
@@ -38,66 +266,180 @@
  * thumbnails are searched for in ~/.bk-thumbnails, ~/thumbnails/large and
  * ~/thumbnails/normal, in that order.
  *
+ * Results are cached and kept up to date by monitoring these directories,
+ * so repeated lookups of the same uri are cheap. This function may be
+ * called from any thread.
+ *
  * Return value: path to the thumbnail, or %NULL if thumbnail does not exist.
  * The retured string must be freed with g_free() when no longer needed.
  */
 gchar *
 mpl_utils_get_thumbnail_path (const gchar *uri)
 {
-  gchar *thumbnail_path;
-  gchar *thumbnail_filename = NULL;
-  gchar *csum;
+  ThumbnailCache *cache;
+  gchar          *thumbnail_path;
+  gchar          *csum;
+  gpointer        cached;
+  guint           generation;
+  guint           n_stats = 0;
+
+  g_return_val_if_fail (uri, NULL);
+
+  cache = thumbnail_cache_get ();
+
+  g_mutex_lock (&cache->lock);
+  cache->n_lookups++;
+  if (g_hash_table_lookup_extended (cache->paths, uri, NULL, &cached))
+    {
+      cache->n_hits++;
+      thumbnail_path = g_strdup (cached);
+      g_mutex_unlock (&cache->lock);
+      return thumbnail_path;
+    }
+  generation = cache->generation;
+  g_mutex_unlock (&cache->lock);
 
+  /* Do the file system work unlocked. */
   csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  thumbnail_path = thumbnail_cache_resolve (cache, csum, &n_stats);
 
-  thumbnail_path = g_build_filename (g_get_home_dir (),
-                                     ".bkl-thumbnails",
-                                     csum,
-                                     NULL);
+  g_mutex_lock (&cache->lock);
+  cache->n_stats += n_stats;
 
-  if (g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
-  {
-    g_free (csum);
-    goto success;
-  }
+  /* Unless a thumbnail came or went in the meantime, which might have
+   * made our result stale, or another thread was quicker. */
+  if (generation == cache->generation &&
+      !g_hash_table_lookup_extended (cache->paths, uri, NULL, NULL))
+    {
+      gchar *key = g_strdup (uri);
 
-  g_free (thumbnail_path);
+      if (g_hash_table_size (cache->paths) >= THUMBNAIL_CACHE_SIZE)
+        thumbnail_cache_clear (cache);
 
-  thumbnail_filename = g_strconcat (csum, ".png", NULL);
-  thumbnail_path = g_build_filename (g_get_home_dir (),
-                                     ".thumbnails",
-                                     "large",
-                                     thumbnail_filename,
-                                     NULL);
+      g_hash_table_insert (cache->paths, key, g_strdup (thumbnail_path));
+      g_hash_table_insert (cache->uris, csum, key);
+      csum = NULL;
+    }
+
+  thumbnail_cache_report_stats (cache);
+  g_mutex_unlock (&cache->lock);
 
   g_free (csum);
+  return thumbnail_path;
+}
 
-  if (g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
-  {
-    goto success;
-  } else {
-    g_free (thumbnail_path);
-    thumbnail_path = g_build_filename (g_get_home_dir (),
-                                       ".thumbnails",
-                                       "normal",
-                                       thumbnail_filename,
-                                       NULL);
-
-    if (g_file_test (thumbnail_path, G_FILE_TEST_EXISTS))
+static void
+_get_thumbnail_paths_thread (GSimpleAsyncResult *result,
+                             GObject            *object,
+                             GCancellable       *cancellable)
+{
+  gchar      **uris = g_simple_async_result_get_op_res_gpointer (result);
+  GHashTable  *paths;
+  guint        i;
+
+  paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  for (i = 0; uris[i]; i++)
     {
-      goto success;
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      g_hash_table_insert (paths,
+                           g_strdup (uris[i]),
+                           mpl_utils_get_thumbnail_path (uris[i]));
     }
-  }
 
-  g_free (thumbnail_filename);
-  g_free (thumbnail_path);
-  return NULL;
+  /* This replaces, and frees, the uris. */
+  g_simple_async_result_set_op_res_gpointer (result, paths,
+                                             (GDestroyNotify)
+                                               g_hash_table_unref);
+}
 
-success:
-  g_free (thumbnail_filename);
-  return thumbnail_path;
+/*
+ * Counts of thumbnail path lookups, cache hits and stat() calls since the
+ * cache was first used; any of the pointers may be %NULL.
+ */
+void
+mpl_utils_get_thumbnail_stats (guint *n_lookups,
+                               guint *n_hits,
+                               guint *n_stats)
+{
+  ThumbnailCache *cache = thumbnail_cache_get ();
+
+  g_mutex_lock (&cache->lock);
+
+  if (n_lookups)
+    *n_lookups = cache->total_lookups + cache->n_lookups;
+  if (n_hits)
+    *n_hits = cache->total_hits + cache->n_hits;
+  if (n_stats)
+    *n_stats = cache->total_stats + cache->n_stats;
+
+  g_mutex_unlock (&cache->lock);
+}
+
+/**
+ * mpl_utils_get_thumbnail_paths_async:
+ * @uris: %NULL terminated array of image uris
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: function to call when the paths have been resolved
+ * @user_data: data to pass to @callback
+ *
+ * Resolves the thumbnail paths of many images at once, in a thread; see
+ * mpl_utils_get_thumbnail_path(). Call mpl_utils_get_thumbnail_paths_finish()
+ * from @callback to get the result.
+ */
+void
+mpl_utils_get_thumbnail_paths_async (const gchar * const *uris,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  GSimpleAsyncResult *result;
+
+  g_return_if_fail (uris);
+
+  /* Have the monitors attached to the main loop rather than the worker. */
+  thumbnail_cache_get ();
+
+  result = g_simple_async_result_new (NULL, callback, user_data,
+                                      mpl_utils_get_thumbnail_paths_async);
+  g_simple_async_result_set_op_res_gpointer (result,
+                                             g_strdupv ((gchar **) uris),
+                                             (GDestroyNotify) g_strfreev);
+  g_simple_async_result_run_in_thread (result,
+                                       _get_thumbnail_paths_thread,
+                                       G_PRIORITY_DEFAULT,
+                                       cancellable);
+  g_object_unref (result);
 }
 
+/**
+ * mpl_utils_get_thumbnail_paths_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes mpl_utils_get_thumbnail_paths_async().
+ *
+ * Return value: (transfer full): a #GHashTable mapping each uri to the path
+ * of its thumbnail, or to %NULL if it has none; uris that were not looked
+ * at because of cancellation are missing. Free with g_hash_table_unref().
+ */
+GHashTable *
+mpl_utils_get_thumbnail_paths_finish (GAsyncResult  *result,
+                                      GError       **error)
+{
+  GSimpleAsyncResult *simple = (GSimpleAsyncResult *) result;
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result, NULL,
+                                  mpl_utils_get_thumbnail_paths_async),
+                        NULL);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  return g_hash_table_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
 
 /**
  * mpl_create_audio_store:
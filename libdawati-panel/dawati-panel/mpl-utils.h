@@ -20,10 +20,19 @@
 #define _MPL_UTILS_H
 
 #include <glib.h>
+#include <gio/gio.h>
 #include <gtk/gtk.h>
 
 gchar *mpl_utils_get_thumbnail_path (const gchar *uri);
 
+void mpl_utils_get_thumbnail_paths_async (const gchar * const *uris,
+                                          GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data);
+
+GHashTable *mpl_utils_get_thumbnail_paths_finish (GAsyncResult  *result,
+                                                  GError       **error);
+
 GtkListStore *mpl_create_audio_store (void);
 
 void mpl_audio_store_set (GtkListStore *store,
@@ -0,0 +1,124 @@
+/*
+ * Microbenchmark for MplAppLaunchesStore: inserts per second and lookup
+ * latency for growing table sizes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+#include <dawati-panel/mpl-app-launches-query.h>
+#include <dawati-panel/mpl-app-launches-store-priv.h>
+
+#define N_LOOKUPS 10000
+
+static void
+bench_table_size (char const *dir,
+                  unsigned    n_apps)
+{
+  MplAppLaunchesStore *store;
+  MplAppLaunchesQuery *query;
+  GTimer    *timer;
+  char      *database_file;
+  char      *journal_file;
+  char       executable[32];
+  char     **executables;
+  double     insert_time;
+  double     lookup_time;
+  double     lookup_many_time;
+  unsigned   n_found = 0;
+  unsigned   i;
+  GError    *error = NULL;
+
+  database_file = g_build_filename (dir, "app-launches", NULL);
+  journal_file = g_strdup_printf ("%s.journal", database_file);
+  store = g_object_new (MPL_TYPE_APP_LAUNCHES_STORE,
+                        "database-file", database_file,
+                        NULL);
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_apps; i++)
+  {
+    g_snprintf (executable, sizeof (executable), "bench-%u", i);
+    if (!mpl_app_launches_store_add (store, executable, 0, &error))
+    {
+      g_critical ("%s : %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+    }
+  }
+  insert_time = g_timer_elapsed (timer, NULL);
+
+  mpl_app_launches_store_compact (store, NULL);
+
+  query = mpl_app_launches_store_create_query (store);
+  g_timer_start (timer);
+  for (i = 0; i < N_LOOKUPS; i++)
+  {
+    g_snprintf (executable, sizeof (executable), "bench-%u", i % (2 * n_apps));
+    if (mpl_app_launches_query_lookup (query, executable, NULL, NULL, NULL))
+      n_found++;
+  }
+  lookup_time = g_timer_elapsed (timer, NULL);
+
+  /* Same keys again, resolved in one batch. */
+  executables = g_new (char *, N_LOOKUPS);
+  for (i = 0; i < N_LOOKUPS; i++)
+    executables[i] = g_strdup_printf ("bench-%u", i % (2 * n_apps));
+
+  g_timer_start (timer);
+  mpl_app_launches_query_lookup_many (query,
+                                      (char const * const *) executables,
+                                      N_LOOKUPS, NULL, NULL, NULL);
+  lookup_many_time = g_timer_elapsed (timer, NULL);
+
+  for (i = 0; i < N_LOOKUPS; i++)
+    g_free (executables[i]);
+  g_free (executables);
+  g_object_unref (query);
+
+  printf ("%8u records\t%10.0f inserts/s\t%8.3f us/lookup\t"
+          "%8.3f us/batched lookup\t(%u hits)\n",
+          n_apps,
+          n_apps / insert_time,
+          lookup_time * 1e6 / N_LOOKUPS,
+          lookup_many_time * 1e6 / N_LOOKUPS,
+          n_found);
+
+  g_timer_destroy (timer);
+  g_object_unref (store);
+  g_unlink (journal_file);
+  g_unlink (database_file);
+  g_free (journal_file);
+  g_free (database_file);
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  unsigned const sizes[] = { 10, 100, 1000, 10000 };
+  char      *dir;
+  unsigned   i;
+
+  g_type_init ();
+
+  dir = g_mkdtemp (g_build_filename (g_get_tmp_dir (),
+                                     "test-app-launches-store-XXXXXX",
+                                     NULL));
+  if (NULL == dir)
+  {
+    g_critical ("%s : Could not create temporary directory", G_STRLOC);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+  {
+    bench_table_size (dir, sizes[i]);
+  }
+
+  g_rmdir (dir);
+  g_free (dir);
+
+  return EXIT_SUCCESS;
+}
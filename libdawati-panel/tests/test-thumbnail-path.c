@@ -0,0 +1,139 @@
+/*
+ * Measures the thumbnail path cache: looks up the same uris over and over,
+ * which used to cost up to three stat() calls each time, then resolves
+ * them all at once in the background, and finally checks that a thumbnail
+ * showing up is noticed.
+ *
+ * Runs against a scratch home directory so nothing of the user's is
+ * touched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <dawati-panel/mpl-utils-priv.h>
+
+#define N_URIS    500
+#define N_PASSES  20
+
+static GMainLoop *loop = NULL;
+
+static void
+_paths_cb (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  GHashTable *paths;
+  GError     *error = NULL;
+
+  paths = mpl_utils_get_thumbnail_paths_finish (result, &error);
+  if (error)
+    {
+      g_critical ("%s", error->message);
+      g_clear_error (&error);
+    }
+  else
+    {
+      printf ("batch: %u uris resolved\n", g_hash_table_size (paths));
+      g_hash_table_unref (paths);
+    }
+
+  g_main_loop_quit (loop);
+}
+
+static gboolean
+_timeout_cb (gpointer data)
+{
+  g_main_loop_quit (loop);
+  return FALSE;
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  gchar   *home;
+  gchar   *thumbnail_dir;
+  gchar   *uris[N_URIS + 1];
+  gchar   *csum;
+  gchar   *thumbnail;
+  gchar   *path;
+  GTimer  *timer;
+  gdouble  cold, warm;
+  guint    n_stats, cold_stats, warm_stats;
+  guint    n_hits, warm_hits;
+  guint    i, pass;
+  gboolean ok;
+
+  g_type_init ();
+
+  home = g_dir_make_tmp ("test-thumbnail-path-XXXXXX", NULL);
+  g_setenv ("HOME", home, TRUE);
+  if (g_strcmp0 (g_get_home_dir (), home) != 0)
+    {
+      g_warning ("Cannot redirect the home directory, not running.");
+      return EXIT_FAILURE;
+    }
+
+  thumbnail_dir = g_build_filename (home, ".thumbnails", "normal", NULL);
+  g_mkdir_with_parents (thumbnail_dir, 0700);
+
+  for (i = 0; i < N_URIS; i++)
+    uris[i] = g_strdup_printf ("file:///tmp/test-thumbnail-path-%u.jpg", i);
+  uris[N_URIS] = NULL;
+
+  /* Cold: every lookup goes to the file system. */
+  timer = g_timer_new ();
+  for (i = 0; i < N_URIS; i++)
+    g_free (mpl_utils_get_thumbnail_path (uris[i]));
+  cold = g_timer_elapsed (timer, NULL);
+  mpl_utils_get_thumbnail_stats (NULL, &n_hits, &cold_stats);
+
+  /* Warm: all from the cache. */
+  g_timer_start (timer);
+  for (pass = 0; pass < N_PASSES; pass++)
+    for (i = 0; i < N_URIS; i++)
+      g_free (mpl_utils_get_thumbnail_path (uris[i]));
+  warm = g_timer_elapsed (timer, NULL) / N_PASSES;
+  mpl_utils_get_thumbnail_stats (NULL, &warm_hits, &n_stats);
+  warm_stats = n_stats - cold_stats;
+  warm_hits -= n_hits;
+
+  printf ("cold: %.0f lookups/s, %u stats (%.1f per lookup, %.0f/s)\n",
+          N_URIS / cold, cold_stats, (gdouble) cold_stats / N_URIS,
+          cold_stats / cold);
+  printf ("warm: %.0f lookups/s, %u stats, %.1f%% hits (%.1fx)\n",
+          N_URIS / warm, warm_stats,
+          100.0 * warm_hits / (N_URIS * N_PASSES), cold / warm);
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  mpl_utils_get_thumbnail_paths_async ((const gchar * const *) uris, NULL,
+                                       _paths_cb, NULL);
+  g_main_loop_run (loop);
+
+  /* A thumbnail appears, and the negative entry must go. */
+  csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uris[0], -1);
+  thumbnail = g_strconcat (csum, ".png", NULL);
+  path = g_build_filename (thumbnail_dir, thumbnail, NULL);
+  g_file_set_contents (path, "", 0, NULL);
+
+  g_timeout_add (500, _timeout_cb, NULL);
+  g_main_loop_run (loop);
+
+  g_free (thumbnail);
+  thumbnail = mpl_utils_get_thumbnail_path (uris[0]);
+  ok = g_strcmp0 (thumbnail, path) == 0;
+  printf ("invalidation: %s\n", ok ? "ok" : "FAILED");
+
+  g_unlink (path);
+  g_rmdir (thumbnail_dir);
+  g_free (path);
+  path = g_path_get_dirname (thumbnail_dir);
+  g_rmdir (path);
+  g_rmdir (home);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
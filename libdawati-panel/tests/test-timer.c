@@ -0,0 +1,74 @@
+/*
+ * Exercises the shared timers: a few timers of different periods and slack
+ * print when they fire, which shows them sharing wakeups; one of them
+ * follows an actor that is hidden every other 5 seconds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <clutter/clutter.h>
+#include <dawati-panel/mpl-timer.h>
+
+#define RUN_TIME 30
+
+static gboolean
+_tick_cb (char const *name)
+{
+  gint64 now = g_get_real_time ();
+
+  printf ("%10.3f %s\n",
+          (now % (60 * G_USEC_PER_SEC)) / (double) G_USEC_PER_SEC,
+          name);
+
+  return TRUE;
+}
+
+static gboolean
+_toggle_cb (ClutterActor *actor)
+{
+  if (CLUTTER_ACTOR_IS_VISIBLE (actor))
+    clutter_actor_hide (actor);
+  else
+    clutter_actor_show (actor);
+
+  printf ("actor %s\n", CLUTTER_ACTOR_IS_MAPPED (actor) ? "mapped" : "hidden");
+
+  return TRUE;
+}
+
+static gboolean
+_quit_cb (gpointer data)
+{
+  clutter_main_quit ();
+  return FALSE;
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  ClutterActor  *stage;
+  ClutterActor  *rect;
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  stage = clutter_stage_get_default ();
+  rect = clutter_rectangle_new ();
+  clutter_actor_set_size (rect, 100, 100);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), rect);
+  clutter_actor_show_all (stage);
+
+  mpl_timer_add (1000, 0, NULL, (GSourceFunc) _tick_cb, "1s");
+  mpl_timer_add (2000, 0, NULL, (GSourceFunc) _tick_cb, "2s");
+  mpl_timer_add (1500, 600, NULL, (GSourceFunc) _tick_cb, "1.5s +0.6s");
+  mpl_timer_add (1000, 0, rect, (GSourceFunc) _tick_cb, "1s on actor");
+  mpl_timer_add_seconds (5, NULL, (GSourceFunc) _toggle_cb, rect);
+
+  g_timeout_add_seconds (RUN_TIME, _quit_cb, NULL);
+
+  clutter_main ();
+
+  return EXIT_SUCCESS;
+}
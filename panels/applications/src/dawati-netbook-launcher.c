@@ -37,6 +37,7 @@
 #include <dawati-panel/mpl-icon-theme.h>
 
 #include <dawati-panel/mpl-app-bookmark-manager.h>
+#include <dawati-panel/mpl-app-launches-query.h>
 #include <dawati-panel/mpl-app-launches-store.h>
 #include <dawati-panel/mpl-content-pane.h>
 #include <dawati-panel/mpl-shared-constants.h>
@@ -44,6 +45,8 @@
 #include "dawati-netbook-launcher.h"
 #include "mnb-launcher-button.h"
 #include "mnb-launcher-grid.h"
+#include "mnb-launcher-icon-loader.h"
+#include "mnb-launcher-index.h"
 #include "mnb-launcher-tree.h"
 #include "mnb-launcher-running.h"
 
@@ -100,6 +103,17 @@ static guint _signals[LAST_SIGNAL] = { 0, };
 
 G_DEFINE_TYPE (MnbLauncher, mnb_launcher, MX_TYPE_BOX_LAYOUT);
 
+/*
+ * Backing data for the apps grid, which only has buttons for what is in view.
+ */
+typedef struct
+{
+  MnbLauncherApplication  *app;
+  gchar                   *category;
+} MnbLauncherItem;
+
+#define ITEM(priv, id) (&g_array_index ((priv)->items, MnbLauncherItem, (id)))
+
 /*
  * Helper struct that contains all the info needed to switch between
  * browser- and filter-mode.
@@ -112,7 +126,9 @@ struct MnbLauncherPrivate_
   MplAppLaunchesStore     *app_launches;
   MnbLauncherMonitor      *monitor;
   GHashTable              *categories;
-  GSList                  *launchers;
+  /* MnbLauncherItem, alphabetically, the index is the item id. */
+  GArray                  *items;
+  MnbLauncherIconLoader   *icon_loader;
   GList                   *bookmarks_list;
   MnbLauncherRunning      *running;
 
@@ -134,6 +150,11 @@ struct MnbLauncherPrivate_
   guint                    timeout_id;
   char                    *lcase_needle;
 
+  /* Search index, over item ids. */
+  MnbLauncherIndex        *index;
+  guint32                 *n_launches;
+  gboolean                 n_launches_dirty;
+
   /* During incremental fill. */
   MnbLauncherTree         *tree;
   GList                   *directories;
@@ -146,6 +167,7 @@ struct MnbLauncherPrivate_
 static void mnb_launcher_monitor_cb        (MnbLauncherMonitor *monitor,
                                              MnbLauncher        *self);
 static void mnb_launcher_fill (MnbLauncher  *self);
+static void mnb_launcher_show_favourites (MnbLauncher *self, gboolean show);
 
 static gboolean
 launcher_button_set_reactive_cb (ClutterActor *launcher)
@@ -186,127 +208,167 @@ launcher_button_fav_toggled_cb (MnbLauncherButton  *launcher,
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
   gchar   *uri = NULL;
-  GError  *error = NULL;
-  gboolean fav_category_active = FALSE;
+  gboolean is_favorite;
   MxButton *active_category;
+  guint    id;
+
+  id = mnb_launcher_grid_get_item_for_actor (MNB_LAUNCHER_GRID (priv->apps_grid),
+                                             CLUTTER_ACTOR (launcher));
+  if (id == MNB_LAUNCHER_GRID_NO_ITEM)
+    return;
+
+  is_favorite = mnb_launcher_button_get_favorite (launcher);
+  mnb_launcher_application_set_bookmarked (ITEM (priv, id)->app, is_favorite);
+
+  /* Update bookmarks. */
+  uri = g_strdup_printf ("file://%s",
+                         mnb_launcher_button_get_desktop_file_path (launcher));
+  if (is_favorite)
+    mpl_app_bookmark_manager_add_uri (priv->manager, uri);
+  else
+    mpl_app_bookmark_manager_remove_uri (priv->manager, uri);
+
+  g_free (uri);
+  mpl_app_bookmark_manager_save (priv->manager);
 
-  /* If the favourites category is active make sure we update the visibility
-   * of the buttons accordingly. All othertimes they are visible regardless of
+  /* If the favourites category is active update the shown items
+   * accordingly. All othertimes they are shown regardless of
    * favourited status.
    */
-
   active_category = mx_button_group_get_active_button (priv->category_group);
 
   if (active_category &&
      g_strcmp0 (mx_button_get_label (MX_BUTTON (active_category)), "fav") == 0)
-    fav_category_active = TRUE;
+    mnb_launcher_show_favourites (self, TRUE);
+}
 
-  if (mnb_launcher_button_get_favorite (launcher))
-    {
-      if (fav_category_active)
-        clutter_actor_show (CLUTTER_ACTOR (launcher));
+static gint
+_is_launcher_bookmarked (gconstpointer a, gconstpointer b)
+{
+  return g_strcmp0 (g_filename_from_uri (a, NULL, NULL), b);
+}
 
-      /* Update bookmarks. */
-      uri = g_strdup_printf ("file://%s",
-                          mnb_launcher_button_get_desktop_file_path (launcher));
-      mpl_app_bookmark_manager_add_uri (priv->manager, uri);
-    }
-  else
-    {
-      if (fav_category_active)
-        {
-          clutter_actor_hide (CLUTTER_ACTOR (launcher));
-        }
+static ClutterActor *
+_apps_grid_create_button_cb (MnbLauncherGrid *grid,
+                             MnbLauncher     *self)
+{
+  ClutterActor *button;
 
-      /* Update bookmarks. */
-      uri = g_strdup_printf ("file://%s",
-                          mnb_launcher_button_get_desktop_file_path (launcher));
-      mpl_app_bookmark_manager_remove_uri (priv->manager, uri);
-    }
+  button = g_object_new (MNB_TYPE_LAUNCHER_BUTTON, NULL);
+  clutter_actor_set_size (button,
+                          DAWATI_CONTENT_TILE_WIDTH,
+                          DAWATI_CONTENT_TILE_HEIGHT);
 
-  if (error)
-    {
-      g_warning ("%s", error->message);
-      g_clear_error (&error);
-    }
+  g_signal_connect (button, "activated",
+                    G_CALLBACK (launcher_button_activated_cb),
+                    self);
+  g_signal_connect (button, "fav-toggled",
+                    G_CALLBACK (launcher_button_fav_toggled_cb),
+                    self);
 
-  g_free (uri);
-  mpl_app_bookmark_manager_save (priv->manager);
+  return button;
 }
 
 static void
-launcher_button_reload_icon_cb (ClutterActor  *launcher,
-                                GtkIconTheme  *theme)
+_apps_grid_bind_button_cb (MnbLauncherGrid *grid,
+                           ClutterActor    *actor,
+                           guint            id,
+                           MnbLauncher     *self)
 {
-  if (!MNB_IS_LAUNCHER_BUTTON (launcher))
-    return;
-
-  const gchar *icon_name = mnb_launcher_button_get_icon_name (MNB_LAUNCHER_BUTTON (launcher));
-  gchar *icon_file;
-
-  icon_file = mpl_icon_theme_lookup_icon_file (theme,
+  MnbLauncherPrivate     *priv = GET_PRIVATE (self);
+  MnbLauncherButton      *button = MNB_LAUNCHER_BUTTON (actor);
+  MnbLauncherApplication *app = ITEM (priv, id)->app;
+  const gchar            *icon_name;
+  gchar                  *icon_file;
+  CoglHandle              texture = COGL_INVALID_HANDLE;
+
+  icon_name = mnb_launcher_application_get_icon (app);
+  mnb_launcher_button_update (button,
+                              icon_name,
+                              mnb_launcher_application_get_name (app),
+                              ITEM (priv, id)->category,
+                              mnb_launcher_application_get_description (app),
+                              mnb_launcher_application_get_executable (app),
+                              mnb_launcher_application_get_desktop_file (app));
+
+  g_signal_handlers_block_by_func (button, launcher_button_fav_toggled_cb, self);
+  mnb_launcher_button_set_favorite (button,
+                                    mnb_launcher_application_get_bookmarked (app));
+  g_signal_handlers_unblock_by_func (button, launcher_button_fav_toggled_cb, self);
+
+  /* Icons are decoded in the background, we get rebound once they are in. */
+  icon_file = mpl_icon_theme_lookup_icon_file (priv->theme,
                                                icon_name,
                                                LAUNCHER_BUTTON_ICON_SIZE);
-
-  mnb_launcher_button_set_icon (MNB_LAUNCHER_BUTTON (launcher),
-                                icon_file,
-                                LAUNCHER_BUTTON_ICON_TARGET_SIZE);
+  if (icon_file)
+    texture = mnb_launcher_icon_loader_lookup (priv->icon_loader, icon_file);
+  mnb_launcher_button_set_icon_texture (button,
+                                        texture,
+                                        LAUNCHER_BUTTON_ICON_TARGET_SIZE);
   g_free (icon_file);
+}
+
+static void
+_icons_loaded_cb (MnbLauncherIconLoader *loader,
+                  MnbLauncher           *self)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
 
+  if (priv->apps_grid)
+    mnb_launcher_grid_rebind (MNB_LAUNCHER_GRID (priv->apps_grid));
 }
 
 static gint
-_is_launcher_bookmarked (gconstpointer a, gconstpointer b)
+_compare_items (MnbLauncherItem const *a,
+                MnbLauncherItem const *b)
 {
-  return g_strcmp0 (g_filename_from_uri (a, NULL, NULL), b);
+  return g_utf8_collate (mnb_launcher_application_get_name (a->app),
+                         mnb_launcher_application_get_name (b->app));
 }
 
-static MxWidget *
-launcher_button_create_from_entry (MnbLauncherApplication *entry,
-                                   const gchar            *category,
-                                   GtkIconTheme           *theme,
-                                   MnbLauncher            *self)
+static void
+mnb_launcher_free_items (MnbLauncher *self)
 {
-  const gchar *generic_name, *description, *exec, *icon_name, *desktop_file;
-  gchar *icon_file;
-  MxWidget  *button;
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
+  guint i;
 
-  description = NULL;
-  exec = NULL;
-  icon_name = NULL;
-  button = NULL;
-
-  generic_name = mnb_launcher_application_get_name (entry);
-  exec = mnb_launcher_application_get_executable (entry);
-  description = mnb_launcher_application_get_description (entry);
-  icon_name = mnb_launcher_application_get_icon (entry);
-  icon_file = mpl_icon_theme_lookup_icon_file (theme, icon_name, LAUNCHER_BUTTON_ICON_SIZE);
+  if (priv->items == NULL)
+    return;
 
-  if (generic_name && exec && icon_file)
+  for (i = 0; i < priv->items->len; i++)
     {
-      desktop_file = mnb_launcher_application_get_desktop_file (entry);
-
-      button = mnb_launcher_button_new (icon_name, icon_file,
-                                        LAUNCHER_BUTTON_ICON_TARGET_SIZE,
-                                        generic_name, category,
-                                        description, exec,
-                                        desktop_file);
-
-      if (g_list_find_custom (priv->bookmarks_list,
-                               desktop_file,
-                               (GCompareFunc)_is_launcher_bookmarked))
-        {
-          mnb_launcher_button_set_favorite (MNB_LAUNCHER_BUTTON (button), TRUE);        }
-
-      clutter_actor_set_size (CLUTTER_ACTOR (button),
-                              DAWATI_CONTENT_TILE_WIDTH,
-                              DAWATI_CONTENT_TILE_HEIGHT);
+      g_object_unref (ITEM (priv, i)->app);
+      g_free (ITEM (priv, i)->category);
     }
 
-  g_free (icon_file);
+  g_array_free (priv->items, TRUE);
+  priv->items = NULL;
+}
 
-  return button;
+/*
+ * Show the items `filter' accepts, all if NULL, in alphabetical order.
+ */
+typedef gboolean (*MnbLauncherItemFilter) (MnbLauncherItem *item,
+                                           gpointer         data);
+
+static void
+mnb_launcher_show_items (MnbLauncher           *self,
+                         MnbLauncherItemFilter  filter,
+                         gpointer               data)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
+  GArray *ids;
+  guint   i;
+
+  ids = g_array_sized_new (FALSE, FALSE, sizeof (guint), priv->items->len);
+  for (i = 0; i < priv->items->len; i++)
+    if (filter == NULL || filter (ITEM (priv, i), data))
+      g_array_append_val (ids, i);
+
+  mnb_launcher_grid_set_items (MNB_LAUNCHER_GRID (priv->apps_grid),
+                               (guint const *) ids->data,
+                               ids->len);
+  g_array_free (ids, TRUE);
 }
 
 static void
@@ -355,12 +417,17 @@ mnb_launcher_reset (MnbLauncher     *self)
       priv->categories = NULL;
     }
 
-  if (priv->launchers)
+  mnb_launcher_free_items (self);
+
+  if (priv->index)
     {
-      g_slist_free (priv->launchers);
-      priv->launchers = NULL;
+      mnb_launcher_index_free (priv->index);
+      priv->index = NULL;
     }
 
+  g_free (priv->n_launches);
+  priv->n_launches = NULL;
+
   /* Shut down monitoring */
   if (priv->monitor)
     {
@@ -369,13 +436,107 @@ mnb_launcher_reset (MnbLauncher     *self)
     }
 }
 
+static void
+mnb_launcher_update_launch_counts (MnbLauncher *self)
+{
+  MnbLauncherPrivate  *priv = GET_PRIVATE (self);
+  MplAppLaunchesQuery *query;
+  const gchar        **executables;
+  guint32             *n_launches;
+  guint                n_items;
+  guint                i;
+  GError              *error = NULL;
+
+  priv->n_launches_dirty = FALSE;
+
+  n_items = priv->items ? priv->items->len : 0;
+  if (n_items == 0)
+    return;
+
+  /* Launches are recorded under the executable as found in the desktop
+   * file, which may or may not be an absolute path. Look up both. */
+  executables = g_new (const gchar *, 2 * n_items);
+  for (i = 0; i < n_items; i++)
+    {
+      MnbLauncherApplication *app = ITEM (priv, i)->app;
+      const gchar *executable = mnb_launcher_application_get_executable (app);
+      const gchar *basename = strrchr (executable, '/');
+
+      executables[i] = executable;
+      executables[n_items + i] = basename ? basename + 1 : executable;
+    }
+
+  n_launches = g_new0 (guint32, 2 * n_items);
+  query = mpl_app_launches_store_create_query (priv->app_launches);
+  mpl_app_launches_query_lookup_many (query,
+                                      (const gchar * const *) executables,
+                                      2 * n_items,
+                                      NULL,
+                                      n_launches,
+                                      &error);
+  g_object_unref (query);
+
+  if (error)
+    {
+      g_warning ("%s : %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+    }
+
+  g_free (priv->n_launches);
+  priv->n_launches = g_new (guint32, n_items);
+  for (i = 0; i < n_items; i++)
+    {
+      if (g_strcmp0 (executables[i], executables[n_items + i]) == 0)
+        priv->n_launches[i] = n_launches[i];
+      else
+        priv->n_launches[i] = n_launches[i] + n_launches[n_items + i];
+    }
+
+  g_free (n_launches);
+  g_free (executables);
+}
+
+static gint
+_compare_by_launches (guint const *a,
+                      guint const *b,
+                      guint32     *n_launches)
+{
+  /* Most launched first, alphabetical (that is by id) otherwise. */
+  if (n_launches[*a] != n_launches[*b])
+    return n_launches[*a] > n_launches[*b] ? -1 : 1;
+
+  return *a < *b ? -1 : *a > *b;
+}
+
+/*
+ * Show the items in `results' (sorted by id), most launched first.
+ * Takes ownership of `results'.
+ */
+static void
+mnb_launcher_show_results (MnbLauncher *self,
+                           GArray      *results)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
+
+  if (priv->n_launches_dirty)
+    mnb_launcher_update_launch_counts (self);
+
+  if (priv->n_launches)
+    g_array_sort_with_data (results,
+                            (GCompareDataFunc) _compare_by_launches,
+                            priv->n_launches);
+
+  mnb_launcher_grid_set_items (MNB_LAUNCHER_GRID (priv->apps_grid),
+                               (guint const *) results->data,
+                               results->len);
+  g_array_free (results, TRUE);
+}
+
 static gboolean
 mnb_launcher_filter_cb (MnbLauncher *self)
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
 
-  GSList *iter;
-
   if (priv->lcase_needle)
     {
       /* Need to switch to filter mode? */
@@ -389,20 +550,10 @@ mnb_launcher_filter_cb (MnbLauncher *self)
         }
 
       /* Perform search. */
-
-      for (iter = priv->launchers; iter; iter = iter->next)
-        {
-          MnbLauncherButton *button = MNB_LAUNCHER_BUTTON (iter->data);
-          if (mnb_launcher_button_match (button, priv->lcase_needle))
-            {
-              clutter_actor_show (CLUTTER_ACTOR (button));
-            }
-          else
-            {
-              clutter_actor_hide (CLUTTER_ACTOR (button));
-              mx_stylable_set_style_pseudo_class (MX_STYLABLE (button), NULL);
-            }
-        }
+      if (priv->index)
+        mnb_launcher_show_results (self,
+                                   mnb_launcher_index_lookup (priv->index,
+                                                              priv->lcase_needle));
 
       g_free (priv->lcase_needle);
       priv->lcase_needle = NULL;
@@ -414,11 +565,8 @@ mnb_launcher_filter_cb (MnbLauncher *self)
       /* Did filter, now switch back to normal mode */
       priv->is_filtering = FALSE;
 
-      for (iter = priv->launchers; iter; iter = iter->next)
-        {
-          ClutterActor *launcher = CLUTTER_ACTOR (iter->data);
-          clutter_actor_show (launcher);
-        }
+      /* Everything, in alphabetical order. */
+      mnb_launcher_show_items (self, NULL, NULL);
     }
 
   return FALSE;
@@ -449,71 +597,54 @@ _filter_text_notify_cb (MxEntry     *filter,
   g_free (needle);
 }
 
+static gboolean
+_item_is_bookmarked (MnbLauncherItem *item,
+                     gpointer         data)
+{
+  return mnb_launcher_application_get_bookmarked (item->app);
+}
+
 static void
 mnb_launcher_show_favourites (MnbLauncher *self, gboolean show)
 {
-  MnbLauncherPrivate *priv = GET_PRIVATE (self);
-  GSList *iter = NULL;
-
   /* Hide non favourites */
+  mnb_launcher_show_items (self, show ? _item_is_bookmarked : NULL, NULL);
+}
 
-  for (iter = priv->launchers; iter; iter = iter->next)
-    {
-      MnbLauncherButton *button = MNB_LAUNCHER_BUTTON (iter->data);
-      if (!mnb_launcher_button_get_favorite (button) && show)
-        {
-          clutter_actor_hide (CLUTTER_ACTOR (button));
-        }
-      else
-        {
-          clutter_actor_show (CLUTTER_ACTOR (button));
-        }
-    }
+static gboolean
+_item_is_running (MnbLauncherItem *item,
+                  GList           *current)
+{
+  gchar   *desktop_file;
+  gboolean found;
+
+  desktop_file = g_filename_display_basename (
+                    mnb_launcher_application_get_desktop_file (item->app));
+  found = g_list_find_custom (current,
+                              desktop_file,
+                              (GCompareFunc) g_strcmp0) != NULL;
+  g_free (desktop_file);
+
+  return found;
 }
 
 static void
 mnb_launcher_show_running (MnbLauncher *self, gboolean show)
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
-  GSList *iter = NULL;
-  GList *current_iter, *current = NULL;
-
-  /* Hide non current */
-  current = mnb_launcher_running_get_running (priv->running);
+  GList *current;
 
-  for (iter = priv->launchers; iter; iter = iter->next)
+  if (!show)
     {
-      if (show)
-        {
-          MnbLauncherButton *button = MNB_LAUNCHER_BUTTON (iter->data);
-          const gchar *desktop_file_path;
-          gchar *desktop_file;
-          gboolean found = FALSE;
-
-          desktop_file_path =
-            mnb_launcher_button_get_desktop_file_path (button);
-
-          desktop_file = g_filename_display_basename (desktop_file_path);
-
-          for (current_iter = current; current_iter; current_iter = current_iter->next)
-            {
-              if (g_strcmp0 (desktop_file, (gchar *)current_iter->data) == 0)
-                found = TRUE;
-            }
-
-          g_free (desktop_file);
-
-          if (found == TRUE)
-            clutter_actor_show (CLUTTER_ACTOR (button));
-          else
-            clutter_actor_hide (CLUTTER_ACTOR (button));
-        }
-      else
-        {
-          clutter_actor_show (CLUTTER_ACTOR (iter->data));
-        }
+      mnb_launcher_show_items (self, NULL, NULL);
+      return;
     }
 
+  /* Hide non current */
+  current = mnb_launcher_running_get_running (priv->running);
+  mnb_launcher_show_items (self,
+                           (MnbLauncherItemFilter) _item_is_running,
+                           current);
   g_list_free (current);
 }
 
@@ -538,118 +669,73 @@ _running_changed_cb (MnbLauncherRunning *running,
 
 #ifdef WITH_ZEITGEIST
 static gint
-mnb_launcher_sort_via_zg (gconstpointer *self_pointer,
-                          gconstpointer *other_pointer,
-                          gpointer      *user_data)
+_compare_by_rank (guint const *a,
+                  guint const *b,
+                  guint       *ranks)
 {
-  gint i;
-  gint             index_a = -1;
-  gint             index_b = -1;
-  gint              result = -1;
-  GList              *apps = (GList*) user_data;
-  MnbLauncherButton *self  = MNB_LAUNCHER_BUTTON (self_pointer);
-  MnbLauncherButton *other = MNB_LAUNCHER_BUTTON (other_pointer);
-  const gchar *file_path_a = mnb_launcher_button_get_desktop_file_path (self);
-  const gchar *file_path_b = mnb_launcher_button_get_desktop_file_path (other);
-  gchar            *exec_a = g_path_get_basename (file_path_a);
-  gchar            *exec_b = g_path_get_basename (file_path_b);
-  const gint   apps_length = g_list_length (apps);
-
-  for (i = 0; i < apps_length; i++)
-    {
-      /* Try to find the index of exec_a and exec_b in apps and jump out of
-       * the loop once both are set */
-      if (g_strcmp0 (exec_a, g_list_nth_data (apps, i)) == 0)
-        index_a = i;
-      else if (g_strcmp0 (exec_b, g_list_nth_data (apps, i)) == 0)
-        index_b = i;
-      if (index_a > -1 && index_b > -1)
-        {
-          result = index_a - index_b;
-          break;
-        }
-    }
-
-  if (index_a == -1)
-    result = -1;
-  if (index_b == -1)
-    result = 1;
-
-  g_free (exec_a);
-  g_free (exec_b);
-
-  return result;
+  return ranks[*a] < ranks[*b] ? -1 : ranks[*a] > ranks[*b];
 }
 
 static void
 mnb_launcher_show_zg_category_cb (GList *apps, gpointer user_data)
 {
-  GSList *iter;
-  gchar *exec;
   MnbLauncher *self = (MnbLauncher*) user_data;
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
-  priv->launchers = g_slist_sort_with_data(priv->launchers,
-                                  (GCompareDataFunc) mnb_launcher_sort_via_zg,
-                                  apps);
+  GHashTable *ranks_by_exec;
+  GList      *iter;
+  GArray     *ids;
+  guint      *ranks;
+  guint       rank = 0;
+  guint       i;
+
+  if (priv->items == NULL)
+    return;
 
-  for (iter = priv->launchers; iter; iter = iter->next)
-    {
-      /* Referencing the button since clutter_container takes over ownership */
-      MnbLauncherButton *button = MNB_LAUNCHER_BUTTON (iter->data);
+  /* Show used apps only, in the order zeitgeist returned them. */
+  ranks_by_exec = g_hash_table_new (g_str_hash, g_str_equal);
+  for (iter = apps; iter; iter = iter->next)
+    if (!g_hash_table_lookup (ranks_by_exec, iter->data))
+      g_hash_table_insert (ranks_by_exec, iter->data, GUINT_TO_POINTER (++rank));
 
-      /* Remove button from grid and append to the end of it */
-      exec = g_path_get_basename (mnb_launcher_button_get_desktop_file_path (button));
-      if (g_list_find_custom (apps, exec, (GCompareFunc) g_strcmp0) != NULL)
-        {
-          g_object_ref (button);
-          clutter_container_remove_actor (CLUTTER_CONTAINER (priv->apps_grid),
-                                      CLUTTER_ACTOR (button));
-          clutter_container_add_actor (CLUTTER_CONTAINER (priv->apps_grid),
-                                   CLUTTER_ACTOR (button));
-          clutter_actor_show (CLUTTER_ACTOR (button));
-          g_object_unref (button);
-        }
-      else
-        clutter_actor_hide (CLUTTER_ACTOR (button));
-      g_free(exec);
+  ids = g_array_new (FALSE, FALSE, sizeof (guint));
+  ranks = g_new0 (guint, priv->items->len);
+  for (i = 0; i < priv->items->len; i++)
+    {
+      gchar *exec;
+
+      exec = g_path_get_basename (
+                mnb_launcher_application_get_desktop_file (ITEM (priv, i)->app));
+      ranks[i] = GPOINTER_TO_UINT (g_hash_table_lookup (ranks_by_exec, exec));
+      if (ranks[i])
+        g_array_append_val (ids, i);
+      g_free (exec);
     }
+
+  g_array_sort_with_data (ids, (GCompareDataFunc) _compare_by_rank, ranks);
+  mnb_launcher_grid_set_items (MNB_LAUNCHER_GRID (priv->apps_grid),
+                               (guint const *) ids->data,
+                               ids->len);
+
+  g_array_free (ids, TRUE);
+  g_free (ranks);
+  g_hash_table_destroy (ranks_by_exec);
 }
 
 static void
 mnb_launcher_show_zg_category (MnbLauncher *self, gboolean show, const gchar *category)
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
-  GSList *iter = NULL;
 
   if (show)
     {
-      for (iter = priv->launchers; iter; iter = iter->next)
-        {
-          MnbLauncherButton *button = MNB_LAUNCHER_BUTTON (iter->data);
-          clutter_actor_hide (CLUTTER_ACTOR (button));
-        }
+      /* Nothing until zeitgeist answers. */
+      mnb_launcher_grid_set_items (MNB_LAUNCHER_GRID (priv->apps_grid), NULL, 0);
       mnb_launcher_zg_utils_get_used_apps(mnb_launcher_show_zg_category_cb, self, category);
     }
   else
     {
       /* Sort Alphabetically */
-      priv->launchers = g_slist_sort (priv->launchers,
-                                  (GCompareFunc) mnb_launcher_button_compare);
-
-      for (iter = priv->launchers; iter; iter = iter->next)
-        {
-          /* Referencing the button since clutter_container takes over ownership */
-          MnbLauncherButton *button = g_object_ref (MNB_LAUNCHER_BUTTON (iter->data));
-
-          /* Remove button from grid and append to the end of it */
-          clutter_container_remove_actor (CLUTTER_CONTAINER (priv->apps_grid),
-                                          CLUTTER_ACTOR (button));
-          clutter_container_add_actor (CLUTTER_CONTAINER (priv->apps_grid),
-                                       CLUTTER_ACTOR (button));
-          clutter_actor_show (CLUTTER_ACTOR (button));
-
-          g_object_unref (button);
-        }
+      mnb_launcher_show_items (self, NULL, NULL);
     }
 }
 #endif /* WITH_ZEITGEIST */
@@ -798,6 +884,59 @@ mnb_launcher_category_button_new (MnbLauncher *self, const gchar *text)
   return box;
 }
 
+static void
+mnb_launcher_build_index (MnbLauncher *self)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
+  guint i;
+
+  priv->index = mnb_launcher_index_new ();
+
+  /* Ids follow alphabetical order, so sorted results are too. */
+  for (i = 0; i < priv->items->len; i++)
+    {
+      MnbLauncherApplication *app = ITEM (priv, i)->app;
+      const gchar *keys[5];
+      guint        n_keys = 0;
+
+      keys[n_keys++] = ITEM (priv, i)->category;
+      keys[n_keys++] = mnb_launcher_application_get_name (app);
+      if (mnb_launcher_application_get_description (app))
+        keys[n_keys++] = mnb_launcher_application_get_description (app);
+      keys[n_keys++] = mnb_launcher_application_get_executable (app);
+      keys[n_keys] = NULL;
+
+      mnb_launcher_index_add (priv->index, keys);
+    }
+
+  mnb_launcher_update_launch_counts (self);
+}
+
+/*
+ * Have all icons resolved while we are idle, rather than row by row as
+ * the grid is scrolled.
+ */
+static void
+mnb_launcher_preload_icons (MnbLauncher *self)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
+  const gchar       **icon_names;
+  guint               i, n = 0;
+
+  icon_names = g_new0 (const gchar *, priv->items->len + 1);
+  for (i = 0; i < priv->items->len; i++)
+    {
+      const gchar *icon_name =
+        mnb_launcher_application_get_icon (ITEM (priv, i)->app);
+
+      if (icon_name)
+        icon_names[n++] = icon_name;
+    }
+
+  mpl_icon_theme_preload (priv->theme, icon_names, LAUNCHER_BUTTON_ICON_SIZE);
+  g_free (icon_names);
+}
+
 static gboolean
 mnb_launcher_fill_category (MnbLauncher     *self)
 {
@@ -809,9 +948,16 @@ mnb_launcher_fill_category (MnbLauncher     *self)
 
   if (priv->tree == NULL)
     {
+      GTimer *timer = g_timer_new ();
+
       /* First invocation. */
+      priv->items = g_array_new (FALSE, FALSE, sizeof (MnbLauncherItem));
       priv->tree = mnb_launcher_tree_create ();
       priv->directories = mnb_launcher_tree_list_entries (priv->tree);
+      g_debug ("%s Listed menu in %.3f ms",
+               G_STRLOC,
+               g_timer_elapsed (timer, NULL) * 1000);
+      g_timer_destroy (timer);
       priv->directories = g_list_reverse (priv->directories);
       priv->directory_iter = priv->directories;
     }
@@ -824,9 +970,11 @@ mnb_launcher_fill_category (MnbLauncher     *self)
   if (priv->directory_iter == NULL)
     {
       /* Last invocation. */
-      /* Alphabetically sort buttons, so they are in order while filtering. */
-      priv->launchers = g_slist_sort (priv->launchers,
-                                      (GCompareFunc) mnb_launcher_button_compare);
+      /* Alphabetically sort items, so they are in order while filtering. */
+      g_array_sort (priv->items, (GCompareFunc) _compare_items);
+
+      mnb_launcher_build_index (self);
+      mnb_launcher_preload_icons (self);
 
       /* Create monitor only once. */
       if (!priv->monitor)
@@ -854,22 +1002,23 @@ mnb_launcher_fill_category (MnbLauncher     *self)
   for (entries_iter = directory->entries; entries_iter; entries_iter = entries_iter->next)
     {
       MnbLauncherApplication *launcher = (MnbLauncherApplication *) entries_iter->data;
-      MxWidget *button = launcher_button_create_from_entry (launcher,
-                                                            directory->name,
-                                                            priv->theme,
-                                                            self);
-      if (button)
-        {
-          g_signal_connect (button, "activated",
-                            G_CALLBACK (launcher_button_activated_cb),
-                            self);
-          g_signal_connect (button, "fav-toggled",
-                            G_CALLBACK (launcher_button_fav_toggled_cb),
-                            self);
-          priv->launchers = g_slist_prepend (priv->launchers,
-                                                      button);
-          n_buttons++;
-        }
+      MnbLauncherItem         item;
+      gboolean                bookmarked;
+
+      if (!mnb_launcher_application_get_name (launcher) ||
+          !mnb_launcher_application_get_executable (launcher))
+        continue;
+
+      bookmarked = NULL != g_list_find_custom (
+                      priv->bookmarks_list,
+                      mnb_launcher_application_get_desktop_file (launcher),
+                      (GCompareFunc) _is_launcher_bookmarked);
+      mnb_launcher_application_set_bookmarked (launcher, bookmarked);
+
+      item.app = g_object_ref (launcher);
+      item.category = g_strdup (directory->name);
+      g_array_append_val (priv->items, item);
+      n_buttons++;
     }
 
     /* Create category if at least 1 launcher inside.*/
@@ -885,33 +1034,36 @@ mnb_launcher_fill_category (MnbLauncher     *self)
   return TRUE;
 }
 
-static void
-_add_launchers_to_grid (gpointer button, gpointer apps_grid)
-{
-  clutter_container_add_actor (CLUTTER_CONTAINER (apps_grid),
-                               CLUTTER_ACTOR (button));
-}
-
 static void
 mnb_launcher_fill (MnbLauncher  *self)
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
+  GTimer             *timer = g_timer_new ();
+
   /* Grid */
   priv->apps_grid = CLUTTER_ACTOR (mnb_launcher_grid_new ());
   clutter_actor_set_name (priv->apps_grid, "apps-grid");
   mx_grid_set_column_spacing (MX_GRID (priv->apps_grid), APPS_GRID_COLUMN_GAP);
   mx_grid_set_row_spacing (MX_GRID (priv->apps_grid), APPS_GRID_ROW_GAP);
+  mnb_launcher_grid_set_virtual (MNB_LAUNCHER_GRID (priv->apps_grid),
+                                 DAWATI_CONTENT_TILE_WIDTH,
+                                 DAWATI_CONTENT_TILE_HEIGHT,
+                                 (MnbLauncherGridCreateFunc) _apps_grid_create_button_cb,
+                                 (MnbLauncherGridBindFunc) _apps_grid_bind_button_cb,
+                                 self);
 
   mx_bin_set_child (MX_BIN (priv->scrollview), priv->apps_grid);
 
   while (mnb_launcher_fill_category (self))
         ;
 
-  /* Add to grid */
-  g_slist_foreach (priv->launchers,
-                   (GFunc)_add_launchers_to_grid,
-                   priv->apps_grid);
+  /* Buttons are only created for the rows in view. */
+  mnb_launcher_show_items (self, NULL, NULL);
 
+  g_debug ("%s Filled launcher in %.3f ms",
+           G_STRLOC,
+           g_timer_elapsed (timer, NULL) * 1000);
+  g_timer_destroy (timer);
 }
 
 static void
@@ -920,9 +1072,10 @@ mnb_launcher_theme_changed_cb (GtkIconTheme    *theme,
 {
   MnbLauncherPrivate *priv = GET_PRIVATE (self);
 
-  g_slist_foreach (priv->launchers,
-                   (GFunc) launcher_button_reload_icon_cb,
-                   priv->theme);
+  mnb_launcher_icon_loader_clear (priv->icon_loader);
+
+  if (priv->apps_grid)
+    mnb_launcher_grid_rebind (MNB_LAUNCHER_GRID (priv->apps_grid));
 }
 
 static void
@@ -933,6 +1086,16 @@ mnb_launcher_monitor_cb (MnbLauncherMonitor  *monitor,
   mnb_launcher_fill (self);
 }
 
+static void
+_app_launches_changed_cb (MplAppLaunchesStore *store,
+                          MnbLauncher         *self)
+{
+  MnbLauncherPrivate *priv = GET_PRIVATE (self);
+
+  /* Picked up by the next search. */
+  priv->n_launches_dirty = TRUE;
+}
+
 static void
 _dispose (GObject *object)
 {
@@ -963,9 +1126,24 @@ _dispose (GObject *object)
       priv->running = NULL;
     }
 
+  if (priv->app_launches)
+    {
+      g_signal_handlers_disconnect_by_func (priv->app_launches,
+                                            _app_launches_changed_cb,
+                                            object);
+      g_object_unref (priv->app_launches);
+      priv->app_launches = NULL;
+    }
+
 
   mnb_launcher_reset (self);
 
+  if (priv->icon_loader)
+    {
+      mnb_launcher_icon_loader_free (priv->icon_loader);
+      priv->icon_loader = NULL;
+    }
+
   G_OBJECT_CLASS (mnb_launcher_parent_class)->dispose (object);
 }
 
@@ -1030,28 +1208,6 @@ _scrollview_allocation_changed_cb (MxScrollView           *scroll,
                    g_free);
 }
 
-typedef struct
-{
-  MnbLauncherButton *button;
-  guint              n_visible;
-} app_grid_find_single_visible_button_t;
-
-static void
-_apps_grid_find_single_visible_button_cb (ClutterActor                          *actor,
-                                          app_grid_find_single_visible_button_t *data)
-{
-  if (data->n_visible == 1)
-    return;
-
-  if (MNB_IS_LAUNCHER_BUTTON (actor) &&
-      CLUTTER_ACTOR_IS_REACTIVE (actor) &&
-      CLUTTER_ACTOR_IS_VISIBLE (actor))
-    {
-      data->button = MNB_LAUNCHER_BUTTON (actor);
-      data->n_visible++;
-    }
-}
-
 static gboolean
 _filter_captured_event_cb (ClutterActor *actor,
                            ClutterEvent *event,
@@ -1064,24 +1220,25 @@ _filter_captured_event_cb (ClutterActor *actor,
       ClutterKeyEvent *key_event = (ClutterKeyEvent *) event;
       if (CLUTTER_Return == key_event->keyval)
         {
-          app_grid_find_single_visible_button_t data = { 0, };
-          ClutterActorIter iter;
-          ClutterActor *child;
+          MnbLauncherGrid *grid = MNB_LAUNCHER_GRID (priv->apps_grid);
+          ClutterActor    *button = NULL;
 
-          clutter_actor_iter_init (&iter, priv->apps_grid);
-          while (clutter_actor_iter_next (&iter, &child))
-            _apps_grid_find_single_visible_button_cb (child, &data);
+          if (mnb_launcher_grid_get_n_items (grid) == 1)
+            button = mnb_launcher_grid_get_actor_for_item (
+                                  grid,
+                                  mnb_launcher_grid_get_item (grid, 0));
 
-          if (data.n_visible == 1)
+          if (button && CLUTTER_ACTOR_IS_REACTIVE (button))
             {
               gchar const *desktop_file_path =
-                        mnb_launcher_button_get_desktop_file_path (data.button);
+                        mnb_launcher_button_get_desktop_file_path (
+                                        MNB_LAUNCHER_BUTTON (button));
 
               /* Disable button for some time to avoid launching multiple times. */
-              clutter_actor_set_reactive (CLUTTER_ACTOR (data.button), FALSE);
+              clutter_actor_set_reactive (button, FALSE);
               g_timeout_add_seconds (LAUNCH_REACTIVE_TIMEOUT_S,
                                      (GSourceFunc) launcher_button_set_reactive_cb,
-                                     data.button);
+                                     button);
               g_signal_emit (self,
                              _signals[LAUNCHER_ACTIVATED],
                              0,
@@ -1296,6 +1453,16 @@ _constructor (GType                  gtype,
                     G_CALLBACK (_bookmakrs_changed_cb), self);
 
   priv->bookmarks_list = mpl_app_bookmark_manager_get_bookmarks (priv->manager);
+
+  priv->icon_loader =
+    mnb_launcher_icon_loader_new (LAUNCHER_BUTTON_ICON_TARGET_SIZE,
+                                  (MnbLauncherIconLoaderFunc) _icons_loaded_cb,
+                                  self);
+
+  priv->app_launches = mpl_app_launches_store_new ();
+  g_signal_connect (priv->app_launches, "changed",
+                    G_CALLBACK (_app_launches_changed_cb), self);
+
   priv->is_constructed = TRUE;
 
   mnb_launcher_fill (self);
@@ -407,49 +407,6 @@ mnb_launcher_application_new_from_desktop_file (const gchar *desktop_file)
   return self;
 }
 
-MnbLauncherApplication *
-mnb_launcher_application_new_from_cache (const gchar **attribute_names,
-                                         const gchar **attribute_values)
-{
-  const gchar *name = NULL;
-  const gchar *icon = NULL;
-  const gchar *description = NULL;
-  const gchar *executable = NULL;
-  const gchar *desktop_file = NULL;
-  gboolean     bookmarked = FALSE;
-  guint        i = 0;
-
-  while (attribute_names[i])
-    {
-      if (0 == g_strcmp0 ("name", attribute_names[i]))
-        name = attribute_values[i];
-      if (0 == g_strcmp0 ("icon", attribute_names[i]))
-        icon = attribute_values[i];
-      if (0 == g_strcmp0 ("description", attribute_names[i]))
-        description = attribute_values[i];
-      if (0 == g_strcmp0 ("executable", attribute_names[i]))
-        executable = attribute_values[i];
-      if (0 == g_strcmp0 ("desktop-file", attribute_names[i]))
-        desktop_file = attribute_values[i];
-      if (0 == g_strcmp0 ("bookmarked", attribute_names[i]))
-        bookmarked = (0 == g_strcmp0 ("true", attribute_values[i])) ?
-                        TRUE :
-                        FALSE;
-      i++;
-    }
-
-  g_return_val_if_fail (desktop_file, NULL);
-
-  return g_object_new (MNB_TYPE_LAUNCHER_APPLICATION,
-                       "name", name,
-                       "icon", icon,
-                       "description", description,
-                       "executable", executable,
-                       "desktop-file", desktop_file,
-                       "bookmarked", bookmarked,
-                        NULL);
-}
-
 const gchar *
 mnb_launcher_application_get_desktop_file (MnbLauncherApplication *self)
 {
@@ -604,47 +561,3 @@ mnb_launcher_application_set_bookmarked (MnbLauncherApplication *self,
       g_object_notify (G_OBJECT (self), "bookmarked");
     }
 }
-
-void
-mnb_launcher_application_write_xml (MnbLauncherApplication const *self,
-                                    FILE                         *fp)
-{
-  MnbLauncherApplicationPrivate *priv = GET_PRIVATE (self);
-  gchar *text;
-
-  text = g_markup_printf_escaped ("    <application desktop-file=\"%s\" bookmarked=\"%s\">\n",
-                                  priv->desktop_file,
-                                  priv->bookmarked ? "true" : "false");
-  fputs (text, fp);
-  g_free (text);
-  if (priv->name)
-    {
-      text = g_markup_printf_escaped ("      <name>%s</name>\n",
-                                      priv->name);
-      fputs (text, fp);
-      g_free (text);
-    }
-  if (priv->executable)
-    {
-      text = g_markup_printf_escaped ("      <executable>%s</executable>\n",
-                                      priv->executable);
-      fputs (text, fp);
-      g_free (text);
-    }
-  if (priv->icon)
-    {
-      text = g_markup_printf_escaped ("      <icon>%s</icon>\n",
-                                      priv->icon);
-      fputs (text, fp);
-      g_free (text);
-    }
-  if (priv->description)
-    {
-      text = g_markup_printf_escaped ("      <description>%s</description>\n",
-                                      priv->description);
-      fputs (text, fp);
-      g_free (text);
-    }
-  fputs   (    "    </application>\n", fp);
-}
-
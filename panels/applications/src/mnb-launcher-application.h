@@ -70,9 +70,6 @@ MnbLauncherApplication *  mnb_launcher_application_new (const gchar *name,
 
 MnbLauncherApplication *  mnb_launcher_application_new_from_desktop_file  (const gchar *desktop_file);
 
-MnbLauncherApplication *  mnb_launcher_application_new_from_cache (const gchar **attribute_names,
-                                                                   const gchar **attribute_values);
-
 const gchar *       mnb_launcher_application_get_name               (MnbLauncherApplication *self);
 void                mnb_launcher_application_set_name               (MnbLauncherApplication *self,
                                                                      const gchar            *name);
@@ -92,9 +89,6 @@ gboolean            mnb_launcher_application_get_bookmarked         (MnbLauncher
 void                mnb_launcher_application_set_bookmarked         (MnbLauncherApplication *self,
                                                                      gboolean                bookmarked);
 
-void                mnb_launcher_application_write_xml              (MnbLauncherApplication const *self,
-                                                                     FILE                         *fp);
-
 G_END_DECLS
 
 #endif /* MNB_LAUNCHER_APPLICATION_H */
@@ -516,38 +516,17 @@ mnb_launcher_button_get_icon_name (MnbLauncherButton *self)
   return self->priv->icon_name;
 }
 
-void
-mnb_launcher_button_set_icon (MnbLauncherButton  *self,
-                              const gchar        *icon_file,
-                              gint                icon_size)
+static void
+mnb_launcher_button_insert_icon (MnbLauncherButton *self,
+                                 ClutterActor      *icon)
 {
-  MxTextureCache *texture_cache;
-  GError         *error = NULL;
-
-  if (self->priv->icon_file)
-    {
-      g_free (self->priv->icon_file);
-      self->priv->icon_file = NULL;
-    }
-
   if (self->priv->icon)
     {
       clutter_actor_destroy (self->priv->icon);
       self->priv->icon = NULL;
     }
 
-  self->priv->icon_file = g_strdup (icon_file);
-  self->priv->icon_size = icon_size;
-
-  error = NULL;
-  texture_cache = mx_texture_cache_get_default ();
-  self->priv->icon = mx_texture_cache_get_actor (texture_cache,
-                                                   self->priv->icon_file);
-
-  if (error) {
-    g_warning (G_STRLOC "%s", error->message);
-    g_clear_error (&error);
-  }
+  self->priv->icon = icon;
 
   if (self->priv->icon) {
 
@@ -570,6 +549,105 @@ mnb_launcher_button_set_icon (MnbLauncherButton  *self,
   }
 }
 
+void
+mnb_launcher_button_set_icon (MnbLauncherButton  *self,
+                              const gchar        *icon_file,
+                              gint                icon_size)
+{
+  MxTextureCache *texture_cache;
+
+  if (self->priv->icon_file)
+    {
+      g_free (self->priv->icon_file);
+      self->priv->icon_file = NULL;
+    }
+
+  self->priv->icon_file = g_strdup (icon_file);
+  self->priv->icon_size = icon_size;
+
+  texture_cache = mx_texture_cache_get_default ();
+  mnb_launcher_button_insert_icon (self,
+                                   mx_texture_cache_get_actor (texture_cache,
+                                                               self->priv->icon_file));
+}
+
+/*
+ * Show an already decoded icon, or none if `texture' is COGL_INVALID_HANDLE.
+ */
+void
+mnb_launcher_button_set_icon_texture (MnbLauncherButton  *self,
+                                      CoglHandle          texture,
+                                      gint                icon_size)
+{
+  ClutterActor *icon = NULL;
+
+  g_return_if_fail (self);
+
+  self->priv->icon_size = icon_size;
+
+  /* Rebinding happens a lot, avoid churning actors. */
+  if (self->priv->icon == NULL && texture == COGL_INVALID_HANDLE)
+    return;
+  if (self->priv->icon &&
+      CLUTTER_IS_TEXTURE (self->priv->icon) &&
+      clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (self->priv->icon)) == texture)
+    return;
+
+  if (texture != COGL_INVALID_HANDLE)
+    {
+      icon = clutter_texture_new ();
+      clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (icon), texture);
+    }
+
+  mnb_launcher_button_insert_icon (self, icon);
+}
+
+/*
+ * Re-purpose the button for another application, used when recycling
+ * buttons. The icon is set separately.
+ */
+void
+mnb_launcher_button_update (MnbLauncherButton *self,
+                            const gchar       *icon_name,
+                            const gchar       *title,
+                            const gchar       *category,
+                            const gchar       *description,
+                            const gchar       *executable,
+                            const gchar       *desktop_file_path)
+{
+  MnbLauncherButtonPrivate *priv;
+
+  g_return_if_fail (self);
+
+  priv = self->priv;
+
+  g_free (priv->icon_name);
+  priv->icon_name = g_strdup (icon_name);
+  g_free (priv->icon_file);
+  priv->icon_file = NULL;
+
+  mx_label_set_text (priv->title, title ? title : "");
+
+  g_free (priv->category);
+  priv->category = g_strdup (category);
+  g_free (priv->description);
+  priv->description = g_strdup (description);
+  g_free (priv->executable);
+  priv->executable = g_strdup (executable);
+  g_free (priv->desktop_file_path);
+  priv->desktop_file_path = g_strdup (desktop_file_path);
+
+  /* Drop match keys of the previous application. */
+  g_free (priv->category_key);
+  priv->category_key = NULL;
+  g_free (priv->title_key);
+  priv->title_key = NULL;
+  g_free (priv->description_key);
+  priv->description_key = NULL;
+  g_free (priv->executable_key);
+  priv->executable_key = NULL;
+}
+
 gint
 mnb_launcher_button_compare (MnbLauncherButton *self,
                              MnbLauncherButton *other)
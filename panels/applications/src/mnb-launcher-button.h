@@ -85,6 +85,18 @@ void          mnb_launcher_button_set_icon        (MnbLauncherButton  *self,
                                                    const gchar        *icon_file,
                                                    gint                icon_size);
 
+void          mnb_launcher_button_set_icon_texture (MnbLauncherButton  *self,
+                                                    CoglHandle          texture,
+                                                    gint                icon_size);
+
+void          mnb_launcher_button_update          (MnbLauncherButton *self,
+                                                   const gchar       *icon_name,
+                                                   const gchar       *title,
+                                                   const gchar       *category,
+                                                   const gchar       *description,
+                                                   const gchar       *executable,
+                                                   const gchar       *desktop_file_path);
+
 void          mnb_launcher_button_set_last_launched (MnbLauncherButton  *self,
                                                      time_t              last_launched);
 
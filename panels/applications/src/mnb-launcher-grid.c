@@ -41,14 +41,38 @@ enum
 typedef struct
 {
   gboolean x_expand_children;
+
+  /* Virtual mode. */
+  gboolean                    is_virtual;
+  gfloat                      item_width;
+  gfloat                      item_height;
+  MnbLauncherGridCreateFunc   create_func;
+  MnbLauncherGridBindFunc     bind_func;
+  gpointer                    user_data;
+  GArray                     *items;      /* Position -> item. */
+  GArray                     *positions;  /* Item -> position. */
+  GPtrArray                  *pool;       /* All item actors, bound or not. */
+  GHashTable                 *bound;      /* Item -> actor. */
+  MxAdjustment               *vadjustment;
+  gboolean                    in_allocation;
+  guint                       update_id;
+  /* Layout used for the last update. */
+  guint                       n_columns;
+  gfloat                      page_height;
+  guint                       first_visible;
 } MnbLauncherGridPrivate;
 
+static GQuark _item_quark = 0;
+
+static void mnb_launcher_grid_update_visible (MnbLauncherGrid *self);
+
 static gboolean
 _allocation_changed_idle_cb (MnbLauncherGrid *self)
 {
   MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
 
-  if (priv && priv->x_expand_children)
+  /* Cells have a fixed size in virtual mode. */
+  if (priv && priv->x_expand_children && !priv->is_virtual)
     {
       ClutterActorIter iter;
       ClutterActor *child;
@@ -115,15 +139,536 @@ _set_property (GObject      *object,
   }
 }
 
+/*
+ * Virtual mode helpers.
+ */
+
+static guint
+mnb_launcher_grid_get_n_columns (MnbLauncherGrid *self,
+                                 gfloat           width)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  MxPadding padding;
+  gfloat    spacing;
+  guint     n_columns;
+
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+  spacing = mx_grid_get_column_spacing (MX_GRID (self));
+
+  width -= padding.left + padding.right;
+  n_columns = (guint) MAX (0, (width + spacing) / (priv->item_width + spacing));
+
+  return MAX (n_columns, 1);
+}
+
+static gfloat
+mnb_launcher_grid_get_row_pitch (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  return priv->item_height + mx_grid_get_row_spacing (MX_GRID (self));
+}
+
+static gfloat
+mnb_launcher_grid_get_content_height (MnbLauncherGrid *self,
+                                      guint            n_columns)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  MxPadding padding;
+  guint     n_rows;
+
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+  n_rows = (priv->items->len + n_columns - 1) / n_columns;
+
+  return padding.top + padding.bottom +
+         (n_rows ? n_rows * mnb_launcher_grid_get_row_pitch (self) -
+                   mx_grid_get_row_spacing (MX_GRID (self)) :
+                   0);
+}
+
+static guint
+mnb_launcher_grid_get_position (MnbLauncherGrid *self,
+                                guint            item)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  if (item >= priv->positions->len)
+    return MNB_LAUNCHER_GRID_NO_ITEM;
+
+  return g_array_index (priv->positions, guint, item);
+}
+
+static void
+mnb_launcher_grid_bind (MnbLauncherGrid *self,
+                        ClutterActor    *actor,
+                        guint            item)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  g_object_set_qdata (G_OBJECT (actor), _item_quark, GUINT_TO_POINTER (item + 1));
+  g_hash_table_insert (priv->bound, GUINT_TO_POINTER (item), actor);
+
+  priv->bind_func (self, actor, item, priv->user_data);
+  clutter_actor_show (actor);
+}
+
+static void
+mnb_launcher_grid_unbind (MnbLauncherGrid *self,
+                          ClutterActor    *actor)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  ClutterActor *stage;
+  guint         item;
+
+  item = mnb_launcher_grid_get_item_for_actor (self, actor);
+  if (item == MNB_LAUNCHER_GRID_NO_ITEM)
+    return;
+
+  g_hash_table_remove (priv->bound, GUINT_TO_POINTER (item));
+  g_object_set_qdata (G_OBJECT (actor), _item_quark, NULL);
+
+  /* Do not leave focus on an actor that is about to show something else. */
+  stage = clutter_actor_get_stage (actor);
+  if (stage &&
+      clutter_stage_get_key_focus (CLUTTER_STAGE (stage)) == actor)
+    clutter_actor_grab_key_focus (CLUTTER_ACTOR (self));
+
+  if (MX_IS_STYLABLE (actor))
+    mx_stylable_set_style_pseudo_class (MX_STYLABLE (actor), NULL);
+  clutter_actor_hide (actor);
+}
+
+/*
+ * Bind actors to the items in the rows intersecting the view, plus one row
+ * on either side, and release the rest for recycling.
+ */
+static void
+mnb_launcher_grid_update_visible (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  ClutterActorBox  box;
+  MxPadding        padding;
+  GSList          *free_actors = NULL;
+  gfloat           value = 0;
+  gfloat           pitch;
+  gint             first_row;
+  gint             last_row;
+  guint            first;
+  guint            last;
+  guint            i;
+
+  if (priv->update_id)
+    {
+      g_source_remove (priv->update_id);
+      priv->update_id = 0;
+    }
+
+  clutter_actor_get_allocation_box (CLUTTER_ACTOR (self), &box);
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+
+  priv->n_columns = mnb_launcher_grid_get_n_columns (self, box.x2 - box.x1);
+  priv->page_height = box.y2 - box.y1;
+  pitch = mnb_launcher_grid_get_row_pitch (self);
+
+  if (priv->vadjustment)
+    value = mx_adjustment_get_value (priv->vadjustment);
+
+  first_row = MAX (0, (gint) ((value - padding.top) / pitch));
+  last_row = (gint) ((value + priv->page_height - padding.top) / pitch) + 1;
+
+  priv->first_visible = MIN (first_row * priv->n_columns, priv->items->len);
+  first = MIN (MAX (first_row - 1, 0) * priv->n_columns, priv->items->len);
+  last = MIN ((last_row + 1) * priv->n_columns, priv->items->len);
+
+  for (i = 0; i < priv->pool->len; i++)
+    {
+      ClutterActor *actor = g_ptr_array_index (priv->pool, i);
+      guint         item = mnb_launcher_grid_get_item_for_actor (self, actor);
+
+      if (item != MNB_LAUNCHER_GRID_NO_ITEM)
+        {
+          guint position = mnb_launcher_grid_get_position (self, item);
+
+          if (position != MNB_LAUNCHER_GRID_NO_ITEM &&
+              position >= first &&
+              position < last)
+            continue;
+
+          mnb_launcher_grid_unbind (self, actor);
+        }
+
+      free_actors = g_slist_prepend (free_actors, actor);
+    }
+
+  for (i = first; i < last; i++)
+    {
+      guint         item = g_array_index (priv->items, guint, i);
+      ClutterActor *actor;
+
+      if (g_hash_table_lookup (priv->bound, GUINT_TO_POINTER (item)))
+        continue;
+
+      if (free_actors)
+        {
+          actor = free_actors->data;
+          free_actors = g_slist_delete_link (free_actors, free_actors);
+        }
+      else
+        {
+          actor = priv->create_func (self, priv->user_data);
+          clutter_container_add_actor (CLUTTER_CONTAINER (self), actor);
+          g_ptr_array_add (priv->pool, actor);
+        }
+
+      mnb_launcher_grid_bind (self, actor, item);
+    }
+
+  g_slist_free (free_actors);
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+}
+
+static gboolean
+_update_idle_cb (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  priv->update_id = 0;
+  mnb_launcher_grid_update_visible (self);
+
+  return FALSE;
+}
+
+static void
+mnb_launcher_grid_queue_update (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  /* Actors can not be added while allocating, so this runs before
+   * the next redraw. */
+  if (priv->update_id == 0)
+    priv->update_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                       (GSourceFunc) _update_idle_cb,
+                                       self,
+                                       NULL);
+}
+
+static void
+_vadjustment_value_notify_cb (MxAdjustment    *adjustment,
+                              GParamSpec      *pspec,
+                              MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  if (priv->in_allocation)
+    mnb_launcher_grid_queue_update (self);
+  else
+    mnb_launcher_grid_update_visible (self);
+}
+
+static void
+mnb_launcher_grid_set_vadjustment (MnbLauncherGrid *self,
+                                   MxAdjustment    *vadjustment)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  if (priv->vadjustment == vadjustment)
+    return;
+
+  if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            _vadjustment_value_notify_cb,
+                                            self);
+      g_object_unref (priv->vadjustment);
+      priv->vadjustment = NULL;
+    }
+
+  if (vadjustment)
+    {
+      priv->vadjustment = g_object_ref (vadjustment);
+      g_signal_connect (priv->vadjustment, "notify::value",
+                        G_CALLBACK (_vadjustment_value_notify_cb), self);
+    }
+}
+
+/*
+ * Scroll the item at `position' into view and return its actor.
+ */
+static ClutterActor *
+mnb_launcher_grid_ensure_position_visible (MnbLauncherGrid *self,
+                                           guint            position)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  MxPadding padding;
+  gfloat    y;
+
+  if (position >= priv->items->len)
+    return NULL;
+
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+  y = padding.top +
+      (position / priv->n_columns) * mnb_launcher_grid_get_row_pitch (self);
+
+  if (priv->vadjustment)
+    {
+      gdouble value = mx_adjustment_get_value (priv->vadjustment);
+
+      if (y < value)
+        mx_adjustment_set_value (priv->vadjustment, y);
+      else if (y + priv->item_height > value + priv->page_height)
+        mx_adjustment_set_value (priv->vadjustment,
+                                 y + priv->item_height - priv->page_height);
+    }
+
+  mnb_launcher_grid_update_visible (self);
+
+  return mnb_launcher_grid_get_actor_for_item (
+                          self,
+                          g_array_index (priv->items, guint, position));
+}
+
+/*
+ * Keyboard navigation over item positions rather than actors, the target
+ * may not have an actor until scrolled into view.
+ */
+static ClutterActor *
+mnb_launcher_grid_keynav_virtual (MnbLauncherGrid  *self,
+                                  ClutterActor     *old,
+                                  MxFocusDirection  direction)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  guint n_columns = priv->n_columns;
+  guint n_items = priv->items->len;
+  guint position;
+  guint next_row;
+
+  if (old == NULL)
+    return NULL;
+
+  position = mnb_launcher_grid_get_position (
+                self,
+                mnb_launcher_grid_get_item_for_actor (self, old));
+  if (position == MNB_LAUNCHER_GRID_NO_ITEM)
+    return NULL;
+
+  switch (direction)
+    {
+    case MX_FOCUS_DIRECTION_UP:
+      if (position < n_columns)
+        return NULL;
+      position -= n_columns;
+      break;
+    case MX_FOCUS_DIRECTION_DOWN:
+      next_row = (position / n_columns + 1) * n_columns;
+      if (position + n_columns < n_items)
+        position += n_columns;
+      else if (next_row < n_items)
+        /* Wrap to the start of a short last row. */
+        position = next_row;
+      else
+        return NULL;
+      break;
+    case MX_FOCUS_DIRECTION_LEFT:
+    case MX_FOCUS_DIRECTION_PREVIOUS:
+      if (position == 0)
+        return NULL;
+      position--;
+      break;
+    case MX_FOCUS_DIRECTION_RIGHT:
+    case MX_FOCUS_DIRECTION_NEXT:
+      if (position + 1 >= n_items)
+        return NULL;
+      position++;
+      break;
+    default:
+      return NULL;
+    }
+
+  return mnb_launcher_grid_ensure_position_visible (self, position);
+}
+
+static void
+mnb_launcher_grid_get_preferred_width (ClutterActor *actor,
+                                       gfloat        for_height,
+                                       gfloat       *min_width_p,
+                                       gfloat       *natural_width_p)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (actor);
+  MxPadding padding;
+
+  if (!priv->is_virtual)
+    {
+      CLUTTER_ACTOR_CLASS (mnb_launcher_grid_parent_class)
+        ->get_preferred_width (actor, for_height, min_width_p, natural_width_p);
+      return;
+    }
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  if (min_width_p)
+    *min_width_p = padding.left + priv->item_width + padding.right;
+  if (natural_width_p)
+    *natural_width_p = padding.left + priv->item_width + padding.right;
+}
+
+static void
+mnb_launcher_grid_get_preferred_height (ClutterActor *actor,
+                                        gfloat        for_width,
+                                        gfloat       *min_height_p,
+                                        gfloat       *natural_height_p)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (actor);
+  MnbLauncherGrid *self = MNB_LAUNCHER_GRID (actor);
+  MxPadding padding;
+  guint     n_columns;
+
+  if (!priv->is_virtual)
+    {
+      CLUTTER_ACTOR_CLASS (mnb_launcher_grid_parent_class)
+        ->get_preferred_height (actor, for_width, min_height_p, natural_height_p);
+      return;
+    }
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  n_columns = for_width < 0 ? 1 :
+                              mnb_launcher_grid_get_n_columns (self, for_width);
+
+  if (min_height_p)
+    *min_height_p = padding.top + priv->item_height + padding.bottom;
+  if (natural_height_p)
+    *natural_height_p = mnb_launcher_grid_get_content_height (self, n_columns);
+}
+
+static void
+mnb_launcher_grid_allocate (ClutterActor           *actor,
+                            const ClutterActorBox  *box,
+                            ClutterAllocationFlags  flags)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (actor);
+  MnbLauncherGrid *self = MNB_LAUNCHER_GRID (actor);
+  MxAdjustment    *vadjustment = NULL;
+  MxPadding        padding;
+  GHashTableIter   iter;
+  gpointer         key;
+  gpointer         value;
+  gfloat           column_pitch;
+  gfloat           row_pitch;
+  gfloat           height;
+  gfloat           content_height;
+  guint            n_columns;
+
+  if (!priv->is_virtual)
+    {
+      CLUTTER_ACTOR_CLASS (mnb_launcher_grid_parent_class)
+        ->allocate (actor, box, flags);
+      return;
+    }
+
+  priv->in_allocation = TRUE;
+
+  /* Skip MxGrid's flow layout, children are placed by position. */
+  CLUTTER_ACTOR_CLASS (g_type_class_peek (MX_TYPE_WIDGET))
+    ->allocate (actor, box, flags);
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  n_columns = mnb_launcher_grid_get_n_columns (self, box->x2 - box->x1);
+  column_pitch = priv->item_width +
+                 mx_grid_get_column_spacing (MX_GRID (actor));
+  row_pitch = mnb_launcher_grid_get_row_pitch (self);
+
+  g_hash_table_iter_init (&iter, priv->bound);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      guint           position;
+      ClutterActorBox child_box;
+
+      position = mnb_launcher_grid_get_position (self, GPOINTER_TO_UINT (key));
+      child_box.x1 = padding.left + (position % n_columns) * column_pitch;
+      child_box.y1 = padding.top + (position / n_columns) * row_pitch;
+      child_box.x2 = child_box.x1 + priv->item_width;
+      child_box.y2 = child_box.y1 + priv->item_height;
+      clutter_actor_allocate (CLUTTER_ACTOR (value), &child_box, flags);
+    }
+
+  /* Scroll range. */
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (actor), NULL, &vadjustment);
+  mnb_launcher_grid_set_vadjustment (self, vadjustment);
+
+  height = box->y2 - box->y1;
+  if (priv->vadjustment)
+    {
+      content_height = mnb_launcher_grid_get_content_height (self, n_columns);
+      mx_adjustment_set_values (priv->vadjustment,
+                                CLAMP (mx_adjustment_get_value (priv->vadjustment),
+                                       0,
+                                       MAX (0, content_height - height)),
+                                0,
+                                content_height,
+                                row_pitch,
+                                height,
+                                height);
+    }
+
+  priv->in_allocation = FALSE;
+
+  if (n_columns != priv->n_columns ||
+      height != priv->page_height)
+    mnb_launcher_grid_queue_update (self);
+}
+
+static void
+_dispose (GObject *object)
+{
+  MnbLauncherGrid *self = MNB_LAUNCHER_GRID (object);
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->update_id)
+    {
+      g_source_remove (priv->update_id);
+      priv->update_id = 0;
+    }
+
+  mnb_launcher_grid_set_vadjustment (self, NULL);
+
+  G_OBJECT_CLASS (mnb_launcher_grid_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->is_virtual)
+    {
+      /* The actors themselves are children, managed by clutter. */
+      g_array_free (priv->items, TRUE);
+      g_array_free (priv->positions, TRUE);
+      g_ptr_array_free (priv->pool, TRUE);
+      g_hash_table_destroy (priv->bound);
+    }
+
+  G_OBJECT_CLASS (mnb_launcher_grid_parent_class)->finalize (object);
+}
+
 static void
 mnb_launcher_grid_class_init (MnbLauncherGridClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
 
   g_type_class_add_private (klass, sizeof (MnbLauncherGridPrivate));
 
   object_class->get_property = _get_property;
   object_class->set_property = _set_property;
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+
+  actor_class->get_preferred_width = mnb_launcher_grid_get_preferred_width;
+  actor_class->get_preferred_height = mnb_launcher_grid_get_preferred_height;
+  actor_class->allocate = mnb_launcher_grid_allocate;
+
+  _item_quark = g_quark_from_static_string ("mnb-launcher-grid-item");
 
   /* Properties */
 
@@ -366,9 +911,16 @@ static MxFocusable *
 mnb_launcher_grid_accept_focus (MxFocusable *focusable,
                                 MxFocusHint hint)
 {
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (focusable);
   MxFocusable *focus;
 
-  focus = MX_FOCUSABLE (_find_first_focusable (CLUTTER_ACTOR (focusable)));
+  if (priv->is_virtual)
+    focus = (MxFocusable *)
+              mnb_launcher_grid_ensure_position_visible (
+                                    MNB_LAUNCHER_GRID (focusable),
+                                    priv->first_visible);
+  else
+    focus = MX_FOCUSABLE (_find_first_focusable (CLUTTER_ACTOR (focusable)));
   if (focus)
     {
       clutter_actor_grab_key_focus (CLUTTER_ACTOR (focusable));
@@ -383,8 +935,24 @@ mnb_launcher_grid_move_focus (MxFocusable *focusable,
                               MxFocusDirection direction,
                               MxFocusable *from)
 {
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (focusable);
   ClutterActor *focus = NULL;
 
+  if (priv->is_virtual)
+    {
+      focus = mnb_launcher_grid_keynav_virtual (MNB_LAUNCHER_GRID (focusable),
+                                                CLUTTER_ACTOR (from),
+                                                direction);
+
+      if (from)
+        mx_stylable_set_style_pseudo_class (MX_STYLABLE (from), NULL);
+
+      if (focus && MX_IS_FOCUSABLE (focus))
+        return mx_focusable_accept_focus (MX_FOCUSABLE (focus),
+                                          MX_FOCUS_HINT_FIRST);
+      return NULL;
+    }
+
   switch (direction)
     {
      case MX_FOCUS_DIRECTION_UP:
@@ -419,7 +987,8 @@ mnb_launcher_grid_move_focus (MxFocusable *focusable,
        break;
    }
 
-  mx_stylable_set_style_pseudo_class (MX_STYLABLE (from), NULL);
+  if (from)
+    mx_stylable_set_style_pseudo_class (MX_STYLABLE (from), NULL);
 
  if (focus)
    {
@@ -471,3 +1040,139 @@ mnb_launcher_grid_set_x_expand_children (MnbLauncherGrid *self,
     }
 }
 
+/*
+ * Switch to virtual mode, where items of `item_width' x `item_height' are
+ * shown through actors made by `create_func' and bound by `bind_func'.
+ * Must be called before any items are set.
+ */
+void
+mnb_launcher_grid_set_virtual (MnbLauncherGrid           *self,
+                               gfloat                     item_width,
+                               gfloat                     item_height,
+                               MnbLauncherGridCreateFunc  create_func,
+                               MnbLauncherGridBindFunc    bind_func,
+                               gpointer                   user_data)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (MNB_IS_LAUNCHER_GRID (self));
+  g_return_if_fail (!priv->is_virtual);
+  g_return_if_fail (create_func && bind_func);
+
+  priv->is_virtual = TRUE;
+  priv->item_width = item_width;
+  priv->item_height = item_height;
+  priv->create_func = create_func;
+  priv->bind_func = bind_func;
+  priv->user_data = user_data;
+  priv->items = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->positions = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->pool = g_ptr_array_new ();
+  priv->bound = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->n_columns = 1;
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+}
+
+/*
+ * Show `items' in the given order. Items that stay in view keep their actor.
+ */
+void
+mnb_launcher_grid_set_items (MnbLauncherGrid *self,
+                             guint const     *items,
+                             guint            n_items)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  guint max_item = 0;
+  guint i;
+
+  g_return_if_fail (MNB_IS_LAUNCHER_GRID (self));
+  g_return_if_fail (priv->is_virtual);
+
+  g_array_set_size (priv->items, 0);
+  g_array_append_vals (priv->items, items, n_items);
+
+  for (i = 0; i < n_items; i++)
+    max_item = MAX (max_item, items[i]);
+
+  g_array_set_size (priv->positions, n_items ? max_item + 1 : 0);
+  for (i = 0; i < priv->positions->len; i++)
+    g_array_index (priv->positions, guint, i) = MNB_LAUNCHER_GRID_NO_ITEM;
+  for (i = 0; i < n_items; i++)
+    g_array_index (priv->positions, guint, items[i]) = i;
+
+  mnb_launcher_grid_update_visible (self);
+}
+
+guint
+mnb_launcher_grid_get_n_items (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (MNB_IS_LAUNCHER_GRID (self), 0);
+  g_return_val_if_fail (priv->is_virtual, 0);
+
+  return priv->items->len;
+}
+
+guint
+mnb_launcher_grid_get_item (MnbLauncherGrid *self,
+                            guint            position)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (MNB_IS_LAUNCHER_GRID (self), MNB_LAUNCHER_GRID_NO_ITEM);
+  g_return_val_if_fail (priv->is_virtual, MNB_LAUNCHER_GRID_NO_ITEM);
+
+  if (position >= priv->items->len)
+    return MNB_LAUNCHER_GRID_NO_ITEM;
+
+  return g_array_index (priv->items, guint, position);
+}
+
+guint
+mnb_launcher_grid_get_item_for_actor (MnbLauncherGrid *self,
+                                      ClutterActor    *actor)
+{
+  gpointer data;
+
+  g_return_val_if_fail (MNB_IS_LAUNCHER_GRID (self), MNB_LAUNCHER_GRID_NO_ITEM);
+
+  data = g_object_get_qdata (G_OBJECT (actor), _item_quark);
+
+  return data ? GPOINTER_TO_UINT (data) - 1 : MNB_LAUNCHER_GRID_NO_ITEM;
+}
+
+/*
+ * Returns the actor currently showing `item', NULL if it is out of view.
+ */
+ClutterActor *
+mnb_launcher_grid_get_actor_for_item (MnbLauncherGrid *self,
+                                      guint            item)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (MNB_IS_LAUNCHER_GRID (self), NULL);
+  g_return_val_if_fail (priv->is_virtual, NULL);
+
+  return g_hash_table_lookup (priv->bound, GUINT_TO_POINTER (item));
+}
+
+/*
+ * Bind all actors in view again, e.g. after the backing data changed.
+ */
+void
+mnb_launcher_grid_rebind (MnbLauncherGrid *self)
+{
+  MnbLauncherGridPrivate *priv = GET_PRIVATE (self);
+  GHashTableIter iter;
+  gpointer       key;
+  gpointer       value;
+
+  g_return_if_fail (MNB_IS_LAUNCHER_GRID (self));
+  g_return_if_fail (priv->is_virtual);
+
+  g_hash_table_iter_init (&iter, priv->bound);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    priv->bind_func (self, value, GPOINTER_TO_UINT (key), priv->user_data);
+}
@@ -58,6 +58,21 @@ typedef struct {
   MxGridClass parent_class;
 } MnbLauncherGridClass;
 
+/*
+ * Virtual mode: the grid lays out a list of item ids in fixed-size cells and
+ * only keeps actors for the rows in view, recycling them while scrolling.
+ * `create_func' makes a new actor, `bind_func' points an actor at an item.
+ */
+typedef ClutterActor * (*MnbLauncherGridCreateFunc) (MnbLauncherGrid *grid,
+                                                     gpointer         user_data);
+
+typedef void (*MnbLauncherGridBindFunc) (MnbLauncherGrid *grid,
+                                         ClutterActor    *actor,
+                                         guint            item,
+                                         gpointer         user_data);
+
+#define MNB_LAUNCHER_GRID_NO_ITEM G_MAXUINT
+
 GType mnb_launcher_grid_get_type (void);
 
 MxWidget  * mnb_launcher_grid_new         (void);
@@ -68,5 +83,30 @@ gboolean   mnb_launcher_grid_get_x_expand_children (MnbLauncherGrid *self);
 void       mnb_launcher_grid_set_x_expand_children (MnbLauncherGrid *self,
                                                     gboolean         value);
 
+void       mnb_launcher_grid_set_virtual        (MnbLauncherGrid           *self,
+                                                 gfloat                     item_width,
+                                                 gfloat                     item_height,
+                                                 MnbLauncherGridCreateFunc  create_func,
+                                                 MnbLauncherGridBindFunc    bind_func,
+                                                 gpointer                   user_data);
+
+void       mnb_launcher_grid_set_items          (MnbLauncherGrid *self,
+                                                 guint const     *items,
+                                                 guint            n_items);
+
+guint      mnb_launcher_grid_get_n_items        (MnbLauncherGrid *self);
+
+guint      mnb_launcher_grid_get_item           (MnbLauncherGrid *self,
+                                                 guint            position);
+
+guint      mnb_launcher_grid_get_item_for_actor (MnbLauncherGrid *self,
+                                                 ClutterActor    *actor);
+
+ClutterActor *
+           mnb_launcher_grid_get_actor_for_item (MnbLauncherGrid *self,
+                                                 guint            item);
+
+void       mnb_launcher_grid_rebind             (MnbLauncherGrid *self);
+
 #endif /* MNB_LAUNCHER_GRID_H */
 
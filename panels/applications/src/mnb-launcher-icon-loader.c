@@ -0,0 +1,252 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (c) 2012 Intel Corp.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "mnb-launcher-icon-loader.h"
+
+/*
+ * Files are decoded by a single worker thread, results are handed back
+ * through `decoded' and turned into textures in the main loop, where
+ * cogl is safe to use. One idle handler is scheduled per batch.
+ */
+
+typedef struct
+{
+  gchar     *icon_file;
+  GdkPixbuf *pixbuf;
+} DecodedIcon;
+
+struct MnbLauncherIconLoader_
+{
+  gint                        icon_size;
+  MnbLauncherIconLoaderFunc   loaded_func;
+  gpointer                    user_data;
+
+  GHashTable                 *textures;   /* Icon file -> CoglHandle. */
+  GHashTable                 *requested;  /* Icon files queued or failed. */
+  GThreadPool                *pool;
+
+  /* Shared with the worker. */
+  GMutex                      mutex;
+  GSList                     *decoded;
+  guint                       idle_id;
+  gboolean                    cancelled;
+};
+
+static void
+decoded_icon_free (DecodedIcon *decoded)
+{
+  g_free (decoded->icon_file);
+  if (decoded->pixbuf)
+    g_object_unref (decoded->pixbuf);
+  g_free (decoded);
+}
+
+static gboolean
+_decoded_idle_cb (MnbLauncherIconLoader *self)
+{
+  GSList *decoded;
+  GSList *iter;
+
+  g_mutex_lock (&self->mutex);
+  decoded = self->decoded;
+  self->decoded = NULL;
+  self->idle_id = 0;
+  g_mutex_unlock (&self->mutex);
+
+  for (iter = decoded; iter; iter = iter->next)
+    {
+      DecodedIcon *icon = iter->data;
+      CoglHandle   texture;
+
+      if (icon->pixbuf == NULL)
+        continue;
+
+      texture =
+        cogl_texture_new_from_data (gdk_pixbuf_get_width (icon->pixbuf),
+                                    gdk_pixbuf_get_height (icon->pixbuf),
+                                    COGL_TEXTURE_NO_SLICING,
+                                    gdk_pixbuf_get_has_alpha (icon->pixbuf) ?
+                                      COGL_PIXEL_FORMAT_RGBA_8888 :
+                                      COGL_PIXEL_FORMAT_RGB_888,
+                                    COGL_PIXEL_FORMAT_ANY,
+                                    gdk_pixbuf_get_rowstride (icon->pixbuf),
+                                    gdk_pixbuf_get_pixels (icon->pixbuf));
+      if (texture != COGL_INVALID_HANDLE)
+        {
+          g_hash_table_insert (self->textures,
+                               g_strdup (icon->icon_file),
+                               texture);
+        }
+    }
+
+  g_slist_foreach (decoded, (GFunc) decoded_icon_free, NULL);
+  g_slist_free (decoded);
+
+  self->loaded_func (self, self->user_data);
+
+  return FALSE;
+}
+
+/* Runs in the worker thread. */
+static void
+_decode_cb (gchar                 *icon_file,
+            MnbLauncherIconLoader *self)
+{
+  DecodedIcon *decoded;
+  GError      *error = NULL;
+  gboolean     cancelled;
+
+  g_mutex_lock (&self->mutex);
+  cancelled = self->cancelled;
+  g_mutex_unlock (&self->mutex);
+
+  if (cancelled)
+    {
+      g_free (icon_file);
+      return;
+    }
+
+  decoded = g_new0 (DecodedIcon, 1);
+  decoded->icon_file = icon_file;
+  decoded->pixbuf = gdk_pixbuf_new_from_file_at_size (icon_file,
+                                                      self->icon_size,
+                                                      self->icon_size,
+                                                      &error);
+  if (error)
+    {
+      g_warning ("%s %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+    }
+
+  g_mutex_lock (&self->mutex);
+  self->decoded = g_slist_prepend (self->decoded, decoded);
+  if (self->idle_id == 0)
+    self->idle_id = g_idle_add ((GSourceFunc) _decoded_idle_cb, self);
+  g_mutex_unlock (&self->mutex);
+}
+
+MnbLauncherIconLoader *
+mnb_launcher_icon_loader_new (gint                       icon_size,
+                              MnbLauncherIconLoaderFunc  loaded_func,
+                              gpointer                   user_data)
+{
+  MnbLauncherIconLoader *self;
+
+  g_return_val_if_fail (loaded_func, NULL);
+
+  self = g_new0 (MnbLauncherIconLoader, 1);
+  self->icon_size = icon_size;
+  self->loaded_func = loaded_func;
+  self->user_data = user_data;
+  self->textures = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, cogl_handle_unref);
+  self->requested = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, NULL);
+  self->pool = g_thread_pool_new ((GFunc) _decode_cb, self, 1, FALSE, NULL);
+  g_mutex_init (&self->mutex);
+
+  return self;
+}
+
+static void
+mnb_launcher_icon_loader_cancel (MnbLauncherIconLoader *self)
+{
+  /* Have the worker skip queued files, and wait for it. */
+  g_mutex_lock (&self->mutex);
+  self->cancelled = TRUE;
+  g_mutex_unlock (&self->mutex);
+
+  g_thread_pool_free (self->pool, FALSE, TRUE);
+  self->pool = NULL;
+  self->cancelled = FALSE;
+
+  if (self->idle_id)
+    {
+      g_source_remove (self->idle_id);
+      self->idle_id = 0;
+    }
+
+  g_slist_foreach (self->decoded, (GFunc) decoded_icon_free, NULL);
+  g_slist_free (self->decoded);
+  self->decoded = NULL;
+}
+
+void
+mnb_launcher_icon_loader_free (MnbLauncherIconLoader *self)
+{
+  g_return_if_fail (self);
+
+  mnb_launcher_icon_loader_cancel (self);
+
+  g_hash_table_destroy (self->textures);
+  g_hash_table_destroy (self->requested);
+  g_mutex_clear (&self->mutex);
+
+  g_free (self);
+}
+
+/*
+ * Returns the texture for `icon_file' if already decoded, otherwise queues
+ * the file and returns COGL_INVALID_HANDLE. The loader keeps the reference.
+ */
+CoglHandle
+mnb_launcher_icon_loader_lookup (MnbLauncherIconLoader *self,
+                                 const gchar           *icon_file)
+{
+  CoglHandle texture;
+
+  g_return_val_if_fail (self, COGL_INVALID_HANDLE);
+
+  if (icon_file == NULL)
+    return COGL_INVALID_HANDLE;
+
+  texture = g_hash_table_lookup (self->textures, icon_file);
+  if (texture)
+    return texture;
+
+  if (!g_hash_table_lookup_extended (self->requested, icon_file, NULL, NULL))
+    {
+      g_hash_table_insert (self->requested, g_strdup (icon_file), NULL);
+      g_thread_pool_push (self->pool, g_strdup (icon_file), NULL);
+    }
+
+  return COGL_INVALID_HANDLE;
+}
+
+/*
+ * Forget about all icons, e.g. after an icon theme change.
+ */
+void
+mnb_launcher_icon_loader_clear (MnbLauncherIconLoader *self)
+{
+  g_return_if_fail (self);
+
+  mnb_launcher_icon_loader_cancel (self);
+
+  g_hash_table_remove_all (self->textures);
+  g_hash_table_remove_all (self->requested);
+
+  self->pool = g_thread_pool_new ((GFunc) _decode_cb, self, 1, FALSE, NULL);
+}
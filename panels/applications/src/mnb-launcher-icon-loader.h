@@ -0,0 +1,49 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (c) 2012 Intel Corp.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MNB_LAUNCHER_ICON_LOADER_H
+#define MNB_LAUNCHER_ICON_LOADER_H
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+/*
+ * MnbLauncherIconLoader decodes icon files on a worker thread and keeps the
+ * resulting textures around, keyed by file name.
+ */
+typedef struct MnbLauncherIconLoader_ MnbLauncherIconLoader;
+
+/* Invoked from the main loop after one or more icons have been decoded. */
+typedef void (*MnbLauncherIconLoaderFunc) (MnbLauncherIconLoader *loader,
+                                           gpointer               user_data);
+
+MnbLauncherIconLoader * mnb_launcher_icon_loader_new    (gint                       icon_size,
+                                                         MnbLauncherIconLoaderFunc  loaded_func,
+                                                         gpointer                   user_data);
+void                    mnb_launcher_icon_loader_free   (MnbLauncherIconLoader     *loader);
+
+CoglHandle              mnb_launcher_icon_loader_lookup (MnbLauncherIconLoader     *loader,
+                                                         const gchar               *icon_file);
+
+void                    mnb_launcher_icon_loader_clear  (MnbLauncherIconLoader     *loader);
+
+G_END_DECLS
+
+#endif /* MNB_LAUNCHER_ICON_LOADER_H */
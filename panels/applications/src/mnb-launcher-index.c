@@ -0,0 +1,269 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (c) 2012 Intel Corp.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "mnb-launcher-index.h"
+
+/*
+ * Every byte 1-, 2- and 3-gram of the lower-cased keys maps to the sorted
+ * list of items containing it. A needle of up to three bytes is answered
+ * straight from its posting list, longer needles intersect the lists of
+ * their trigrams and verify the few remaining candidates with strstr().
+ * Working on bytes keeps UTF-8 substring semantics intact.
+ */
+
+#define MAX_GRAM_LEN 3
+
+struct MnbLauncherIndex_
+{
+  GPtrArray   *keys;      /* Item id -> NULL-terminated lower-cased keys. */
+  GHashTable  *postings;  /* Packed n-gram -> GArray of item ids. */
+};
+
+static guint
+pack_gram (const gchar *str,
+           gsize        len)
+{
+  guint gram = 0;
+  gsize i;
+
+  /* Bytes of C strings are non-zero, so grams of different length
+   * never collide. */
+  for (i = 0; i < len; i++)
+    gram |= ((guint) (guchar) str[i]) << (8 * i);
+
+  return gram;
+}
+
+static void
+posting_add (MnbLauncherIndex *index,
+             guint             gram,
+             guint             id)
+{
+  GArray *list;
+
+  list = g_hash_table_lookup (index->postings, GUINT_TO_POINTER (gram));
+  if (!list)
+    {
+      list = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (index->postings, GUINT_TO_POINTER (gram), list);
+    }
+
+  /* Ids are added in ascending order, just drop duplicates. */
+  if (list->len == 0 || g_array_index (list, guint, list->len - 1) != id)
+    g_array_append_val (list, id);
+}
+
+static void
+_posting_free (GArray *list)
+{
+  g_array_free (list, TRUE);
+}
+
+MnbLauncherIndex *
+mnb_launcher_index_new (void)
+{
+  MnbLauncherIndex *index;
+
+  index = g_slice_new (MnbLauncherIndex);
+  index->keys = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+  index->postings = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL,
+                                           (GDestroyNotify) _posting_free);
+
+  return index;
+}
+
+void
+mnb_launcher_index_free (MnbLauncherIndex *index)
+{
+  g_return_if_fail (index);
+
+  g_ptr_array_free (index->keys, TRUE);
+  g_hash_table_destroy (index->postings);
+  g_slice_free (MnbLauncherIndex, index);
+}
+
+/*
+ * Add an item and return its id. `keys' is a NULL-terminated array of
+ * strings to match against, NULL entries are not allowed but empty ones are.
+ */
+guint
+mnb_launcher_index_add (MnbLauncherIndex   *index,
+                        const gchar *const *keys)
+{
+  GPtrArray *lcase_keys;
+  guint      id;
+  guint      k;
+
+  g_return_val_if_fail (index, 0);
+
+  id = index->keys->len;
+  lcase_keys = g_ptr_array_new ();
+
+  for (k = 0; keys[k]; k++)
+    {
+      gchar *key = g_utf8_strdown (keys[k], -1);
+      gsize  len = strlen (key);
+      gsize  i;
+
+      for (i = 0; i < len; i++)
+        {
+          gsize n;
+
+          for (n = 1; n <= MAX_GRAM_LEN && i + n <= len; n++)
+            posting_add (index, pack_gram (key + i, n), id);
+        }
+
+      g_ptr_array_add (lcase_keys, key);
+    }
+
+  g_ptr_array_add (lcase_keys, NULL);
+  g_ptr_array_add (index->keys, g_ptr_array_free (lcase_keys, FALSE));
+
+  return id;
+}
+
+guint
+mnb_launcher_index_get_size (MnbLauncherIndex *index)
+{
+  g_return_val_if_fail (index, 0);
+
+  return index->keys->len;
+}
+
+static GArray *
+intersect (GArray *result,
+           GArray *list)
+{
+  guint i = 0;
+  guint j = 0;
+  guint n = 0;
+
+  /* In place, result only ever shrinks. */
+  while (i < result->len && j < list->len)
+    {
+      guint a = g_array_index (result, guint, i);
+      guint b = g_array_index (list, guint, j);
+
+      if (a < b)
+        i++;
+      else if (a > b)
+        j++;
+      else
+        {
+          g_array_index (result, guint, n++) = a;
+          i++;
+          j++;
+        }
+    }
+
+  return g_array_set_size (result, n);
+}
+
+static gboolean
+item_match (MnbLauncherIndex *index,
+            guint             id,
+            const gchar      *lcase_needle)
+{
+  gchar **keys = g_ptr_array_index (index->keys, id);
+  guint   k;
+
+  for (k = 0; keys[k]; k++)
+    {
+      if (strstr (keys[k], lcase_needle))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Look up items having `lcase_needle' as a substring of any of their keys.
+ * Returns: a new array of matching item ids in ascending order,
+ *          free with g_array_free().
+ */
+GArray *
+mnb_launcher_index_lookup (MnbLauncherIndex *index,
+                           const gchar      *lcase_needle)
+{
+  GArray  *result;
+  GArray  *shortest = NULL;
+  gsize    len;
+  gsize    i;
+  guint    n;
+
+  g_return_val_if_fail (index, NULL);
+  g_return_val_if_fail (lcase_needle, NULL);
+
+  result = g_array_new (FALSE, FALSE, sizeof (guint));
+  len = strlen (lcase_needle);
+
+  /* Empty key matches. */
+  if (len == 0)
+    {
+      g_array_set_size (result, index->keys->len);
+      for (i = 0; i < index->keys->len; i++)
+        g_array_index (result, guint, i) = i;
+      return result;
+    }
+
+  /* Start off with the rarest trigram (or the needle itself when short). */
+  for (i = 0; i + MIN (len, MAX_GRAM_LEN) <= len; i++)
+    {
+      GArray *list = g_hash_table_lookup (index->postings,
+                                          GUINT_TO_POINTER (pack_gram (lcase_needle + i,
+                                                                       MIN (len, MAX_GRAM_LEN))));
+      if (!list)
+        return result;
+
+      if (!shortest || list->len < shortest->len)
+        shortest = list;
+    }
+
+  g_array_append_vals (result, shortest->data, shortest->len);
+
+  if (len <= MAX_GRAM_LEN)
+    return result;
+
+  for (i = 0; i + MAX_GRAM_LEN <= len && result->len > 0; i++)
+    {
+      GArray *list = g_hash_table_lookup (index->postings,
+                                          GUINT_TO_POINTER (pack_gram (lcase_needle + i,
+                                                                       MAX_GRAM_LEN)));
+      if (list != shortest)
+        result = intersect (result, list);
+    }
+
+  /* Trigrams may occur in different keys or out of order, verify. */
+  for (i = 0, n = 0; i < result->len; i++)
+    {
+      guint id = g_array_index (result, guint, i);
+
+      if (item_match (index, id, lcase_needle))
+        g_array_index (result, guint, n++) = id;
+    }
+
+  return g_array_set_size (result, n);
+}
@@ -0,0 +1,46 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (c) 2012 Intel Corp.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MNB_LAUNCHER_INDEX_H
+#define MNB_LAUNCHER_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * MnbLauncherIndex is a substring search index over the launcher keys.
+ * Items are numbered in the order they are added, starting from 0.
+ */
+typedef struct MnbLauncherIndex_ MnbLauncherIndex;
+
+MnbLauncherIndex *  mnb_launcher_index_new      (void);
+void                mnb_launcher_index_free     (MnbLauncherIndex   *index);
+
+guint               mnb_launcher_index_add      (MnbLauncherIndex   *index,
+                                                 const gchar *const *keys);
+
+guint               mnb_launcher_index_get_size (MnbLauncherIndex   *index);
+
+GArray *            mnb_launcher_index_lookup   (MnbLauncherIndex   *index,
+                                                 const gchar        *lcase_needle);
+
+G_END_DECLS
+
+#endif /* MNB_LAUNCHER_INDEX_H */
@@ -19,6 +19,7 @@
  * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -28,11 +29,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
 #include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
 
 #define GMENU_I_KNOW_THIS_IS_UNSTABLE
 #include <gmenu-tree.h>
@@ -40,11 +43,22 @@
 #include "mnb-launcher-tree.h"
 
 #define MNB_LAUNCHER_TREE_CACHE_FILE "dawati-launcher-cache"
+#define MNB_LAUNCHER_TREE_CACHE_MAGIC "MnbLTre"
+#define MNB_LAUNCHER_TREE_CACHE_VERSION 2
+#define MNB_LAUNCHER_TREE_CACHE_NO_STRING G_MAXUINT32
+
+/* File timestamps come from the kernel's coarse clock, which may lag the
+ * real time by a tick. */
+#define MNB_LAUNCHER_TREE_CACHE_CLOCK_SLACK_NS (20 * 1000 * 1000)
 
 /* Set this to include the settings menu.
   #define MNB_LAUNCHER_TREE_LOAD_SETTINGS
  */
 
+static gchar *    mnb_launcher_tree_get_cache_path  (void);
+static gboolean   mnb_launcher_tree_patch_cache     (const gchar  *cache_path,
+                                                     GHashTable   *changed_files);
+
 /*
  * MnbLauncherMonitor.
  */
@@ -52,6 +66,8 @@ struct MnbLauncherMonitor_ {
     GMenuTree                   *applications;
     GMenuTree                   *settings;
     GSList                      *monitors;
+    GHashTable                  *changed_files;
+    gboolean                     needs_rewalk;
     MnbLauncherMonitorFunction   monitor_function;
     gpointer                     user_data;
 };
@@ -59,6 +75,23 @@ struct MnbLauncherMonitor_ {
 static gboolean
 menu_changed_idle_cb (MnbLauncherMonitor *self)
 {
+  gchar *cache_path = mnb_launcher_tree_get_cache_path ();
+
+  /* Patch the changed desktop files into the cache, so the monitor function
+   * does not have to walk the entire menu again. Edits to existing files
+   * do not show in the directory fingerprints, hence drop the cache when
+   * patching is not possible. */
+  if (self->needs_rewalk ||
+      !mnb_launcher_tree_patch_cache (cache_path, self->changed_files))
+    {
+      g_debug ("%s Dropping cache '%s'", G_STRLOC, cache_path);
+      g_unlink (cache_path);
+    }
+
+  g_hash_table_remove_all (self->changed_files);
+  self->needs_rewalk = FALSE;
+  g_free (cache_path);
+
   self->monitor_function (self, self->user_data);
 
   return FALSE;
@@ -105,6 +138,8 @@ mnb_launcher_monitor_free (MnbLauncherMonitor *self)
 
   g_return_if_fail (self);
 
+  g_idle_remove_by_data (self);
+
   g_signal_handlers_disconnect_by_func (self->applications,
                                         applications_menu_changed_cb,
                                         NULL);
@@ -124,9 +159,27 @@ mnb_launcher_monitor_free (MnbLauncherMonitor *self)
       iter = g_slist_delete_link (iter, iter);
     }
 
+  g_hash_table_destroy (self->changed_files);
+
   g_free (self);
 }
 
+static void
+mnb_launcher_monitor_add_changed_file (MnbLauncherMonitor *self,
+                                       GFile              *file)
+{
+  gchar *path;
+
+  path = g_file_get_path (file);
+  if (path == NULL)
+    return;
+
+  /* New sub-directories can only be picked up by walking the menu. */
+  if (g_file_test (path, G_FILE_TEST_IS_DIR))
+    self->needs_rewalk = TRUE;
+
+  g_hash_table_insert (self->changed_files, path, NULL);
+}
 
 static void
 applications_directory_changed_cb (GFileMonitor       *monitor,
@@ -135,6 +188,10 @@ applications_directory_changed_cb (GFileMonitor       *monitor,
                                    GFileMonitorEvent   event_type,
                                    MnbLauncherMonitor *self)
 {
+  mnb_launcher_monitor_add_changed_file (self, file);
+  if (other_file)
+    mnb_launcher_monitor_add_changed_file (self, other_file);
+
   /* Filter multiple notifications. */
   g_idle_remove_by_data (self);
   g_idle_add_full (G_PRIORITY_LOW,
@@ -147,17 +204,17 @@ applications_directory_changed_cb (GFileMonitor       *monitor,
  */
 
 static MnbLauncherApplication *
-mnb_launcher_application_create_from_gmenu_entry (GMenuTreeEntry *entry)
+mnb_launcher_application_create_from_app_info (GAppInfo    *app_info,
+                                               const gchar *desktop_file)
 {
   MnbLauncherApplication *self = NULL;
   int       argc;
   char    **argv;
   GError   *error = NULL;
-  GAppInfo *app_info;
-
-  g_return_val_if_fail (entry, NULL);
+  GIcon    *icon;
+  gchar    *icon_name;
 
-  app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
+  g_return_val_if_fail (app_info, NULL);
 
   if (!g_shell_parse_argv (g_app_info_get_commandline (app_info),
                            &argc, &argv, &error))
@@ -167,66 +224,96 @@ mnb_launcher_application_create_from_gmenu_entry (GMenuTreeEntry *entry)
     }
   else if (argc > 0)
     {
+      icon = g_app_info_get_icon (app_info);
+      icon_name = icon ? g_icon_to_string (icon) : NULL;
+
       self =
         mnb_launcher_application_new (g_app_info_get_display_name (app_info),
-                                      g_icon_to_string (g_app_info_get_icon (app_info)),
+                                      icon_name,
                                       g_app_info_get_description (app_info),
                                       argv[0],
-                                      gmenu_tree_entry_get_desktop_file_path (entry));
+                                      desktop_file);
 
+      g_free (icon_name);
       g_strfreev (argv);
     }
 
   return self;
 }
 
-/*
- * MnbLauncherDirectory.
- */
-
-static MnbLauncherDirectory *
-mnb_launcher_directory_new (GMenuTreeDirectory *branch)
+static gint
+mnb_launcher_application_compare_desktop_file (MnbLauncherApplication *self,
+                                               const gchar            *desktop_file)
 {
-  MnbLauncherDirectory *self;
+  return g_strcmp0 (mnb_launcher_application_get_desktop_file (self),
+                    desktop_file);
+}
 
-  g_return_val_if_fail (branch, NULL);
+static gboolean
+mnb_launcher_strv_contains (gchar       **strv,
+                            const gchar  *string)
+{
+  guint i;
 
-  self = g_new0 (MnbLauncherDirectory, 1);
-  self->id = g_strdup (gmenu_tree_directory_get_menu_id (branch));
-  self->name = g_strdup (gmenu_tree_directory_get_name (branch));
+  for (i = 0; strv[i]; i++)
+    {
+      if (0 == g_strcmp0 (strv[i], string))
+        return TRUE;
+    }
 
-  return self;
+  return FALSE;
 }
 
-static MnbLauncherDirectory *
-mnb_launcher_directory_new_from_cache (const gchar **attribute_names,
-                                       const gchar **attribute_values)
+/*
+ * Intersect two ";"-separated lists of desktop categories.
+ * NULL stands for "no entry seen yet", i.e. all categories.
+ */
+static gchar *
+mnb_launcher_categories_intersect (const gchar *categories,
+                                   const gchar *other)
 {
-  MnbLauncherDirectory *self;
-  guint i;
-  gboolean have_id = FALSE;
-  gboolean have_name = FALSE;;
+  gchar   **strv;
+  gchar   **other_strv;
+  GString  *ret;
+  guint     i;
 
-  g_return_val_if_fail (attribute_names, NULL);
-  g_return_val_if_fail (attribute_values, NULL);
+  if (categories == NULL)
+    return g_strdup (other ? other : "");
 
-  self = g_new0 (MnbLauncherDirectory, 1);
+  strv = g_strsplit (categories, ";", -1);
+  other_strv = g_strsplit (other ? other : "", ";", -1);
+  ret = g_string_new ("");
 
-  for (i = 0; attribute_names[i]; i++)
+  for (i = 0; strv[i]; i++)
     {
-      if (0 == g_strcmp0 (attribute_names[i], "id"))
+      if (*strv[i] &&
+          mnb_launcher_strv_contains (other_strv, strv[i]))
         {
-          self->id = g_strdup (attribute_values[i]);
-          have_id = TRUE;
-        }
-      else if (0 == g_strcmp0 (attribute_names[i], "name"))
-        {
-          self->name = g_strdup (attribute_values[i]);
-          have_name = TRUE;
+          g_string_append (ret, strv[i]);
+          g_string_append_c (ret, ';');
         }
     }
 
-  g_warn_if_fail (have_id && have_name);
+  g_strfreev (strv);
+  g_strfreev (other_strv);
+
+  return g_string_free (ret, FALSE);
+}
+
+/*
+ * MnbLauncherDirectory.
+ */
+
+static MnbLauncherDirectory *
+mnb_launcher_directory_new (GMenuTreeDirectory *branch)
+{
+  MnbLauncherDirectory *self;
+
+  g_return_val_if_fail (branch, NULL);
+
+  self = g_new0 (MnbLauncherDirectory, 1);
+  self->id = g_strdup (gmenu_tree_directory_get_menu_id (branch));
+  self->name = g_strdup (gmenu_tree_directory_get_name (branch));
 
   return self;
 }
@@ -238,6 +325,7 @@ mnb_launcher_directory_free (MnbLauncherDirectory *self)
 
   g_free (self->id);
   g_free (self->name);
+  g_free (self->categories);
 
   iter = self->entries;
   while (iter)
@@ -249,26 +337,46 @@ mnb_launcher_directory_free (MnbLauncherDirectory *self)
   g_free (self);
 }
 
-static void
-mnb_launcher_directory_write_xml (MnbLauncherDirectory const  *self,
-                                  FILE                        *fp)
+/*
+ * Create an application for the directory, the caller adds it to the entries.
+ * Keeps track of the categories common to all entries, so new desktop files
+ * can be placed into the cached tree without asking gmenu.
+ */
+static MnbLauncherApplication *
+mnb_launcher_directory_create_application (MnbLauncherDirectory  *self,
+                                           GDesktopAppInfo       *info,
+                                           const gchar           *desktop_file)
 {
-  GList const *app_iter;
-  gchar       *text;
+  MnbLauncherApplication  *app;
+  gchar                   *categories;
 
-  text = g_markup_printf_escaped ("  <category id=\"%s\" name=\"%s\">\n",
-                                   self->id,
-                                   self->name);
-  fputs (text, fp);
-  g_free (text);
-  for (app_iter = self->entries;
-       app_iter;
-       app_iter = app_iter->next)
+  app = mnb_launcher_application_create_from_app_info (G_APP_INFO (info),
+                                                       desktop_file);
+  if (app)
     {
-      mnb_launcher_application_write_xml ((MnbLauncherApplication const *) app_iter->data,
-                                          fp);
+      categories =
+        mnb_launcher_categories_intersect (self->categories,
+                                           g_desktop_app_info_get_categories (info));
+      g_free (self->categories);
+      self->categories = categories;
     }
-  fputs ("  </category>\n", fp);
+
+  return app;
+}
+
+static void
+mnb_launcher_directory_prepend_gmenu_entry (MnbLauncherDirectory *self,
+                                            GMenuTreeEntry       *entry)
+{
+  MnbLauncherApplication *app;
+
+  g_return_if_fail (entry);
+
+  app = mnb_launcher_directory_create_application (self,
+                                                   gmenu_tree_entry_get_app_info (entry),
+                                                   gmenu_tree_entry_get_desktop_file_path (entry));
+  if (app)
+    self->entries = g_list_prepend (self->entries, app);
 }
 
 /*
@@ -296,10 +404,9 @@ get_all_applications_from_alias (GMenuTreeAlias *alias,
   switch (gmenu_tree_alias_get_aliased_item_type (alias))
     {
     case GMENU_TREE_ITEM_ENTRY:
-      directory->entries = g_list_prepend (
-        directory->entries,
-        mnb_launcher_application_create_from_gmenu_entry (
-                                                          gmenu_tree_alias_get_aliased_entry (alias)));
+      mnb_launcher_directory_prepend_gmenu_entry (
+        directory,
+        gmenu_tree_alias_get_aliased_entry (alias));
       break;
 
     case GMENU_TREE_ITEM_DIRECTORY:
@@ -345,10 +452,9 @@ get_all_applications_from_dir (GMenuTreeDirectory *branch,
             /* Can be NULL for root dir. */
             if (directory)
               {
-                directory->entries =
-                    g_list_prepend (
-                      directory->entries,
-                      mnb_launcher_application_create_from_gmenu_entry (gmenu_tree_iter_get_entry (iter)));
+                mnb_launcher_directory_prepend_gmenu_entry (
+                  directory,
+                  gmenu_tree_iter_get_entry (iter));
               }
             break;
 
@@ -377,25 +483,9 @@ struct MnbLauncherTree_ {
   GMenuTree *applications;
   GMenuTree *settings;
   GSList    *watch_list;
+  gboolean   loaded;
 };
 
-typedef enum {
-  ACCUMULATOR_STATE_INVALID = 0,
-  ACCUMULATOR_STATE_CACHE,
-  ACCUMULATOR_STATE_CATEGORY,
-  ACCUMULATOR_STATE_APPLICATION,
-  ACCUMULATOR_STATE_APPLICATION_NAME,
-  ACCUMULATOR_STATE_APPLICATION_EXECUTABLE,
-  ACCUMULATOR_STATE_APPLICATION_ICON,
-  ACCUMULATOR_STATE_APPLICATION_DESCRIPTION
-} AccumulatorState;
-
-typedef struct {
-  GList             *categories;
-  GSList            *watch_list;
-  AccumulatorState   state;
-} Accumulator;
-
 MnbLauncherTree *
 mnb_launcher_tree_create (void)
 {
@@ -403,6 +493,7 @@ mnb_launcher_tree_create (void)
 
   self = g_new0 (MnbLauncherTree, 1);
 
+  /* The menus are only loaded on cache miss, see mnb_launcher_tree_load(). */
   self->applications = gmenu_tree_new ("applications.menu",
                                        GMENU_TREE_FLAGS_NONE);
 
@@ -411,30 +502,40 @@ mnb_launcher_tree_create (void)
                     G_CALLBACK (applications_menu_changed_cb),
                     NULL);
 
+#ifdef MNB_LAUNCHER_TREE_LOAD_SETTINGS
+  self->settings = gmenu_tree_new ("settings.menu",
+                                   GMENU_TREE_FLAGS_NONE);
+
+  g_signal_connect (self->settings,
+                    "changed",
+                    G_CALLBACK (settings_menu_changed_cb),
+                    NULL);
+#endif
+
+  return self;
+}
+
+static gboolean
+mnb_launcher_tree_load (MnbLauncherTree *self)
+{
   GError *error = NULL;
 
-  g_return_val_if_fail (self, NULL);
+  if (self->loaded)
+    return TRUE;
 
   if (!gmenu_tree_load_sync (self->applications, &error))
     {
       g_warning ("Failed to load apps: %s", error->message);
       g_clear_error (&error);
-      return NULL;
+      return FALSE;
     }
 
 #ifdef MNB_LAUNCHER_TREE_LOAD_SETTINGS
-  self->settings = gmenu_tree_new ("settings.menu",
-                                   GMENU_TREE_FLAGS_NONE);
-
-  g_signal_connect (self->settings,
-                    "changed",
-                    G_CALLBACK (settings_menu_changed_cb),
-                    NULL);
   settings_menu_changed_cb (self->settings);
 #endif
 
-  applications_menu_changed_cb (self->applications);
-  return self;
+  self->loaded = TRUE;
+  return TRUE;
 }
 
 void
@@ -479,23 +580,6 @@ mnb_launcher_tree_free (MnbLauncherTree *self)
   g_free (self);
 }
 
-static void
-mnb_launcher_tree_write_xml (GList const *tree,
-                             FILE        *fp)
-{
-  GList const *directory_iter;
-
-  fputs ("<cache>\n", fp);
-  for (directory_iter = tree;
-       directory_iter;
-       directory_iter = directory_iter->next)
-    {
-      mnb_launcher_directory_write_xml ((MnbLauncherDirectory const *) directory_iter->data,
-                                        fp);
-    }
-  fputs ("</cache>\n", fp);
-}
-
 static GSList *
 mnb_launcher_tree_watch_list_add_watch_dir (GSList      *watch_list,
                                             const gchar *dir)
@@ -515,6 +599,48 @@ mnb_launcher_tree_watch_list_add_watch_dir (GSList      *watch_list,
   return g_slist_prepend (watch_list, g_strdup (dir));
 }
 
+static GSList *
+mnb_launcher_tree_watch_list_from_entries (GList const *tree)
+{
+  GList const *directory_iter;
+  GList const *entry_iter;
+  GSList      *watch_list;
+  gchar       *dir;
+
+  /* Always watch "~/.local/share/applications" */
+  dir = g_build_filename (g_get_user_data_dir (), "applications", NULL);
+  watch_list = mnb_launcher_tree_watch_list_add_watch_dir (NULL, dir);
+  g_free (dir);
+
+  for (directory_iter = tree;
+       directory_iter;
+       directory_iter = directory_iter->next)
+    {
+      MnbLauncherDirectory const *directory = directory_iter->data;
+
+      for (entry_iter = directory->entries;
+           entry_iter;
+           entry_iter = entry_iter->next)
+        {
+          const gchar *desktop_file =
+            mnb_launcher_application_get_desktop_file (entry_iter->data);
+
+          if (desktop_file == NULL)
+            {
+              g_warning ("%s Missing desktop file", G_STRLOC);
+              continue;
+            }
+
+          dir = g_path_get_dirname (desktop_file);
+          watch_list = mnb_launcher_tree_watch_list_add_watch_dir (watch_list,
+                                                                   dir);
+          g_free (dir);
+        }
+    }
+
+  return watch_list;
+}
+
 static GList *
 mnb_launcher_tree_list_categories_from_disk (MnbLauncherTree *self)
 {
@@ -523,6 +649,9 @@ mnb_launcher_tree_list_categories_from_disk (MnbLauncherTree *self)
 
   g_return_val_if_fail (self, NULL);
 
+  if (!mnb_launcher_tree_load (self))
+    return NULL;
+
   tree = NULL;
 
   /* Applications. */
@@ -539,418 +668,727 @@ mnb_launcher_tree_list_categories_from_disk (MnbLauncherTree *self)
   return tree;
 }
 
-static void
-_cache_parser_start_element (GMarkupParseContext *context,
-                             const gchar         *element_name,
-                             const gchar        **attribute_names,
-                             const gchar        **attribute_values,
-                             gpointer             user_data,
-                             GError             **error)
-{
-  Accumulator *self = (Accumulator *) user_data;
-
-  switch (self->state)
-    {
-      case ACCUMULATOR_STATE_INVALID:
-        if (0 == g_strcmp0 ("cache", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_CACHE;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_CACHE:
-        if (0 == g_strcmp0 ("category", element_name))
-          {
-            MnbLauncherDirectory *cat
-              = mnb_launcher_directory_new_from_cache (attribute_names,
-                                                       attribute_values);
-            if (cat)
-              {
-                self->categories = g_list_prepend (self->categories, cat);
-                self->state = ACCUMULATOR_STATE_CATEGORY;
-                return;
-              }
-          }
-        break;
-      case ACCUMULATOR_STATE_CATEGORY:
-        if (0 == g_strcmp0 ("application", element_name))
-          {
-            MnbLauncherApplication  *app;
-            MnbLauncherDirectory    *cat;
-
-            g_return_if_fail (self->categories);
-            g_return_if_fail (self->categories->data);
-
-            cat = (MnbLauncherDirectory *) self->categories->data;
-            app = mnb_launcher_application_new_from_cache (attribute_names,
-                                                           attribute_values);
-            if (app)
-              {
-                const gchar *desktop_file = mnb_launcher_application_get_desktop_file (app);
-                if (desktop_file == NULL)
-                  g_warning ("%s Missing desktop file", G_STRLOC);
-                else {
-                  gchar *dir = g_path_get_dirname (desktop_file);
-                  self->watch_list = mnb_launcher_tree_watch_list_add_watch_dir (
-                                      self->watch_list,
-                                      dir);
-                  g_free (dir);
-                }
-                cat->entries = g_list_prepend (cat->entries, app);
-                self->state = ACCUMULATOR_STATE_APPLICATION;
-
-                return;
-              }
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION:
-        if (0 == g_strcmp0 ("name", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION_NAME;
-            return;
-          }
-        else if (0 == g_strcmp0 ("executable", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION_EXECUTABLE;
-            return;
-          }
-        else if (0 == g_strcmp0 ("icon", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION_ICON;
-            return;
-          }
-        else if (0 == g_strcmp0 ("description", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION_DESCRIPTION;
-            return;
-          }
-        break;
-      /* Fall thru. */
-      case ACCUMULATOR_STATE_APPLICATION_NAME:
-      case ACCUMULATOR_STATE_APPLICATION_EXECUTABLE:
-      case ACCUMULATOR_STATE_APPLICATION_ICON:
-      case ACCUMULATOR_STATE_APPLICATION_DESCRIPTION:
-        ;
-    }
-
-    g_set_error (error, 0, 0, "%s Unknown element '%s' in state '%d'",
-                 G_STRLOC,
-                 element_name,
-                 self->state);
+/*
+ * Binary menu cache.
+ *
+ * The file is mapped at startup and consists of a header, the fingerprints
+ * (mtime in nanoseconds and inode) of all directories holding desktop files, the category
+ * and application records, and finally a table of nul-terminated strings
+ * that the records refer to by offset. Applications are stored in category
+ * order, each category record tells how many belong to it.
+ */
+
+typedef struct {
+  gchar   magic[8];
+  guint32 version;
+  guint32 n_watch_dirs;
+  guint32 n_directories;
+  guint32 n_applications;
+  guint32 strings_size;
+  guint32 padding;
+  gint64  timestamp;
+} MnbLauncherCacheHeader;
+
+typedef struct {
+  gint64  mtime;
+  guint64 inode;
+  guint32 path;
+  guint32 mtime_nsec;
+} MnbLauncherCacheWatchDir;
+
+typedef struct {
+  guint32 id;
+  guint32 name;
+  guint32 categories;
+  guint32 n_applications;
+} MnbLauncherCacheDirectory;
+
+typedef struct {
+  guint32 name;
+  guint32 icon;
+  guint32 description;
+  guint32 executable;
+  guint32 desktop_file;
+  guint32 padding;
+} MnbLauncherCacheApplication;
+
+typedef struct {
+  GByteArray  *strings;
+  GHashTable  *offsets;
+} MnbLauncherCacheWriter;
+
+typedef struct {
+  const gchar *strings;
+  guint32      strings_size;
+  gboolean     valid;
+} MnbLauncherCacheReader;
+
+static gchar *
+mnb_launcher_tree_get_cache_path (void)
+{
+  const gchar *cache_dir = g_get_user_cache_dir ();
+  const gchar *lang = g_getenv ("LANG");
+  gchar       *cache_file;
+  gchar       *cache_path;
+
+  if (!g_file_test (cache_dir, G_FILE_TEST_IS_DIR))
+    {
+      g_mkdir (cache_dir, 0755);
+    }
+
+  cache_file = g_strdup_printf ("%s.%s.bin",
+                                MNB_LAUNCHER_TREE_CACHE_FILE,
+                                lang ? lang : "C");
+  cache_path = g_build_filename (cache_dir, cache_file, NULL);
+  g_free (cache_file);
+
+  return cache_path;
 }
 
-static void
-_cache_parser_end_element (GMarkupParseContext *context,
-                           const gchar         *element_name,
-                           gpointer             user_data,
-                           GError             **error)
-{
-  Accumulator *self = (Accumulator *) user_data;
-
-  switch (self->state)
-    {
-      case ACCUMULATOR_STATE_INVALID:
-        /* Break to error. */
-        break;
-      case ACCUMULATOR_STATE_CACHE:
-        if (0 == g_strcmp0 ("cache", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_INVALID;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_CATEGORY:
-        if (0 == g_strcmp0 ("category", element_name))
-          {
-            MnbLauncherDirectory *cat;
-
-            g_return_if_fail (self->categories);
-            g_return_if_fail (self->categories->data);
-
-            cat = (MnbLauncherDirectory *) self->categories->data;
-            cat->entries = g_list_reverse (cat->entries);
-
-            self->state = ACCUMULATOR_STATE_CACHE;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION:
-        if (0 == g_strcmp0 ("application", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_CATEGORY;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION_NAME:
-        if (0 == g_strcmp0 ("name", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION_EXECUTABLE:
-        if (0 == g_strcmp0 ("executable", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION_ICON:
-        if (0 == g_strcmp0 ("icon", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION;
-            return;
-          }
-        break;
-      case ACCUMULATOR_STATE_APPLICATION_DESCRIPTION:
-        if (0 == g_strcmp0 ("description", element_name))
-          {
-            self->state = ACCUMULATOR_STATE_APPLICATION;
-            return;
-          }
-        break;
-    }
-
-    g_set_error (error, 0, 0, "%s Unknown element '%s' in state '%d'",
-                 G_STRLOC,
-                 element_name,
-                 self->state);
+static guint32
+mnb_launcher_cache_writer_add_string (MnbLauncherCacheWriter *self,
+                                      const gchar            *string)
+{
+  gpointer offset;
+
+  if (string == NULL)
+    return MNB_LAUNCHER_TREE_CACHE_NO_STRING;
+
+  if (g_hash_table_lookup_extended (self->offsets, string, NULL, &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  offset = GUINT_TO_POINTER (self->strings->len);
+  g_byte_array_append (self->strings,
+                       (guint8 const *) string,
+                       strlen (string) + 1);
+  g_hash_table_insert (self->offsets, (gpointer) string, offset);
+
+  return GPOINTER_TO_UINT (offset);
 }
 
+static const gchar *
+mnb_launcher_cache_reader_get_string (MnbLauncherCacheReader *self,
+                                      guint32                 offset)
+{
+  if (offset == MNB_LAUNCHER_TREE_CACHE_NO_STRING)
+    return NULL;
+
+  /* The table is nul-terminated, so every offset into it is a valid string. */
+  if (offset >= self->strings_size)
+    {
+      self->valid = FALSE;
+      return NULL;
+    }
+
+  return self->strings + offset;
+}
+
+static gint64
+mnb_launcher_cache_now (void)
+{
+  return g_get_real_time () * 1000;
+}
+
+/*
+ * Record the fingerprint of a watched directory. Directories that changed
+ * after @not_before (nanoseconds since the epoch) may have changed again
+ * without their mtime showing it, so they never match; pass 0 to trust the
+ * current mtime, as for directories that were just patched while their
+ * monitor is running.
+ */
 static void
-_cache_parser_text (GMarkupParseContext *context,
-                    const gchar         *text,
-                    gsize                text_len,
-                    gpointer             user_data,
-                    GError             **error)
+mnb_launcher_cache_fingerprint (MnbLauncherCacheWatchDir  *record,
+                                const gchar               *path,
+                                gint64                     not_before)
 {
-  Accumulator *self = (Accumulator *) user_data;
+  struct stat watch_stat;
 
-  switch (self->state)
+  if (0 == stat (path, &watch_stat))
     {
-      case ACCUMULATOR_STATE_INVALID:
-        /* Ignore text here. */
-        return;
-      case ACCUMULATOR_STATE_CACHE:
-        /* Ignore text here. */
-        return;
-      case ACCUMULATOR_STATE_CATEGORY:
-        /* Ignore text here. */
-        return;
-      case ACCUMULATOR_STATE_APPLICATION:
-        /* Ignore text here. */
+      gint64 mtime = (gint64) watch_stat.st_mtim.tv_sec * 1000000000 +
+                     watch_stat.st_mtim.tv_nsec;
+
+      record->mtime = watch_stat.st_mtim.tv_sec;
+      record->mtime_nsec = watch_stat.st_mtim.tv_nsec;
+      record->inode = watch_stat.st_ino;
+
+      if (not_before == 0)
         return;
-      /* Fall thru. */
-      case ACCUMULATOR_STATE_APPLICATION_NAME:
-      case ACCUMULATOR_STATE_APPLICATION_EXECUTABLE:
-      case ACCUMULATOR_STATE_APPLICATION_ICON:
-      case ACCUMULATOR_STATE_APPLICATION_DESCRIPTION:
-        {
-          MnbLauncherDirectory    *cat;
-          MnbLauncherApplication  *app;
 
-          g_return_if_fail (self->categories);
-          g_return_if_fail (self->categories->data);
-          cat = (MnbLauncherDirectory *) self->categories->data;
-          g_return_if_fail (cat->entries);
-          g_return_if_fail (cat->entries->data);
+      /* File systems without sub-second timestamps only tell seconds
+       * apart, so changes in the same second as the menu walk would go
+       * unnoticed there. */
+      if (watch_stat.st_mtim.tv_nsec == 0)
+        not_before -= not_before % 1000000000;
+      else
+        not_before -= MNB_LAUNCHER_TREE_CACHE_CLOCK_SLACK_NS;
 
-          app = (MnbLauncherApplication *) cat->entries->data;
-          switch (self->state)
-            {
-              case ACCUMULATOR_STATE_APPLICATION_NAME:
-                mnb_launcher_application_set_name (app, text);
-                return;
-              case ACCUMULATOR_STATE_APPLICATION_EXECUTABLE:
-                mnb_launcher_application_set_executable (app, text);
-                return;
-              case ACCUMULATOR_STATE_APPLICATION_ICON:
-                mnb_launcher_application_set_icon (app, text);
-                return;
-              case ACCUMULATOR_STATE_APPLICATION_DESCRIPTION:
-                mnb_launcher_application_set_description (app, text);
-                return;
-              default:
-                ; /* Shut up compiler, all cases handled in outer switch. */
-            }
-        }
+      if (mtime >= not_before)
+        record->mtime = -1;
+    }
+  else
+    {
+      /* Non-existing dirs, e.g. "~/.local/share/applications" is being
+       * watched even if not existing, so we get notified about the first
+       * per user app install. */
+      record->mtime = 0;
+      record->mtime_nsec = 0;
+      record->inode = 0;
     }
 }
 
-static GList *
-mnb_launcher_tree_list_categories_from_cache (MnbLauncherTree *self,
-                                              const gchar     *cache_buffer,
-                                              gsize            buffer_size)
-{
-  /* Accumulator appends to existing watches. */
-  Accumulator accumulator = {
-    .categories = NULL,
-    .watch_list = self->watch_list,
-    .state = ACCUMULATOR_STATE_INVALID
-  };
-  GMarkupParser parser = {
-    .start_element = _cache_parser_start_element,
-    .end_element   = _cache_parser_end_element,
-    .text          = _cache_parser_text,
-    .passthrough   = NULL,
-    .error         = NULL
-  };
-  GMarkupParseContext *context = g_markup_parse_context_new (&parser,
-                                                             0,
-                                                             &accumulator,
-                                                             NULL);
-  GError *error = NULL;
+static gboolean
+mnb_launcher_cache_fingerprint_matches (MnbLauncherCacheWatchDir const  *record,
+                                        const gchar                     *path)
+{
+  struct stat watch_stat;
+
+  if (0 != stat (path, &watch_stat))
+    return record->inode == 0;
+
+  return record->mtime == (gint64) watch_stat.st_mtim.tv_sec &&
+         record->mtime_nsec == (guint32) watch_stat.st_mtim.tv_nsec &&
+         record->inode == (guint64) watch_stat.st_ino;
+}
 
-  g_markup_parse_context_parse (context, cache_buffer, buffer_size, &error);
-  if (error)
+static gboolean
+mnb_launcher_tree_write_cache (const gchar  *cache_path,
+                               GList const  *tree,
+                               GSList const *watch_list,
+                               gint64        not_before,
+                               GHashTable   *trusted_dirs)
+{
+  MnbLauncherCacheHeader  header;
+  MnbLauncherCacheWriter  writer;
+  GArray                 *watch_dirs;
+  GArray                 *directories;
+  GArray                 *applications;
+  GByteArray             *buffer;
+  GList const            *directory_iter;
+  GList const            *entry_iter;
+  GSList const           *watch_iter;
+  GError                 *error = NULL;
+  gboolean                ret;
+
+  writer.strings = g_byte_array_new ();
+  writer.offsets = g_hash_table_new (g_str_hash, g_str_equal);
+  watch_dirs = g_array_new (FALSE, TRUE, sizeof (MnbLauncherCacheWatchDir));
+  directories = g_array_new (FALSE, TRUE, sizeof (MnbLauncherCacheDirectory));
+  applications = g_array_new (FALSE, TRUE, sizeof (MnbLauncherCacheApplication));
+
+  for (watch_iter = watch_list; watch_iter; watch_iter = watch_iter->next)
+    {
+      MnbLauncherCacheWatchDir record = { 0, };
+
+      record.path = mnb_launcher_cache_writer_add_string (&writer,
+                                                          watch_iter->data);
+      mnb_launcher_cache_fingerprint (&record,
+                                      watch_iter->data,
+                                      trusted_dirs &&
+                                      g_hash_table_lookup_extended (trusted_dirs,
+                                                                    watch_iter->data,
+                                                                    NULL, NULL) ?
+                                        0 : not_before);
+      g_array_append_val (watch_dirs, record);
+    }
+
+  for (directory_iter = tree;
+       directory_iter;
+       directory_iter = directory_iter->next)
+    {
+      MnbLauncherDirectory const *directory = directory_iter->data;
+      MnbLauncherCacheDirectory   record = { 0, };
+
+      record.id = mnb_launcher_cache_writer_add_string (&writer,
+                                                        directory->id);
+      record.name = mnb_launcher_cache_writer_add_string (&writer,
+                                                          directory->name);
+      record.categories =
+        mnb_launcher_cache_writer_add_string (&writer, directory->categories);
+
+      for (entry_iter = directory->entries;
+           entry_iter;
+           entry_iter = entry_iter->next)
+        {
+          MnbLauncherApplication      *app = entry_iter->data;
+          MnbLauncherCacheApplication  app_record = { 0, };
+
+          app_record.name =
+            mnb_launcher_cache_writer_add_string (&writer,
+                                                  mnb_launcher_application_get_name (app));
+          app_record.icon =
+            mnb_launcher_cache_writer_add_string (&writer,
+                                                  mnb_launcher_application_get_icon (app));
+          app_record.description =
+            mnb_launcher_cache_writer_add_string (&writer,
+                                                  mnb_launcher_application_get_description (app));
+          app_record.executable =
+            mnb_launcher_cache_writer_add_string (&writer,
+                                                  mnb_launcher_application_get_executable (app));
+          app_record.desktop_file =
+            mnb_launcher_cache_writer_add_string (&writer,
+                                                  mnb_launcher_application_get_desktop_file (app));
+          g_array_append_val (applications, app_record);
+          record.n_applications++;
+        }
+
+      g_array_append_val (directories, record);
+    }
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, MNB_LAUNCHER_TREE_CACHE_MAGIC, sizeof (header.magic));
+  header.version = MNB_LAUNCHER_TREE_CACHE_VERSION;
+  header.n_watch_dirs = watch_dirs->len;
+  header.n_directories = directories->len;
+  header.n_applications = applications->len;
+  header.strings_size = writer.strings->len;
+  header.timestamp = time (NULL);
+
+  buffer = g_byte_array_sized_new (sizeof (header) +
+                                   watch_dirs->len * sizeof (MnbLauncherCacheWatchDir) +
+                                   directories->len * sizeof (MnbLauncherCacheDirectory) +
+                                   applications->len * sizeof (MnbLauncherCacheApplication) +
+                                   writer.strings->len);
+  g_byte_array_append (buffer, (guint8 const *) &header, sizeof (header));
+  g_byte_array_append (buffer,
+                       (guint8 const *) watch_dirs->data,
+                       watch_dirs->len * sizeof (MnbLauncherCacheWatchDir));
+  g_byte_array_append (buffer,
+                       (guint8 const *) directories->data,
+                       directories->len * sizeof (MnbLauncherCacheDirectory));
+  g_byte_array_append (buffer,
+                       (guint8 const *) applications->data,
+                       applications->len * sizeof (MnbLauncherCacheApplication));
+  g_byte_array_append (buffer, writer.strings->data, writer.strings->len);
+
+  /* Written to a temporary file and renamed, so readers never see a
+   * partial cache. */
+  ret = g_file_set_contents (cache_path,
+                             (const gchar *) buffer->data,
+                             buffer->len,
+                             &error);
+  if (!ret)
     {
       g_warning ("%s %s", G_STRLOC, error->message);
       g_clear_error (&error);
     }
-  g_warn_if_fail (accumulator.state == ACCUMULATOR_STATE_INVALID);
 
-  /* Take over the list of dirs to watch. */
-  self->watch_list = accumulator.watch_list;
-  accumulator.watch_list = NULL;
+  g_byte_array_free (buffer, TRUE);
+  g_array_free (applications, TRUE);
+  g_array_free (directories, TRUE);
+  g_array_free (watch_dirs, TRUE);
+  g_hash_table_destroy (writer.offsets);
+  g_byte_array_free (writer.strings, TRUE);
 
-  return g_list_reverse (accumulator.categories);
+  return ret;
 }
 
+/*
+ * Map the cache and build the tree from it, fails when the cache is missing,
+ * corrupt or out of date. Directories in `changed_dirs' are not checked
+ * against their fingerprints, they are about to be patched.
+ */
 static gboolean
-mnb_launcher_tree_test_cache (MnbLauncherTree *self,
-                              const gchar     *cache_path)
+mnb_launcher_tree_read_cache (const gchar  *cache_path,
+                              GHashTable   *changed_dirs,
+                              GList       **tree_out,
+                              GSList      **watch_list_out)
 {
-  gchar        binary_path[PATH_MAX] = { 0, };
-  struct stat  binary_stat;
-  struct stat  cache_stat;
-  struct stat  watch_stat;
-  GSList      *iter;
+  GMappedFile                       *mapped;
+  MnbLauncherCacheHeader const      *header;
+  MnbLauncherCacheWatchDir const    *watch_dirs;
+  MnbLauncherCacheDirectory const   *directories;
+  MnbLauncherCacheApplication const *applications;
+  MnbLauncherCacheReader             reader;
+  gchar const   *data;
+  gsize          length;
+  guint64        expected_length;
+  guint64        n_applications;
+  gchar          binary_path[PATH_MAX] = { 0, };
+  struct stat    binary_stat;
+  GList         *tree = NULL;
+  GSList        *watch_list = NULL;
+  guint          i, j;
+  GError        *error = NULL;
+
+  mapped = g_mapped_file_new (cache_path, FALSE, &error);
+  if (mapped == NULL)
+    {
+      g_debug ("%s %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+      return FALSE;
+    }
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  if (length < sizeof (MnbLauncherCacheHeader))
+    goto corrupt;
+
+  header = (MnbLauncherCacheHeader const *) data;
+  if (0 != memcmp (header->magic,
+                   MNB_LAUNCHER_TREE_CACHE_MAGIC,
+                   sizeof (header->magic)) ||
+      header->version != MNB_LAUNCHER_TREE_CACHE_VERSION)
+    goto corrupt;
+
+  expected_length = sizeof (MnbLauncherCacheHeader) +
+                    (guint64) header->n_watch_dirs * sizeof (MnbLauncherCacheWatchDir) +
+                    (guint64) header->n_directories * sizeof (MnbLauncherCacheDirectory) +
+                    (guint64) header->n_applications * sizeof (MnbLauncherCacheApplication) +
+                    header->strings_size;
+  if (expected_length != length ||
+      (header->strings_size > 0 &&
+       data[length - 1] != '\0'))
+    goto corrupt;
 
   /* Do not use cache if we don't have any directories to watch,
    * something must have gone wrong in that case. */
-  g_return_val_if_fail (self->watch_list, FALSE);
+  if (header->n_watch_dirs == 0)
+    goto corrupt;
 
-  if (0 != stat (cache_path, &cache_stat))
+  /* Do not use cache when it's older than this binary,
+   * format or something might have changed. */
+  if (0 < readlink ("/proc/self/exe", binary_path, PATH_MAX - 1) &&
+      0 == stat (binary_path, &binary_stat) &&
+      binary_stat.st_mtime > header->timestamp)
     {
-      g_warning ("%s Could not stat '%s'",
-                  G_STRLOC,
-                  cache_path);
+      g_debug ("%s Cache miss, '%s' more recent",
+               G_STRLOC,
+               binary_path);
+      g_mapped_file_unref (mapped);
       return FALSE;
     }
 
-  /* Do not use cache when it's older than this binary,
-   * format or something might have changed. */
-  if (0 < readlink ("/proc/self/exe", binary_path, PATH_MAX))
+  watch_dirs = (MnbLauncherCacheWatchDir const *) (header + 1);
+  directories = (MnbLauncherCacheDirectory const *) (watch_dirs + header->n_watch_dirs);
+  applications = (MnbLauncherCacheApplication const *) (directories + header->n_directories);
+  reader.strings = (gchar const *) (applications + header->n_applications);
+  reader.strings_size = header->strings_size;
+  reader.valid = TRUE;
+
+  for (i = 0; i < header->n_watch_dirs; i++)
     {
-      if (0 == stat (binary_path, &binary_stat))
+      const gchar *path =
+        mnb_launcher_cache_reader_get_string (&reader, watch_dirs[i].path);
+
+      if (path == NULL)
+        goto corrupt;
+
+      if ((changed_dirs == NULL ||
+           !g_hash_table_lookup_extended (changed_dirs, path, NULL, NULL)) &&
+          !mnb_launcher_cache_fingerprint_matches (&watch_dirs[i], path))
         {
-          if (binary_stat.st_mtime > cache_stat.st_mtime)
-            {
-              g_debug ("%s Cache miss, '%s' more recent",
-                       G_STRLOC,
-                       binary_path);
-              return FALSE;
-            }
+          g_debug ("%s Cache miss, '%s' changed", G_STRLOC, path);
+          mnb_launcher_tree_free_watch_list (watch_list);
+          g_mapped_file_unref (mapped);
+          return FALSE;
         }
+
+      watch_list = g_slist_prepend (watch_list, g_strdup (path));
     }
 
-  for (iter = self->watch_list; iter; iter = iter->next)
+  n_applications = 0;
+  for (i = 0; i < header->n_directories; i++)
+    n_applications += directories[i].n_applications;
+  if (n_applications != header->n_applications)
+    goto corrupt;
+
+  for (i = 0; i < header->n_directories; i++)
     {
-      /* Skip non-exist dirs, e.g. "~/.local/share/applications" is being
-       * watched even if not existing, so we get notified about the first
-       * per user app install.
-       * FIXME: can this cause problems when entire dirs are removed and we
-       * still hit the cache -- probably not because /usr/share/applications
-       * and friends are rather persistant. */
-      if (g_file_test (iter->data, G_FILE_TEST_IS_DIR) &&
-          0 == stat ((const gchar *) iter->data, &watch_stat))
+      MnbLauncherDirectory *directory = g_new0 (MnbLauncherDirectory, 1);
+
+      directory->id =
+        g_strdup (mnb_launcher_cache_reader_get_string (&reader,
+                                                        directories[i].id));
+      directory->name =
+        g_strdup (mnb_launcher_cache_reader_get_string (&reader,
+                                                        directories[i].name));
+      directory->categories =
+        g_strdup (mnb_launcher_cache_reader_get_string (&reader,
+                                                        directories[i].categories));
+
+      for (j = 0; j < directories[i].n_applications; j++)
         {
-          if (watch_stat.st_mtime > cache_stat.st_mtime)
-            {
-              g_debug ("%s Cache miss, '%s' more recent",
-                       G_STRLOC,
-                       (const gchar *) iter->data);
-              return FALSE;
-            }
+          MnbLauncherCacheApplication const *record = applications++;
+          MnbLauncherApplication            *app;
+
+          app = mnb_launcher_application_new (
+                  mnb_launcher_cache_reader_get_string (&reader, record->name),
+                  mnb_launcher_cache_reader_get_string (&reader, record->icon),
+                  mnb_launcher_cache_reader_get_string (&reader, record->description),
+                  mnb_launcher_cache_reader_get_string (&reader, record->executable),
+                  mnb_launcher_cache_reader_get_string (&reader, record->desktop_file));
+          directory->entries = g_list_prepend (directory->entries, app);
         }
-      else
+      directory->entries = g_list_reverse (directory->entries);
+
+      tree = g_list_prepend (tree, directory);
+    }
+
+  if (!reader.valid)
+    goto corrupt;
+
+  g_mapped_file_unref (mapped);
+
+  *tree_out = g_list_reverse (tree);
+  *watch_list_out = g_slist_reverse (watch_list);
+
+  return TRUE;
+
+corrupt:
+  g_warning ("%s Corrupt cache '%s'", G_STRLOC, cache_path);
+  mnb_launcher_tree_free_entries (tree);
+  mnb_launcher_tree_free_watch_list (watch_list);
+  g_mapped_file_unref (mapped);
+
+  return FALSE;
+}
+
+/*
+ * Find the only category all of whose shared desktop categories are listed
+ * by a new entry, NULL if there is none or it is ambiguous.
+ */
+static MnbLauncherDirectory *
+mnb_launcher_tree_find_directory (GList const *tree,
+                                  const gchar *categories)
+{
+  MnbLauncherDirectory  *match = NULL;
+  GList const           *iter;
+  gchar                **entry_categories;
+  guint                  n_matches = 0;
+
+  if (categories == NULL)
+    return NULL;
+
+  entry_categories = g_strsplit (categories, ";", -1);
+
+  for (iter = tree; iter; iter = iter->next)
+    {
+      MnbLauncherDirectory   *directory = iter->data;
+      gchar                 **required;
+      gboolean                matches;
+      guint                   i;
+
+      /* Catch-all categories like "Other" are not matched. */
+      if (directory->categories == NULL ||
+          directory->categories[0] == '\0')
+        continue;
+
+      required = g_strsplit (directory->categories, ";", -1);
+      matches = TRUE;
+      for (i = 0; required[i] && matches; i++)
         {
-          g_warning ("%s Could not stat '%s'",
-                      G_STRLOC,
-                      (const gchar *) iter->data);
+          if (*required[i] &&
+              !mnb_launcher_strv_contains (entry_categories, required[i]))
+            matches = FALSE;
+        }
+      g_strfreev (required);
+
+      if (matches)
+        {
+          match = directory;
+          n_matches++;
         }
     }
 
-  return TRUE;
+  g_strfreev (entry_categories);
+
+  return n_matches == 1 ? match : NULL;
 }
 
-GList *
-mnb_launcher_tree_list_entries (MnbLauncherTree *self)
+/*
+ * Apply the current state of `desktop_file' to the cached tree, returns
+ * FALSE if this needs gmenu to figure out.
+ */
+static gboolean
+mnb_launcher_tree_patch_entry (GList        *tree,
+                               GSList const *watch_list,
+                               const gchar  *desktop_file)
 {
-  const gchar *cache_dir = g_get_user_cache_dir ();
-  gchar       *cache_file = g_strdup_printf ("%s.%s.xml",
-                                             MNB_LAUNCHER_TREE_CACHE_FILE,
-                                             g_getenv ("LANG"));
-  gchar       *cache_path = g_build_filename (cache_dir,
-                                              cache_file,
-                                              NULL);
-  gchar *cache_buffer = NULL;
-  gsize  buffer_size;
-  GList *tree = NULL;
-  gchar *user_apps_dir = NULL;
+  MnbLauncherDirectory    *directory = NULL;
+  MnbLauncherApplication  *app = NULL;
+  GDesktopAppInfo         *info;
+  GList                   *entry = NULL;
+  GList                   *iter;
+  GSList const            *watch_iter;
+  gchar                   *basename;
+  gchar                   *dirname;
+  gboolean                 shadowed = FALSE;
+
+  /* Desktop files of the same name in other directories shadow each other,
+   * leave resolving that to gmenu. */
+  basename = g_path_get_basename (desktop_file);
+  dirname = g_path_get_dirname (desktop_file);
+  for (watch_iter = watch_list;
+       watch_iter && !shadowed;
+       watch_iter = watch_iter->next)
+    {
+      gchar *path;
 
-  /* Avoid duplicate watches. */
-  mnb_launcher_tree_free_watch_list (self->watch_list);
-  self->watch_list = NULL;
+      if (0 == g_strcmp0 (dirname, watch_iter->data))
+        continue;
 
-  /* Always watch "~/.local/share/applications" */
-  user_apps_dir = g_build_filename (g_get_user_data_dir (),
-                                    "applications", NULL);
-  self->watch_list = mnb_launcher_tree_watch_list_add_watch_dir (self->watch_list,
-                                                                 user_apps_dir);
-  g_free (user_apps_dir);
+      path = g_build_filename (watch_iter->data, basename, NULL);
+      shadowed = g_file_test (path, G_FILE_TEST_EXISTS);
+      g_free (path);
+    }
+  g_free (basename);
+  g_free (dirname);
 
-  if (!g_file_test (cache_dir, G_FILE_TEST_IS_DIR))
+  if (shadowed)
     {
-      g_mkdir (cache_dir, 0755);
+      g_debug ("%s '%s' is shadowed", G_STRLOC, desktop_file);
+      return FALSE;
     }
 
-  if (g_file_get_contents (cache_path, &cache_buffer, &buffer_size, NULL))
+  for (iter = tree; iter && entry == NULL; iter = iter->next)
     {
-      /* This fills the list of watched dirs. */
-      tree = mnb_launcher_tree_list_categories_from_cache (self,
-                                                           cache_buffer,
-                                                           buffer_size);
-      if (!mnb_launcher_tree_test_cache (self, cache_path))
+      MnbLauncherDirectory *candidate = iter->data;
+
+      entry = g_list_find_custom (candidate->entries,
+                                  desktop_file,
+                                  (GCompareFunc) mnb_launcher_application_compare_desktop_file);
+      if (entry)
+        directory = candidate;
+    }
+
+  info = g_desktop_app_info_new_from_filename (desktop_file);
+  if (info && g_app_info_should_show (G_APP_INFO (info)))
+    {
+      if (directory == NULL)
         {
-          mnb_launcher_tree_free_entries (tree);
-          tree = NULL;
+          directory =
+            mnb_launcher_tree_find_directory (tree,
+                                              g_desktop_app_info_get_categories (info));
         }
-      else
+
+      if (directory == NULL)
         {
-          g_debug ("%s Cache hit", G_STRLOC);
+          g_debug ("%s Can not place '%s'", G_STRLOC, desktop_file);
+          g_object_unref (info);
+          return FALSE;
         }
-      g_free (cache_buffer);
+
+      app = mnb_launcher_directory_create_application (directory,
+                                                       info,
+                                                       desktop_file);
     }
 
-  if (tree == NULL)
+  if (info)
+    g_object_unref (info);
+
+  if (entry)
+    {
+      /* Changed or removed. */
+      g_object_unref (entry->data);
+      if (app)
+        entry->data = app;
+      else
+        directory->entries = g_list_delete_link (directory->entries, entry);
+    }
+  else if (app)
+    {
+      /* Installed. */
+      directory->entries = g_list_append (directory->entries, app);
+    }
+
+  return TRUE;
+}
+
+/*
+ * Patch the changed desktop files into the cache and refresh the directory
+ * fingerprints, so the next mnb_launcher_tree_list_entries() hits the cache.
+ */
+static gboolean
+mnb_launcher_tree_patch_cache (const gchar  *cache_path,
+                               GHashTable   *changed_files)
+{
+  GHashTable      *changed_dirs;
+  GHashTableIter   iter;
+  const gchar     *path;
+  GList           *tree = NULL;
+  GSList          *watch_list = NULL;
+  gint64           started;
+  gboolean         ret;
+
+  started = mnb_launcher_cache_now ();
+
+  changed_dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_iter_init (&iter, changed_files);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &path, NULL))
+    g_hash_table_insert (changed_dirs, g_path_get_dirname (path), NULL);
+
+  ret = mnb_launcher_tree_read_cache (cache_path,
+                                      changed_dirs,
+                                      &tree,
+                                      &watch_list);
+
+  /* Files other than desktop entries, e.g. mimeinfo.cache, only
+   * touch the directory fingerprints. */
+  g_hash_table_iter_init (&iter, changed_files);
+  while (ret && g_hash_table_iter_next (&iter, (gpointer *) &path, NULL))
+    {
+      if (g_str_has_suffix (path, ".desktop"))
+        ret = mnb_launcher_tree_patch_entry (tree, watch_list, path);
+    }
+
+  if (ret)
+    {
+      ret = mnb_launcher_tree_write_cache (cache_path,
+                                           tree,
+                                           watch_list,
+                                           started,
+                                           changed_dirs);
+      g_debug ("%s Patched %u files into cache",
+               G_STRLOC,
+               g_hash_table_size (changed_files));
+    }
+
+  mnb_launcher_tree_free_entries (tree);
+  mnb_launcher_tree_free_watch_list (watch_list);
+  g_hash_table_destroy (changed_dirs);
+
+  return ret;
+}
+
+GList *
+mnb_launcher_tree_list_entries (MnbLauncherTree *self)
+{
+  gchar   *cache_path;
+  GList   *tree = NULL;
+  gint64   started;
+
+  g_return_val_if_fail (self, NULL);
+
+  /* Avoid duplicate watches. */
+  mnb_launcher_tree_free_watch_list (self->watch_list);
+  self->watch_list = NULL;
+
+  cache_path = mnb_launcher_tree_get_cache_path ();
+
+  if (mnb_launcher_tree_read_cache (cache_path,
+                                    NULL,
+                                    &tree,
+                                    &self->watch_list))
+    {
+      g_debug ("%s Cache hit", G_STRLOC);
+    }
+  else
     {
-      FILE *fp;
       g_debug ("%s Cache miss", G_STRLOC);
+      started = mnb_launcher_cache_now ();
       tree = mnb_launcher_tree_list_categories_from_disk (self);
-      fp = fopen (cache_path, "w");
-      if (fp)
+      self->watch_list = mnb_launcher_tree_watch_list_from_entries (tree);
+      if (tree)
         {
-          mnb_launcher_tree_write_xml (tree, fp);
-          fclose (fp);
+          mnb_launcher_tree_write_cache (cache_path,
+                                         tree,
+                                         self->watch_list,
+                                         started,
+                                         NULL);
         }
-      else
-        g_warning ("%s Could not open '%s'",
-                   G_STRLOC,
-                   cache_path);
     }
 
-  g_free (cache_file);
   g_free (cache_path);
 
   return tree;
@@ -967,6 +1405,8 @@ mnb_launcher_tree_create_monitor  (MnbLauncherTree            *tree,
   g_return_val_if_fail (monitor_function, NULL);
 
   self = g_new0 (MnbLauncherMonitor, 1);
+  self->changed_files = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
 
   /* gmenu monitors */
   self->applications = g_object_ref (tree->applications);
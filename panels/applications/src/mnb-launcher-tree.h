@@ -57,6 +57,7 @@ void                  mnb_launcher_tree_free            (MnbLauncherTree
 typedef struct {
   gchar *id;
   gchar *name;
+  gchar *categories;  /* Desktop categories shared by all entries. */
   GList *entries;
 } MnbLauncherDirectory;
 
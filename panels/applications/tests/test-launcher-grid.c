@@ -0,0 +1,93 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <clutter/clutter.h>
+#include <mx/mx.h>
+#include "mnb-launcher-button.h"
+#include "mnb-launcher-grid.h"
+
+#define N_ITEMS     10000
+#define TILE_WIDTH  140
+#define TILE_HEIGHT  95
+
+static guint _n_created = 0;
+
+static ClutterActor *
+create_cb (MnbLauncherGrid *grid,
+           gpointer         data)
+{
+  ClutterActor *button;
+
+  button = g_object_new (MNB_TYPE_LAUNCHER_BUTTON, NULL);
+  clutter_actor_set_size (button, TILE_WIDTH, TILE_HEIGHT);
+  _n_created++;
+
+  return button;
+}
+
+static void
+bind_cb (MnbLauncherGrid *grid,
+         ClutterActor    *actor,
+         guint            item,
+         gpointer         data)
+{
+  gchar *title;
+
+  title = g_strdup_printf ("Launcher %u", item);
+  mnb_launcher_button_update (MNB_LAUNCHER_BUTTON (actor),
+                              NULL, title, "Category", NULL,
+                              "/bin/false", NULL);
+  g_free (title);
+}
+
+static gboolean
+report_cb (gpointer data)
+{
+  printf ("%u items, %u buttons\n", N_ITEMS, _n_created);
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterActor *stage;
+  ClutterActor *scroll;
+  ClutterActor *grid;
+  guint        *items;
+  guint         i;
+
+  if (!clutter_init (&argc, &argv))
+    return EXIT_FAILURE;
+
+  mx_style_load_from_file (mx_style_get_default (),
+                           "../data/theme/panel.css", NULL);
+
+  stage = clutter_stage_new ();
+  clutter_actor_set_size (stage, 800, 600);
+
+  scroll = mx_scroll_view_new ();
+  clutter_actor_set_size (scroll, 800, 600);
+  clutter_actor_add_child (stage, scroll);
+
+  grid = CLUTTER_ACTOR (mnb_launcher_grid_new ());
+  mnb_launcher_grid_set_virtual (MNB_LAUNCHER_GRID (grid),
+                                 TILE_WIDTH, TILE_HEIGHT,
+                                 create_cb, bind_cb, NULL);
+  mx_bin_set_child (MX_BIN (scroll), grid);
+
+  /* Every other item, in reverse, to exercise the position mapping. */
+  items = g_new (guint, N_ITEMS);
+  for (i = 0; i < N_ITEMS; i++)
+    items[i] = 2 * (N_ITEMS - i - 1);
+  mnb_launcher_grid_set_items (MNB_LAUNCHER_GRID (grid), items, N_ITEMS);
+  g_free (items);
+
+  g_timeout_add_seconds (1, report_cb, NULL);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  return EXIT_SUCCESS;
+}
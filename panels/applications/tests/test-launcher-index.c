@@ -0,0 +1,144 @@
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+#include "mnb-launcher-index.h"
+#include "mnb-launcher-tree.h"
+#include "config.h"
+
+/*
+ * Index all installed applications, then type the needles given on the
+ * command line one character at a time, comparing index lookups against
+ * a linear strstr() scan.
+ */
+
+static guint
+linear_scan (GPtrArray   *items,
+             const gchar *lcase_needle)
+{
+  guint n_matches = 0;
+  guint i;
+
+  for (i = 0; i < items->len; i++)
+    {
+      gchar **keys = g_ptr_array_index (items, i);
+      guint   k;
+
+      for (k = 0; keys[k]; k++)
+        if (strstr (keys[k], lcase_needle))
+          {
+            n_matches++;
+            break;
+          }
+    }
+
+  return n_matches;
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  MnbLauncherTree   *tree;
+  MnbLauncherIndex  *index;
+  GPtrArray         *items;
+  GList             *directories;
+  GList const       *directory_iter;
+  GTimer            *timer;
+  int                i;
+
+  setlocale (LC_ALL, "");
+  bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+  textdomain (GETTEXT_PACKAGE);
+
+  gtk_init (&argc, &argv);
+
+  tree = mnb_launcher_tree_create ();
+  directories = mnb_launcher_tree_list_entries (tree);
+  index = mnb_launcher_index_new ();
+  items = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+  timer = g_timer_new ();
+
+  for (directory_iter = directories;
+       directory_iter;
+       directory_iter = directory_iter->next)
+    {
+      MnbLauncherDirectory  *directory = directory_iter->data;
+      GList                 *entry_iter;
+
+      for (entry_iter = directory->entries;
+           entry_iter;
+           entry_iter = entry_iter->next)
+        {
+          MnbLauncherApplication *entry = entry_iter->data;
+          const gchar *keys[5];
+          gchar      **lcase_keys;
+          guint        n_keys = 0;
+          guint        k;
+
+          keys[n_keys++] = directory->name;
+          keys[n_keys++] = mnb_launcher_application_get_name (entry);
+          if (mnb_launcher_application_get_description (entry))
+            keys[n_keys++] = mnb_launcher_application_get_description (entry);
+          if (mnb_launcher_application_get_executable (entry))
+            keys[n_keys++] = mnb_launcher_application_get_executable (entry);
+          keys[n_keys] = NULL;
+
+          mnb_launcher_index_add (index, keys);
+
+          lcase_keys = g_new0 (gchar *, n_keys + 1);
+          for (k = 0; k < n_keys; k++)
+            lcase_keys[k] = g_utf8_strdown (keys[k], -1);
+          g_ptr_array_add (items, lcase_keys);
+        }
+    }
+
+  printf ("%u items indexed in %.3f ms\n",
+          mnb_launcher_index_get_size (index),
+          g_timer_elapsed (timer, NULL) * 1000);
+
+  for (i = 1; i < argc; i++)
+    {
+      gchar *needle = g_utf8_strdown (argv[i], -1);
+      gsize  len;
+
+      for (len = 1; len <= strlen (needle); len++)
+        {
+          gchar   *prefix = g_strndup (needle, len);
+          GArray  *results;
+          gdouble  index_time;
+          gdouble  scan_time;
+          guint    n_scanned;
+
+          g_timer_start (timer);
+          results = mnb_launcher_index_lookup (index, prefix);
+          index_time = g_timer_elapsed (timer, NULL);
+
+          g_timer_start (timer);
+          n_scanned = linear_scan (items, prefix);
+          scan_time = g_timer_elapsed (timer, NULL);
+
+          printf ("%-20s %4u matches\tindex %8.3f us\tscan %8.3f us\n",
+                  prefix, results->len, index_time * 1e6, scan_time * 1e6);
+          g_assert_cmpuint (results->len, ==, n_scanned);
+
+          g_array_free (results, TRUE);
+          g_free (prefix);
+        }
+
+      g_free (needle);
+    }
+
+  g_timer_destroy (timer);
+  g_ptr_array_free (items, TRUE);
+  mnb_launcher_index_free (index);
+  mnb_launcher_tree_free_entries (directories);
+  mnb_launcher_tree_free (tree);
+
+  return EXIT_SUCCESS;
+}
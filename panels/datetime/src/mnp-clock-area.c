@@ -23,6 +23,7 @@
 #include <config.h>
 #include <glib.h>
 #include <glib/gi18n-lib.h>
+#include <dawati-panel/mpl-timer.h>
 
 #include "mnp-clock-area.h"
 #include "mnp-clock-tile.h"
@@ -44,7 +45,6 @@ struct _MnpClockAreaPriv {
 	gfloat position;
 	time_t time_now;
 	guint source;
-	gboolean prop_sec_zero;
 
 	ZoneRemovedFunc zone_remove_func;
 	gpointer zone_remove_data;
@@ -53,6 +53,7 @@ struct _MnpClockAreaPriv {
 	gpointer zone_reorder_data;
 	gboolean tfh;
 	time_t last_time;
+	gint64 last_mono;
 };
 
 enum
@@ -184,7 +185,7 @@ mnp_clock_area_finalize (GObject *object)
 {
 	MnpClockArea *area = (MnpClockArea *)object;
 
-	g_source_remove (area->priv->source);
+	/* The tick timer went away with the actor */
 
 	if (area->priv->background) {
 		clutter_actor_destroy (area->priv->background);
@@ -286,18 +287,11 @@ clock_ticks (MnpClockArea *area)
 {
 	int i;
 	GPtrArray *tmp = area->priv->clock_tiles;
-	gboolean ret;
 
-	ret = mnp_clock_area_refresh_time(area, FALSE);
+	mnp_clock_area_refresh_time(area, FALSE);
 	for (i=0; i<tmp->len; i++) { 
 		mnp_clock_tile_refresh ((MnpClockTile *)tmp->pdata[i], area->priv->time_now, area->priv->tfh);
 	}
-	
-	if (!ret && !area->priv->prop_sec_zero) {
-		area->priv->prop_sec_zero = TRUE;
-		area->priv->source = g_timeout_add (60 * 1000, (GSourceFunc)clock_ticks, area);
-		return FALSE;
-	}
 
 	return TRUE;
 }
@@ -338,27 +332,23 @@ MnpClockArea *
 mnp_clock_area_new (void)
 {
 	MnpClockArea *area = g_object_new(MNP_TYPE_CLOCK_AREA, NULL);
-	int clk_sec = 60 - (time(NULL)%60);
 	GConfClient *client = gconf_client_get_default ();
 
 	area->priv = g_new0(MnpClockAreaPriv, 1);
 	area->priv->is_enabled = 1;
-	area->priv->prop_sec_zero = FALSE;
 	area->priv->clock_tiles = g_ptr_array_new ();
 	area->priv->position = 0.05;
 	mx_box_layout_set_orientation ((MxBoxLayout *)area, MX_ORIENTATION_VERTICAL);
 	mx_box_layout_set_enable_animations ((MxBoxLayout *)area, TRUE);
 	area->priv->time_now = time(NULL);
-	area->priv->last_time = area->priv->time_now - 60 + clk_sec;
+	area->priv->last_time = area->priv->time_now;
+	area->priv->last_mono = g_get_monotonic_time () / G_USEC_PER_SEC;
 
 	mx_box_layout_set_spacing ((MxBoxLayout *)area, 4);
 
-	if (clk_sec) {
-		area->priv->source = g_timeout_add (clk_sec * 1000, (GSourceFunc)clock_ticks, area);
-	} else {
-		area->priv->prop_sec_zero = TRUE;
-		area->priv->source = g_timeout_add (60 * 1000, (GSourceFunc)clock_ticks, area);
-	}
+	/* Ticks at the start of every minute, but not while the panel is hidden */
+	area->priv->source = mpl_timer_add_seconds (60, (ClutterActor *)area,
+						    (GSourceFunc)clock_ticks, area);
 
   	gconf_client_add_dir (client, "/apps/date-time-panel", GCONF_CLIENT_PRELOAD_ONELEVEL, NULL);
   	gconf_client_notify_add (client, "/apps/date-time-panel/24_h_clock", clock_fmt_changed, area, NULL, NULL);
@@ -439,33 +429,26 @@ mnp_clock_area_set_zone_reordered_cb (MnpClockArea *area, ClockZoneReorderedFunc
 gboolean
 mnp_clock_area_refresh_time (MnpClockArea *area, gboolean manual)
 {
-	int clk_sec = 0;
+	gint64 mono_now = g_get_monotonic_time () / G_USEC_PER_SEC;
 	gboolean ret = FALSE;
 
 	area->priv->time_now = time(NULL);
 	if (area->priv->last_time && !manual) {
 		time_t difference = area->priv->time_now - area->priv->last_time;
 
-		if (difference != 60) {
-			clk_sec = 60 - (area->priv->time_now%60);
-
+		/* The wall clock moving apart from the monotonic clock means the
+		 * time was changed; ticks held back while the panel was hidden
+		 * move both alike. */
+		if (ABS (difference - (mono_now - area->priv->last_mono)) > 1) {
 			/* There is a time change in some order, lets alert others */
 			g_signal_emit (area, signals[TIME_CHANGED], 0);
-			g_source_remove (area->priv->source);
-			if (clk_sec) {
-				area->priv->source = g_timeout_add (clk_sec * 1000, (GSourceFunc)clock_ticks, area);
-				area->priv->prop_sec_zero = FALSE;
-				area->priv->last_time = area->priv->time_now - 60 + clk_sec;
-				ret = TRUE;
-			} else {
-				area->priv->prop_sec_zero = TRUE;
-				area->priv->source = g_timeout_add (60 * 1000, (GSourceFunc)clock_ticks, area);
-			}			
+			ret = TRUE;
 		}
-
 	}
-	if(!clk_sec && !manual)
+	if (!manual) {
 		area->priv->last_time = area->priv->time_now;
+		area->priv->last_mono = mono_now;
+	}
 
 	return ret;
 }
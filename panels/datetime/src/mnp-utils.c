@@ -29,7 +29,6 @@
 #include <libgweather/gweather-xml.h>
 #include <libgweather/gweather-location.h>
 #include <libgweather/weather.h>
-#include "system-timezone.h"
 #include "mnp-utils.h"
 
 GWeatherLocation *world = NULL;
@@ -391,106 +390,60 @@ mnp_get_world_timezones (void)
 
 /* Time formatting from gnome-panel */
 
-static const char *
-get_tzname (char *tzid)
-{
-        time_t now_t;
-        struct tm now;
-
-        setenv ("TZ", tzid, 1);
-        tzset();
-
-        now_t = time (NULL);
-        localtime_r (&now_t, &now);
-
-        if (now.tm_isdst > 0) {
-                return tzname[1];
-        } else {
-                return tzname[0];
-        }
-
-	return NULL;
-}
-
-static void
-clock_set_tz (char *tzone)
-{
-        setenv ("TZ", tzone, 1);
-        tzset();
-}
-
-#include <sys/time.h>
+/*
+ * Parsed zones by tzid. A GTimeZone holds the transition table of the
+ * zone, so once a zone is in here computing the time at a location is a
+ * lookup in memory, with no need to switch TZ and reread the zoneinfo.
+ */
+static GHashTable *zone_cache = NULL;
 
-static void
-clock_unset_tz (SystemTimezone *tzone)
+static GTimeZone *
+get_zone (const char *tzid)
 {
-        const char *env_timezone;
+	GTimeZone *zone;
 
-        env_timezone = system_timezone_get_env (tzone);
+	if (!zone_cache)
+		zone_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free,
+						    (GDestroyNotify) g_time_zone_unref);
 
-        if (env_timezone) {
-                setenv ("TZ", env_timezone, 1);
-        } else {
-                unsetenv ("TZ");
-        }
-        tzset();
-}
+	zone = g_hash_table_lookup (zone_cache, tzid);
+	if (!zone) {
+		zone = g_time_zone_new (tzid);
+		g_hash_table_insert (zone_cache, g_strdup (tzid), zone);
+	}
 
-static glong
-get_offset (const char *tzone, SystemTimezone *systz)
-{
-	glong offset = 0;
-	time_t t;
-	struct tm *tm;
-
-        unsetenv ("TZ");
-	t = time (NULL);
-        tm = localtime (&t);
-
-	if (tm->tm_isdst <= 0)
-          goto done;
-
-        setenv ("TZ", tzone, 1);
-	t = time (NULL);
-        tm = localtime (&t);
-	if (tm->tm_isdst <= 0)
-		offset = -3600;
-
-done:
-        clock_unset_tz (systz);
-        return offset;
+	return zone;
 }
 
 static void
-clock_location_localtime (SystemTimezone *systz, char *tzone, struct tm *tm, time_t now)
+date_time_to_tm (GDateTime *dt, struct tm *tm)
 {
-	glong offset = get_offset (tzone, systz);
-	time_t real_now = now + offset;
-
-        clock_set_tz (tzone);
-
-        localtime_r (&real_now, tm);
-
-        clock_unset_tz (systz);
+	memset (tm, 0, sizeof (*tm));
+
+	tm->tm_sec = g_date_time_get_second (dt);
+	tm->tm_min = g_date_time_get_minute (dt);
+	tm->tm_hour = g_date_time_get_hour (dt);
+	tm->tm_mday = g_date_time_get_day_of_month (dt);
+	tm->tm_mon = g_date_time_get_month (dt) - 1;
+	tm->tm_year = g_date_time_get_year (dt) - 1900;
+	tm->tm_wday = g_date_time_get_day_of_week (dt) % 7;
+	tm->tm_yday = g_date_time_get_day_of_year (dt) - 1;
+	tm->tm_isdst = g_date_time_is_daylight_savings (dt);
 }
 
 static MnpDateFormat *
 format_time (struct tm   *now, 
-             char        *tzname,
              gboolean  	  twelveh,
-	     time_t 	 local_t,
-	     gboolean 	 priority)
+	     struct tm   *local_now,
+	     gboolean 	  same_offset,
+	     gboolean 	  priority)
 {
 	char buf[256];
 	char *format;
-	struct tm local_now;
-	time_t now_t;
 	char *utf8;	
 	MnpDateFormat *fmt = g_new0 (MnpDateFormat, 1);
 
-	localtime_r (&local_t, &local_now);
-	now_t = mktime(now);
-
 	if (twelveh) {
 		/* Translators: This is a strftime format string.
 		 * It is used to display the time in 12-hours format
@@ -520,18 +473,18 @@ format_time (struct tm   *now,
 		/* Translators: This is a strftime format string.
 		 * It is used to display in Aug 6 (current location) */
 		format = _("%b %-d (current location)");
-	} else if (local_now.tm_wday != now->tm_wday) {
+	} else if (local_now->tm_wday != now->tm_wday) {
 		/* Translators: This is a strftime format string.
 		 * It is used to display in Aug 6 (Yesterday) */
 		
-		if (local_now.tm_wday > now->tm_wday)
+		if (local_now->tm_wday > now->tm_wday)
 			format = _("%b %-d (Yesterday)");
 		else
 			format = _("%b %-d (Tomorrow)");
 	} else {
 		/* Translators: This is a strftime format string.
 		 * It is used to display in Aug 6 */
-		if (now_t == local_t) 
+		if (same_offset) 
 			format = _("%b %-d (local)");
 		else
 			format = _("%b %-d");
@@ -550,23 +503,26 @@ format_time (struct tm   *now,
 MnpDateFormat *
 mnp_format_time_from_location (MnpZoneLocation *location, time_t time_now, gboolean tfh, gboolean priority)
 {
-	char *tzid;
-	char *tzname;
-	static SystemTimezone *systz = NULL; 
+	GDateTime *local_dt;
+	GDateTime *dt;
+	struct tm local_now;
 	struct tm now;
 	MnpDateFormat *fmt;
 
-	if (!systz)
-		systz = system_timezone_new ();
+	local_dt = g_date_time_new_from_unix_local (time_now);
+	dt = g_date_time_to_timezone (local_dt, get_zone (location->tzid));
 
-	tzid = location->tzid;
-	tzname = g_strdup (get_tzname(tzid));
+	date_time_to_tm (local_dt, &local_now);
+	date_time_to_tm (dt, &now);
 
-	clock_location_localtime (systz, tzid, &now, time_now);
-	fmt = format_time (&now, tzname, !tfh, time_now, priority);
+	fmt = format_time (&now, !tfh, &local_now,
+			   g_date_time_get_utc_offset (dt) == g_date_time_get_utc_offset (local_dt),
+			   priority);
 
 	fmt->city = g_strdup(location->city);
-	g_free(tzname);
+
+	g_date_time_unref (dt);
+	g_date_time_unref (local_dt);
 
 	return fmt;
 }
@@ -35,6 +35,7 @@
 
 #include "mnp-world-clock.h"
 #include "mnp-utils.h"
+#include "mnp-zone-index.h"
 #include "mnp-button-item.h"
 
 #include "mnp-clock-tile.h"
@@ -50,6 +51,9 @@ G_DEFINE_TYPE (MnpWorldClock, mnp_world_clock, MX_TYPE_BOX_LAYOUT)
 
 #define TIMEOUT 250
 
+/* Completion rows shown at most */
+#define MAX_COMPLETIONS 50
+
 enum {
 	TIME_CHANGED,
 	LAST_SIGNAL
@@ -62,7 +66,7 @@ typedef struct _MnpWorldClockPrivate MnpWorldClockPrivate;
 struct _MnpWorldClockPrivate {
 	MxEntry *search_location;
 	MxListView *zones_list;
-	ClutterModel *zones_model;
+	ClutterModel *completion_model;
 	ClutterActor *completion;
         ClutterActor *event_box;
 	ClutterActor *entry_box;
@@ -76,12 +80,10 @@ struct _MnpWorldClockPrivate {
 
 	ClutterActor *launcher;
 
-	const char *search_text;
 	gboolean location_tile;
 	MnpClockArea *area;
 
 	GPtrArray *zones;
-	guint completion_timeout;
 	gboolean completion_inited;
 
 	MplPanelClient *panel_client;
@@ -138,143 +140,80 @@ mnp_world_clock_init (MnpWorldClock *self)
 {
   MnpWorldClockPrivate *priv = GET_PRIVATE (self);
 
-  priv->search_text = "";
   priv->zones = NULL;
   priv->completion_inited = FALSE;
 }
 
-static gboolean
+static void
+clear_completion (MnpWorldClock *world_clock)
+{
+	MnpWorldClockPrivate *priv = GET_PRIVATE (world_clock);
+
+	if (!priv->completion_model)
+		return;
+
+	while (clutter_model_get_n_rows (priv->completion_model))
+		clutter_model_remove (priv->completion_model, 0);
+}
+
+static void
 start_search (MnpWorldClock *area)
 {
 	MnpWorldClockPrivate *priv = GET_PRIVATE (area);
-
-	priv->completion_timeout = 0;
+	const char *search_text;
+	GPtrArray *matches;
+	guint i;
 
 	if (!priv->completion_inited) {
 		priv->completion_inited = TRUE;
 		construct_completion (area);
 	}
-	priv->search_text = mx_entry_get_text (priv->search_location);
+	search_text = mx_entry_get_text (priv->search_location);
+
+	clutter_model_freeze (priv->completion_model);
+	clear_completion (area);
 
-	if (!priv->search_text || (strlen(priv->search_text) < 3))
+	if (!search_text || (strlen(search_text) < 3)) {
+		clutter_model_thaw (priv->completion_model);
 		clutter_actor_hide(priv->completion);
+		return;
+	}
+
+	/* The index answers without looking at every location, so the
+	 * completion can follow the typing as it happens. */
+	matches = mnp_zone_index_query (mnp_zone_index_get_default (),
+					search_text, MAX_COMPLETIONS);
+	for (i = 0; i < matches->len; i++) {
+		MnpZoneEntry *entry = matches->pdata[i];
 
-	if (priv->search_text && (strlen(priv->search_text) > 2))
-		g_signal_emit_by_name (priv->zones_model, "filter-changed");
-	if (priv->search_text && (strlen(priv->search_text) > 2) && (clutter_model_get_n_rows(priv->zones_model) > 0)) {
+		clutter_model_append (priv->completion_model,
+				      0, entry->display,
+				      -1);
+	}
+	clutter_model_thaw (priv->completion_model);
+
+	if (matches->len > 0) {
 		clutter_actor_show(priv->completion);
 		clutter_actor_raise_top (priv->completion);
 	} else {
 		clutter_actor_hide(priv->completion);
 	}
 
-
-	return FALSE;
+	g_ptr_array_free (matches, TRUE);
 }
 
-static void
-text_changed_cb (MxEntry *entry, GParamSpec *pspec, void *user_data)
-{
-	MnpWorldClockPrivate *priv = GET_PRIVATE (user_data);
-
-	if (priv->completion_timeout != 0)
-		g_source_remove(priv->completion_timeout);
-
-	priv->completion_timeout = g_timeout_add (500, (GSourceFunc) start_search, user_data);
-
-}
-
-static char *
-find_word (const char *full_name, const char *word, int word_len,
-	   gboolean whole_word, gboolean is_first_word)
+static gboolean
+load_zone_index_cb (gpointer data)
 {
-    char *p = (char *)full_name - 1;
-
-    while ((p = strchr (p + 1, *word))) {
-	if (strncmp (p, word, word_len) != 0)
-	    continue;
-
-	if (p > (char *)full_name) {
-	    char *prev = g_utf8_prev_char (p);
-
-	    /* Make sure p points to the start of a word */
-	    if (g_unichar_isalpha (g_utf8_get_char (prev)))
-		continue;
-
-	    /* If we're matching the first word of the key, it has to
-	     * match the first word of the location, city, state, or
-	     * country. Eg, it either matches the start of the string
-	     * (which we already know it doesn't at this point) or
-	     * it is preceded by the string ", " (which isn't actually
-	     * a perfect test. FIXME)
-	     */
-	    if (is_first_word) {
-		if (prev == (char *)full_name || strncmp (prev - 1, ", ", 2) != 0)
-		    continue;
-	    }
-	}
+	mnp_zone_index_get_default ();
 
-	if (whole_word && g_unichar_isalpha (g_utf8_get_char (p + word_len)))
-	    continue;
-
-	return p;
-    }
-    return NULL;
+	return FALSE;
 }
 
-static gboolean
-filter_zone (ClutterModel *model, ClutterModelIter *iter, gpointer user_data)
+static void
+text_changed_cb (MxEntry *entry, GParamSpec *pspec, void *user_data)
 {
-	MnpWorldClockPrivate *priv = GET_PRIVATE (user_data);
-	char *name, *name_mem;
-	GWeatherLocation *loc;
-	gboolean is_first_word = TRUE, match;
-	int len;
-	char *key, *skey;
-
-	if (!priv->search_text || !*priv->search_text)
-		return TRUE;
-
-	skey = key = g_ascii_strdown(priv->search_text, -1);
-	clutter_model_iter_get (iter,
-			GWEATHER_LOCATION_ENTRY_COL_COMPARE_NAME, &name_mem,
-			GWEATHER_LOCATION_ENTRY_COL_LOCATION, &loc,
-			-1);
-	name = name_mem;
-
-    	if (!loc) {
-		g_free (name_mem);
-		g_free (key);
-		return FALSE;
-    	}
-
-    	/* All but the last word in KEY must match a full word from NAME,
-     	 * in order (but possibly skipping some words from NAME).
-     	 */
-	len = strcspn (key, " ");
-	while (key[len]) {
-		name = find_word (name, key, len, TRUE, is_first_word);
-		if (!name) {
-	    		g_free (name_mem);
-			g_free (skey);
-	    		return FALSE;
-		}
-
-		key += len;
-		while (*key && !g_unichar_isalpha (g_utf8_get_char (key)))
-	    		key = g_utf8_next_char (key);
-		while (*name && !g_unichar_isalpha (g_utf8_get_char (name)))
-	    		name = g_utf8_next_char (name);
-
-		len = strcspn (key, " ");
-		is_first_word = FALSE;
-    	}
-
-	/* The last word in KEY must match a prefix of a following word in NAME */
-	match = find_word (name, key, strlen (key), FALSE, is_first_word) != NULL;
-	g_free (name_mem);
-	g_free (skey);
-	return match;
+	start_search ((MnpWorldClock *) user_data);
 }
 
 static void
@@ -289,25 +228,21 @@ clear_btn_clicked_cb (ClutterActor *button, MnpWorldClock *world_clock)
 static void
 add_location_tile(MnpWorldClock *world_clock, const char *display, gboolean priority)
 {
-	GWeatherLocation *location;
+	const MnpZoneEntry *entry;
 	MnpClockTile *tile;
-	MnpZoneLocation *loc = g_new0(MnpZoneLocation, 1);
-	const GWeatherTimezone *tzone;
+	MnpZoneLocation *loc;
 	MnpWorldClockPrivate *priv = GET_PRIVATE (world_clock);
 	int i;
 
-	if (!priv->zones_model)
-		priv->zones_model = mnp_get_world_timezones();
-
-	location = (GWeatherLocation *) mnp_utils_get_location_from_display (priv->zones_model, display);
-	if (!location)
+	entry = mnp_zone_index_lookup (mnp_zone_index_get_default (), display);
+	if (!entry)
 		return;
 
 	printf("Adding location: %s\n", display);
+	loc = g_new0(MnpZoneLocation, 1);
 	loc->display = g_strdup(display);
-	loc->city = g_strdup(gweather_location_get_city_name (location));
-	tzone =  gweather_location_get_timezone (location);
-	loc->tzid = g_strdup(gweather_timezone_get_tzid ((GWeatherTimezone *)tzone));
+	loc->city = g_strdup(entry->city);
+	loc->tzid = g_strdup(entry->tzid);
 	loc->local = FALSE;
 
 	for (i=0; i< priv->zones->len; i++) {
@@ -340,8 +275,7 @@ add_location_tile(MnpWorldClock *world_clock, const char *display, gboolean prio
 	tile = mnp_clock_tile_new (loc, mnp_clock_area_get_time(priv->area), priority);
 	mnp_clock_area_add_tile (priv->area, tile);
 
-	priv->search_text = "asd";
-	g_signal_emit_by_name (priv->zones_model, "filter-changed");
+	clear_completion (world_clock);
 
 	if (priv->zones->len >= 4)
 		clutter_actor_hide (priv->entry_box);
@@ -353,14 +287,7 @@ add_location_clicked_cb (ClutterActor *button, MnpWorldClock *world_clock)
 {
 	MnpWorldClockPrivate *priv = GET_PRIVATE (world_clock);
 
-	mx_list_view_set_model (MX_LIST_VIEW (priv->zones_list), NULL);
-
-	priv->search_text = NULL;
-	g_signal_emit_by_name (priv->zones_model, "filter-changed");
-
 	add_location_tile (world_clock, mx_entry_get_text (priv->search_location), FALSE);
-
-	mx_list_view_set_model (MX_LIST_VIEW (priv->zones_list), priv->zones_model);
 }
 
 
@@ -473,7 +400,6 @@ construct_completion (MnpWorldClock *world_clock)
 
 	ClutterActor *frame, *scroll, *view, *stage;
 	MnpWorldClockPrivate *priv = GET_PRIVATE (world_clock);
-	ClutterModel *model;
 	MnpButtonItem *button_item;
 
 	stage = priv->stage;
@@ -492,14 +418,7 @@ construct_completion (MnpWorldClock *world_clock)
         g_signal_connect (priv->event_box, "button-press-event",
                           G_CALLBACK (event_box_clicked_cb), world_clock);
 
-	if (!priv->zones_model) {
-		model = mnp_get_world_timezones ();
-		priv->zones_model = model;
-	} else
-		model = priv->zones_model;
-
-	clutter_model_set_filter (model, filter_zone, world_clock, NULL);
-	priv->search_text = "asd";
+	priv->completion_model = clutter_list_model_new (1, G_TYPE_STRING, "DisplayName");
 
         frame = mx_frame_new ();
         clutter_actor_set_name (frame, "CompletionFrame");
@@ -526,7 +445,7 @@ construct_completion (MnpWorldClock *world_clock)
 	priv->zones_list = (MxListView *)view;
 
 	clutter_container_add_actor (CLUTTER_CONTAINER (scroll), view);
-	mx_list_view_set_model (MX_LIST_VIEW (view), model);
+	mx_list_view_set_model (MX_LIST_VIEW (view), priv->completion_model);
 
 	button_item = mnp_button_item_new ((gpointer)world_clock, mnp_completion_done);
 	mx_list_view_set_factory (MX_LIST_VIEW (view), (MxItemFactory *)button_item);
@@ -749,7 +668,8 @@ mnp_world_clock_construct (MnpWorldClock *world_clock)
 
 	construct_heading_and_top_area (world_clock);
 
-	priv->completion_timeout = 0;
+	/* Have the location index ready by the time the user types */
+	g_idle_add_full (G_PRIORITY_LOW, load_zone_index_cb, NULL, NULL);
 
 	/* Search Entry */
 
@@ -0,0 +1,521 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Word-prefix index over the world clock locations.
+ *
+ * Every location is listed once, in the order of the location model, with
+ * its normalized compare name. The index is a sorted array of the word
+ * starts in all the compare names; all the locations having a word that
+ * starts with a given prefix are one binary search away. Queries probe it
+ * with one word of the search text and only check the locations found
+ * that way against the full text.
+ *
+ * Building the list means loading the whole GWeather location tree, so it
+ * is cached on disk and rebuilt only when the version or the locale
+ * changes.
+ */
+
+#include <config.h>
+#include <locale.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#define GWEATHER_I_KNOW_THIS_IS_UNSTABLE
+#include <libgweather/gweather-location.h>
+
+#include "mnp-utils.h"
+#include "mnp-zone-index.h"
+
+#define CACHE_FILE "world-clock-locations"
+
+typedef struct _zone_word {
+	const char *word;	/* points into the entry's compare name */
+	guint entry;
+}ZoneWord;
+
+struct _MnpZoneIndex {
+	GArray *entries;	/* MnpZoneEntry, in model order */
+	GArray *words;		/* ZoneWord, sorted */
+	GHashTable *by_display;
+
+	guint *seen;		/* per entry, last query that saw it */
+	guint generation;
+};
+
+static char *
+normalize (const char *text)
+{
+	GString *str;
+	char *decomposed, *p;
+
+	decomposed = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+	if (!decomposed)
+		return g_ascii_strdown (text, -1);
+
+	str = g_string_sized_new (strlen (decomposed));
+	for (p = decomposed; *p; p = g_utf8_next_char (p)) {
+		gunichar c = g_utf8_get_char (p);
+
+		/* Drop the accents, "zürich" is found as "zurich" */
+		if (g_unichar_type (c) == G_UNICODE_NON_SPACING_MARK)
+			continue;
+		g_string_append_unichar (str, g_unichar_tolower (c));
+	}
+	g_free (decomposed);
+
+	return g_string_free (str, FALSE);
+}
+
+static gboolean
+is_alpha (const char *p)
+{
+	return g_unichar_isalpha (g_utf8_get_char (p));
+}
+
+static const char *
+find_word (const char *full_name, const char *word, int word_len,
+	   gboolean whole_word, gboolean is_first_word)
+{
+    const char *p = full_name - 1;
+
+    while ((p = strchr (p + 1, *word))) {
+	if (strncmp (p, word, word_len) != 0)
+	    continue;
+
+	if (p > full_name) {
+	    const char *prev = g_utf8_prev_char (p);
+
+	    /* Make sure p points to the start of a word */
+	    if (is_alpha (prev))
+		continue;
+
+	    /* If we're matching the first word of the key, it has to
+	     * match the first word of the location, city, state, or
+	     * country. Eg, it either matches the start of the string
+	     * (which we already know it doesn't at this point) or
+	     * it is preceded by the string ", " (which isn't actually
+	     * a perfect test. FIXME)
+	     */
+	    if (is_first_word) {
+		if (prev == full_name || strncmp (prev - 1, ", ", 2) != 0)
+		    continue;
+	    }
+	}
+
+	if (whole_word && is_alpha (p + word_len))
+	    continue;
+
+	return p;
+    }
+    return NULL;
+}
+
+/* All but the last word in KEY must match a full word from NAME, in order
+ * (but possibly skipping some words from NAME); the last word in KEY must
+ * match a prefix of a following word in NAME. */
+static gboolean
+match_name (const char *name, const char *key)
+{
+	gboolean is_first_word = TRUE;
+	int len;
+
+	len = strcspn (key, " ");
+	while (key[len]) {
+		name = find_word (name, key, len, TRUE, is_first_word);
+		if (!name)
+			return FALSE;
+
+		key += len;
+		while (*key && !is_alpha (key))
+			key = g_utf8_next_char (key);
+		while (*name && !is_alpha (name))
+			name = g_utf8_next_char (name);
+
+		len = strcspn (key, " ");
+		is_first_word = FALSE;
+	}
+
+	return find_word (name, key, strlen (key), FALSE, is_first_word) != NULL;
+}
+
+static int
+compare_words (gconstpointer a, gconstpointer b)
+{
+	return strcmp (((const ZoneWord *)a)->word, ((const ZoneWord *)b)->word);
+}
+
+static void
+build_words (MnpZoneIndex *index)
+{
+	guint i;
+
+	index->words = g_array_new (FALSE, FALSE, sizeof (ZoneWord));
+	index->by_display = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (i = 0; i < index->entries->len; i++) {
+		MnpZoneEntry *entry = &g_array_index (index->entries, MnpZoneEntry, i);
+		const char *p, *prev = NULL;
+
+		for (p = entry->compare; *p; prev = p, p = g_utf8_next_char (p)) {
+			ZoneWord word;
+
+			if (!is_alpha (p) || (prev && is_alpha (prev)))
+				continue;
+
+			word.word = p;
+			word.entry = i;
+			g_array_append_val (index->words, word);
+		}
+
+		g_hash_table_insert (index->by_display, entry->display, entry);
+	}
+
+	g_array_sort (index->words, compare_words);
+	index->seen = g_new0 (guint, index->entries->len);
+}
+
+static char *
+get_cache_file (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), "dawati", CACHE_FILE, NULL);
+}
+
+/* The first libgweather Locations database in the data dirs, as
+ * "mtime:size", so that an update of it invalidates the cache. */
+static char *
+get_locations_stamp (void)
+{
+	static const char *names[] = { "Locations.xml", "Locations.xml.gz" };
+	const char * const *dirs = g_get_system_data_dirs ();
+	guint i, j;
+
+	for (i = 0; dirs[i]; i++) {
+		for (j = 0; j < G_N_ELEMENTS (names); j++) {
+			struct stat buf;
+			char *path;
+
+			path = g_build_filename (dirs[i], "libgweather",
+						 names[j], NULL);
+			if (g_stat (path, &buf) == 0) {
+				g_free (path);
+				return g_strdup_printf ("%ld:%ld",
+							(long) buf.st_mtime,
+							(long) buf.st_size);
+			}
+			g_free (path);
+		}
+	}
+
+	return g_strdup ("-");
+}
+
+static char *
+get_cache_header (void)
+{
+	char *stamp, *header;
+
+	stamp = get_locations_stamp ();
+	header = g_strdup_printf ("%s\t%s\t%s", PACKAGE_VERSION,
+				  setlocale (LC_MESSAGES, NULL), stamp);
+	g_free (stamp);
+
+	return header;
+}
+
+/* The entries point straight into the file contents, which are kept for
+ * the lifetime of the index. */
+static gboolean
+load_cache (MnpZoneIndex *index)
+{
+	char *path, *contents, *header, *line, *next;
+	gboolean ret = FALSE;
+
+	path = get_cache_file ();
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+		g_free (path);
+		return FALSE;
+	}
+	g_free (path);
+
+	header = get_cache_header ();
+	next = strchr (contents, '\n');
+	if (!next || strncmp (contents, header, next - contents) != 0 ||
+	    strlen (header) != (gsize) (next - contents))
+		goto out;
+
+	for (line = next + 1; *line; line = next) {
+		MnpZoneEntry entry;
+		char *fields[4];
+		int i;
+
+		next = strchr (line, '\n');
+		if (!next)
+			goto out;
+		*next++ = '\0';
+
+		fields[0] = line;
+		for (i = 1; i < 4; i++) {
+			fields[i] = strchr (fields[i - 1], '\t');
+			if (!fields[i])
+				goto out;
+			*fields[i]++ = '\0';
+		}
+
+		entry.display = fields[0];
+		entry.compare = fields[1];
+		entry.city = fields[2];
+		entry.tzid = fields[3];
+		g_array_append_val (index->entries, entry);
+	}
+
+	ret = TRUE;
+
+out:
+	g_free (header);
+	if (!ret) {
+		g_array_set_size (index->entries, 0);
+		g_free (contents);
+	}
+
+	return ret;
+}
+
+static void
+save_cache (MnpZoneIndex *index)
+{
+	GString *str;
+	char *path, *dir, *header;
+	GError *error = NULL;
+	guint i;
+
+	header = get_cache_header ();
+	str = g_string_new (header);
+	g_string_append_c (str, '\n');
+	g_free (header);
+
+	for (i = 0; i < index->entries->len; i++) {
+		MnpZoneEntry *entry = &g_array_index (index->entries, MnpZoneEntry, i);
+
+		g_string_append_printf (str, "%s\t%s\t%s\t%s\n",
+					entry->display, entry->compare,
+					entry->city, entry->tzid);
+	}
+
+	path = get_cache_file ();
+	dir = g_path_get_dirname (path);
+	g_mkdir_with_parents (dir, 0700);
+
+	if (!g_file_set_contents (path, str->str, str->len, &error)) {
+		g_warning ("Could not save the world clock locations: %s",
+			   error->message);
+		g_clear_error (&error);
+	}
+
+	g_free (dir);
+	g_free (path);
+	g_string_free (str, TRUE);
+}
+
+static gboolean
+has_separator (const char *text)
+{
+	return strpbrk (text, "\t\n") != NULL;
+}
+
+static void
+load_world (MnpZoneIndex *index)
+{
+	ClutterModel *model;
+	ClutterModelIter *iter;
+
+	model = mnp_get_world_timezones ();
+	if (!model)
+		return;
+
+	iter = clutter_model_get_first_iter (model);
+	while (!clutter_model_iter_is_last (iter)) {
+		GWeatherLocation *location;
+		const GWeatherTimezone *tzone;
+		char *display, *compare;
+
+		clutter_model_iter_get (iter,
+				GWEATHER_LOCATION_ENTRY_COL_DISPLAY_NAME, &display,
+				GWEATHER_LOCATION_ENTRY_COL_COMPARE_NAME, &compare,
+				GWEATHER_LOCATION_ENTRY_COL_LOCATION, &location,
+				-1);
+
+		tzone = location ? gweather_location_get_timezone (location) : NULL;
+		if (tzone && !has_separator (display) && !has_separator (compare)) {
+			MnpZoneEntry entry;
+
+			entry.display = display;
+			entry.compare = normalize (compare);
+			entry.city = g_strdup (gweather_location_get_city_name (location));
+			entry.tzid = g_strdup (gweather_timezone_get_tzid ((GWeatherTimezone *)tzone));
+			g_array_append_val (index->entries, entry);
+		} else {
+			g_free (display);
+		}
+		g_free (compare);
+
+		clutter_model_iter_next (iter);
+	}
+
+	g_object_unref (iter);
+	g_object_unref (model);
+}
+
+MnpZoneIndex *
+mnp_zone_index_get_default (void)
+{
+	static MnpZoneIndex *index = NULL;
+
+	if (index)
+		return index;
+
+	index = g_new0 (MnpZoneIndex, 1);
+	index->entries = g_array_new (FALSE, FALSE, sizeof (MnpZoneEntry));
+
+	if (!load_cache (index)) {
+		load_world (index);
+		if (index->entries->len)
+			save_cache (index);
+	}
+
+	build_words (index);
+
+	return index;
+}
+
+const MnpZoneEntry *
+mnp_zone_index_lookup (MnpZoneIndex *index, const char *display)
+{
+	return g_hash_table_lookup (index->by_display, display);
+}
+
+/* First word start in the sorted array that is not smaller than PREFIX */
+static guint
+lower_bound (MnpZoneIndex *index, const char *prefix, int len)
+{
+	guint lo = 0, hi = index->words->len;
+
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+		ZoneWord *word = &g_array_index (index->words, ZoneWord, mid);
+
+		if (strncmp (word->word, prefix, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static int
+compare_uint (gconstpointer a, gconstpointer b)
+{
+	guint ua = *(const guint *)a, ub = *(const guint *)b;
+
+	return ua < ub ? -1 : ua > ub;
+}
+
+/*
+ * Returns the entries matching TEXT, as filter_zone() used to match them,
+ * at most MAX_RESULTS of them. Locations whose name starts with the text
+ * come first; otherwise the entries keep the model order. The array does
+ * not own the entries.
+ */
+GPtrArray *
+mnp_zone_index_query (MnpZoneIndex *index, const char *text, guint max_results)
+{
+	GPtrArray *results, *others;
+	GArray *candidates;
+	char *key, *start, *probe, *p;
+	int probe_len = 0, first_len;
+	guint i;
+
+	results = g_ptr_array_new ();
+
+	key = normalize (text);
+	start = key;
+	while (*start && !is_alpha (start))
+		start = g_utf8_next_char (start);
+	if (!*start) {
+		g_free (key);
+		return results;
+	}
+
+	/* Probe with the longest word of the key, the most selective one */
+	probe = start;
+	for (p = start; *p; ) {
+		int len = strcspn (p, " ");
+
+		if (len > probe_len) {
+			probe = p;
+			probe_len = len;
+		}
+		p += len;
+		while (*p == ' ')
+			p++;
+	}
+
+	index->generation++;
+	candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (i = lower_bound (index, probe, probe_len); i < index->words->len; i++) {
+		ZoneWord *word = &g_array_index (index->words, ZoneWord, i);
+
+		if (strncmp (word->word, probe, probe_len) != 0)
+			break;
+		if (index->seen[word->entry] == index->generation)
+			continue;
+
+		index->seen[word->entry] = index->generation;
+		g_array_append_val (candidates, word->entry);
+	}
+	g_array_sort (candidates, compare_uint);
+
+	first_len = strcspn (start, " ");
+	others = g_ptr_array_new ();
+	for (i = 0; i < candidates->len && results->len < max_results; i++) {
+		MnpZoneEntry *entry;
+
+		entry = &g_array_index (index->entries, MnpZoneEntry,
+					g_array_index (candidates, guint, i));
+		if (!match_name (entry->compare, start))
+			continue;
+
+		if (strncmp (entry->compare, start, first_len) == 0)
+			g_ptr_array_add (results, entry);
+		else
+			g_ptr_array_add (others, entry);
+	}
+
+	for (i = 0; i < others->len && results->len < max_results; i++)
+		g_ptr_array_add (results, others->pdata[i]);
+
+	g_ptr_array_free (others, TRUE);
+	g_array_free (candidates, TRUE);
+	g_free (key);
+
+	return results;
+}
@@ -0,0 +1,38 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MNP_ZONE_INDEX_H
+#define MNP_ZONE_INDEX_H
+
+#include <glib.h>
+
+typedef struct _MnpZoneIndex MnpZoneIndex;
+
+typedef struct _mnp_zone_entry {
+	char *display;
+	char *compare;	/* normalized, lower case */
+	char *city;
+	char *tzid;
+}MnpZoneEntry;
+
+MnpZoneIndex * mnp_zone_index_get_default (void);
+const MnpZoneEntry * mnp_zone_index_lookup (MnpZoneIndex *index, const char *display);
+GPtrArray * mnp_zone_index_query (MnpZoneIndex *index, const char *text, guint max_results);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Benchmark for the world clock: formats 50 clocks per tick, the way the
+ * clock area refreshes its tiles once a minute.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mnp-utils.h"
+
+#define N_TICKS 1000
+
+static char const *zones[] = {
+  "Europe/London", "Europe/Paris", "Europe/Berlin", "Europe/Madrid",
+  "Europe/Rome", "Europe/Amsterdam", "Europe/Helsinki", "Europe/Moscow",
+  "Europe/Istanbul", "Europe/Lisbon", "Europe/Dublin", "Europe/Athens",
+  "America/New_York", "America/Chicago", "America/Denver",
+  "America/Los_Angeles", "America/Anchorage", "America/Sao_Paulo",
+  "America/Mexico_City", "America/Toronto", "America/Bogota",
+  "America/Caracas", "America/Halifax", "America/St_Johns",
+  "America/Argentina/Buenos_Aires", "Pacific/Honolulu", "Pacific/Auckland",
+  "Pacific/Fiji", "Pacific/Chatham", "Asia/Tokyo", "Asia/Shanghai",
+  "Asia/Kolkata", "Asia/Kathmandu", "Asia/Dubai", "Asia/Singapore",
+  "Asia/Hong_Kong", "Asia/Seoul", "Asia/Tehran", "Asia/Kabul",
+  "Asia/Jakarta", "Asia/Manila", "Asia/Karachi", "Australia/Sydney",
+  "Australia/Adelaide", "Australia/Perth", "Australia/Lord_Howe",
+  "Africa/Cairo", "Africa/Johannesburg", "Africa/Lagos", "Africa/Nairobi"
+};
+
+int
+main (int     argc,
+      char  **argv)
+{
+  MnpZoneLocation  locations[G_N_ELEMENTS (zones)];
+  GTimer          *timer;
+  time_t           now;
+  double           first_tick;
+  double           elapsed;
+  unsigned         i, tick;
+
+  g_type_init ();
+
+  for (i = 0; i < G_N_ELEMENTS (zones); i++)
+  {
+    locations[i].display = (char *) zones[i];
+    locations[i].city = (char *) zones[i];
+    locations[i].tzid = (char *) zones[i];
+    locations[i].local = FALSE;
+  }
+
+  now = time (NULL);
+  timer = g_timer_new ();
+
+  for (tick = 0; tick < N_TICKS; tick++)
+  {
+    for (i = 0; i < G_N_ELEMENTS (locations); i++)
+    {
+      MnpDateFormat *fmt;
+
+      fmt = mnp_format_time_from_location (&locations[i],
+                                           now + tick * 60,
+                                           TRUE, FALSE);
+      if (tick == 0 && argc > 1)
+        printf ("%-32s %s %s\n", fmt->city, fmt->time, fmt->date);
+
+      g_free (fmt->city);
+      g_free (fmt->time);
+      g_free (fmt->date);
+      g_free (fmt);
+    }
+
+    if (tick == 0)
+    {
+      first_tick = g_timer_elapsed (timer, NULL);
+      g_timer_start (timer);
+    }
+  }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  printf ("%u clocks: first tick %.3f ms, then %.3f ms/tick "
+          "(%.3f us/clock)\n",
+          (unsigned) G_N_ELEMENTS (locations),
+          first_tick * 1e3,
+          elapsed * 1e3 / (N_TICKS - 1),
+          elapsed * 1e6 / (N_TICKS - 1) / G_N_ELEMENTS (locations));
+
+  g_timer_destroy (timer);
+
+  return EXIT_SUCCESS;
+}
@@ -20,6 +20,7 @@
 
 #include <stdbool.h>
 #include <clutter-gtk/clutter-gtk.h>
+#include <dawati-panel/mpl-timer.h>
 #include "mpd-battery-icon.h"
 
 G_DEFINE_TYPE (MpdBatteryIcon, mpd_battery_icon, CLUTTER_TYPE_TEXTURE)
@@ -39,6 +40,7 @@ typedef struct
 
   /* Only while animating. */
   GList const *iter;
+  unsigned int frame_timer_id;
 } MpdBatteryIconPrivate;
 
 static void
@@ -163,7 +165,13 @@ render_frame (MpdBatteryIcon *self)
 static bool
 _next_frame_cb (MpdBatteryIcon  *self)
 {
-  return render_frame (self);
+  MpdBatteryIconPrivate *priv = GET_PRIVATE (self);
+
+  if (render_frame (self))
+    return true;
+
+  priv->frame_timer_id = 0;
+  return false;
 }
 
 void
@@ -172,9 +180,17 @@ mpd_battery_icon_animate (MpdBatteryIcon  *self,
 {
   MpdBatteryIconPrivate *priv = GET_PRIVATE (self);
 
+  if (priv->frame_timer_id)
+    mpl_timer_remove (priv->frame_timer_id);
+
   priv->iter = frames;
   render_frame (self);
-  g_timeout_add (1000 / priv->fps, (GSourceFunc) _next_frame_cb, self);
+
+  /* Frames are not rendered while the icon is not on screen. */
+  priv->frame_timer_id = mpl_timer_add (1000 / priv->fps, 0,
+                                        CLUTTER_ACTOR (self),
+                                        (GSourceFunc) _next_frame_cb,
+                                        self);
 }
 
 GList *
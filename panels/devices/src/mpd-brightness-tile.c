@@ -21,6 +21,7 @@
 #include <stdbool.h>
 
 #include <glib/gi18n.h>
+#include <dawati-panel/mpl-timer.h>
 
 #include "mpd-battery-device.h"
 #include "mpd-brightness-tile.h"
@@ -38,6 +39,7 @@ typedef struct
   MxSlider            *slider;
   MpdBatteryDevice    *battery;
   MpdDisplayDevice    *display;
+  unsigned int         update_timer_id;
 } MpdBrightnessTilePrivate;
 
 static void
@@ -76,6 +78,9 @@ _brightness_slider_value_notify_cb (MxSlider          *slider,
 static bool
 _update_brightness_display_cb (MpdBrightnessTile  *self)
 {
+  MpdBrightnessTilePrivate *priv = GET_PRIVATE (self);
+
+  priv->update_timer_id = 0;
   update_brightness_display (self);
 
   return false;
@@ -86,9 +91,17 @@ _battery_state_notify_cb (MpdBatteryDevice   *display,
                           GParamSpec         *pspec,
                           MpdBrightnessTile  *self)
 {
+  MpdBrightnessTilePrivate *priv = GET_PRIVATE (self);
+
   /* Update again 1 second later in case we're getting
-   * this notification before the power-icon. */
-  g_timeout_add_seconds (1, (GSourceFunc) _update_brightness_display_cb, self);
+   * this notification before the power-icon. Only the last change
+   * matters, so changes while unmapped don't pile up. */
+  if (priv->update_timer_id)
+    mpl_timer_remove (priv->update_timer_id);
+
+  priv->update_timer_id =
+    mpl_timer_add_seconds (1, CLUTTER_ACTOR (self),
+                           (GSourceFunc) _update_brightness_display_cb, self);
 }
 
 static void
@@ -104,6 +117,12 @@ _dispose (GObject *object)
 {
   MpdBrightnessTilePrivate *priv = GET_PRIVATE (object);
 
+  if (priv->update_timer_id)
+  {
+    mpl_timer_remove (priv->update_timer_id);
+    priv->update_timer_id = 0;
+  }
+
   mpd_gobject_detach (object, (GObject **) &priv->battery);
   mpd_gobject_detach (object, (GObject **) &priv->display);
 
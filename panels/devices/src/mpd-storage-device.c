@@ -18,12 +18,20 @@
  * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#define _GNU_SOURCE /* for copy_file_range from unistd.h */
+
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <unistd.h>
 
 #include <gio/gio.h>
+#include <dawati-panel/mpl-timer.h>
 
 #include "mpd-gobject.h"
 #include "mpd-storage-device.h"
@@ -59,12 +67,33 @@ enum
 enum
 {
   HAS_MEDIA,
+  MEDIA_PROGRESS,
   IMPORT_PROGRESS,
   IMPORT_ERROR,
+  IMPORT_FINISHED,
 
   LAST_SIGNAL
 };
 
+typedef enum
+{
+  MEDIA_NONE,
+  MEDIA_AUDIO,
+  MEDIA_IMAGE,
+  MEDIA_VIDEO
+} MediaKind;
+
+typedef struct
+{
+  char          *path;
+  uint64_t       size;
+  int64_t        mtime;
+  MediaKind      kind;
+} MediaFile;
+
+typedef struct Discovery_ Discovery;
+typedef struct Import_ Import;
+
 typedef struct
 {
   int64_t        available_size;
@@ -72,20 +101,19 @@ typedef struct
   int64_t        size;
   unsigned int   update_timeout_id;
 
-  GSList        *dir_stack;
+  Discovery     *discovery;
   GSList        *media_files;
   uint64_t       media_files_size;
+  unsigned int   n_media_files;
 
-  /* During import */
-  GFile         *pictures_dir;
-  GFile         *music_dir;
-  GFile         *videos_dir;
-  uint64_t       imported_size;
-  GCancellable  *cancellable;
+  Import        *import;
 } MpdStorageDevicePrivate;
 
 static unsigned int _signals[LAST_SIGNAL] = { 0, };
 
+static void
+clear_media_files (MpdStorageDevice *self);
+
 static void
 update (MpdStorageDevice *self)
 {
@@ -123,10 +151,12 @@ _constructor (GType                  type,
   if (priv->path)
   {
     update (self);
+    /* Free space need not be exact to the second, let the poll share its
+     * wakeup with the other once-a-minute timers. */
     priv->update_timeout_id =
-                  g_timeout_add_seconds (60,
-                                         (GSourceFunc) _update_timeout_cb,
-                                         self);
+                  mpl_timer_add (60 * 1000, 15 * 1000, NULL,
+                                 (GSourceFunc) _update_timeout_cb,
+                                 self);
   } else {
     g_critical ("%s : No mount path set", G_STRLOC);
   }
@@ -217,40 +247,14 @@ _dispose (GObject *object)
 
   if (priv->update_timeout_id)
   {
-    g_source_remove (priv->update_timeout_id);
+    mpl_timer_remove (priv->update_timeout_id);
     priv->update_timeout_id = 0;
   }
 
-  if (priv->media_files)
-  {
-    g_slist_foreach (priv->media_files, (GFunc) g_free, NULL);
-    g_slist_free (priv->media_files);
-    priv->media_files = NULL;
-  }
-
-  if (priv->pictures_dir)
-  {
-    g_object_unref (priv->pictures_dir);
-    priv->pictures_dir = NULL;
-  }
-
-  if (priv->music_dir)
-  {
-    g_object_unref (priv->music_dir);
-    priv->music_dir = NULL;
-  }
-
-  if (priv->videos_dir)
-  {
-    g_object_unref (priv->videos_dir);
-    priv->videos_dir = NULL;
-  }
-
-  if (priv->cancellable)
-  {
-    g_object_unref (priv->cancellable);
-    priv->cancellable = NULL;
-  }
+  /* The worker may still be busy, detach from it. */
+  mpd_storage_device_cancel_has_media (MPD_STORAGE_DEVICE (object));
+  clear_media_files (MPD_STORAGE_DEVICE (object));
+  mpd_storage_device_stop_import (MPD_STORAGE_DEVICE (object));
 
   G_OBJECT_CLASS (mpd_storage_device_parent_class)->dispose (object);
 }
@@ -329,12 +333,21 @@ mpd_storage_device_class_init (MpdStorageDeviceClass *klass)
                                       g_cclosure_marshal_VOID__BOOLEAN,
                                       G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
 
+  _signals[MEDIA_PROGRESS] = g_signal_new ("media-progress",
+                                           G_TYPE_FROM_CLASS (klass),
+                                           G_SIGNAL_RUN_LAST,
+                                           0, NULL, NULL,
+                                           g_cclosure_marshal_generic,
+                                           G_TYPE_NONE, 2,
+                                           G_TYPE_UINT, G_TYPE_UINT64);
+
   _signals[IMPORT_PROGRESS] = g_signal_new ("import-progress",
                                             G_TYPE_FROM_CLASS (klass),
                                             G_SIGNAL_RUN_LAST,
                                             0, NULL, NULL,
-                                            g_cclosure_marshal_VOID__FLOAT,
-                                            G_TYPE_NONE, 1, G_TYPE_FLOAT);
+                                            g_cclosure_marshal_generic,
+                                            G_TYPE_NONE, 2,
+                                            G_TYPE_FLOAT, G_TYPE_UINT64);
 
   _signals[IMPORT_ERROR] = g_signal_new ("import-error",
                                          G_TYPE_FROM_CLASS (klass),
@@ -342,6 +355,13 @@ mpd_storage_device_class_init (MpdStorageDeviceClass *klass)
                                          0, NULL, NULL,
                                          g_cclosure_marshal_VOID__POINTER,
                                          G_TYPE_NONE, 1, G_TYPE_POINTER);
+
+  _signals[IMPORT_FINISHED] = g_signal_new ("import-finished",
+                                            G_TYPE_FROM_CLASS (klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL,
+                                            g_cclosure_marshal_VOID__VOID,
+                                            G_TYPE_NONE, 0);
 }
 
 static void
@@ -417,19 +437,438 @@ mpd_storage_device_get_path (MpdStorageDevice *self)
   return priv->path;
 }
 
-#if 0 /* Volume crawling code etc. */
+/*
+ * Media discovery.
+ *
+ * The volume is crawled in a worker thread with plain readdir(), which
+ * hands out the entry type along with the name, so no per-file stat() or
+ * content sniffing is needed for the common case. Files are classified by
+ * extension first; only names that do not tell are guessed by the shared
+ * mime database, and only what is still uncertain after that is sniffed.
+ *
+ * Found files are handed to the main loop in batches through `found', one
+ * idle per batch, which also drives the "media-progress" signal. The
+ * device may go away while the worker is busy; it then detaches itself by
+ * clearing `self', and cancels the crawl.
+ */
 
-#define MPD_STORAGE_DEVICE_ERROR mpd_storage_device_error_quark()
+/* Flush found files to the main loop after this many, or this long. */
+#define DISCOVERY_BATCH_SIZE 64
+#define DISCOVERY_BATCH_TIME (100 * 1000) /* us */
 
-static GQuark
-mpd_storage_device_error_quark (void)
+/* How much of a file we look at when its name gives no clue. */
+#define SNIFF_SIZE 4096
+
+static GThreadPool *_discovery_pool = NULL;
+
+static const struct
 {
-  static GQuark _quark = 0;
-  if (!_quark)
-    _quark = g_quark_from_static_string ("mpd-storage-device-error");
-  return _quark;
+  char const  *extension;
+  MediaKind    kind;
+} _media_extensions[] = {
+  { "jpg", MEDIA_IMAGE }, { "jpeg", MEDIA_IMAGE }, { "png", MEDIA_IMAGE },
+  { "gif", MEDIA_IMAGE }, { "bmp", MEDIA_IMAGE }, { "tif", MEDIA_IMAGE },
+  { "tiff", MEDIA_IMAGE }, { "webp", MEDIA_IMAGE }, { "dng", MEDIA_IMAGE },
+  { "cr2", MEDIA_IMAGE }, { "nef", MEDIA_IMAGE }, { "raw", MEDIA_IMAGE },
+
+  { "mp3", MEDIA_AUDIO }, { "ogg", MEDIA_AUDIO }, { "oga", MEDIA_AUDIO },
+  { "flac", MEDIA_AUDIO }, { "wav", MEDIA_AUDIO }, { "m4a", MEDIA_AUDIO },
+  { "aac", MEDIA_AUDIO }, { "wma", MEDIA_AUDIO }, { "opus", MEDIA_AUDIO },
+
+  { "avi", MEDIA_VIDEO }, { "mp4", MEDIA_VIDEO }, { "m4v", MEDIA_VIDEO },
+  { "mov", MEDIA_VIDEO }, { "mkv", MEDIA_VIDEO }, { "mpg", MEDIA_VIDEO },
+  { "mpeg", MEDIA_VIDEO }, { "wmv", MEDIA_VIDEO }, { "ogv", MEDIA_VIDEO },
+  { "3gp", MEDIA_VIDEO }, { "webm", MEDIA_VIDEO },
+
+  /* Common on cameras and music players, and never media. */
+  { "txt", MEDIA_NONE }, { "xml", MEDIA_NONE }, { "ini", MEDIA_NONE },
+  { "dat", MEDIA_NONE }, { "db", MEDIA_NONE }, { "thm", MEDIA_NONE },
+  { "ctg", MEDIA_NONE }, { "html", MEDIA_NONE }, { "pdf", MEDIA_NONE },
+};
+
+struct Discovery_
+{
+  int               ref_count;        /* atomic */
+  MpdStorageDevice *self;             /* main thread only */
+  char             *path;
+  GCancellable     *cancellable;
+
+  /* Shared with the worker. */
+  GMutex            mutex;
+  GSList           *found;
+  uint64_t          found_size;
+  unsigned int      n_scanned;
+  unsigned int      n_dirs;
+  bool              done;
+  unsigned int      idle_id;
+
+  /* Worker only. */
+  int64_t           start_time;
+};
+
+static void
+media_file_free (MediaFile *file)
+{
+  g_free (file->path);
+  g_slice_free (MediaFile, file);
+}
+
+static Discovery *
+discovery_ref (Discovery *discovery)
+{
+  g_atomic_int_inc (&discovery->ref_count);
+  return discovery;
 }
 
+static void
+discovery_unref (Discovery *discovery)
+{
+  if (!g_atomic_int_dec_and_test (&discovery->ref_count))
+    return;
+
+  g_slist_foreach (discovery->found, (GFunc) media_file_free, NULL);
+  g_slist_free (discovery->found);
+  g_object_unref (discovery->cancellable);
+  g_mutex_clear (&discovery->mutex);
+  g_free (discovery->path);
+  g_slice_free (Discovery, discovery);
+}
+
+static MediaKind
+kind_from_content_type (char const *content_type)
+{
+  if (g_str_has_prefix (content_type, "audio/"))
+    return MEDIA_AUDIO;
+  if (g_str_has_prefix (content_type, "image/"))
+    return MEDIA_IMAGE;
+  if (g_str_has_prefix (content_type, "video/"))
+    return MEDIA_VIDEO;
+  return MEDIA_NONE;
+}
+
+/* Runs in the worker thread. */
+static MediaKind
+classify (int         dir_fd,
+          char const *name)
+{
+  char const  *extension;
+  char        *content_type;
+  gboolean     uncertain = TRUE;
+  MediaKind    kind;
+  unsigned int i;
+
+  extension = strrchr (name, '.');
+  if (extension && extension != name)
+  {
+    for (i = 0; i < G_N_ELEMENTS (_media_extensions); i++)
+      if (0 == g_ascii_strcasecmp (extension + 1,
+                                   _media_extensions[i].extension))
+        return _media_extensions[i].kind;
+  }
+
+  content_type = g_content_type_guess (name, NULL, 0, &uncertain);
+
+  if (uncertain)
+  {
+    guchar  data[SNIFF_SIZE];
+    ssize_t n_read = -1;
+    int     fd;
+
+    fd = openat (dir_fd, name, O_RDONLY | O_NOCTTY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+      n_read = read (fd, data, sizeof (data));
+      close (fd);
+    }
+
+    if (n_read > 0)
+    {
+      g_free (content_type);
+      content_type = g_content_type_guess (name, data, n_read, NULL);
+    }
+  }
+
+  kind = kind_from_content_type (content_type);
+  g_free (content_type);
+
+  return kind;
+}
+
+static bool
+_discovery_idle_cb (Discovery *discovery);
+
+/* Runs in the worker thread. */
+static void
+discovery_flush (Discovery  *discovery,
+                 GSList    **batch,
+                 uint64_t   *batch_size,
+                 unsigned    n_scanned,
+                 unsigned    n_dirs,
+                 bool        done)
+{
+  g_mutex_lock (&discovery->mutex);
+
+  discovery->found = g_slist_concat (*batch, discovery->found);
+  discovery->found_size += *batch_size;
+  discovery->n_scanned = n_scanned;
+  discovery->n_dirs = n_dirs;
+  discovery->done = done;
+
+  if (0 == discovery->idle_id)
+    discovery->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                          (GSourceFunc) _discovery_idle_cb,
+                                          discovery_ref (discovery),
+                                          (GDestroyNotify) discovery_unref);
+
+  g_mutex_unlock (&discovery->mutex);
+
+  *batch = NULL;
+  *batch_size = 0;
+}
+
+/* Runs in the worker thread. */
+static void
+_discover_cb (Discovery *discovery,
+              void      *data)
+{
+  GSList        *dirs;
+  GSList        *batch = NULL;
+  unsigned int   batch_length = 0;
+  uint64_t       batch_size = 0;
+  int64_t        batch_time;
+  unsigned int   n_scanned = 0;
+  unsigned int   n_dirs = 0;
+
+  discovery->start_time = g_get_monotonic_time ();
+  batch_time = discovery->start_time;
+  dirs = g_slist_prepend (NULL, g_strdup (discovery->path));
+
+  while (dirs &&
+         !g_cancellable_is_cancelled (discovery->cancellable))
+  {
+    char          *path = (char *) dirs->data;
+    DIR           *dir;
+    struct dirent *entry;
+
+    dirs = g_slist_delete_link (dirs, dirs);
+
+    dir = opendir (path);
+    if (NULL == dir)
+    {
+      g_warning ("%s : %s: %s", G_STRLOC, path, strerror (errno));
+      g_free (path);
+      continue;
+    }
+
+    n_dirs++;
+
+    while (NULL != (entry = readdir (dir)) &&
+           !g_cancellable_is_cancelled (discovery->cancellable))
+    {
+      unsigned char type = entry->d_type;
+      struct stat   st;
+      MediaKind     kind;
+      MediaFile    *file;
+
+      if (0 == strcmp (entry->d_name, ".") ||
+          0 == strcmp (entry->d_name, ".."))
+        continue;
+
+      /* Not all file systems fill in the type. Links are followed to
+       * files, but not to directories so we cannot get into cycles. */
+      if (DT_UNKNOWN == type || DT_LNK == type)
+      {
+        if (0 != fstatat (dirfd (dir), entry->d_name, &st, 0))
+          continue;
+        if (S_ISDIR (st.st_mode))
+          type = DT_UNKNOWN == type ? DT_DIR : DT_LNK;
+        else if (S_ISREG (st.st_mode))
+          type = DT_REG;
+      }
+
+      /* Do not recurse into "dot" directories, they are use for trash. */
+      if (DT_DIR == type)
+      {
+        if (entry->d_name[0] != '.')
+          dirs = g_slist_prepend (dirs, g_build_filename (path,
+                                                          entry->d_name,
+                                                          NULL));
+        continue;
+      }
+
+      if (DT_REG != type)
+        continue;
+
+      n_scanned++;
+
+      kind = classify (dirfd (dir), entry->d_name);
+      if (MEDIA_NONE == kind ||
+          0 != fstatat (dirfd (dir), entry->d_name, &st, 0))
+        continue;
+
+      /* Media found. */
+      file = g_slice_new (MediaFile);
+      file->path = g_build_filename (path, entry->d_name, NULL);
+      file->size = st.st_size;
+      file->mtime = st.st_mtime;
+      file->kind = kind;
+      batch = g_slist_prepend (batch, file);
+      batch_size += file->size;
+      batch_length++;
+
+      if (batch_length >= DISCOVERY_BATCH_SIZE ||
+          g_get_monotonic_time () - batch_time >= DISCOVERY_BATCH_TIME)
+      {
+        discovery_flush (discovery, &batch, &batch_size,
+                         n_scanned, n_dirs, false);
+        batch_length = 0;
+        batch_time = g_get_monotonic_time ();
+      }
+    }
+
+    closedir (dir);
+    g_free (path);
+  }
+
+  g_slist_foreach (dirs, (GFunc) g_free, NULL);
+  g_slist_free (dirs);
+
+  discovery_flush (discovery, &batch, &batch_size, n_scanned, n_dirs, true);
+  discovery_unref (discovery);
+}
+
+static bool
+_discovery_idle_cb (Discovery *discovery)
+{
+  MpdStorageDevice        *self = discovery->self;
+  MpdStorageDevicePrivate *priv;
+  GSList      *found;
+  uint64_t     found_size;
+  unsigned int n_scanned;
+  unsigned int n_dirs;
+  bool         done;
+
+  g_mutex_lock (&discovery->mutex);
+  found = discovery->found;
+  found_size = discovery->found_size;
+  n_scanned = discovery->n_scanned;
+  n_dirs = discovery->n_dirs;
+  done = discovery->done;
+  discovery->found = NULL;
+  discovery->found_size = 0;
+  discovery->idle_id = 0;
+  g_mutex_unlock (&discovery->mutex);
+
+  if (NULL == self)
+  {
+    /* Detached, nobody is interested any more. */
+    g_slist_foreach (found, (GFunc) media_file_free, NULL);
+    g_slist_free (found);
+    return false;
+  }
+
+  priv = GET_PRIVATE (self);
+  priv->media_files = g_slist_concat (found, priv->media_files);
+  priv->media_files_size += found_size;
+  priv->n_media_files += g_slist_length (found);
+
+  g_signal_emit (self, _signals[MEDIA_PROGRESS], 0,
+                 priv->n_media_files, priv->media_files_size);
+
+  if (done)
+  {
+    double elapsed = (g_get_monotonic_time () - discovery->start_time) /
+                     (double) G_USEC_PER_SEC;
+    char *size_text = g_format_size (priv->media_files_size);
+
+    g_debug ("%s : %s: %u files in %u directories in %.2fs (%.0f files/s), "
+             "%u media files, %s",
+             G_STRLOC, priv->path, n_scanned, n_dirs, elapsed,
+             elapsed > 0 ? n_scanned / elapsed : 0,
+             priv->n_media_files, size_text);
+    g_free (size_text);
+
+    priv->discovery = NULL;
+    discovery->self = NULL;
+    discovery_unref (discovery);
+
+    g_signal_emit (self, _signals[HAS_MEDIA], 0,
+                   (gboolean) (priv->media_files != NULL));
+  }
+
+  return false;
+}
+
+static void
+clear_media_files (MpdStorageDevice *self)
+{
+  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
+
+  g_slist_foreach (priv->media_files, (GFunc) media_file_free, NULL);
+  g_slist_free (priv->media_files);
+  priv->media_files = NULL;
+  priv->media_files_size = 0;
+  priv->n_media_files = 0;
+}
+
+/*
+ * Looks for pictures, music and videos on the device. "media-progress" is
+ * emitted as files are found, and "has-media" once the whole device has
+ * been looked at.
+ */
+void
+mpd_storage_device_has_media_async (MpdStorageDevice *self)
+{
+  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
+  Discovery *discovery;
+
+  g_return_if_fail (MPD_IS_STORAGE_DEVICE (self));
+  g_return_if_fail (g_file_test (priv->path, G_FILE_TEST_IS_DIR));
+
+  if (priv->discovery)
+    return;
+
+  clear_media_files (self);
+
+  if (NULL == _discovery_pool)
+    _discovery_pool = g_thread_pool_new ((GFunc) _discover_cb, NULL,
+                                         2, false, NULL);
+
+  discovery = g_slice_new0 (Discovery);
+  discovery->ref_count = 1;
+  discovery->self = self;
+  discovery->path = g_strdup (priv->path);
+  discovery->cancellable = g_cancellable_new ();
+  g_mutex_init (&discovery->mutex);
+  priv->discovery = discovery;
+
+  g_thread_pool_push (_discovery_pool, discovery_ref (discovery), NULL);
+}
+
+/*
+ * Stops looking for media; "has-media" will not be emitted for the
+ * cancelled run.
+ */
+void
+mpd_storage_device_cancel_has_media (MpdStorageDevice *self)
+{
+  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (MPD_IS_STORAGE_DEVICE (self));
+
+  if (NULL == priv->discovery)
+    return;
+
+  g_cancellable_cancel (priv->discovery->cancellable);
+  priv->discovery->self = NULL;
+  discovery_unref (priv->discovery);
+  priv->discovery = NULL;
+
+  clear_media_files (self);
+}
+
+#if 0 /* Volume crawling code etc. */
+
 char const *
 mpd_storage_device_get_label (MpdStorageDevice *self)
 {
@@ -470,211 +909,293 @@ mpd_storage_device_get_vendor (MpdStorageDevice *self)
 #endif
 }
 
-static void
-push_dir_async (MpdStorageDevice  *self,
-                GFile             *dir);
+#endif
 
-static GFile *
-file_new_for_path (char const *path)
+/*
+ * Media import.
+ *
+ * Copies run on a thread pool of their own, a few at a time; with
+ * thousands of small photos the cost is in opening and creating files,
+ * which overlaps nicely. How many copies are worth having in flight is
+ * limited separately by the source, typically a flash card or USB stick
+ * that gets no faster with more outstanding reads, and by the local disk
+ * we write to. The source limit applies to each import, the target limit
+ * to all imports writing to the same disk; a copy starts only when both
+ * allow it. Data is moved with copy_file_range() where available, and
+ * otherwise through a large buffer. Each file is written under a
+ * temporary name and renamed into place when complete.
+ *
+ * Every imported file is recorded in a journal kept per device, together
+ * with its size and modification time. A later import, e.g. after the
+ * device was pulled out half way, skips what the journal says has
+ * already been copied.
+ */
+
+#define IMPORT_SOURCE_COPIES  2
+#define IMPORT_TARGET_COPIES  4
+#define IMPORT_BUFFER_SIZE    (1024 * 1024)
+#define IMPORT_CHUNK_SIZE     (8 * 1024 * 1024)
+
+typedef struct
 {
-  g_debug ("%s() %s", __FUNCTION__, path);
-  return g_file_new_for_path (path);
-}
+  MediaFile *file;
+  char      *target_path;
+  dev_t      target_dev;
+  GError    *error;
+} ImportCopy;
 
-static void
-file_destroy (GFile *file)
+/* Copies in flight per target disk, across all imports. */
+typedef struct
 {
-  char *path;
+  dev_t         dev;
+  unsigned int  n_copies;
+} ImportTarget;
 
-  path = g_file_get_path (file);
-  g_debug ("%s() %s (%d)", __FUNCTION__, path,  G_OBJECT (file)->ref_count);
-  g_free (path);
+struct Import_
+{
+  int               ref_count;        /* atomic */
+  MpdStorageDevice *self;             /* main thread only */
+  GCancellable     *cancellable;
+  GThreadPool      *pool;
+
+  /* Shared with the workers. */
+  GMutex            mutex;
+  GSList           *copied;
+  unsigned int      idle_id;
+
+  /* Main thread only. */
+  char             *root;
+  GSList           *pending;
+  unsigned int      n_copies;         /* in flight from this source */
+  GHashTable       *reserved;         /* Target paths in flight. */
+  GFile            *music_dir;
+  GFile            *pictures_dir;
+  GFile            *videos_dir;
+  dev_t             music_dev;
+  dev_t             pictures_dev;
+  dev_t             videos_dev;
+  FILE             *journal;
+  uint64_t          total_size;
+  uint64_t          imported_size;    /* Including skipped files. */
+  uint64_t          copied_size;
+  int64_t           start_time;
+};
+
+typedef struct
+{
+  uint64_t  size;
+  int64_t   mtime;
+  char     *target_path;
+} JournalEntry;
+
+/* Main thread only. */
+static GArray *_import_targets = NULL;  /* ImportTarget */
+static GSList *_imports = NULL;         /* Import, those not finished */
+
+#define MPD_STORAGE_DEVICE_ERROR mpd_storage_device_error_quark()
+
+static GQuark
+mpd_storage_device_error_quark (void)
+{
+  static GQuark _quark = 0;
+  if (!_quark)
+    _quark = g_quark_from_static_string ("mpd-storage-device-error");
+  return _quark;
+}
 
-  g_object_unref (file);
+static Import *
+import_ref (Import *import)
+{
+  g_atomic_int_inc (&import->ref_count);
+  return import;
 }
 
 static void
-enumerate_dir (MpdStorageDevice  *self)
+import_unref (Import *import)
 {
-  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  GFileEnumerator *enumerator;
-  GFileInfo       *info;
-  GError          *error = NULL;
+  if (!g_atomic_int_dec_and_test (&import->ref_count))
+    return;
 
-  g_return_if_fail (priv->dir_stack);
-  enumerator = G_FILE_ENUMERATOR (priv->dir_stack->data);
-  g_return_if_fail (G_IS_FILE_ENUMERATOR (enumerator));
+  g_slist_foreach (import->pending, (GFunc) media_file_free, NULL);
+  g_slist_free (import->pending);
+  g_hash_table_destroy (import->reserved);
+  if (import->music_dir) g_object_unref (import->music_dir);
+  if (import->pictures_dir) g_object_unref (import->pictures_dir);
+  if (import->videos_dir) g_object_unref (import->videos_dir);
+  if (import->journal) fclose (import->journal);
+  g_object_unref (import->cancellable);
+  g_mutex_clear (&import->mutex);
+  g_free (import->root);
+  g_slice_free (Import, import);
+}
 
-  while (NULL !=
-         (info = g_file_enumerator_next_file (enumerator, NULL, &error)))
-  {
-    char const *content_type = g_file_info_get_content_type (info);
-    char const *name = g_file_info_get_name (info);
+static void
+import_copy_free (ImportCopy *copy)
+{
+  media_file_free (copy->file);
+  g_free (copy->target_path);
+  g_clear_error (&copy->error);
+  g_slice_free (ImportCopy, copy);
+}
 
-    /* Debug */
-    char *indent = g_strnfill (g_slist_length (priv->dir_stack), ' ');
-    g_debug ("%s%s %s", indent, name, content_type);
-    g_free (indent);
+static void
+journal_entry_free (JournalEntry *entry)
+{
+  g_free (entry->target_path);
+  g_slice_free (JournalEntry, entry);
+}
 
-    /* Do not recurse into "dot" directories, they are use for trash. */
-    if (0 == g_strcmp0 ("inode/directory", content_type) &&
-        name[0] != '.')
-    {
-      char const *path = g_object_get_data (G_OBJECT (enumerator), "path");
-      char *subpath = g_build_filename (path, name, NULL);
-      GFile *subdir = file_new_for_path (subpath);
+/*
+ * The mount path alone does not tell cards apart, they all end up on
+ * /media/disk or similar.
+ */
+static char *
+journal_path (MpdStorageDevice *self)
+{
+  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
+  char *key;
+  char *checksum;
+  char *path;
 
-      /* Push and recurse. */
-      push_dir_async (self, subdir);
+  key = g_strdup_printf ("%s:%lld", priv->path, (long long) priv->size);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+  path = g_build_filename (g_get_user_cache_dir (), "dawati", "imports",
+                           checksum, NULL);
+  g_free (checksum);
+  g_free (key);
 
-      file_destroy (subdir);
-      g_free (subpath);
-      break;
+  return path;
+}
 
-    } else if (g_str_has_prefix (content_type, "audio/") ||
-               g_str_has_prefix (content_type, "image/") ||
-               g_str_has_prefix (content_type, "video/")) {
+/*
+ * Journal lines are "size <tab> mtime <tab> target <tab> source", the
+ * source relative to the mount path, both escaped.
+ * Returns a table of source -> JournalEntry.
+ */
+static GHashTable *
+journal_load (char const *path)
+{
+  GHashTable  *journal;
+  char        *contents = NULL;
+  char       **lines;
+  unsigned int i;
 
-      /* Media found. */
-      char const *path = g_object_get_data (G_OBJECT (enumerator), "path");
-      char *filename = g_build_filename (path, name, NULL);
-      priv->media_files = g_slist_prepend (priv->media_files, filename);
-      priv->media_files_size += g_file_info_get_size (info);
-    }
+  journal = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                   g_free,
+                                   (GDestroyNotify) journal_entry_free);
 
-    g_object_unref (info);
-  }
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return journal;
 
-  if (info)
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i]; i++)
   {
-    /* Broke out of loop, not done yet. */
-    g_object_unref (info);
+    char         **fields = g_strsplit (lines[i], "\t", 4);
+    JournalEntry  *entry;
 
-  } else {
-
-    /* Directory finished, pop. */
-    g_object_unref (enumerator);
-    priv->dir_stack = g_slist_delete_link (priv->dir_stack, priv->dir_stack);
-    if (priv->dir_stack)
+    if (g_strv_length (fields) == 4)
     {
-      enumerate_dir (self);
-    } else {
-      /* Done iterating. */
-      g_signal_emit_by_name (self, "has-media", (bool) priv->media_files);
+      entry = g_slice_new (JournalEntry);
+      entry->size = g_ascii_strtoull (fields[0], NULL, 10);
+      entry->mtime = g_ascii_strtoll (fields[1], NULL, 10);
+      entry->target_path = g_strcompress (fields[2]);
+      g_hash_table_insert (journal, g_strcompress (fields[3]), entry);
     }
-  }
 
-  if (error)
-  {
-    g_critical ("%s : %s", G_STRLOC, error->message);
-    g_clear_error (&error);
+    g_strfreev (fields);
   }
-}
-
-static void
-_push_dir_cb (GFile             *file,
-              GAsyncResult      *res,
-              MpdStorageDevice  *self)
-{
-  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  GFileEnumerator *enumerator;
-  GError          *error = NULL;
-
-  g_return_if_fail (G_IS_FILE (file));
-
-  /* Debug */
-  char *indent = g_strnfill (g_slist_length (priv->dir_stack), ' ');
-  char *path = g_file_get_path (file);
-  g_debug ("%s%s", indent, path);
-  g_free (path);
-  g_free (indent);
 
-  enumerator = g_file_enumerate_children_finish (file, res, &error);
-  if (error)
-  {
-    g_critical ("%s : %s", G_STRLOC, error->message);
-    g_clear_error (&error);
-    return;
-  }
+  g_strfreev (lines);
+  g_free (contents);
 
-  /* g_file_enumerator_get_container () fails on us. */
-  g_object_set_data_full (G_OBJECT (enumerator), "path",
-                          g_file_get_path (file), g_free);
-  priv->dir_stack = g_slist_prepend (priv->dir_stack,
-                                     g_object_ref (enumerator));
-  enumerate_dir (self);
-  g_object_unref (enumerator);
+  return journal;
 }
 
 static void
-push_dir_async (MpdStorageDevice  *self,
-                GFile             *dir)
+journal_append (Import     *import,
+                ImportCopy *copy)
 {
-  char *path;
-  bool  is_dir;
+  char *target;
+  char *source;
 
-  path = g_file_get_path (dir);
-  is_dir = g_file_test (path, G_FILE_TEST_IS_DIR);
-  g_free (path);
-  g_return_if_fail (is_dir);
+  if (NULL == import->journal)
+    return;
 
-  g_file_enumerate_children_async (dir, "standard", G_FILE_QUERY_INFO_NONE,
-                                   G_PRIORITY_DEFAULT, NULL,
-                                   (GAsyncReadyCallback) _push_dir_cb,
-                                   self);
+  target = g_strescape (copy->target_path, NULL);
+  source = g_strescape (copy->file->path + strlen (import->root), NULL);
+  fprintf (import->journal, "%llu\t%lld\t%s\t%s\n",
+           (unsigned long long) copy->file->size,
+           (long long) copy->file->mtime,
+           target, source);
+  /* Each line must make it to disk on its own, the device may go away
+   * any time. */
+  fflush (import->journal);
+  g_free (source);
+  g_free (target);
 }
 
-void
-mpd_storage_device_has_media_async (MpdStorageDevice *self)
+/*
+ * Whether the journal has `file' as imported and the copy is still there.
+ */
+static bool
+journal_has (GHashTable *journal,
+             char const *root,
+             MediaFile  *file)
 {
-  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  GFile *dir;
+  JournalEntry *entry;
+  struct stat   st;
 
-  g_return_if_fail (MPD_IS_STORAGE_DEVICE (self));
+  entry = g_hash_table_lookup (journal, file->path + strlen (root));
 
-  dir = file_new_for_path (priv->path);
-  push_dir_async (self, dir);
-  file_destroy (dir);
+  return entry &&
+         entry->size == file->size &&
+         entry->mtime == file->mtime &&
+         0 == stat (entry->target_path, &st) &&
+         (uint64_t) st.st_size == file->size;
 }
 
-static GFile *
+static char *
 ensure_unique_child (GFile      *dir,
                      char const *template,
-                     bool        test_suffix)
+                     bool        test_suffix,
+                     GHashTable *reserved)
 {
-  GFile       *child;
+  char        *dir_path;
+  char        *path;
   char        *basename = NULL;
-  char const  *suffix = NULL;
+  char const  *suffix = "";
   unsigned int i = 0;
 
   g_return_val_if_fail (dir, NULL);
   g_return_val_if_fail (template, NULL);
 
   if (test_suffix)
-  {
     suffix = strrchr (template, '.');
-    if (NULL == suffix ||
-        0 == g_strcmp0 (template, suffix))
-    {
-      /* No suffix found. */
-      test_suffix = false;
-    } else {
-      basename = g_strndup (template, strlen (template) - strlen (suffix));
-    }
+
+  if (test_suffix && suffix && suffix != template)
+  {
+    basename = g_strndup (template, strlen (template) - strlen (suffix));
+  } else {
+    /* No suffix found. */
+    basename = g_strdup (template);
+    suffix = "";
   }
 
-  child = g_file_get_child (dir, template);
-  while (g_file_query_exists (child, NULL))
+  dir_path = g_file_get_path (dir);
+  path = g_build_filename (dir_path, template, NULL);
+  while ((reserved && g_hash_table_lookup (reserved, path)) ||
+         g_file_test (path, G_FILE_TEST_EXISTS))
   {
     char *filename = g_strdup_printf ("%s (%d)%s", basename, ++i, suffix);
-    g_object_unref (child);
-    child = g_file_get_child (dir, filename);
+    g_free (path);
+    path = g_build_filename (dir_path, filename, NULL);
     g_free (filename);
   }
 
+  g_free (dir_path);
   g_free (basename);
 
-  return child;
+  return path;
 }
 
 static GFile *
@@ -686,8 +1207,22 @@ ensure_import_subdir (char const   *path,
   char       template[PATH_MAX] = { 0, } /* whatever */;
   GFile     *basedir;
   GFile     *subdir;
+  char      *subdir_path;
+
+  /* The XDG directory may well be unset or not created yet. */
+  if (NULL == path)
+  {
+    g_set_error (error, MPD_STORAGE_DEVICE_ERROR, 0,
+                 "%s : No directory to import to", G_STRLOC);
+    return NULL;
+  }
 
-  g_return_val_if_fail (g_file_test (path, G_FILE_TEST_IS_DIR), NULL);
+  if (0 != g_mkdir_with_parents (path, 0755))
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s: %s", path, strerror (errno));
+    return NULL;
+  }
 
   g_get_current_time (&tv);
   g_date_set_time_val (&date, &tv);
@@ -702,7 +1237,10 @@ ensure_import_subdir (char const   *path,
     g_date_strftime (template, sizeof (template), "%Y-%m-%d", &date);
   }
 
-  subdir = ensure_unique_child (basedir, template, false);
+  subdir_path = ensure_unique_child (basedir, template, false, NULL);
+
+  subdir = g_file_new_for_path (subdir_path);
+  g_free (subdir_path);
   if (!g_file_make_directory (subdir, NULL, error))
   {
     g_object_unref (subdir);
@@ -713,148 +1251,437 @@ ensure_import_subdir (char const   *path,
   return subdir;
 }
 
-static void
-import_file_async (MpdStorageDevice *self);
+/* Runs in a worker thread. */
+static bool
+copy_data (int            source_fd,
+           int            target_fd,
+           GCancellable  *cancellable,
+           GError       **error)
+{
+  char    *buffer = NULL;
+  ssize_t  n_read;
 
-static void
-_file_copy_cb (GFile            *source_file,
-               GAsyncResult     *res,
-               MpdStorageDevice *self)
+#ifdef HAVE_COPY_FILE_RANGE
+  ssize_t  n_copied;
+
+  /* In kernel, without bouncing the data through us. Falls back to the
+   * buffer when the kernel or file system cannot do it. */
+  while (0 < (n_copied = copy_file_range (source_fd, NULL, target_fd, NULL,
+                                          IMPORT_CHUNK_SIZE, 0)) ||
+         (n_copied < 0 && errno == EINTR))
+  {
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
+      return false;
+  }
+
+  if (0 == n_copied)
+    return true;
+
+  if (errno != ENOSYS && errno != EXDEV && errno != EINVAL &&
+      errno != EOPNOTSUPP)
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s", strerror (errno));
+    return false;
+  }
+#endif
+
+  buffer = g_malloc (IMPORT_BUFFER_SIZE);
+  while (0 < (n_read = read (source_fd, buffer, IMPORT_BUFFER_SIZE)) ||
+         (n_read < 0 && errno == EINTR))
+  {
+    char const *p = buffer;
+
+    while (n_read > 0)
+    {
+      ssize_t n_written = write (target_fd, p, n_read);
+      if (n_written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "%s", strerror (errno));
+        g_free (buffer);
+        return false;
+      }
+      p += n_written;
+      n_read -= n_written;
+    }
+
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    {
+      g_free (buffer);
+      return false;
+    }
+  }
+  g_free (buffer);
+
+  if (n_read < 0)
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s", strerror (errno));
+    return false;
+  }
+
+  return true;
+}
+
+/* Runs in a worker thread. */
+static bool
+copy_file (char const    *source_path,
+           char const    *target_path,
+           GCancellable  *cancellable,
+           GError       **error)
 {
-  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  GFileInfo *info;
-  GError    *error = NULL;
-  float      progress;
+  struct stat     st;
+  struct timespec times[2];
+  char           *part_path;
+  int             source_fd;
+  int             target_fd;
+  bool            ret;
+
+  source_fd = open (source_path, O_RDONLY | O_NOCTTY | O_CLOEXEC);
+  if (source_fd < 0 ||
+      0 != fstat (source_fd, &st))
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s: %s", source_path, strerror (errno));
+    if (source_fd >= 0)
+      close (source_fd);
+    return false;
+  }
+
+  posix_fadvise (source_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-  g_file_copy_finish (source_file, res, &error);
-  if (error)
+  part_path = g_strconcat (target_path, ".part", NULL);
+  target_fd = open (part_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+  if (target_fd < 0)
   {
-    g_warning ("%s : %s", G_STRLOC, error->message);
-    g_signal_emit_by_name (self, "import-error", error);
-    g_clear_error (&error);
-    return;
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s: %s", part_path, strerror (errno));
+    close (source_fd);
+    g_free (part_path);
+    return false;
   }
 
-  info = g_file_query_info (source_file, "standard", G_FILE_QUERY_INFO_NONE,
-                            NULL, &error);
-  if (error)
+  ret = copy_data (source_fd, target_fd, cancellable, error);
+
+  if (ret)
   {
-    g_warning ("%s : %s", G_STRLOC, error->message);
-    g_signal_emit_by_name (self, "import-error", error);
-    g_clear_error (&error);
-    return;
+    /* Keep the time the picture was taken. */
+    times[0] = st.st_atim;
+    times[1] = st.st_mtim;
+    futimens (target_fd, times);
+  }
+
+  close (source_fd);
+  if (0 != close (target_fd) && ret)
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s: %s", part_path, strerror (errno));
+    ret = false;
+  }
+
+  if (ret && 0 != rename (part_path, target_path))
+  {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "%s: %s", target_path, strerror (errno));
+    ret = false;
   }
 
-  priv->imported_size += g_file_info_get_size (info);
-  progress = (float) priv->imported_size / priv->media_files_size;
-  g_signal_emit_by_name (self, "import-progress", progress);
-  g_object_unref (info);
+  if (!ret)
+    unlink (part_path);
 
-  g_debug ("%s() %f", __FUNCTION__, progress);
+  g_free (part_path);
 
-  /* Next file. */
-  if (priv->media_files)
-    import_file_async (self);
+  return ret;
 }
 
+static bool
+_import_idle_cb (Import *import);
+
+/* Runs in a worker thread. */
 static void
-import_file_async (MpdStorageDevice *self)
+_copy_cb (ImportCopy *copy,
+          Import     *import)
 {
-  MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  char        *source_path = NULL;
-  GFile       *source_file = NULL;
-  GFileInfo   *source_info = NULL;
-  char const  *content_type;
-  GFile       *target_dir = NULL;
-  char        *target_name = NULL;
-  GFile       *target_file = NULL;
-  GError      *error = NULL;
+  if (!g_cancellable_set_error_if_cancelled (import->cancellable,
+                                             &copy->error))
+    copy_file (copy->file->path, copy->target_path, import->cancellable,
+               &copy->error);
+
+  g_mutex_lock (&import->mutex);
+  import->copied = g_slist_prepend (import->copied, copy);
+  if (0 == import->idle_id)
+    import->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                       (GSourceFunc) _import_idle_cb,
+                                       import_ref (import),
+                                       (GDestroyNotify) import_unref);
+  g_mutex_unlock (&import->mutex);
+
+  import_unref (import);
+}
 
-  g_return_if_fail (priv->media_files);
+static void
+import_error (Import *import,
+              GError *error)
+{
+  g_warning ("%s : %s", G_STRLOC, error->message);
+  if (import->self)
+    g_signal_emit (import->self, _signals[IMPORT_ERROR], 0, error);
+}
 
-  source_path = (char *) priv->media_files->data;
-  priv->media_files = g_slist_delete_link (priv->media_files, priv->media_files);
+static GFile *
+import_target_dir (Import     *import,
+                   MediaKind   kind,
+                   dev_t      *target_dev,
+                   GError    **error)
+{
+  GFile             **dir;
+  dev_t              *dev;
+  GUserDirectory      directory;
 
-  source_file = g_file_new_for_path (source_path);
-  source_info = g_file_query_info (source_file, "standard",
-                                   G_FILE_QUERY_INFO_NONE, NULL, &error);
-  if (error)
+  switch (kind)
   {
-    g_signal_emit_by_name (self, "import-error", error);
-    g_clear_error (&error);
-    goto bail;
+  case MEDIA_AUDIO:
+    dir = &import->music_dir;
+    dev = &import->music_dev;
+    directory = G_USER_DIRECTORY_MUSIC;
+    break;
+  case MEDIA_IMAGE:
+    dir = &import->pictures_dir;
+    dev = &import->pictures_dev;
+    directory = G_USER_DIRECTORY_PICTURES;
+    break;
+  case MEDIA_VIDEO:
+    dir = &import->videos_dir;
+    dev = &import->videos_dev;
+    directory = G_USER_DIRECTORY_VIDEOS;
+    break;
+  default:
+    g_set_error (error, MPD_STORAGE_DEVICE_ERROR, 0,
+                 "%s : Unhandled media kind %d", G_STRLOC, kind);
+    return NULL;
   }
 
-  content_type = g_file_info_get_content_type (source_info);
-  if (g_str_has_prefix (content_type, "audio/"))
+  if (NULL == *dir)
   {
-    if (NULL == priv->music_dir)
-    {
-      priv->music_dir =
-        ensure_import_subdir (g_get_user_special_dir(G_USER_DIRECTORY_MUSIC),
-                              &error);
-      if (error)
-      {
-        g_signal_emit_by_name (self, "import-error", error);
-        g_clear_error (&error);
-        goto bail;
-      }
-    }
-    target_dir = priv->music_dir;
+    struct stat  buf;
+    char        *path;
+
+    *dir = ensure_import_subdir (g_get_user_special_dir (directory), error);
+    if (NULL == *dir)
+      return NULL;
+
+    path = g_file_get_path (*dir);
+    if (0 == stat (path, &buf))
+      *dev = buf.st_dev;
+    g_free (path);
+  }
+
+  *target_dev = *dev;
+  return *dir;
+}
+
+static ImportTarget *
+import_target_get (dev_t dev)
+{
+  ImportTarget  target = { dev, 0 };
+  unsigned int  i;
 
-  } else if (g_str_has_prefix (content_type, "image/")) {
+  if (NULL == _import_targets)
+    _import_targets = g_array_new (false, false, sizeof (ImportTarget));
 
-    if (NULL == priv->pictures_dir)
+  for (i = 0; i < _import_targets->len; i++)
+    if (g_array_index (_import_targets, ImportTarget, i).dev == dev)
+      return &g_array_index (_import_targets, ImportTarget, i);
+
+  g_array_append_val (_import_targets, target);
+  return &g_array_index (_import_targets, ImportTarget, i);
+}
+
+/*
+ * Keeps the pool filled up with copies.
+ */
+static void
+import_dispatch (Import *import)
+{
+  while (import->pending &&
+         import->n_copies < IMPORT_SOURCE_COPIES &&
+         !g_cancellable_is_cancelled (import->cancellable))
+  {
+    MediaFile    *file = (MediaFile *) import->pending->data;
+    ImportCopy   *copy;
+    ImportTarget *target;
+    GFile        *target_dir;
+    dev_t         target_dev = 0;
+    char         *target_name;
+    GError       *error = NULL;
+
+    target_dir = import_target_dir (import, file->kind, &target_dev, &error);
+    if (NULL == target_dir)
     {
-      priv->pictures_dir =
-        ensure_import_subdir (g_get_user_special_dir (G_USER_DIRECTORY_PICTURES),
-                              &error);
-      if (error)
-      {
-        g_signal_emit_by_name (self, "import-error", error);
-        g_clear_error (&error);
-        goto bail;
-      }
+      if (NULL == error)
+        g_set_error (&error, MPD_STORAGE_DEVICE_ERROR, 0,
+                     "%s : No directory to import %s to",
+                     G_STRLOC, file->path);
+      import->pending = g_slist_delete_link (import->pending, import->pending);
+      import_error (import, error);
+      g_clear_error (&error);
+      import->imported_size += file->size;
+      media_file_free (file);
+      continue;
     }
-    target_dir = priv->pictures_dir;
 
-  } else if (g_str_has_prefix (content_type, "video/")) {
+    /* The disk is busy with copies from other imports, wait for one of
+     * them to finish. */
+    target = import_target_get (target_dev);
+    if (target->n_copies >= IMPORT_TARGET_COPIES)
+      break;
+
+    target->n_copies++;
+    import->pending = g_slist_delete_link (import->pending, import->pending);
+
+    copy = g_slice_new0 (ImportCopy);
+    copy->file = file;
+    copy->target_dev = target_dev;
+    target_name = g_path_get_basename (file->path);
+    copy->target_path = ensure_unique_child (target_dir, target_name, true,
+                                             import->reserved);
+    g_free (target_name);
+
+    g_hash_table_insert (import->reserved, copy->target_path, copy);
+    import->n_copies++;
+    import_ref (import);
+    g_thread_pool_push (import->pool, copy, NULL);
+  }
+}
+
+static void
+import_finish (Import *import)
+{
+  MpdStorageDevice *self = import->self;
+  double  elapsed;
+  char   *size_text;
+
+  elapsed = (g_get_monotonic_time () - import->start_time) /
+            (double) G_USEC_PER_SEC;
+  size_text = g_format_size (import->copied_size);
+  g_debug ("%s : %s: copied %s in %.2fs (%.1f MB/s)",
+           G_STRLOC, import->root, size_text, elapsed,
+           elapsed > 0 ? import->copied_size / elapsed / 1e6 : 0);
+  g_free (size_text);
+
+  _imports = g_slist_remove (_imports, import);
+
+  /* All copies are back, this does not block. */
+  g_thread_pool_free (import->pool, false, true);
+  import->pool = NULL;
+
+  if (self)
+  {
+    bool stopped = g_cancellable_is_cancelled (import->cancellable);
+
+    GET_PRIVATE (self)->import = NULL;
+    import->self = NULL;
+    import_unref (import);
+
+    if (!stopped)
+      g_signal_emit (self, _signals[IMPORT_FINISHED], 0);
+  }
+}
+
+/*
+ * Starts what the limits allow, and finishes the import once nothing is
+ * left to do.
+ */
+static void
+import_kick (Import *import)
+{
+  import_dispatch (import);
+
+  if (0 == import->n_copies &&
+      (NULL == import->pending ||
+       g_cancellable_is_cancelled (import->cancellable)))
+    import_finish (import);
+}
 
-    if (NULL == priv->pictures_dir)
+static bool
+_import_idle_cb (Import *import)
+{
+  MpdStorageDevice *self = import->self;
+  GSList  *copied;
+  GSList  *iter;
+  bool     any_copied;
+
+  g_mutex_lock (&import->mutex);
+  copied = import->copied;
+  import->copied = NULL;
+  import->idle_id = 0;
+  g_mutex_unlock (&import->mutex);
+
+  any_copied = (NULL != copied);
+  for (iter = copied; iter; iter = iter->next)
+  {
+    ImportCopy *copy = (ImportCopy *) iter->data;
+
+    import->n_copies--;
+    import_target_get (copy->target_dev)->n_copies--;
+    g_hash_table_remove (import->reserved, copy->target_path);
+    import->imported_size += copy->file->size;
+
+    if (copy->error)
     {
-      priv->videos_dir =
-        ensure_import_subdir (g_get_user_special_dir (G_USER_DIRECTORY_VIDEOS),
-                              &error);
-      if (error)
-      {
-        g_signal_emit_by_name (self, "import-error", error);
-        g_clear_error (&error);
-        goto bail;
-      }
+      if (!g_error_matches (copy->error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        import_error (import, copy->error);
+    } else {
+      import->copied_size += copy->file->size;
+      journal_append (import, copy);
     }
-    target_dir = priv->videos_dir;
 
-  } else {
+    import_copy_free (copy);
+  }
+  g_slist_free (copied);
 
-    g_warning ("%s : Unhandled content type %s", G_STRLOC, content_type);
-    goto bail;
+  if (self)
+  {
+    float    progress;
+    uint64_t rate;
+    double   elapsed;
+
+    elapsed = (g_get_monotonic_time () - import->start_time) /
+              (double) G_USEC_PER_SEC;
+    progress = import->total_size ?
+                 (float) import->imported_size / import->total_size : 1.0;
+    rate = elapsed > 0 ? import->copied_size / elapsed : 0;
+    g_signal_emit (self, _signals[IMPORT_PROGRESS], 0, progress, rate);
   }
 
-  target_name = g_path_get_basename (source_path);
-  target_file = ensure_unique_child (target_dir, target_name, true);
-  g_file_copy_async (source_file, target_file, G_FILE_COPY_NONE,
-                     G_PRIORITY_DEFAULT, priv->cancellable,
-                     NULL, NULL,
-                     (GAsyncReadyCallback) _file_copy_cb, self);
+  import_kick (import);
+
+  /* Other imports may have been waiting for the disk we wrote to. */
+  if (any_copied)
+  {
+    GSList *imports = g_slist_copy (_imports);
 
-bail:
-  if (target_file) g_object_unref (target_file);
-  if (target_name) g_free (target_name);
-  if (source_info) g_object_unref (source_info);
-  if (source_file) g_object_unref (source_file);
-  if (source_path) g_free (source_path);
+    for (iter = imports; iter; iter = iter->next)
+      if (iter->data != import)
+        import_kick ((Import *) iter->data);
+
+    g_slist_free (imports);
+  }
+
+  return false;
 }
 
+/*
+ * Copies the media found by mpd_storage_device_has_media_async() to the
+ * user's pictures, music and videos directories. "import-progress" is
+ * emitted with the fraction done and the throughput in bytes per second,
+ * and "import-finished" once everything is copied and recorded, unless
+ * the import is stopped.
+ */
 bool
 mpd_storage_device_import_async (MpdStorageDevice  *self,
                                  GError           **error)
@@ -862,10 +1689,16 @@ mpd_storage_device_import_async (MpdStorageDevice  *self,
   MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
   MpdStorageDevice *target;
   uint64_t          target_available;
+  uint64_t          required_size;
+  Import           *import;
+  GHashTable       *journal;
+  char             *path;
+  char             *dir;
+  GSList           *iter;
 
   g_return_val_if_fail (MPD_IS_STORAGE_DEVICE (self), false);
 
-  if (priv->dir_stack)
+  if (priv->discovery)
   {
     g_warning ("%s : %s: Device indexing in progress",
                 G_STRLOC,
@@ -891,42 +1724,119 @@ mpd_storage_device_import_async (MpdStorageDevice  *self,
     return false;
   }
 
+  if (priv->import)
+    return true;
+
+  import = g_slice_new0 (Import);
+  import->ref_count = 1;
+  import->self = self;
+  import->cancellable = g_cancellable_new ();
+  g_mutex_init (&import->mutex);
+  import->root = g_str_has_suffix (priv->path, G_DIR_SEPARATOR_S) ?
+                   g_strdup (priv->path) :
+                   g_strconcat (priv->path, G_DIR_SEPARATOR_S, NULL);
+  import->reserved = g_hash_table_new (g_str_hash, g_str_equal);
+  import->total_size = priv->media_files_size;
+
+  /* Skip what an earlier import already took care of. */
+  path = journal_path (self);
+  journal = journal_load (path);
+  for (iter = priv->media_files; iter; iter = iter->next)
+  {
+    MediaFile *file = (MediaFile *) iter->data;
+
+    if (!g_str_has_prefix (file->path, import->root) ||
+        journal_has (journal, import->root, file))
+    {
+      import->imported_size += file->size;
+    } else {
+      MediaFile *pending = g_slice_dup (MediaFile, file);
+      pending->path = g_strdup (file->path);
+      import->pending = g_slist_prepend (import->pending, pending);
+    }
+  }
+  g_hash_table_destroy (journal);
+
+  required_size = import->total_size - import->imported_size;
   target = mpd_storage_device_new (g_get_home_dir ());
   target_available = mpd_storage_device_get_available_size (target);
   g_object_unref (target);
-  if (target_available < priv->media_files_size)
+  if (target_available < required_size)
   {
-    char *available_text = g_format_size_for_display (target_available);
-    char *required_text = g_format_size_for_display (priv->media_files_size);
+    char *available_text = g_format_size (target_available);
+    char *required_text = g_format_size (required_size);
     g_warning ("%s : Would need %s on %s but only %s available",
                G_STRLOC,
-               available_text,
+               required_text,
                g_get_home_dir (),
-               required_text);
+               available_text);
     if (error)
       *error = g_error_new (MPD_STORAGE_DEVICE_ERROR,
                         MPD_STORAGE_DEVICE_IMPORT_ERROR_INSUFICCIENT_DISK_SPACE,
                         "%s : Would need %s on %s but only %s available",
                         G_STRLOC,
-                        available_text,
+                        required_text,
                         g_get_home_dir (),
-                        required_text);
+                        available_text);
     g_free (available_text);
     g_free (required_text);
+    g_free (path);
+    import_unref (import);
     return false;
   }
 
-  priv->cancellable = g_cancellable_new ();
-  import_file_async (self);
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0700);
+  import->journal = fopen (path, "a");
+  if (NULL == import->journal)
+    g_warning ("%s : %s: %s", G_STRLOC, path, strerror (errno));
+  g_free (dir);
+  g_free (path);
+
+  import->pool = g_thread_pool_new ((GFunc) _copy_cb, import,
+                                    IMPORT_SOURCE_COPIES, false, NULL);
+  import->start_time = g_get_monotonic_time ();
+  priv->import = import;
+  _imports = g_slist_prepend (_imports, import);
+
+  import_dispatch (import);
+  if (0 == import->n_copies && NULL == import->pending)
+  {
+    /* Nothing left to copy. */
+    g_signal_emit (self, _signals[IMPORT_PROGRESS], 0, 1.0, (uint64_t) 0);
+    import_finish (import);
+  }
+
   return true;
 }
 
+/*
+ * Stops the import; copies in flight are abandoned, and what has been
+ * imported so far is remembered for the next time.
+ */
 bool
 mpd_storage_device_stop_import (MpdStorageDevice *self)
 {
   MpdStorageDevicePrivate *priv = GET_PRIVATE (self);
-  g_cancellable_cancel (priv->cancellable);
+
+  g_return_val_if_fail (MPD_IS_STORAGE_DEVICE (self), false);
+
+  if (NULL == priv->import)
+    return false;
+
+  g_cancellable_cancel (priv->import->cancellable);
+
+  /* Waiting for the target disk, there is no idle to finish it. */
+  if (0 == priv->import->n_copies)
+  {
+    import_finish (priv->import);
+    return true;
+  }
+
+  /* The workers drain and the last idle closes the journal. */
+  priv->import->self = NULL;
+  import_unref (priv->import);
+  priv->import = NULL;
+
   return true;
 }
-
-#endif
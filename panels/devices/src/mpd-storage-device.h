@@ -76,6 +76,19 @@ mpd_storage_device_get_available_size (MpdStorageDevice *self);
 char const *
 mpd_storage_device_get_path (MpdStorageDevice *self);
 
+void
+mpd_storage_device_has_media_async (MpdStorageDevice *self);
+
+void
+mpd_storage_device_cancel_has_media (MpdStorageDevice *self);
+
+bool
+mpd_storage_device_import_async (MpdStorageDevice  *self,
+                                 GError           **error);
+
+bool
+mpd_storage_device_stop_import (MpdStorageDevice *self);
+
 #if 0 /* Volume crawling code etc. */
 
 char const *
@@ -87,16 +100,6 @@ mpd_storage_device_get_model (MpdStorageDevice *self);
 char const *
 mpd_storage_device_get_vendor (MpdStorageDevice *self);
 
-void
-mpd_storage_device_has_media_async (MpdStorageDevice *self);
-
-bool
-mpd_storage_device_import_async (MpdStorageDevice  *self,
-                                 GError           **error);
-
-bool
-mpd_storage_device_stop_import (MpdStorageDevice *self);
-
 #endif
 
 G_END_DECLS
@@ -24,12 +24,72 @@
 #include <clutter/clutter.h>
 #include "mpd-storage-device.h"
 
+static bool _import = false;
+
+static void
+_import_progress_cb (MpdStorageDevice *storage,
+                     float             progress,
+                     uint64_t          rate,
+                     void             *data)
+{
+  g_debug ("%s() %.2f at %llu bytes/s", __FUNCTION__,
+           progress, (unsigned long long) rate);
+}
+
+static void
+_import_finished_cb (MpdStorageDevice *storage,
+                     void             *data)
+{
+  g_debug ("%s()", __FUNCTION__);
+
+  clutter_main_quit ();
+}
+
+static void
+_import_error_cb (MpdStorageDevice *storage,
+                  GError           *error,
+                  void             *data)
+{
+  g_debug ("%s() %s", __FUNCTION__, error->message);
+}
+
 static void
 _has_media_cb (MpdStorageDevice *storage,
                bool              has_media,
                void             *data)
 {
+  GError *error = NULL;
+
   g_debug ("%s() %d", __FUNCTION__, has_media);
+
+  if (!_import || !has_media)
+  {
+    clutter_main_quit ();
+    return;
+  }
+
+  g_signal_connect (storage, "import-progress",
+                    G_CALLBACK (_import_progress_cb), NULL);
+  g_signal_connect (storage, "import-error",
+                    G_CALLBACK (_import_error_cb), NULL);
+  g_signal_connect (storage, "import-finished",
+                    G_CALLBACK (_import_finished_cb), NULL);
+  if (!mpd_storage_device_import_async (storage, &error))
+  {
+    g_critical ("%s", error->message);
+    g_clear_error (&error);
+    clutter_main_quit ();
+  }
+}
+
+static void
+_media_progress_cb (MpdStorageDevice *storage,
+                    unsigned int      n_files,
+                    uint64_t          size,
+                    void             *data)
+{
+  g_debug ("%s() %u files, %llu bytes", __FUNCTION__,
+           n_files, (unsigned long long) size);
 }
 
 int
@@ -52,6 +112,7 @@ main (int     argc,
   {
     path = argv[1];
     query_media = true;
+    _import = argc > 2 && 0 == g_strcmp0 (argv[2], "import");
   } else {
     path = g_get_home_dir ();
     query_media = false;
@@ -69,9 +130,9 @@ main (int     argc,
   {
     g_signal_connect (storage, "has-media",
                       G_CALLBACK (_has_media_cb), NULL);
-#if 0
+    g_signal_connect (storage, "media-progress",
+                      G_CALLBACK (_media_progress_cb), NULL);
     mpd_storage_device_has_media_async (storage);
-#endif
     clutter_main ();
   }
 
@@ -34,11 +34,27 @@ G_DEFINE_TYPE (AnerleyFeedModel, anerley_feed_model, CLUTTER_TYPE_LIST_MODEL)
 
 typedef struct _AnerleyFeedModelPrivate AnerleyFeedModelPrivate;
 
+/*
+ * Rather than a ClutterModel filter, which can only be re-run over the
+ * whole model, we keep track of every item of the feed ourselves and only
+ * the visible ones are rows of the model. When an item changes only that
+ * item is looked at again, and it is added, removed or reported as changed
+ * as a single row.
+ */
+typedef struct {
+  AnerleyFeedModel *model;
+  AnerleyItem *item;
+  GSequenceIter *visible; /* in priv->visible, NULL when filtered out */
+} AnerleyFeedModelRow;
+
 struct _AnerleyFeedModelPrivate {
   AnerleyFeed *feed;
   gchar *filter_text;
   gboolean show_offline;
   AnerleyFeedModelSortMethod sort_method;
+
+  GHashTable *rows;    /* AnerleyItem -> AnerleyFeedModelRow */
+  GSequence *visible;  /* AnerleyFeedModelRow, in the order of the model */
 };
 
 enum
@@ -59,6 +75,8 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 static void anerley_feed_model_update_feed (AnerleyFeedModel *model,
                                             AnerleyFeed      *feed);
+static void _item_changed_cb (AnerleyFeedModel *model,
+                              AnerleyItem      *item);
 
 static void
 anerley_feed_model_get_property (GObject *object, guint property_id,
@@ -103,10 +121,20 @@ anerley_feed_model_dispose (GObject *object)
 
   if (priv->feed)
   {
+    g_signal_handlers_disconnect_matched (priv->feed,
+                                          G_SIGNAL_MATCH_DATA,
+                                          0, 0, NULL, NULL,
+                                          object);
     g_object_unref (priv->feed);
     priv->feed = NULL;
   }
 
+  if (priv->rows)
+  {
+    g_hash_table_unref (priv->rows);
+    priv->rows = NULL;
+  }
+
   G_OBJECT_CLASS (anerley_feed_model_parent_class)->dispose (object);
 }
 
@@ -120,6 +148,8 @@ anerley_feed_model_finalize (GObject *object)
     g_free (priv->filter_text);
   }
 
+  g_sequence_free (priv->visible);
+
   G_OBJECT_CLASS (anerley_feed_model_parent_class)->finalize (object);
 }
 
@@ -173,105 +203,80 @@ anerley_feed_model_class_init (AnerleyFeedModelClass *klass)
 }
 
 static gint
-_model_sort_func_name (ClutterModel *model,
-                       const GValue *a,
-                       const GValue *b,
-                       gpointer      userdata)
+_compare_items_by_name (AnerleyItem *item_a,
+                        AnerleyItem *item_b)
 {
-  AnerleyItem *item_a;
-  AnerleyItem *item_b;
-  const gchar *str_a;
-  const gchar *str_b;
-
-  item_a = g_value_get_object (a);
-  item_b = g_value_get_object (b);
-
-  /* Already g_utf8_casefold'ed */
-  str_a = anerley_item_get_sortable_name (item_a);
-  str_b = anerley_item_get_sortable_name (item_b);
-
-  return g_utf8_collate (str_a, str_b);
+  /* Collation keys of the g_utf8_casefold'ed names */
+  return strcmp (anerley_item_get_collate_key (item_a),
+                 anerley_item_get_collate_key (item_b));
 }
 
 static gint
-_model_sort_func_presence (ClutterModel *model,
-                           const GValue *a,
-                           const GValue *b,
-                           gpointer      userdata)
+_compare_items_by_presence (AnerleyItem *item_a,
+                            AnerleyItem *item_b)
 {
-  AnerleyItem *item_a;
-  AnerleyItem *item_b;
-  TpConnectionPresenceType presence_a;
-  TpConnectionPresenceType presence_b;
   gint ret_val;
 
-  item_a = g_value_get_object (a);
-  item_b = g_value_get_object (b);
-
-  /* TpConnectionPresenceType as exact same values than FolksPresenceType.... */
-  presence_a = (TpConnectionPresenceType) anerley_item_get_presence_type (item_a);
-  presence_b = (TpConnectionPresenceType) anerley_item_get_presence_type (item_b);
-
-  ret_val = -tp_connection_presence_type_cmp_availability (presence_a, presence_b);
+  /* Most available first */
+  ret_val = anerley_item_get_presence_rank (item_b) -
+            anerley_item_get_presence_rank (item_a);
   if (ret_val == 0)
     {
       /* Fallback: compare by name */
-      ret_val = _model_sort_func_name (model, a, b, userdata);
+      ret_val = _compare_items_by_name (item_a, item_b);
     }
 
   return ret_val;
 }
 
 static gint
-_model_sort_func (ClutterModel *model,
-                  const GValue *a,
-                  const GValue *b,
-                  gpointer      userdata)
+_compare_rows (gconstpointer a,
+               gconstpointer b,
+               gpointer      userdata)
 {
-  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (userdata);
+  const AnerleyFeedModelRow *row_a = a;
+  const AnerleyFeedModelRow *row_b = b;
 
   switch (priv->sort_method)
   {
     case ANERLEY_FEED_MODEL_SORT_METHOD_NAME:
-      return _model_sort_func_name (model, a, b, userdata);
+      return _compare_items_by_name (row_a->item, row_b->item);
     case ANERLEY_FEED_MODEL_SORT_METHOD_PRESENCE:
-      return _model_sort_func_presence (model, a, b, userdata);
+      return _compare_items_by_presence (row_a->item, row_b->item);
   }
 
   return 0;
 }
 
 static gboolean
-_model_filter_cb (ClutterModel     *model,
-                  ClutterModelIter *iter,
-                  gpointer          userdata)
+_item_is_visible (AnerleyFeedModel *model,
+                  AnerleyItem      *item)
 {
   AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
-  AnerleyItem *item = NULL;
-  gboolean ret = FALSE;
-
-  clutter_model_iter_get (iter, 0, &item, -1);
-
-  if (G_UNLIKELY (item == NULL))
-    return FALSE;
 
   if (!anerley_item_is_im (item))
-    goto out;
+    return FALSE;
 
   if (!priv->show_offline && !anerley_item_is_online (item))
-    goto out;
+    return FALSE;
 
   if (priv->filter_text != NULL &&
       strcasestr (anerley_item_get_display_name (item),
                   priv->filter_text) == NULL)
-    goto out;
-
-  ret = TRUE;
+    return FALSE;
 
-out:
-  g_object_unref (item);
+  return TRUE;
+}
 
-  return ret;
+static void
+_row_free (AnerleyFeedModelRow *row)
+{
+  g_signal_handlers_disconnect_by_func (row->item,
+                                        _item_changed_cb,
+                                        row->model);
+  g_object_unref (row->item);
+  g_slice_free (AnerleyFeedModelRow, row);
 }
 
 static void
@@ -279,13 +284,17 @@ anerley_feed_model_init (AnerleyFeedModel *self)
 {
   GType types[] = { ANERLEY_TYPE_ITEM };
 
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (self);
+
   clutter_model_set_types (CLUTTER_MODEL (self),
                            1,
                            types);
-  clutter_model_set_filter (CLUTTER_MODEL (self),
-                            _model_filter_cb,
-                            NULL,
-                            NULL);
+
+  priv->rows = g_hash_table_new_full (NULL,
+                                      NULL,
+                                      NULL,
+                                      (GDestroyNotify)_row_free);
+  priv->visible = g_sequence_new (NULL);
 }
 
 ClutterModel *
@@ -297,20 +306,149 @@ anerley_feed_model_new (AnerleyFeed *feed)
                        NULL);
 }
 
+static void
+show_row (AnerleyFeedModel    *model,
+          AnerleyFeedModelRow *row)
+{
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+
+  row->visible = g_sequence_insert_sorted (priv->visible,
+                                           row,
+                                           _compare_rows,
+                                           model);
+  clutter_model_insert ((ClutterModel *)model,
+                        g_sequence_iter_get_position (row->visible),
+                        0,
+                        row->item,
+                        -1);
+}
+
+/* Whether the row is still between its neighbours */
+static gboolean
+row_is_in_order (AnerleyFeedModel    *model,
+                 AnerleyFeedModelRow *row)
+{
+  GSequenceIter *iter;
+
+  if (!g_sequence_iter_is_begin (row->visible))
+  {
+    iter = g_sequence_iter_prev (row->visible);
+    if (_compare_rows (g_sequence_get (iter), row, model) > 0)
+      return FALSE;
+  }
+
+  iter = g_sequence_iter_next (row->visible);
+  if (!g_sequence_iter_is_end (iter) &&
+      _compare_rows (row, g_sequence_get (iter), model) > 0)
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * Moves a single row that went out of order to its new place, rather than
+ * sorting the whole model again.
+ */
+static void
+reposition_row (AnerleyFeedModel    *model,
+                AnerleyFeedModelRow *row)
+{
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  gint old_position, new_position;
+
+  old_position = g_sequence_iter_get_position (row->visible);
+  g_sequence_sort_changed (row->visible, _compare_rows, model);
+  new_position = g_sequence_iter_get_position (row->visible);
+
+  if (old_position == new_position)
+    return;
+
+  clutter_model_remove ((ClutterModel *)model, old_position);
+  clutter_model_insert ((ClutterModel *)model,
+                        new_position,
+                        0,
+                        row->item,
+                        -1);
+}
+
+static void
+hide_row (AnerleyFeedModel    *model,
+          AnerleyFeedModelRow *row)
+{
+  clutter_model_remove ((ClutterModel *)model,
+                        g_sequence_iter_get_position (row->visible));
+  g_sequence_remove (row->visible);
+  row->visible = NULL;
+}
+
+/* Brings a row in line with the filter, returns whether it was visible
+ * before and still is */
+static gboolean
+refilter_row (AnerleyFeedModel    *model,
+              AnerleyFeedModelRow *row)
+{
+  gboolean visible = _item_is_visible (model, row->item);
+
+  if (visible && !row->visible)
+    show_row (model, row);
+  else if (!visible && row->visible)
+    hide_row (model, row);
+  else
+    return visible;
+
+  return FALSE;
+}
+
 static void
 refilter_all (AnerleyFeedModel *model)
 {
-  g_signal_emit_by_name (model, "filter-changed");
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, priv->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    refilter_row (model, value);
+}
+
+/*
+ * Takes one item that changed in a way that can affect whether it is shown
+ * or where, and filters and places just that item again. The model already
+ * does this for changes of presence and of the name.
+ */
+void
+anerley_feed_model_update_item (AnerleyFeedModel *model,
+                                AnerleyItem      *item)
+{
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  AnerleyFeedModelRow *row;
+  ClutterModelIter *iter;
+
+  row = g_hash_table_lookup (priv->rows, item);
+  if (row == NULL)
+    return;
+
+  if (!refilter_row (model, row))
+    return;
+
+  if (!row_is_in_order (model, row))
+  {
+    reposition_row (model, row);
+    return;
+  }
+
+  /* Still showing, let the views know that just this row changed */
+  iter = clutter_model_get_iter_at_row ((ClutterModel *)model,
+                                        g_sequence_iter_get_position (row->visible));
+  g_signal_emit_by_name (model, "row-changed", iter);
+  g_object_unref (iter);
 }
 
 static void
-refilter_item (AnerleyFeedModel *model,
-               AnerleyItem      *item)
+_item_changed_cb (AnerleyFeedModel *model,
+                  AnerleyItem      *item)
 {
-  /* We can't find unvisible rows, so its not possible to simply emit
-   * row-changed for that item... so let's just refilter everything...
-   * Thanks clutter, thanks! */
-  refilter_all (model);
+  anerley_feed_model_update_item (model, item);
 }
 
 static void
@@ -319,40 +457,35 @@ _feed_items_added_cb (AnerleyFeed *feed,
                       gpointer     userdata)
 {
   AnerleyFeedModel *model = (AnerleyFeedModel *)userdata;
-  GList *l;
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  AnerleyFeedModelRow *row;
   AnerleyItem *item;
+  GList *l;
 
   g_signal_emit (model, signals[BULK_CHANGE_START], 0);
 
-  clutter_model_set_sort ((ClutterModel *)model,
-                          -1,
-                          NULL,
-                          NULL,
-                          NULL);
-
-
   for (l = items; l; l = l->next)
   {
     item = (AnerleyItem *)l->data;
 
-    tp_g_signal_connect_object (item, "presence-changed",
-                                G_CALLBACK (refilter_item),
-                                model, G_CONNECT_SWAPPED);
-    tp_g_signal_connect_object (item, "display-name-changed",
-                                G_CALLBACK (refilter_item),
-                                model, G_CONNECT_SWAPPED);
-
-    clutter_model_append (CLUTTER_MODEL (model),
-                          0,
-                          item,
-                          -1);
-  }
+    if (g_hash_table_lookup (priv->rows, item))
+      continue;
 
-  clutter_model_set_sort ((ClutterModel *)model,
-                          0,
-                          _model_sort_func,
-                          NULL,
-                          NULL);
+    row = g_slice_new0 (AnerleyFeedModelRow);
+    row->model = model;
+    row->item = g_object_ref (item);
+    g_hash_table_insert (priv->rows, item, row);
+
+    g_signal_connect_swapped (item, "presence-changed",
+                              G_CALLBACK (_item_changed_cb),
+                              model);
+    g_signal_connect_swapped (item, "display-name-changed",
+                              G_CALLBACK (_item_changed_cb),
+                              model);
+
+    if (_item_is_visible (model, item))
+      show_row (model, row);
+  }
 
   g_signal_emit (model, signals[BULK_CHANGE_END], 0);
 }
@@ -363,56 +496,24 @@ _feed_items_removed_cb (AnerleyFeed *feed,
                         gpointer     userdata)
 {
   AnerleyFeedModel *model = (AnerleyFeedModel *)userdata;
+  AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  AnerleyFeedModelRow *row;
   GList *l;
-  AnerleyItem *item_to_remove, *item;
-  ClutterModelIter *iter;
 
   g_signal_emit (model, signals[BULK_CHANGE_START], 0);
 
-  /* If we have a filter set we must remove it before we can iterate */
-
-  if (clutter_model_get_filter_set ((ClutterModel *)model))
-  {
-    clutter_model_set_filter ((ClutterModel *)model,
-                              NULL,
-                              NULL,
-                              NULL);
-  }
-
   for (l = items; l; l = l->next)
   {
-    item_to_remove = (AnerleyItem *)l->data;
+    row = g_hash_table_lookup (priv->rows, l->data);
+    if (row == NULL)
+      continue;
 
-    iter = clutter_model_get_first_iter ((ClutterModel *)model);
-    if (iter == NULL)
-      break;
+    if (row->visible)
+      hide_row (model, row);
 
-    while (!clutter_model_iter_is_last (iter))
-    {
-      clutter_model_iter_get (iter,
-                              0,
-                              &item,
-                              -1);
-
-      if (item == item_to_remove)
-      {
-        g_signal_handlers_disconnect_by_func (item, refilter_item, feed);
-        clutter_model_remove ((ClutterModel *)model,
-                              clutter_model_iter_get_row (iter));
-        break;
-      }
-
-      clutter_model_iter_next (iter);
-    }
-
-    g_object_unref (iter);
+    g_hash_table_remove (priv->rows, l->data);
   }
 
-  clutter_model_set_filter ((ClutterModel *)model,
-                            _model_filter_cb,
-                            NULL,
-                            NULL);
-
   g_signal_emit (model, signals[BULK_CHANGE_END], 0);
 }
 
@@ -434,6 +535,21 @@ anerley_feed_model_update_feed (AnerleyFeedModel *model,
     priv->feed = NULL;
   }
 
+  /* Drop the rows of the old feed */
+  if (g_hash_table_size (priv->rows) > 0)
+  {
+    g_signal_emit (model, signals[BULK_CHANGE_START], 0);
+
+    while (clutter_model_get_n_rows ((ClutterModel *)model) > 0)
+      clutter_model_remove ((ClutterModel *)model, 0);
+
+    g_sequence_remove_range (g_sequence_get_begin_iter (priv->visible),
+                             g_sequence_get_end_iter (priv->visible));
+    g_hash_table_remove_all (priv->rows);
+
+    g_signal_emit (model, signals[BULK_CHANGE_END], 0);
+  }
+
   if (feed)
   {
     priv->feed = g_object_ref (feed);
@@ -482,11 +598,29 @@ anerley_feed_model_set_sort_method (AnerleyFeedModel *model,
                                     AnerleyFeedModelSortMethod method)
 {
   AnerleyFeedModelPrivate *priv = GET_PRIVATE (model);
+  GSequenceIter *iter;
 
   if (method == priv->sort_method)
     return;
 
   priv->sort_method = method;
 
-  clutter_model_resort (CLUTTER_MODEL (model));
+  /* The rows are placed by us, so put them all in the new order */
+  g_signal_emit (model, signals[BULK_CHANGE_START], 0);
+
+  g_sequence_sort (priv->visible, _compare_rows, model);
+
+  while (clutter_model_get_n_rows ((ClutterModel *)model) > 0)
+    clutter_model_remove ((ClutterModel *)model, 0);
+
+  for (iter = g_sequence_get_begin_iter (priv->visible);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+  {
+    AnerleyFeedModelRow *row = g_sequence_get (iter);
+
+    clutter_model_append ((ClutterModel *)model, 0, row->item, -1);
+  }
+
+  g_signal_emit (model, signals[BULK_CHANGE_END], 0);
 }
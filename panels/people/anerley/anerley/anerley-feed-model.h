@@ -25,6 +25,7 @@
 
 #include <glib-object.h>
 #include <anerley/anerley-feed.h>
+#include <anerley/anerley-item.h>
 #include <clutter/clutter.h>
 
 G_BEGIN_DECLS
@@ -68,6 +69,8 @@ void anerley_feed_model_set_show_offline (AnerleyFeedModel *model,
                                           gboolean          show_offline);
 void anerley_feed_model_set_sort_method (AnerleyFeedModel *model,
                                          AnerleyFeedModelSortMethod method);
+void anerley_feed_model_update_item (AnerleyFeedModel *model,
+                                     AnerleyItem      *item);
 G_END_DECLS
 
 #endif /* _ANERLEY_FEED_MODEL */
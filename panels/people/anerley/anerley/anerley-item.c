@@ -40,6 +40,12 @@ struct _AnerleyItemPrivate {
   gchar *presence_message;
   gchar *sortable_name;
 
+  /* Sort keys, worked out once when the contact changes rather than on
+   * every comparison of a sort */
+  gchar *collate_key;
+  guint8 presence_rank;
+
+  FolksPresenceType presence_type;
   const gchar *presence_status;
 
   GHashTable *pending_messages; /* reffed TpChannel* to GSList of guint */
@@ -124,6 +130,12 @@ anerley_item_dispose (GObject *object)
 static void
 anerley_item_finalize (GObject *object)
 {
+  AnerleyItemPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->display_name);
+  g_free (priv->sortable_name);
+  g_free (priv->collate_key);
+
   G_OBJECT_CLASS (anerley_item_parent_class)->finalize (object);
 }
 
@@ -143,6 +155,31 @@ anerley_item_get_sortable_name (AnerleyItem *item)
   return priv->sortable_name;
 }
 
+/*
+ * The key to sort items by name with, a g_utf8_collate_key() of the
+ * sortable name; compare keys with strcmp().
+ */
+const gchar *
+anerley_item_get_collate_key (AnerleyItem *item)
+{
+  AnerleyItemPrivate *priv = GET_PRIVATE (item);
+
+  return priv->collate_key;
+}
+
+/*
+ * How available the contact is, the higher the more available; ranks can
+ * be compared directly instead of with
+ * tp_connection_presence_type_cmp_availability().
+ */
+guint8
+anerley_item_get_presence_rank (AnerleyItem *item)
+{
+  AnerleyItemPrivate *priv = GET_PRIVATE (item);
+
+  return priv->presence_rank;
+}
+
 GLoadableIcon *
 anerley_item_get_avatar (AnerleyItem *item)
 {
@@ -172,33 +209,24 @@ anerley_item_get_presence_type (AnerleyItem *item)
 {
   AnerleyItemPrivate *priv = GET_PRIVATE (item);
 
-  return folks_presence_details_get_presence_type (
-      (FolksPresenceDetails *) priv->contact);
+  return priv->presence_type;
 }
 
 gboolean
 anerley_item_is_im (AnerleyItem *item)
 {
   AnerleyItemPrivate *priv = GET_PRIVATE (item);
-  FolksPresenceType presence;
 
-  presence = folks_presence_details_get_presence_type (
-      (FolksPresenceDetails *) priv->contact);
-
-  return presence != FOLKS_PRESENCE_TYPE_UNSET;
+  return priv->presence_type != FOLKS_PRESENCE_TYPE_UNSET;
 }
 
 gboolean
 anerley_item_is_online (AnerleyItem *item)
 {
   AnerleyItemPrivate *priv = GET_PRIVATE (item);
-  FolksPresenceType presence;
-
-  presence = folks_presence_details_get_presence_type (
-      (FolksPresenceDetails *) priv->contact);
 
-  return presence > FOLKS_PRESENCE_TYPE_OFFLINE &&
-         presence < FOLKS_PRESENCE_TYPE_UNKNOWN;
+  return priv->presence_type > FOLKS_PRESENCE_TYPE_OFFLINE &&
+         priv->presence_type < FOLKS_PRESENCE_TYPE_UNKNOWN;
 }
 
 guint
@@ -378,6 +406,22 @@ anerley_item_class_init (AnerleyItemClass *klass)
                   1, G_TYPE_UINT);
 }
 
+/* The number of presence types @presence is more available than */
+static guint8
+_get_presence_rank (FolksPresenceType presence)
+{
+  guint8 rank = 0;
+  gint i;
+
+  /* TpConnectionPresenceType as exact same values than FolksPresenceType.... */
+  for (i = 0; i < TP_NUM_CONNECTION_PRESENCE_TYPES; i++)
+    if (tp_connection_presence_type_cmp_availability (
+          (TpConnectionPresenceType) presence, i) > 0)
+      rank++;
+
+  return rank;
+}
+
 static void
 anerley_item_init (AnerleyItem *self)
 {
@@ -386,6 +430,10 @@ anerley_item_init (AnerleyItem *self)
 
   priv->pending_messages = g_hash_table_new_full (NULL, NULL,
                                                   g_object_unref, NULL);
+
+  priv->collate_key = g_strdup ("");
+  priv->presence_type = FOLKS_PRESENCE_TYPE_UNSET;
+  priv->presence_rank = _get_presence_rank (FOLKS_PRESENCE_TYPE_UNSET);
 }
 
 AnerleyItem *
@@ -396,40 +444,48 @@ anerley_item_new (FolksIndividual *contact)
                        NULL);
 }
 
-static void
-_contact_notify_alias_cb (GObject    *object,
-                          GParamSpec *pspec,
-                          gpointer    userdata)
+/*
+ * Normally the item follows its contact; these are also how an item can be
+ * driven without one, for instance by a test.
+ */
+void
+anerley_item_set_alias (AnerleyItem *item,
+                        const gchar *alias)
 {
-  FolksIndividual *contact = (FolksIndividual *)object;
-  AnerleyItem *item = (AnerleyItem *)userdata;
   AnerleyItemPrivate *priv = GET_PRIVATE (item);
-  const gchar *alias;
 
   g_free (priv->display_name);
   priv->display_name = NULL;
   g_free (priv->sortable_name);
   priv->sortable_name = NULL;
-
-  alias = folks_alias_details_get_alias (FOLKS_ALIAS_DETAILS (contact));
+  g_free (priv->collate_key);
 
   if (alias)
   {
     priv->display_name = g_strdup (alias);
     priv->sortable_name = g_utf8_casefold (alias, -1);
+    priv->collate_key = g_utf8_collate_key (priv->sortable_name, -1);
+  } else {
+    priv->collate_key = g_strdup ("");
   }
 
   anerley_item_emit_display_name_changed ((AnerleyItem *)item);
 }
 
-static const gchar *
-_get_real_presence_status (FolksIndividual *contact)
+static void
+_contact_notify_alias_cb (GObject    *object,
+                          GParamSpec *pspec,
+                          gpointer    userdata)
 {
-  FolksPresenceType presence;
+  FolksIndividual *contact = (FolksIndividual *)object;
 
-  presence = folks_presence_details_get_presence_type (
-      (FolksPresenceDetails *) contact);
+  anerley_item_set_alias ((AnerleyItem *)userdata,
+                          folks_alias_details_get_alias (FOLKS_ALIAS_DETAILS (contact)));
+}
 
+static const gchar *
+_get_real_presence_status (FolksPresenceType presence)
+{
   switch (presence)
   {
     case FOLKS_PRESENCE_TYPE_UNSET:
@@ -455,23 +511,33 @@ _get_real_presence_status (FolksIndividual *contact)
   }
 }
 
+void
+anerley_item_set_presence_type (AnerleyItem       *item,
+                                FolksPresenceType  presence)
+{
+  AnerleyItemPrivate *priv = GET_PRIVATE (item);
+
+  /* Folks notifies both presence-type and presence-status for one change */
+  if (priv->presence_status && priv->presence_type == presence)
+    return;
+
+  priv->presence_type = presence;
+  priv->presence_rank = _get_presence_rank (presence);
+  priv->presence_status = _get_real_presence_status (presence);
+
+  anerley_item_emit_presence_changed ((AnerleyItem *)item);
+}
+
 static void
 _contact_notify_presence_status_cb (GObject    *object,
                                     GParamSpec *pspec,
                                     gpointer    userdata)
 {
   FolksIndividual *contact = (FolksIndividual *)object;
-  AnerleyItem *item = (AnerleyItem *)userdata;
-  AnerleyItemPrivate *priv = GET_PRIVATE (item);
 
-  if (_get_real_presence_status (contact))
-  {
-    priv->presence_status = _get_real_presence_status (contact);
-  } else {
-    priv->presence_status = NULL;
-  }
-
-  anerley_item_emit_presence_changed ((AnerleyItem *)item);
+  anerley_item_set_presence_type ((AnerleyItem *)userdata,
+                                  folks_presence_details_get_presence_type (
+                                      (FolksPresenceDetails *) contact));
 }
 
 static void
@@ -550,6 +616,10 @@ anerley_item_update_contact (AnerleyItem *item,
                       "notify::alias",
                       (GCallback)_contact_notify_alias_cb,
                       item);
+    g_signal_connect (priv->contact,
+                      "notify::presence-type",
+                      (GCallback)_contact_notify_presence_status_cb,
+                      item);
     g_signal_connect (priv->contact,
                       "notify::presence-status",
                       (GCallback)_contact_notify_presence_status_cb,
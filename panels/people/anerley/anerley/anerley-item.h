@@ -71,8 +71,15 @@ FolksPresenceType anerley_item_get_presence_type (AnerleyItem *item);
 gboolean anerley_item_is_im (AnerleyItem *item);
 gboolean anerley_item_is_online (AnerleyItem *item);
 const gchar *anerley_item_get_sortable_name (AnerleyItem *item);
+const gchar *anerley_item_get_collate_key (AnerleyItem *item);
+guint8 anerley_item_get_presence_rank (AnerleyItem *item);
 guint anerley_item_get_unread_messages_count (AnerleyItem *item);
 
+void anerley_item_set_alias (AnerleyItem *item,
+                             const gchar *alias);
+void anerley_item_set_presence_type (AnerleyItem       *item,
+                                     FolksPresenceType  presence);
+
 void anerley_item_emit_display_name_changed (AnerleyItem *item);
 void anerley_item_emit_avatar_changed (AnerleyItem *item);
 void anerley_item_emit_presence_changed (AnerleyItem *item);
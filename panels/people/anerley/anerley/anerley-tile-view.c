@@ -34,6 +34,7 @@ struct _AnerleyTileViewPrivate {
   AnerleyFeedModel *model;
   ClutterActor *new_selected_actor;
   ClutterActor *selected_actor;
+  gboolean frozen;
 };
 
 enum
@@ -274,9 +275,12 @@ static void
 _bulk_change_start_cb (AnerleyFeedModel *model,
                        gpointer          userdata)
 {
+  AnerleyTileViewPrivate *priv = GET_PRIVATE (userdata);
+
   /* Clear selected item, the old one is almost certainly wrong */
   anerley_tile_view_set_selected_actor ((AnerleyTileView *)userdata,
                                         NULL);
+  priv->frozen = TRUE;
   mx_item_view_freeze (MX_ITEM_VIEW (userdata));
 }
 
@@ -284,16 +288,95 @@ static void
 _bulk_change_end_cb (AnerleyFeedModel *model,
                      gpointer          userdata)
 {
+  AnerleyTileViewPrivate *priv = GET_PRIVATE (userdata);
+
+  /* MxItemView brings all the tiles up to date when thawed */
+  priv->frozen = FALSE;
   mx_item_view_thaw (MX_ITEM_VIEW (userdata));
 }
 
+/*
+ * Outside of bulk changes the model changes a row at a time, for instance
+ * when a contact goes online. MxItemView would go over all the tiles for
+ * each of those, so we handle them here and only touch the tile of the row.
+ */
+static AnerleyItem *
+_model_get_item (ClutterModel     *model,
+                 ClutterModelIter *iter)
+{
+  AnerleyItem *item = NULL;
+
+  clutter_model_iter_get (iter, 0, &item, -1);
+
+  return item;
+}
+
 static void
-_model_filter_changed_cb (ClutterModel *model,
-                          gpointer      userdata)
+_model_row_added_cb (ClutterModel     *model,
+                     ClutterModelIter *iter,
+                     gpointer          userdata)
 {
-  /* Clear selected item, the old one is almost certainly wrong */
-  anerley_tile_view_set_selected_actor ((AnerleyTileView *)userdata,
-                                        NULL);
+  AnerleyTileViewPrivate *priv = GET_PRIVATE (userdata);
+  ClutterActor *tile;
+  AnerleyItem *item;
+
+  if (priv->frozen)
+    return;
+
+  item = _model_get_item (model, iter);
+  tile = g_object_new (mx_item_view_get_item_type (MX_ITEM_VIEW (userdata)),
+                       "item", item,
+                       NULL);
+  clutter_actor_insert_child_at_index (CLUTTER_ACTOR (userdata),
+                                       tile,
+                                       clutter_model_iter_get_row (iter));
+  g_object_unref (item);
+}
+
+static void
+_model_row_removed_cb (ClutterModel     *model,
+                       ClutterModelIter *iter,
+                       gpointer          userdata)
+{
+  AnerleyTileViewPrivate *priv = GET_PRIVATE (userdata);
+  ClutterActor *tile;
+
+  if (priv->frozen)
+    return;
+
+  tile = clutter_actor_get_child_at_index (CLUTTER_ACTOR (userdata),
+                                           clutter_model_iter_get_row (iter));
+  if (tile == NULL)
+    return;
+
+  if (tile == priv->selected_actor)
+    anerley_tile_view_set_selected_actor ((AnerleyTileView *)userdata, NULL);
+
+  clutter_actor_destroy (tile);
+}
+
+static void
+_model_row_changed_cb (ClutterModel     *model,
+                       ClutterModelIter *iter,
+                       gpointer          userdata)
+{
+  AnerleyTileViewPrivate *priv = GET_PRIVATE (userdata);
+  ClutterActor *tile;
+  AnerleyItem *item;
+
+  if (priv->frozen)
+    return;
+
+  tile = clutter_actor_get_child_at_index (CLUTTER_ACTOR (userdata),
+                                           clutter_model_iter_get_row (iter));
+  if (tile == NULL)
+    return;
+
+  /* The tile follows the changes of its item by itself, and setting the
+   * same item again is a no-op */
+  item = _model_get_item (model, iter);
+  g_object_set (tile, "item", item, NULL);
+  g_object_unref (item);
 }
 
 static void
@@ -311,6 +394,15 @@ anerley_tile_view_set_model (AnerleyTileView  *view,
     g_signal_handlers_disconnect_by_func (priv->model,
                                           _bulk_change_end_cb,
                                           view);
+    g_signal_handlers_disconnect_by_func (priv->model,
+                                          _model_row_added_cb,
+                                          view);
+    g_signal_handlers_disconnect_by_func (priv->model,
+                                          _model_row_removed_cb,
+                                          view);
+    g_signal_handlers_disconnect_by_func (priv->model,
+                                          _model_row_changed_cb,
+                                          view);
     g_object_unref (priv->model);
     priv->model = NULL;
     model_was_set = TRUE;
@@ -322,6 +414,37 @@ anerley_tile_view_set_model (AnerleyTileView  *view,
     mx_item_view_set_model (MX_ITEM_VIEW (view),
                             (ClutterModel *)priv->model);
 
+    /* Take the single row changes over from MxItemView; its handlers are
+     * the only ones on the model with the view as data at this point. */
+    g_signal_handlers_block_matched (model,
+                                     G_SIGNAL_MATCH_ID | G_SIGNAL_MATCH_DATA,
+                                     g_signal_lookup ("row-added",
+                                                      CLUTTER_TYPE_MODEL),
+                                     0, NULL, NULL, view);
+    g_signal_handlers_block_matched (model,
+                                     G_SIGNAL_MATCH_ID | G_SIGNAL_MATCH_DATA,
+                                     g_signal_lookup ("row-removed",
+                                                      CLUTTER_TYPE_MODEL),
+                                     0, NULL, NULL, view);
+    g_signal_handlers_block_matched (model,
+                                     G_SIGNAL_MATCH_ID | G_SIGNAL_MATCH_DATA,
+                                     g_signal_lookup ("row-changed",
+                                                      CLUTTER_TYPE_MODEL),
+                                     0, NULL, NULL, view);
+
+    g_signal_connect (model,
+                      "row-added",
+                      (GCallback)_model_row_added_cb,
+                      view);
+    g_signal_connect (model,
+                      "row-removed",
+                      (GCallback)_model_row_removed_cb,
+                      view);
+    g_signal_connect (model,
+                      "row-changed",
+                      (GCallback)_model_row_changed_cb,
+                      view);
+
     g_signal_connect (model,
                       "bulk-change-start",
                       (GCallback)_bulk_change_start_cb,
@@ -331,11 +454,6 @@ anerley_tile_view_set_model (AnerleyTileView  *view,
                       "bulk-change-end",
                       (GCallback)_bulk_change_end_cb,
                       view);
-
-    g_signal_connect (model,
-                      "filter-changed",
-                      (GCallback)_model_filter_changed_cb,
-                      view);
   } else {
     if (model_was_set)
     {
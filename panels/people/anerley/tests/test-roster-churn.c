@@ -0,0 +1,238 @@
+/*
+ * Anerley - people feeds and widgets
+ * Copyright (C) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Presence churn on a large roster: a feed of synthetic contacts is put in
+ * a model sorted by presence, then random contacts change presence as they
+ * do in the storm after logging in. Prints how long that takes and how
+ * many rows moved, and checks the model is in order straight after the
+ * churn, before it is re-sorted from scratch for comparison.
+ *
+ * Usage: ./test-roster-churn [n-contacts] [n-changes]
+ */
+
+#include <anerley/anerley-feed.h>
+#include <anerley/anerley-feed-model.h>
+#include <anerley/anerley-item.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define N_CONTACTS 5000
+#define N_CHANGES  50000
+
+typedef GObject TestFeed;
+typedef GObjectClass TestFeedClass;
+
+G_DEFINE_TYPE_WITH_CODE (TestFeed, test_feed, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (ANERLEY_TYPE_FEED, NULL));
+
+static void
+test_feed_class_init (TestFeedClass *klass)
+{
+}
+
+static void
+test_feed_init (TestFeed *self)
+{
+}
+
+static const FolksPresenceType presences[] = {
+  FOLKS_PRESENCE_TYPE_OFFLINE,
+  FOLKS_PRESENCE_TYPE_AVAILABLE,
+  FOLKS_PRESENCE_TYPE_AWAY,
+  FOLKS_PRESENCE_TYPE_EXTENDED_AWAY,
+  FOLKS_PRESENCE_TYPE_BUSY
+};
+
+static const gchar *syllables[] = {
+  "an", "ber", "cho", "da", "el", "fi", "go", "hu", "is", "jo", "ka", "lé",
+  "mo", "nu", "ör", "pa", "qui", "ro", "sa", "ti", "ul", "ve", "wa", "zé"
+};
+
+static gchar *
+make_name (GRand *rand)
+{
+  GString *name = g_string_new (NULL);
+  gint i, n = g_rand_int_range (rand, 2, 6);
+
+  for (i = 0; i < n; i++)
+    g_string_append (name,
+                     syllables[g_rand_int_range (rand, 0,
+                                                 G_N_ELEMENTS (syllables))]);
+
+  name->str[0] = g_ascii_toupper (name->str[0]);
+
+  return g_string_free (name, FALSE);
+}
+
+static void
+_row_moved_cb (ClutterModel     *model,
+               ClutterModelIter *iter,
+               guint            *count)
+{
+  (*count)++;
+}
+
+static gboolean
+check_order (ClutterModel *model)
+{
+  ClutterModelIter *iter;
+  AnerleyItem *prev = NULL, *item;
+  gboolean ok = TRUE;
+
+  iter = clutter_model_get_first_iter (model);
+
+  while (iter && !clutter_model_iter_is_last (iter))
+  {
+    clutter_model_iter_get (iter, 0, &item, -1);
+
+    if (prev)
+    {
+      gint rank = anerley_item_get_presence_rank (prev) -
+                  anerley_item_get_presence_rank (item);
+
+      if (rank < 0 ||
+          (rank == 0 && strcmp (anerley_item_get_collate_key (prev),
+                                anerley_item_get_collate_key (item)) > 0))
+        ok = FALSE;
+
+      g_object_unref (prev);
+    }
+
+    prev = item;
+    clutter_model_iter_next (iter);
+  }
+
+  if (prev)
+    g_object_unref (prev);
+  if (iter)
+    g_object_unref (iter);
+
+  return ok;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GObject *feed;
+  ClutterModel *model;
+  GList *items = NULL, *l;
+  AnerleyItem **array;
+  GRand *rand;
+  GTimer *timer;
+  guint n_contacts = N_CONTACTS, n_changes = N_CHANGES;
+  guint n_added = 0, n_removed = 0;
+  guint i;
+  gboolean ok, moved_ok;
+
+  g_type_init ();
+
+  if (argc > 1)
+    n_contacts = MAX (atoi (argv[1]), 1);
+  if (argc > 2)
+    n_changes = atoi (argv[2]);
+
+  rand = g_rand_new_with_seed (42);
+  timer = g_timer_new ();
+
+  array = g_new (AnerleyItem *, n_contacts);
+
+  for (i = 0; i < n_contacts; i++)
+  {
+    gchar *name = make_name (rand);
+
+    array[i] = anerley_item_new (NULL);
+    anerley_item_set_alias (array[i], name);
+    anerley_item_set_presence_type (array[i],
+                                    presences[g_rand_int_range (rand, 0,
+                                                                G_N_ELEMENTS (presences))]);
+    items = g_list_prepend (items, array[i]);
+    g_free (name);
+  }
+
+  feed = g_object_new (test_feed_get_type (), NULL);
+  model = anerley_feed_model_new ((AnerleyFeed *)feed);
+  anerley_feed_model_set_show_offline ((AnerleyFeedModel *)model, TRUE);
+  anerley_feed_model_set_sort_method ((AnerleyFeedModel *)model,
+                                      ANERLEY_FEED_MODEL_SORT_METHOD_PRESENCE);
+
+  g_timer_start (timer);
+  g_signal_emit_by_name (feed, "items-added", items);
+  g_print ("Added %u contacts in %.1f ms\n",
+           clutter_model_get_n_rows (model),
+           g_timer_elapsed (timer, NULL) * 1000);
+
+  g_signal_connect (model, "row-added",
+                    G_CALLBACK (_row_moved_cb), &n_added);
+  g_signal_connect (model, "row-removed",
+                    G_CALLBACK (_row_moved_cb), &n_removed);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_changes; i++)
+  {
+    AnerleyItem *item = array[g_rand_int_range (rand, 0, n_contacts)];
+
+    anerley_item_set_presence_type (item,
+                                    presences[g_rand_int_range (rand, 0,
+                                                                G_N_ELEMENTS (presences))]);
+  }
+  g_timer_stop (timer);
+
+  g_print ("%u presence changes in %.1f ms, %.0f changes/s, "
+           "%u rows moved\n",
+           n_changes,
+           g_timer_elapsed (timer, NULL) * 1000,
+           n_changes / g_timer_elapsed (timer, NULL),
+           n_added);
+
+  /* Check what the churn itself left, the full sorts below would hide a
+   * misplaced row */
+  ok = check_order (model);
+  moved_ok = n_added == n_removed;
+  g_print ("After the churn the model is %s, %u rows added and %u removed\n",
+           ok ? "in order" : "OUT OF ORDER", n_added, n_removed);
+
+  g_signal_handlers_disconnect_by_func (model, _row_moved_cb, &n_added);
+  g_signal_handlers_disconnect_by_func (model, _row_moved_cb, &n_removed);
+
+  g_timer_start (timer);
+  anerley_feed_model_set_sort_method ((AnerleyFeedModel *)model,
+                                      ANERLEY_FEED_MODEL_SORT_METHOD_NAME);
+  anerley_feed_model_set_sort_method ((AnerleyFeedModel *)model,
+                                      ANERLEY_FEED_MODEL_SORT_METHOD_PRESENCE);
+  g_print ("Two full sorts for comparison in %.1f ms\n",
+           g_timer_elapsed (timer, NULL) * 1000);
+
+  ok = ok && moved_ok;
+
+  g_object_unref (model);
+  g_object_unref (feed);
+
+  for (l = items; l; l = l->next)
+    g_object_unref (l->data);
+  g_list_free (items);
+  g_free (array);
+
+  g_timer_destroy (timer);
+  g_rand_free (rand);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,812 @@
+/*
+ * Dawati-Web-Browser: The web browser for Dawati
+ * Copyright (c) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include <sqlite3.h>
+#include <clutter/clutter.h>
+
+#include "mwb-ac-index.h"
+
+/*
+ * Every history entry is split into the trigrams of its case folded label,
+ * and each trigram maps to the list of entries containing it. Entries are
+ * numbered in visit count order, so walking the shortest list of the
+ * query's trigrams and checking each entry yields the best matches first
+ * and lets us stop as soon as we have enough of them.
+ *
+ * The index lives as long as the panel. History added afterwards is
+ * appended as a tail of entries beyond the ranked ones; queries merge the
+ * matches from the tail in by visit count. Once the tail grows too long, or
+ * history was removed, the index is built again from scratch.
+ */
+
+#define MWB_AC_INDEX_BATCH_SIZE 5
+
+/* Rows read between checks for the index being freed */
+#define MWB_AC_INDEX_BUILD_CHUNK 256
+
+/* Longest tail, relative to the ranked entries, before a rebuild */
+#define MWB_AC_INDEX_MAX_TAIL(n_ranked) MAX ((n_ranked) / 4, 256)
+
+#define MWB_AC_INDEX_SQL "SELECT DISTINCT url, url||' - '||title as vl, "\
+                         "favicon_id, visit_count "\
+                         "FROM ( "\
+                               "SELECT url, title, favicon_id, "\
+                                      "100 as visit_count "\
+                               "FROM bookmarks WHERE rowid > ?1 "\
+                               "UNION "\
+                               "SELECT url, title, favicon_id, visit_count "\
+                               "FROM urls WHERE rowid > ?2"\
+                              ") ORDER BY visit_count DESC"
+
+#define MWB_AC_INDEX_WATERMARK_SQL "SELECT "\
+                         "(SELECT ifnull (max (rowid), 0) FROM bookmarks), "\
+                         "(SELECT ifnull (max (rowid), 0) FROM urls)"
+
+#define MWB_AC_INDEX_COUNT_SQL "SELECT "\
+                         "(SELECT count (*) FROM bookmarks WHERE rowid <= ?1), "\
+                         "(SELECT count (*) FROM urls WHERE rowid <= ?2)"
+
+#define MWB_AC_INDEX_FAVICON_SQL "SELECT url FROM favicons WHERE id=?"
+
+typedef struct
+{
+  gchar *url;
+  gchar *label;
+  gchar *folded;
+  gint   favicon_id;
+  gint   visit_count;
+} MwbAcIndexRow;
+
+/* A query without a needle refreshes the index instead */
+typedef struct
+{
+  gint                  generation;
+  gchar                *needle;
+  guint                 max_results;
+  MwbAcIndexResultFunc  func;
+  gpointer              user_data;
+} MwbAcIndexQuery;
+
+typedef struct
+{
+  gint                  generation;
+  GArray               *results;
+  gboolean              done;
+  MwbAcIndexResultFunc  func;
+  gpointer              user_data;
+} MwbAcIndexBatch;
+
+struct _MwbAcIndex
+{
+  gchar       *db_filename;
+  GThreadPool *pool;         /* single thread, runs the build and queries */
+
+  volatile gint generation;  /* bumped for each query and on cancel */
+  volatile gint stopping;    /* set when the index is being freed */
+
+  /* Only touched by the worker */
+  sqlite3      *dbcon;
+  sqlite3_stmt *favicon_stmt;
+  GPtrArray    *rows;
+  guint         n_ranked;    /* rows in visit count order, the rest is tail */
+  GHashTable   *trigrams;    /* trigram -> GArray of row numbers */
+  GHashTable   *urls;        /* url -> row, to skip those indexed already */
+  GHashTable   *icon_paths;  /* favicon id -> icon path */
+  gint64        bookmarks_rowid;   /* highest rowids indexed */
+  gint64        urls_rowid;
+  gint64        n_bookmarks;       /* rows up to those rowids */
+  gint64        n_urls;
+  gint64        db_mtime;          /* in nanoseconds */
+  off_t         db_size;
+
+  /* Batches waiting to be delivered in the main loop */
+  GMutex        lock;
+  GList        *pending;
+  guint         dispatch_id;
+};
+
+#define TRIGRAM(s) GUINT_TO_POINTER (((guint8)(s)[0] << 16) | \
+                                     ((guint8)(s)[1] << 8)  | \
+                                     (guint8)(s)[2])
+
+static void
+mwb_ac_index_free_row (gpointer data)
+{
+  MwbAcIndexRow *row = (MwbAcIndexRow *) data;
+
+  g_free (row->url);
+  g_free (row->label);
+  g_free (row->folded);
+  g_slice_free (MwbAcIndexRow, row);
+}
+
+static void
+mwb_ac_index_free_posting (gpointer data)
+{
+  g_array_free ((GArray *) data, TRUE);
+}
+
+static void
+mwb_ac_index_free_results (GArray *results)
+{
+  guint i;
+
+  for (i = 0; i < results->len; i++)
+    {
+      MwbAcIndexResult *result = &g_array_index (results, MwbAcIndexResult, i);
+
+      g_free (result->url);
+      g_free (result->label);
+      g_free (result->icon_path);
+    }
+
+  g_array_free (results, TRUE);
+}
+
+static void
+mwb_ac_index_free_batch (MwbAcIndexBatch *batch)
+{
+  mwb_ac_index_free_results (batch->results);
+  g_slice_free (MwbAcIndexBatch, batch);
+}
+
+static void
+mwb_ac_index_clear (MwbAcIndex *index)
+{
+  if (index->rows)
+    g_ptr_array_free (index->rows, TRUE);
+  if (index->trigrams)
+    g_hash_table_destroy (index->trigrams);
+  if (index->urls)
+    g_hash_table_destroy (index->urls);
+
+  index->rows = NULL;
+  index->trigrams = NULL;
+  index->urls = NULL;
+  index->n_ranked = 0;
+  index->bookmarks_rowid = index->urls_rowid = 0;
+  index->n_bookmarks = index->n_urls = 0;
+}
+
+static gboolean
+mwb_ac_index_open (MwbAcIndex *index)
+{
+  gint rc;
+
+  if (index->dbcon)
+    return TRUE;
+
+  rc = sqlite3_open_v2 (index->db_filename, &index->dbcon,
+                        SQLITE_OPEN_READONLY, NULL);
+  if (rc)
+    {
+      g_warning ("[netpanel] unable to open history db: %s",
+                 sqlite3_errmsg (index->dbcon));
+      sqlite3_close (index->dbcon);
+      index->dbcon = NULL;
+      return FALSE;
+    }
+
+  rc = sqlite3_prepare_v2 (index->dbcon, MWB_AC_INDEX_FAVICON_SQL, -1,
+                           &index->favicon_stmt, NULL);
+  if (rc)
+    g_warning ("[netpanel] sqlite3_prepare_v2 (): %s",
+               sqlite3_errmsg (index->dbcon));
+
+  return TRUE;
+}
+
+/* Runs a statement returning a single row of two integers */
+static gboolean
+mwb_ac_index_get_pair (MwbAcIndex  *index,
+                       const gchar *sql,
+                       gint64      *first,
+                       gint64      *second)
+{
+  sqlite3_stmt *stmt = NULL;
+  gboolean      ret = FALSE;
+
+  if (sqlite3_prepare_v2 (index->dbcon, sql, -1, &stmt, NULL))
+    {
+      g_warning ("[netpanel] sqlite3_prepare_v2 (): %s",
+                 sqlite3_errmsg (index->dbcon));
+      return FALSE;
+    }
+
+  /* Only the count statement has parameters */
+  if (sqlite3_bind_parameter_count (stmt) == 2)
+    {
+      sqlite3_bind_int64 (stmt, 1, index->bookmarks_rowid);
+      sqlite3_bind_int64 (stmt, 2, index->urls_rowid);
+    }
+
+  if (sqlite3_step (stmt) == SQLITE_ROW)
+    {
+      *first = sqlite3_column_int64 (stmt, 0);
+      *second = sqlite3_column_int64 (stmt, 1);
+      ret = TRUE;
+    }
+
+  sqlite3_finalize (stmt);
+
+  return ret;
+}
+
+static void
+mwb_ac_index_add_row (MwbAcIndex  *index,
+                      const gchar *url,
+                      const gchar *label,
+                      gint         favicon_id,
+                      gint         visit_count)
+{
+  MwbAcIndexRow *row;
+  guint          n = index->rows->len;
+  const gchar   *p;
+
+  /* Bookmarked and visited urls show up twice, keep the better ranked */
+  if (g_hash_table_lookup (index->urls, url))
+    return;
+
+  row = g_slice_new (MwbAcIndexRow);
+  row->url = g_strdup (url);
+  row->label = g_strdup (label);
+  row->folded = g_utf8_casefold (label, -1);
+  row->favicon_id = favicon_id;
+  row->visit_count = visit_count;
+
+  g_ptr_array_add (index->rows, row);
+  g_hash_table_insert (index->urls, row->url, row);
+
+  for (p = row->folded; p[0] && p[1] && p[2]; p++)
+    {
+      GArray *posting = (GArray *) g_hash_table_lookup (index->trigrams,
+                                                        TRIGRAM (p));
+
+      if (!posting)
+        {
+          posting = g_array_new (FALSE, FALSE, sizeof (guint));
+          g_hash_table_insert (index->trigrams, TRIGRAM (p), posting);
+        }
+
+      /* Rows are added in order, so duplicates can only be at the end */
+      if (!posting->len ||
+          g_array_index (posting, guint, posting->len - 1) != n)
+        g_array_append_val (posting, n);
+    }
+}
+
+/*
+ * Adds the history entries past the indexed rowids. Returns FALSE when the
+ * index is being freed meanwhile.
+ */
+static gboolean
+mwb_ac_index_add_rows (MwbAcIndex *index)
+{
+  sqlite3_stmt *stmt = NULL;
+  gint64        bookmarks_rowid, urls_rowid;
+  guint         n = 0;
+
+  /* Read before the rows, anything added in between is picked up by the
+   * next update and then skipped as a duplicate */
+  if (!mwb_ac_index_get_pair (index, MWB_AC_INDEX_WATERMARK_SQL,
+                              &bookmarks_rowid, &urls_rowid))
+    return TRUE;
+
+  if (sqlite3_prepare_v2 (index->dbcon, MWB_AC_INDEX_SQL, -1, &stmt, NULL))
+    {
+      g_warning ("[netpanel] sqlite3_prepare_v2 (): %s",
+                 sqlite3_errmsg (index->dbcon));
+      return TRUE;
+    }
+
+  sqlite3_bind_int64 (stmt, 1, index->bookmarks_rowid);
+  sqlite3_bind_int64 (stmt, 2, index->urls_rowid);
+
+  while (sqlite3_step (stmt) == SQLITE_ROW)
+    {
+      const gchar *url = (const gchar *) sqlite3_column_text (stmt, 0);
+      const gchar *label = (const gchar *) sqlite3_column_text (stmt, 1);
+
+      if (++n % MWB_AC_INDEX_BUILD_CHUNK == 0 &&
+          g_atomic_int_get (&index->stopping))
+        {
+          sqlite3_finalize (stmt);
+          return FALSE;
+        }
+
+      if (!url || !label)
+        continue;
+
+      mwb_ac_index_add_row (index, url, label,
+                            sqlite3_column_int (stmt, 2),
+                            sqlite3_column_int (stmt, 3));
+    }
+
+  sqlite3_finalize (stmt);
+
+  index->bookmarks_rowid = bookmarks_rowid;
+  index->urls_rowid = urls_rowid;
+
+  /* What later updates compare with to notice deletions */
+  mwb_ac_index_get_pair (index, MWB_AC_INDEX_COUNT_SQL,
+                         &index->n_bookmarks, &index->n_urls);
+
+  return TRUE;
+}
+
+static void
+mwb_ac_index_build (MwbAcIndex *index)
+{
+  mwb_ac_index_clear (index);
+
+  index->rows = g_ptr_array_new_with_free_func (mwb_ac_index_free_row);
+  index->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, mwb_ac_index_free_posting);
+  index->urls = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (!mwb_ac_index_add_rows (index))
+    {
+      mwb_ac_index_clear (index);
+      return;
+    }
+
+  index->n_ranked = index->rows->len;
+}
+
+/*
+ * Brings the index up to date with the history db: appends what was added
+ * since, or builds it again when history was removed or the unranked tail
+ * got too long.
+ */
+static void
+mwb_ac_index_update (MwbAcIndex *index)
+{
+  struct stat  db_stat;
+  gint64       n_bookmarks, n_urls;
+
+  if (stat (index->db_filename, &db_stat) == 0)
+    {
+      gint64 mtime = (gint64) db_stat.st_mtim.tv_sec * 1000000000 +
+                     db_stat.st_mtim.tv_nsec;
+
+      if (index->rows &&
+          mtime == index->db_mtime &&
+          db_stat.st_size == index->db_size)
+        return;
+
+      index->db_mtime = mtime;
+      index->db_size = db_stat.st_size;
+    }
+
+  /* Favicons may have been fetched since */
+  g_hash_table_remove_all (index->icon_paths);
+
+  if (!mwb_ac_index_open (index))
+    return;
+
+  if (!index->rows)
+    {
+      mwb_ac_index_build (index);
+      return;
+    }
+
+  /* Fewer rows up to the rowids we indexed means some were deleted */
+  if (!mwb_ac_index_get_pair (index, MWB_AC_INDEX_COUNT_SQL,
+                              &n_bookmarks, &n_urls) ||
+      n_bookmarks != index->n_bookmarks ||
+      n_urls != index->n_urls)
+    {
+      mwb_ac_index_build (index);
+      return;
+    }
+
+  if (!mwb_ac_index_add_rows (index))
+    return;
+
+  if (index->rows->len - index->n_ranked >
+      MWB_AC_INDEX_MAX_TAIL (index->n_ranked))
+    mwb_ac_index_build (index);
+}
+
+static const gchar *
+mwb_ac_index_get_icon_path (MwbAcIndex *index, gint favicon_id)
+{
+  gchar       *icon_path;
+  const gchar *favi_url = NULL;
+
+  icon_path = (gchar *) g_hash_table_lookup (index->icon_paths,
+                                             GINT_TO_POINTER (favicon_id));
+  if (icon_path)
+    return icon_path;
+
+  if (index->favicon_stmt)
+    {
+      sqlite3_reset (index->favicon_stmt);
+      sqlite3_bind_int (index->favicon_stmt, 1, favicon_id);
+
+      if (sqlite3_step (index->favicon_stmt) == SQLITE_ROW)
+        favi_url = (const gchar *) sqlite3_column_text (index->favicon_stmt, 0);
+    }
+
+  if (favi_url)
+    {
+      gchar *csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, favi_url, -1);
+      gchar *thumbnail_filename = g_strconcat (csum, ".ico", NULL);
+
+      icon_path = g_build_filename (g_get_home_dir (),
+                                    ".config",
+                                    "internet-panel",
+                                    "favicons",
+                                    thumbnail_filename,
+                                    NULL);
+      if (!g_file_test (icon_path, G_FILE_TEST_EXISTS))
+        {
+          g_free (icon_path);
+          icon_path = NULL;
+        }
+
+      g_free (csum);
+      g_free (thumbnail_filename);
+    }
+
+  if (!icon_path)
+    icon_path = g_strdup_printf ("%s%s", THEMEDIR, "o2_globe.png");
+
+  g_hash_table_insert (index->icon_paths,
+                       GINT_TO_POINTER (favicon_id), icon_path);
+
+  return icon_path;
+}
+
+static gboolean
+mwb_ac_index_dispatch_cb (gpointer data)
+{
+  MwbAcIndex *index = (MwbAcIndex *) data;
+  GList      *batches, *l;
+
+  g_mutex_lock (&index->lock);
+  batches = g_list_reverse (index->pending);
+  index->pending = NULL;
+  index->dispatch_id = 0;
+  g_mutex_unlock (&index->lock);
+
+  for (l = batches; l; l = l->next)
+    {
+      MwbAcIndexBatch *batch = (MwbAcIndexBatch *) l->data;
+
+      /* Results of superseded queries are dropped here */
+      if (batch->generation == g_atomic_int_get (&index->generation))
+        batch->func ((const MwbAcIndexResult *) batch->results->data,
+                     batch->results->len,
+                     batch->done,
+                     batch->user_data);
+
+      mwb_ac_index_free_batch (batch);
+    }
+
+  g_list_free (batches);
+
+  return FALSE;
+}
+
+static void
+mwb_ac_index_post_batch (MwbAcIndex      *index,
+                         MwbAcIndexQuery *query,
+                         GArray          *results,
+                         gboolean         done)
+{
+  MwbAcIndexBatch *batch = g_slice_new (MwbAcIndexBatch);
+
+  batch->generation = query->generation;
+  batch->results = results;
+  batch->done = done;
+  batch->func = query->func;
+  batch->user_data = query->user_data;
+
+  g_mutex_lock (&index->lock);
+  index->pending = g_list_prepend (index->pending, batch);
+  if (!index->dispatch_id)
+    index->dispatch_id = clutter_threads_add_idle (mwb_ac_index_dispatch_cb,
+                                                   index);
+  g_mutex_unlock (&index->lock);
+}
+
+static GArray *
+mwb_ac_index_new_results (void)
+{
+  return g_array_sized_new (FALSE, FALSE, sizeof (MwbAcIndexResult),
+                            MWB_AC_INDEX_BATCH_SIZE);
+}
+
+/* Appends a match, posting full batches; returns the batch to fill next */
+static GArray *
+mwb_ac_index_add_result (MwbAcIndex      *index,
+                         MwbAcIndexQuery *query,
+                         GArray          *results,
+                         MwbAcIndexRow   *row,
+                         guint           *n_found)
+{
+  MwbAcIndexResult result;
+
+  result.url = g_strdup (row->url);
+  result.label = g_strdup (row->label);
+  result.icon_path = g_strdup (mwb_ac_index_get_icon_path (index,
+                                                           row->favicon_id));
+  g_array_append_val (results, result);
+  (*n_found)++;
+
+  if (results->len == MWB_AC_INDEX_BATCH_SIZE &&
+      *n_found < query->max_results)
+    {
+      mwb_ac_index_post_batch (index, query, results, FALSE);
+      results = mwb_ac_index_new_results ();
+    }
+
+  return results;
+}
+
+static gint
+mwb_ac_index_compare_visits (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  GPtrArray     *rows = (GPtrArray *) user_data;
+  MwbAcIndexRow *row_a = (MwbAcIndexRow *)
+    g_ptr_array_index (rows, *(const guint *) a);
+  MwbAcIndexRow *row_b = (MwbAcIndexRow *)
+    g_ptr_array_index (rows, *(const guint *) b);
+
+  return row_b->visit_count - row_a->visit_count;
+}
+
+static void
+mwb_ac_index_run_query (gpointer data, gpointer user_data)
+{
+  MwbAcIndexQuery *query = (MwbAcIndexQuery *) data;
+  MwbAcIndex      *index = (MwbAcIndex *) user_data;
+  GArray          *posting = NULL;
+  GArray          *tail;
+  GArray          *results;
+  guint            n_candidates, n_found = 0, i, j = 0;
+  gsize            needle_len;
+
+  if (!query->needle)
+    {
+      mwb_ac_index_update (index);
+      goto out;
+    }
+
+  /* Queries queued behind a newer one are skipped without any work */
+  if (query->generation != g_atomic_int_get (&index->generation))
+    goto out;
+
+  if (!index->rows)
+    mwb_ac_index_update (index);
+
+  if (!index->rows)
+    {
+      mwb_ac_index_post_batch (index, query, mwb_ac_index_new_results (),
+                               TRUE);
+      goto out;
+    }
+
+  needle_len = strlen (query->needle);
+  n_candidates = index->rows->len;
+
+  /*
+   * Use the rarest trigram of the needle to narrow down the candidates; a
+   * trigram nobody has means there is no match at all.
+   */
+  if (needle_len >= 3)
+    {
+      const gchar *p;
+
+      for (p = query->needle; p[2]; p++)
+        {
+          GArray *l = (GArray *) g_hash_table_lookup (index->trigrams,
+                                                      TRIGRAM (p));
+
+          if (!l)
+            {
+              n_candidates = 0;
+              break;
+            }
+
+          if (!posting || l->len < posting->len)
+            posting = l;
+        }
+
+      if (posting && n_candidates)
+        n_candidates = posting->len;
+    }
+
+  /*
+   * Matches in the tail are few, collect all of them up front so they can
+   * be merged with the ranked ones by visit count. Both come in row order,
+   * so the tail is at the end of the candidates.
+   */
+  tail = g_array_new (FALSE, FALSE, sizeof (guint));
+  while (n_candidates)
+    {
+      guint n = posting ?
+        g_array_index (posting, guint, n_candidates - 1) : n_candidates - 1;
+      MwbAcIndexRow *row;
+
+      if (n < index->n_ranked)
+        break;
+
+      row = (MwbAcIndexRow *) g_ptr_array_index (index->rows, n);
+      if (strstr (row->folded, query->needle))
+        g_array_append_val (tail, n);
+
+      n_candidates--;
+    }
+  g_array_sort_with_data (tail, mwb_ac_index_compare_visits, index->rows);
+
+  results = mwb_ac_index_new_results ();
+
+  for (i = 0; i < n_candidates && n_found < query->max_results; i++)
+    {
+      guint          n = posting ? g_array_index (posting, guint, i) : i;
+      MwbAcIndexRow *row = (MwbAcIndexRow *) g_ptr_array_index (index->rows, n);
+
+      if (query->generation != g_atomic_int_get (&index->generation))
+        {
+          mwb_ac_index_free_results (results);
+          g_array_free (tail, TRUE);
+          goto out;
+        }
+
+      if (!strstr (row->folded, query->needle))
+        continue;
+
+      for (; j < tail->len && n_found < query->max_results; j++)
+        {
+          MwbAcIndexRow *tail_row = (MwbAcIndexRow *)
+            g_ptr_array_index (index->rows, g_array_index (tail, guint, j));
+
+          if (tail_row->visit_count <= row->visit_count)
+            break;
+
+          results = mwb_ac_index_add_result (index, query, results,
+                                             tail_row, &n_found);
+        }
+
+      if (n_found < query->max_results)
+        results = mwb_ac_index_add_result (index, query, results,
+                                           row, &n_found);
+    }
+
+  for (; j < tail->len && n_found < query->max_results; j++)
+    results = mwb_ac_index_add_result (index, query, results,
+                                       (MwbAcIndexRow *)
+                                       g_ptr_array_index (index->rows,
+                                                          g_array_index (tail,
+                                                                         guint,
+                                                                         j)),
+                                       &n_found);
+
+  g_array_free (tail, TRUE);
+
+  mwb_ac_index_post_batch (index, query, results, TRUE);
+
+ out:
+  g_free (query->needle);
+  g_slice_free (MwbAcIndexQuery, query);
+}
+
+MwbAcIndex *
+mwb_ac_index_new (const gchar *db_filename)
+{
+  MwbAcIndex *index;
+
+  g_return_val_if_fail (db_filename, NULL);
+
+  index = g_slice_new0 (MwbAcIndex);
+  index->db_filename = g_strdup (db_filename);
+  index->icon_paths = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, g_free);
+  g_mutex_init (&index->lock);
+  index->pool = g_thread_pool_new (mwb_ac_index_run_query, index,
+                                   1, FALSE, NULL);
+
+  /* Build the index before the first keystroke */
+  mwb_ac_index_refresh (index);
+
+  return index;
+}
+
+void
+mwb_ac_index_free (MwbAcIndex *index)
+{
+  GList *l;
+
+  g_return_if_fail (index);
+
+  /* Makes a running build or query bail out, so the join below is quick;
+   * whatever is still queued is dropped */
+  g_atomic_int_set (&index->stopping, 1);
+  mwb_ac_index_cancel (index);
+  g_thread_pool_free (index->pool, TRUE, TRUE);
+
+  if (index->dispatch_id)
+    g_source_remove (index->dispatch_id);
+
+  for (l = index->pending; l; l = l->next)
+    mwb_ac_index_free_batch ((MwbAcIndexBatch *) l->data);
+  g_list_free (index->pending);
+
+  if (index->favicon_stmt)
+    sqlite3_finalize (index->favicon_stmt);
+  if (index->dbcon)
+    sqlite3_close (index->dbcon);
+
+  mwb_ac_index_clear (index);
+  g_hash_table_destroy (index->icon_paths);
+
+  g_mutex_clear (&index->lock);
+  g_free (index->db_filename);
+  g_slice_free (MwbAcIndex, index);
+}
+
+void
+mwb_ac_index_refresh (MwbAcIndex *index)
+{
+  MwbAcIndexQuery *query;
+
+  g_return_if_fail (index);
+
+  query = g_slice_new0 (MwbAcIndexQuery);
+  g_thread_pool_push (index->pool, query, NULL);
+}
+
+void
+mwb_ac_index_query (MwbAcIndex           *index,
+                    const gchar          *text,
+                    guint                 max_results,
+                    MwbAcIndexResultFunc  func,
+                    gpointer              user_data)
+{
+  MwbAcIndexQuery *query;
+
+  g_return_if_fail (index && text && func);
+
+  query = g_slice_new (MwbAcIndexQuery);
+  query->generation = g_atomic_int_add (&index->generation, 1) + 1;
+  query->needle = g_utf8_casefold (text, -1);
+  query->max_results = max_results;
+  query->func = func;
+  query->user_data = user_data;
+
+  g_thread_pool_push (index->pool, query, NULL);
+}
+
+void
+mwb_ac_index_cancel (MwbAcIndex *index)
+{
+  g_return_if_fail (index);
+
+  g_atomic_int_inc (&index->generation);
+}
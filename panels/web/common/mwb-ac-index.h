@@ -0,0 +1,65 @@
+/*
+ * Dawati-Web-Browser: The web browser for Dawati
+ * Copyright (c) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MWB_AC_INDEX_H
+#define _MWB_AC_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Substring index over the browsing history used for autocompletion.
+ *
+ * The index is built and queried on a worker thread; results are delivered
+ * in the main loop, in batches, most visited first. Starting a new query
+ * cancels the previous one, whose remaining results are never delivered.
+ * The index is meant to be kept around, refreshing it only reads the
+ * history added since.
+ */
+
+typedef struct _MwbAcIndex MwbAcIndex;
+
+typedef struct
+{
+  gchar *url;
+  gchar *label;      /* "url - title" */
+  gchar *icon_path;  /* favicon file to show for the entry */
+} MwbAcIndexResult;
+
+/* Called once per batch; done is TRUE for the last one. */
+typedef void (*MwbAcIndexResultFunc) (const MwbAcIndexResult *results,
+                                      guint                   n_results,
+                                      gboolean                done,
+                                      gpointer                user_data);
+
+MwbAcIndex *mwb_ac_index_new    (const gchar *db_filename);
+void        mwb_ac_index_free   (MwbAcIndex *index);
+
+void        mwb_ac_index_refresh (MwbAcIndex *index);
+
+void        mwb_ac_index_query  (MwbAcIndex           *index,
+                                 const gchar          *text,
+                                 guint                 max_results,
+                                 MwbAcIndexResultFunc  func,
+                                 gpointer              user_data);
+void        mwb_ac_index_cancel (MwbAcIndex *index);
+
+G_END_DECLS
+
+#endif /* _MWB_AC_INDEX_H */
@@ -28,6 +28,7 @@
 #include <cogl/cogl.h>
 
 #include "mwb-ac-list.h"
+#include "mwb-ac-index.h"
 #include "mwb-separator.h"
 #include "mwb-utils.h"
 
@@ -88,8 +89,7 @@ struct _MwbAcListPrivate
   gchar         *search_engine_name;
   gchar         *search_engine_url;
 
-  sqlite3       *dbcon;
-  sqlite3_stmt  *search_stmt;
+  MwbAcIndex    *index;
 
   /* List of suggested TLD completions */
   GHashTable    *tld_suggestions;
@@ -240,6 +240,12 @@ mwb_ac_list_dispose (GObject *object)
       priv->separator = NULL;
     }
 
+  if (priv->index)
+    {
+      mwb_ac_index_free (priv->index);
+      priv->index = NULL;
+    }
+
   mwb_ac_list_clear_entries (MWB_AC_LIST (object));
 
   mwb_ac_list_forget_search_engine (MWB_AC_LIST (object));
@@ -864,8 +870,7 @@ mwb_ac_list_init (MwbAcList *self)
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mwb_ac_list_style_changed_cb), NULL);
 
-  priv->dbcon = NULL;
-  priv->search_stmt = NULL;
+  priv->index = NULL;
 }
 
 MxWidget*
@@ -874,79 +879,27 @@ mwb_ac_list_new (void)
   return MX_WIDGET (g_object_new (MWB_TYPE_AC_LIST, NULL));
 }
 
-#define FAVICON_SQL "SELECT url FROM favicons WHERE id='%d'"
-
 static void
-mwb_ac_list_set_icon (MwbAcList *self, MwbAcListEntry *entry)
+mwb_ac_list_set_icon (MwbAcList      *self,
+                      MwbAcListEntry *entry,
+                      const gchar    *icon_path)
 {
-
-  MwbAcListPrivate *priv = self->priv;
-
   GError *texture_error = NULL;
 
-  if (!entry)
+  if (!entry || !icon_path)
     return;
 
-  gchar *favi_url = NULL;
-  gchar *icon_path = NULL;
-
-  sqlite3_stmt *favicon_stmt;
-  gchar *stmt = g_strdup_printf(FAVICON_SQL, entry->type);
-  int rc = sqlite3_prepare_v2 (priv->dbcon,
-                           stmt,
-                           -1,
-                           &favicon_stmt, NULL);
-  if (rc)
-    g_warning ("[netpanel] sqlite3_prepare_v2():tab_stmt %s",
-               sqlite3_errmsg(priv->dbcon));
-
-  if (priv->dbcon && favicon_stmt)
+  entry->texture =  cogl_texture_new_from_file (icon_path,
+                                                COGL_TEXTURE_NONE,
+                                                COGL_PIXEL_FORMAT_ANY,
+                                                &texture_error);
+  if (texture_error)
     {
-      if (sqlite3_step (favicon_stmt) == SQLITE_ROW)
-        {
-          favi_url = (gchar*)sqlite3_column_text(favicon_stmt, 0);
-        }
-    }
-
-  if(favi_url)
-    {
-      gchar *csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, favi_url, -1);
-      gchar *thumbnail_filename = g_strconcat (csum, ".ico", NULL);
-      icon_path = g_build_filename (g_get_home_dir (),
-                                    ".config",
-                                    "internet-panel",
-                                    "favicons",
-                                    thumbnail_filename,
-                                    NULL);
-      if (!g_file_test (icon_path, G_FILE_TEST_EXISTS))
-        {
-          g_free (icon_path);
-          icon_path = g_strdup_printf ("%s%s", THEMEDIR, "o2_globe.png");
-        }
-      g_free(csum);
-      g_free(thumbnail_filename);
-    }
-  else
-    {
-      icon_path = g_strdup_printf("%s%s", THEMEDIR, "o2_globe.png");
-    }
-  sqlite3_finalize(favicon_stmt);
-
-  if (icon_path)
-    {
-      entry->texture =  cogl_texture_new_from_file (icon_path,
-                                                    COGL_TEXTURE_NONE,
-                                                    COGL_PIXEL_FORMAT_ANY,
-                                                    &texture_error);
-      if (texture_error)
-        {
-          g_warning ("[netpanel] unable to open ac-list icon: %s\n",
-                     texture_error->message);
-          g_error_free (texture_error);
-        }
-      clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
-      g_free(icon_path);
+      g_warning ("[netpanel] unable to open ac-list icon: %s\n",
+                 texture_error->message);
+      g_error_free (texture_error);
     }
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
 }
 
 static void
@@ -994,10 +947,9 @@ mwb_ac_list_start_transition (MwbAcList *self)
 
 static void
 mwb_ac_list_result_received(void       *context,
-                            int         type,
                             const char *url,
                             const char *value,
-                            int         favicon_id)
+                            const char *icon_path)
 {
   MwbAcList* self = (MwbAcList*)context;
   MwbAcListPrivate *priv = self->priv;
@@ -1039,10 +991,9 @@ mwb_ac_list_result_received(void       *context,
 
       entry->label_text = (gchar*)result_text;
       entry->url = g_strdup (url);
-      entry->type = favicon_id;
 
       mwb_ac_list_update_entry (self, entry);
-      mwb_ac_list_set_icon (self, entry);
+      mwb_ac_list_set_icon (self, entry, icon_path);
 
       mwb_ac_list_start_transition (self);
 
@@ -1322,14 +1273,21 @@ mwb_ac_list_clear_timeout_cb (MwbAcList *self)
   return FALSE;
 }
 
-#define AC_LIST_SQL "SELECT DISTINCT url, url||' - '||title as vl, favicon_id "\
-                    "FROM ( "\
-                          "SELECT url, title, favicon_id, 100 as visit_count "\
-                          "FROM bookmarks "\
-                          "UNION "\
-                          "SELECT url, title, favicon_id, visit_count "\
-                          "FROM urls"\
-                         ") WHERE vl like ? ORDER BY visit_count DESC"
+static void
+mwb_ac_list_results_cb (const MwbAcIndexResult *results,
+                        guint                   n_results,
+                        gboolean                done,
+                        gpointer                user_data)
+{
+  MwbAcList *self = MWB_AC_LIST (user_data);
+  guint      i;
+
+  for (i = 0; i < n_results; i++)
+    mwb_ac_list_result_received (self,
+                                 results[i].url,
+                                 results[i].label,
+                                 results[i].icon_path);
+}
 
 void
 mwb_ac_list_set_search_text (MwbAcList *self,
@@ -1361,26 +1319,24 @@ mwb_ac_list_set_search_text (MwbAcList *self,
 
       g_object_notify (G_OBJECT (self), "search-text");
 
-      if (search_text_len == 0 || !priv->search_stmt)
+      if (!priv->index)
         return;
 
-      sqlite3_reset(priv->search_stmt);
-
-      gchar param[search_text_len + 3];
-      sprintf(param, "%%%s%%", search_text);
-      int rc = sqlite3_bind_text(priv->search_stmt, 1, param, search_text_len + 2, SQLITE_TRANSIENT);
-      if (rc)
-          g_warning("[netpanel] sqlite3_bind_text(): %s", sqlite3_errmsg(priv->dbcon));
-
-      priv->entries->len = 0;
-      while (sqlite3_step(priv->search_stmt) == SQLITE_ROW)
+      if (search_text_len == 0)
         {
-          mwb_ac_list_result_received(self,
-                  0,
-                  (gchar*) sqlite3_column_text(priv->search_stmt, 0), // url
-                  (gchar*) sqlite3_column_text(priv->search_stmt, 1), // title
-                  sqlite3_column_int(priv->search_stmt, 2));          // favicon_id
+          mwb_ac_index_cancel (priv->index);
+          return;
         }
+
+      /* Supersedes the previous query; results trickle in from the index
+       * thread and replace the current ones when the first of them
+       * arrives, or when the clear timeout fires, whichever comes first.
+       */
+      mwb_ac_index_query (priv->index,
+                          search_text,
+                          MWB_AC_LIST_MAX_ENTRIES,
+                          mwb_ac_list_results_cb,
+                          self);
     }
 }
 
@@ -1465,27 +1421,28 @@ mwb_ac_list_get_tld_suggestions (MwbAcList *self)
 void
 mwb_ac_list_db_stmt_prepare (MwbAcList *self, void *dbcon)
 {
-  gint rc;
   MwbAcListPrivate *priv = self->priv;
-  priv->dbcon = (sqlite3 *)dbcon;
+  gchar *db_filename;
 
-  if (!priv->dbcon)
+  if (!dbcon)
     {
       g_warning ("[netpanel] No available database connection");
       return;
     }
 
-  if (!priv->search_stmt)
+  /* The index reads the history through its own connection, on its own
+   * thread, and is kept while the panel is hidden; showing the panel only
+   * picks up what was added since. */
+  if (priv->index)
     {
-      rc = sqlite3_prepare_v2 (priv->dbcon,
-                               AC_LIST_SQL,
-                               -1,
-                               &priv->search_stmt,
-                               NULL);
-    if (rc)
-      g_warning("[netpanel] sqlite3_prepare_v2 (): %s",
-                sqlite3_errmsg(priv->dbcon));
+      mwb_ac_index_refresh (priv->index);
+      return;
     }
+
+  db_filename = mwb_utils_places_db_get_filename ();
+  if (db_filename)
+    priv->index = mwb_ac_index_new (db_filename);
+  g_free (db_filename);
 }
 
 void
@@ -1493,9 +1450,7 @@ mwb_ac_list_db_stmt_finalize (MwbAcList *self)
 {
   MwbAcListPrivate *priv = self->priv;
 
-  if (priv->search_stmt)
-    sqlite3_finalize(priv->search_stmt);
-
-  priv->search_stmt = NULL;
-  priv->dbcon = NULL; /*  let panel to close db */
+  /* The panel closes its db, the index has a connection of its own */
+  if (priv->index)
+    mwb_ac_index_cancel (priv->index);
 }
@@ -0,0 +1,575 @@
+/*
+ * Dawati-Web-Browser: The web browser for Dawati
+ * Copyright (c) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "mwb-plugin-pipe.h"
+
+/* How long the plugin has to answer a command, in seconds */
+#define MWB_PLUGIN_REPLY_TIMEOUT 5
+
+/* How often the batching statistics are reported */
+#define STATS_INTERVAL (60 * G_USEC_PER_SEC)
+
+typedef struct
+{
+  MwbPluginPipe      *pipe;
+  guint32             serial;
+  MwbPluginReplyFunc  func;
+  gpointer            user_data;
+  guint               timeout_id;
+} MwbPluginPendingReply;
+
+struct _MwbPluginPipe
+{
+  gchar       *path;
+  gchar       *reply_path;
+  gchar       *legacy_path;
+
+  gint         fd;            /* -1 while not connected */
+  GIOChannel  *channel;
+  guint        out_watch;     /* while the FIFO is full */
+  GByteArray  *batch;         /* frames not written yet */
+  guint        flush_id;
+  guint32      next_serial;
+
+  gint         reply_fd;
+  gint         reply_keepalive_fd;
+  GIOChannel  *reply_channel;
+  guint        reply_watch;
+  GByteArray  *reply_buffer;
+  GHashTable  *replies;       /* serial -> MwbPluginPendingReply */
+
+  gint64       stats_start;
+  guint        n_commands;
+  guint        n_writes;
+};
+
+static void
+mwb_plugin_pipe_report_stats (MwbPluginPipe *pipe)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (now - pipe->stats_start < STATS_INTERVAL)
+    return;
+
+  if (pipe->n_commands)
+    g_debug ("Plugin pipe: %u commands in %u writes",
+             pipe->n_commands, pipe->n_writes);
+
+  pipe->stats_start = now;
+  pipe->n_commands = 0;
+  pipe->n_writes = 0;
+}
+
+static void
+mwb_plugin_pending_reply_free (MwbPluginPendingReply *reply)
+{
+  if (reply->timeout_id)
+    g_source_remove (reply->timeout_id);
+
+  g_slice_free (MwbPluginPendingReply, reply);
+}
+
+/* Takes the reply off the table and calls its callback */
+static void
+mwb_plugin_pipe_complete (MwbPluginPipe *pipe,
+                          guint32        serial,
+                          gint           status)
+{
+  MwbPluginPendingReply *reply;
+
+  reply = (MwbPluginPendingReply *)
+    g_hash_table_lookup (pipe->replies, GUINT_TO_POINTER (serial));
+  if (!reply)
+    return;
+
+  g_hash_table_steal (pipe->replies, GUINT_TO_POINTER (serial));
+
+  reply->func (status, reply->user_data);
+  mwb_plugin_pending_reply_free (reply);
+}
+
+static void
+mwb_plugin_pipe_fail_replies (MwbPluginPipe *pipe,
+                              gint           status)
+{
+  GList *serials, *l;
+
+  /* The callbacks may send again, so don't iterate the table itself */
+  serials = g_hash_table_get_keys (pipe->replies);
+
+  for (l = serials; l; l = l->next)
+    mwb_plugin_pipe_complete (pipe, GPOINTER_TO_UINT (l->data), status);
+
+  g_list_free (serials);
+}
+
+static gboolean
+mwb_plugin_pipe_reply_timeout_cb (gpointer data)
+{
+  MwbPluginPendingReply *reply = (MwbPluginPendingReply *) data;
+
+  reply->timeout_id = 0;
+  mwb_plugin_pipe_complete (reply->pipe, reply->serial, -ETIMEDOUT);
+
+  return FALSE;
+}
+
+static gboolean
+mwb_plugin_pipe_legacy_reply_cb (gpointer data)
+{
+  MwbPluginPendingReply *reply = (MwbPluginPendingReply *) data;
+
+  reply->timeout_id = 0;
+  mwb_plugin_pipe_complete (reply->pipe, reply->serial, 0);
+
+  return FALSE;
+}
+
+static void
+mwb_plugin_pipe_add_reply (MwbPluginPipe      *pipe,
+                           guint32             serial,
+                           MwbPluginReplyFunc  func,
+                           gpointer            user_data,
+                           gboolean            legacy)
+{
+  MwbPluginPendingReply *reply = g_slice_new0 (MwbPluginPendingReply);
+
+  reply->pipe = pipe;
+  reply->serial = serial;
+  reply->func = func;
+  reply->user_data = user_data;
+
+  /* A legacy plugin does not reply, the command is done once written */
+  if (legacy)
+    reply->timeout_id = g_idle_add (mwb_plugin_pipe_legacy_reply_cb, reply);
+  else
+    reply->timeout_id =
+      g_timeout_add_seconds (MWB_PLUGIN_REPLY_TIMEOUT,
+                             mwb_plugin_pipe_reply_timeout_cb,
+                             reply);
+
+  g_hash_table_insert (pipe->replies, GUINT_TO_POINTER (serial), reply);
+}
+
+static void
+mwb_plugin_pipe_disconnect (MwbPluginPipe *pipe,
+                            gint           error)
+{
+  if (pipe->fd < 0)
+    return;
+
+  if (pipe->out_watch)
+    {
+      g_source_remove (pipe->out_watch);
+      pipe->out_watch = 0;
+    }
+
+  g_io_channel_unref (pipe->channel);
+  pipe->channel = NULL;
+  close (pipe->fd);
+  pipe->fd = -1;
+
+  g_byte_array_set_size (pipe->batch, 0);
+
+  if (error)
+    {
+      g_warning ("Lost the connection to the browser plugin: %s",
+                 g_strerror (error));
+      mwb_plugin_pipe_fail_replies (pipe, -error);
+    }
+}
+
+static gboolean
+mwb_plugin_pipe_reply_cb (GIOChannel   *source,
+                          GIOCondition  condition,
+                          gpointer      data)
+{
+  MwbPluginPipe  *pipe = (MwbPluginPipe *) data;
+  MwbPluginFrame  frame;
+  guint8          buffer[4096];
+  gssize          n;
+
+  while ((n = read (pipe->reply_fd, buffer, sizeof (buffer))) > 0)
+    g_byte_array_append (pipe->reply_buffer, buffer, n);
+
+  while (pipe->reply_buffer->len >= sizeof (frame))
+    {
+      memcpy (&frame, pipe->reply_buffer->data, sizeof (frame));
+
+      if (frame.length > MWB_PLUGIN_MAX_PAYLOAD)
+        {
+          /* We can't find the start of the next frame after this */
+          g_warning ("Bad frame from the browser plugin, dropping %u bytes",
+                     pipe->reply_buffer->len);
+          g_byte_array_set_size (pipe->reply_buffer, 0);
+          break;
+        }
+
+      if (pipe->reply_buffer->len < sizeof (frame) + frame.length)
+        break;
+
+      if (frame.command == MWB_PLUGIN_CMD_REPLY &&
+          frame.length >= sizeof (gint32))
+        {
+          gint32 status;
+
+          memcpy (&status,
+                  pipe->reply_buffer->data + sizeof (frame),
+                  sizeof (status));
+          mwb_plugin_pipe_complete (pipe, frame.serial, status);
+        }
+
+      g_byte_array_remove_range (pipe->reply_buffer,
+                                 0,
+                                 sizeof (frame) + frame.length);
+    }
+
+  return TRUE;
+}
+
+/*
+ * The FIFO the plugin answers on. We keep a writing end open ourselves as
+ * well, so that reading does not report end of file every time the plugin
+ * closes its end.
+ */
+static void
+mwb_plugin_pipe_open_replies (MwbPluginPipe *pipe)
+{
+  if (pipe->reply_fd >= 0)
+    return;
+
+  if (mkfifo (pipe->reply_path, 0600) != 0 && errno != EEXIST)
+    {
+      g_warning ("Unable to create %s: %s",
+                 pipe->reply_path, g_strerror (errno));
+      return;
+    }
+
+  pipe->reply_fd = open (pipe->reply_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (pipe->reply_fd < 0)
+    return;
+
+  pipe->reply_keepalive_fd = open (pipe->reply_path,
+                                   O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+
+  pipe->reply_channel = g_io_channel_unix_new (pipe->reply_fd);
+  pipe->reply_watch = g_io_add_watch (pipe->reply_channel,
+                                      G_IO_IN,
+                                      mwb_plugin_pipe_reply_cb,
+                                      pipe);
+}
+
+static gboolean
+mwb_plugin_pipe_connect (MwbPluginPipe *pipe)
+{
+  if (pipe->fd >= 0)
+    return TRUE;
+
+  /* Fails with ENXIO when the browser is not running */
+  pipe->fd = open (pipe->path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+  if (pipe->fd < 0)
+    return FALSE;
+
+  pipe->channel = g_io_channel_unix_new (pipe->fd);
+  mwb_plugin_pipe_open_replies (pipe);
+
+  return TRUE;
+}
+
+static gboolean
+mwb_plugin_pipe_out_cb (GIOChannel   *source,
+                        GIOCondition  condition,
+                        gpointer      data)
+{
+  MwbPluginPipe *pipe = (MwbPluginPipe *) data;
+
+  pipe->out_watch = 0;
+  mwb_plugin_pipe_flush (pipe);
+
+  return FALSE;
+}
+
+static gboolean
+mwb_plugin_pipe_flush_cb (gpointer data)
+{
+  MwbPluginPipe *pipe = (MwbPluginPipe *) data;
+
+  pipe->flush_id = 0;
+  mwb_plugin_pipe_flush (pipe);
+
+  return FALSE;
+}
+
+/*
+ * Writes the commands sent so far; a batch that does not fit in the FIFO
+ * is finished when the plugin has read some of it. Returns FALSE if the
+ * connection to the plugin was lost.
+ */
+gboolean
+mwb_plugin_pipe_flush (MwbPluginPipe *pipe)
+{
+  if (pipe->flush_id)
+    {
+      g_source_remove (pipe->flush_id);
+      pipe->flush_id = 0;
+    }
+
+  if (pipe->fd < 0)
+    return FALSE;
+
+  while (pipe->batch->len > 0 && !pipe->out_watch)
+    {
+      gssize n = write (pipe->fd, pipe->batch->data, pipe->batch->len);
+
+      if (n > 0)
+        {
+          pipe->n_writes++;
+          g_byte_array_remove_range (pipe->batch, 0, n);
+        }
+      else if (n == 0 || errno == EAGAIN)
+        {
+          /* Also wake up when the plugin goes away, the next write()
+           * then fails with EPIPE and we disconnect */
+          pipe->out_watch = g_io_add_watch (pipe->channel,
+                                            (GIOCondition)
+                                              (G_IO_OUT | G_IO_ERR | G_IO_HUP),
+                                            mwb_plugin_pipe_out_cb,
+                                            pipe);
+        }
+      else if (errno != EINTR)
+        {
+          mwb_plugin_pipe_disconnect (pipe, errno);
+          return FALSE;
+        }
+    }
+
+  mwb_plugin_pipe_report_stats (pipe);
+
+  return TRUE;
+}
+
+static guint32
+mwb_plugin_pipe_next_serial (MwbPluginPipe *pipe)
+{
+  if (++pipe->next_serial == 0)
+    pipe->next_serial = 1;
+
+  return pipe->next_serial;
+}
+
+/*
+ * Sends @command in the encoding of plugins that predate the framed
+ * protocol, opening and closing their FIFO as they expect.
+ */
+static guint32
+mwb_plugin_pipe_send_legacy (MwbPluginPipe      *pipe,
+                             MwbPluginCommand    command,
+                             gconstpointer       payload,
+                             gsize               length,
+                             MwbPluginReplyFunc  func,
+                             gpointer            user_data)
+{
+  GByteArray *buffer;
+  guint       command_id = command;
+  guint32     serial;
+  gssize      n;
+  gint        fd, error;
+
+  if (command != MWB_PLUGIN_CMD_SELECT_TAB &&
+      command != MWB_PLUGIN_CMD_NEW_TAB)
+    return 0;
+
+  /* Fails with ENXIO when the browser is not running */
+  fd = open (pipe->legacy_path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+    return 0;
+
+  buffer = g_byte_array_new ();
+  g_byte_array_append (buffer, (const guint8 *) &command_id,
+                       sizeof (command_id));
+
+  if (command == MWB_PLUGIN_CMD_SELECT_TAB)
+    {
+      gint tab_id = 0;
+
+      memcpy (&tab_id, payload, MIN (length, sizeof (tab_id)));
+      g_byte_array_append (buffer, (const guint8 *) &tab_id, sizeof (tab_id));
+    }
+  else
+    {
+      gssize size = length + 1;
+
+      g_byte_array_append (buffer, (const guint8 *) &size, sizeof (size));
+      g_byte_array_append (buffer, (const guint8 *) payload, length);
+      g_byte_array_append (buffer, (const guint8 *) "", 1);
+    }
+
+  do
+    n = write (fd, buffer->data, buffer->len);
+  while (n < 0 && errno == EINTR);
+
+  error = errno;
+  close (fd);
+
+  if (n != (gssize) buffer->len)
+    {
+      g_warning ("Unable to write to the browser plugin: %s",
+                 n < 0 ? g_strerror (error) : "short write");
+      g_byte_array_free (buffer, TRUE);
+      return 0;
+    }
+
+  g_byte_array_free (buffer, TRUE);
+
+  pipe->n_commands++;
+  pipe->n_writes++;
+  mwb_plugin_pipe_report_stats (pipe);
+
+  serial = mwb_plugin_pipe_next_serial (pipe);
+  if (func)
+    mwb_plugin_pipe_add_reply (pipe, serial, func, user_data, TRUE);
+
+  return serial;
+}
+
+/*
+ * Queues @command for the plugin, to be written with the other commands of
+ * this main loop iteration. If @func is given the plugin is asked for a
+ * reply, which @func is called with. A plugin that only speaks the legacy
+ * encoding is written to straight away.
+ *
+ * Returns the serial of the command, or 0 if the plugin is not running.
+ */
+guint32
+mwb_plugin_pipe_send (MwbPluginPipe      *pipe,
+                      MwbPluginCommand    command,
+                      gconstpointer       payload,
+                      gsize               length,
+                      MwbPluginReplyFunc  func,
+                      gpointer            user_data)
+{
+  MwbPluginFrame frame;
+
+  g_return_val_if_fail (pipe, 0);
+  g_return_val_if_fail (length <= MWB_PLUGIN_MAX_PAYLOAD, 0);
+
+  if (!mwb_plugin_pipe_connect (pipe))
+    return mwb_plugin_pipe_send_legacy (pipe, command, payload, length,
+                                        func, user_data);
+
+  frame.length = length;
+  frame.serial = mwb_plugin_pipe_next_serial (pipe);
+  frame.command = command;
+  frame.flags = func ? MWB_PLUGIN_FLAG_REPLY : 0;
+
+  g_byte_array_append (pipe->batch, (const guint8 *) &frame, sizeof (frame));
+  if (length)
+    g_byte_array_append (pipe->batch, (const guint8 *) payload, length);
+  pipe->n_commands++;
+
+  if (func)
+    mwb_plugin_pipe_add_reply (pipe, frame.serial, func, user_data, FALSE);
+
+  if (!pipe->flush_id && !pipe->out_watch)
+    pipe->flush_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                      mwb_plugin_pipe_flush_cb,
+                                      pipe,
+                                      NULL);
+
+  return frame.serial;
+}
+
+/*
+ * Connection to the plugin listening in @dir, g_get_tmp_dir() if NULL.
+ * Nothing is opened until the first command is sent. The framed FIFO is
+ * tried again whenever the pipe is not connected, so a plugin that was
+ * updated is picked up without restarting the panel.
+ */
+MwbPluginPipe *
+mwb_plugin_pipe_new (const gchar *dir)
+{
+  MwbPluginPipe *pipe = g_slice_new0 (MwbPluginPipe);
+
+  if (!dir)
+    dir = g_get_tmp_dir ();
+
+  pipe->path = g_build_filename (dir, MWB_PLUGIN_PIPE_NAME, NULL);
+  pipe->reply_path = g_build_filename (dir, MWB_PLUGIN_REPLY_PIPE_NAME, NULL);
+  pipe->legacy_path = g_build_filename (dir, MWB_PLUGIN_LEGACY_PIPE_NAME, NULL);
+  pipe->fd = -1;
+  pipe->reply_fd = -1;
+  pipe->reply_keepalive_fd = -1;
+  pipe->batch = g_byte_array_new ();
+  pipe->reply_buffer = g_byte_array_new ();
+  pipe->replies = g_hash_table_new_full (NULL, NULL, NULL,
+                                         (GDestroyNotify)
+                                           mwb_plugin_pending_reply_free);
+  pipe->stats_start = g_get_monotonic_time ();
+
+  /* A browser that quits under us must show up as EPIPE from write(),
+   * not kill the panel */
+  signal (SIGPIPE, SIG_IGN);
+
+  return pipe;
+}
+
+void
+mwb_plugin_pipe_free (MwbPluginPipe *pipe)
+{
+  if (pipe->flush_id)
+    {
+      g_source_remove (pipe->flush_id);
+      pipe->flush_id = 0;
+    }
+
+  /* Before the flush, so that a plugin gone away does not make the
+   * callbacks act on -EPIPE */
+  mwb_plugin_pipe_fail_replies (pipe, -ECANCELED);
+
+  mwb_plugin_pipe_flush (pipe);
+  mwb_plugin_pipe_disconnect (pipe, 0);
+
+  if (pipe->reply_watch)
+    g_source_remove (pipe->reply_watch);
+  if (pipe->reply_channel)
+    g_io_channel_unref (pipe->reply_channel);
+  if (pipe->reply_fd >= 0)
+    close (pipe->reply_fd);
+  if (pipe->reply_keepalive_fd >= 0)
+    close (pipe->reply_keepalive_fd);
+
+  g_hash_table_destroy (pipe->replies);
+  g_byte_array_free (pipe->batch, TRUE);
+  g_byte_array_free (pipe->reply_buffer, TRUE);
+  g_free (pipe->path);
+  g_free (pipe->reply_path);
+  g_free (pipe->legacy_path);
+  g_slice_free (MwbPluginPipe, pipe);
+}
@@ -0,0 +1,106 @@
+/*
+ * Dawati-Web-Browser: The web browser for Dawati
+ * Copyright (c) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MWB_PLUGIN_PIPE_H
+#define _MWB_PLUGIN_PIPE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Connection to the Dawati plugin of the browser.
+ *
+ * Commands go to the plugin through a FIFO, as a stream of frames: a
+ * MwbPluginFrame header in host byte order followed by `length' bytes of
+ * payload. Commands sent during one main loop iteration are written
+ * together, and the FIFO stays open between commands; it is only opened
+ * again after the plugin went away.
+ *
+ * A command flagged MWB_PLUGIN_FLAG_REPLY is answered by the plugin with
+ * a MWB_PLUGIN_CMD_REPLY frame carrying the same serial and a gint32
+ * status as payload, written to the reply FIFO.
+ *
+ * A plugin announces the version of the protocol it speaks by the FIFO it
+ * listens on: MWB_PLUGIN_PIPE_NAME for this one. Plugins from before it
+ * only listen on MWB_PLUGIN_LEGACY_PIPE_NAME, and when that is all there
+ * is commands are sent in the old encoding instead, one per opening of
+ * the FIFO: the command id as a guint, then for MWB_PLUGIN_CMD_SELECT_TAB
+ * the tab id as a gint, for MWB_PLUGIN_CMD_NEW_TAB the length of the url
+ * including the nul as a gssize followed by the nul terminated url. Such
+ * plugins never reply; a reply callback is called with 0 once the command
+ * has been written.
+ *
+ * Payloads:
+ *   MWB_PLUGIN_CMD_SELECT_TAB  gint32 tab id, -1 for a new tab
+ *   MWB_PLUGIN_CMD_NEW_TAB     the url, not nul terminated
+ *   MWB_PLUGIN_CMD_REPLY       gint32 status, 0 on success
+ */
+
+#define MWB_PLUGIN_PIPE_NAME        "chrome-dawati-plugin-2.fifo"
+#define MWB_PLUGIN_REPLY_PIPE_NAME  "chrome-dawati-plugin-reply.fifo"
+#define MWB_PLUGIN_LEGACY_PIPE_NAME "chrome-dawati-plugin.fifo"
+
+/* Frames with a longer payload are a protocol error */
+#define MWB_PLUGIN_MAX_PAYLOAD     (64 * 1024)
+
+typedef enum
+{
+  MWB_PLUGIN_CMD_SELECT_TAB = 1,
+  MWB_PLUGIN_CMD_NEW_TAB    = 2,
+  MWB_PLUGIN_CMD_REPLY      = 0x8000
+} MwbPluginCommand;
+
+typedef enum
+{
+  MWB_PLUGIN_FLAG_REPLY = 1 << 0
+} MwbPluginFlags;
+
+typedef struct
+{
+  guint32 length;   /* of the payload that follows */
+  guint32 serial;
+  guint16 command;  /* MwbPluginCommand */
+  guint16 flags;    /* MwbPluginFlags */
+} MwbPluginFrame;
+
+typedef struct _MwbPluginPipe MwbPluginPipe;
+
+/*
+ * Called with the status the plugin replied with, or with a negative errno
+ * when there will be no reply: -EPIPE when the plugin went away before
+ * reading the command, -ETIMEDOUT when it did not answer in time,
+ * -ECANCELED when the pipe is freed first.
+ */
+typedef void (*MwbPluginReplyFunc) (gint     status,
+                                    gpointer user_data);
+
+MwbPluginPipe *mwb_plugin_pipe_new     (const gchar *dir);
+void           mwb_plugin_pipe_free    (MwbPluginPipe *pipe);
+
+guint32        mwb_plugin_pipe_send    (MwbPluginPipe      *pipe,
+                                        MwbPluginCommand    command,
+                                        gconstpointer       payload,
+                                        gsize               length,
+                                        MwbPluginReplyFunc  func,
+                                        gpointer            user_data);
+gboolean       mwb_plugin_pipe_flush   (MwbPluginPipe *pipe);
+
+G_END_DECLS
+
+#endif /* _MWB_PLUGIN_PIPE_H */
@@ -21,14 +21,20 @@
 #endif
 
 #include <dbus/dbus-glib.h>
+#include <errno.h>
 #include <glib/gi18n.h>
 #include <sys/file.h>
 #include <glib/gstdio.h>
 #include <unistd.h>
 #include <string>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sqlite3.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <json-glib/json-glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 
 extern "C" {
 #include <dawati-panel/mpl-entry.h>
@@ -37,6 +43,7 @@ extern "C" {
 #include "dawati-netbook-netpanel.h"
 #include "mnb-netpanel-bar.h"
 #include "mwb-utils.h"
+#include "mwb-plugin-pipe.h"
 }
 
 /* Number of favorites columns to display */
@@ -59,11 +66,9 @@ extern "C" {
 #define TAB_SQL       "SELECT tab_id, url, title FROM current_tabs " \
                       "LIMIT 256"
 
-#define CMD_SELECT_TAB 1
-#define CMD_NEW_TAB    2
-
 static gboolean
-dawati_netbook_netpanel_open_tab (DawatiNetbookNetpanel *self, const gint type, void *data);
+dawati_netbook_netpanel_open_tab (DawatiNetbookNetpanel *self, const gint type,
+                                  void *data, const gchar *fallback_url);
 
 static void
 dawati_netbook_netpanel_restore_tab (DawatiNetbookNetpanel *self, gchar* tab_url);
@@ -107,6 +112,9 @@ struct _DawatiNetbookNetpanelPrivate
   sqlite3        *dbcon;
 
   gchar          *search_url;
+
+  /* Connection to the browser plugin */
+  MwbPluginPipe  *plugin_pipe;
 };
 
 
@@ -123,6 +131,12 @@ dawati_netbook_netpanel_dispose (GObject *object)
       priv->panel_client = NULL;
     }
 
+  if (priv->plugin_pipe)
+    {
+      mwb_plugin_pipe_free (priv->plugin_pipe);
+      priv->plugin_pipe = NULL;
+    }
+
   if (priv->fav_urls)
     {
       for (i = 0; i < priv->n_favs; i++)
@@ -483,6 +497,46 @@ dawati_netbook_netpanel_button_press (DawatiNetbookNetpanel *netpanel)
  * the application workspace; investigate further.
  */
 
+/* Starts the browser on @esc_url, which is already escaped */
+static void
+dawati_netbook_netpanel_launch_browser (DawatiNetbookNetpanel *netpanel,
+                                        gchar                 *esc_url)
+{
+  DawatiNetbookNetpanelPrivate *priv = DAWATI_NETBOOK_NETPANEL (netpanel)->priv;
+
+  gchar *exec, *ptr, *remaining;
+  gchar *prefix = g_strdup ("");
+
+  /* Change any % to %% to work around g_app_info_launch */
+  remaining = esc_url;
+  while ((ptr = strchr (remaining, '%')))
+    {
+      gchar *tmp = prefix;
+      *ptr = '\0';
+      prefix = g_strdup_printf ("%s%s%%%%", tmp, remaining);
+      g_free (tmp);
+      *ptr = '%';
+      remaining = ptr + 1;
+    }
+
+  exec = g_strdup_printf ("gvfs-open \"%s%s\"",
+                          prefix, remaining);
+
+//   printf("exec %s\n", exec);
+
+  g_free (prefix);
+
+  if (priv->panel_client)
+    {
+      if (!mpl_panel_client_launch_application (priv->panel_client, exec))
+        g_warning (G_STRLOC ": Error launching browser for url '%s'", esc_url);
+      else
+        mpl_panel_client_hide (priv->panel_client);
+    }
+
+  g_free (exec);
+}
+
 static void
 dawati_netbook_netpanel_launch_url (DawatiNetbookNetpanel *netpanel,
                                     const gchar         *url,
@@ -490,8 +544,7 @@ dawati_netbook_netpanel_launch_url (DawatiNetbookNetpanel *netpanel,
 {
   DawatiNetbookNetpanelPrivate *priv = DAWATI_NETBOOK_NETPANEL (netpanel)->priv;
 
-  gchar *exec, *ptr, *remaining, *esc_url=NULL;
-  gchar *prefix = g_strdup ("");
+  gchar *esc_url=NULL;
 
   if(!bool_exec)
     {
@@ -522,7 +575,8 @@ dawati_netbook_netpanel_launch_url (DawatiNetbookNetpanel *netpanel,
           g_free(esc_url);
           esc_url = tmp_url;
         }
-      if(dawati_netbook_netpanel_open_tab(netpanel, CMD_NEW_TAB, (void*)esc_url))
+      if(dawati_netbook_netpanel_open_tab(netpanel, MWB_PLUGIN_CMD_NEW_TAB,
+                                          (void*)esc_url, esc_url))
         {
           g_free(esc_url);
           return;
@@ -536,34 +590,7 @@ dawati_netbook_netpanel_launch_url (DawatiNetbookNetpanel *netpanel,
         esc_url = g_strescape (url, NULL);
     }
 
-  /* Change any % to %% to work around g_app_info_launch */
-  remaining = esc_url;
-  while ((ptr = strchr (remaining, '%')))
-    {
-      gchar *tmp = prefix;
-      *ptr = '\0';
-      prefix = g_strdup_printf ("%s%s%%%%", tmp, remaining);
-      g_free (tmp);
-      *ptr = '%';
-      remaining = ptr + 1;
-    }
-
-  exec = g_strdup_printf ("gvfs-open \"%s%s\"",
-                          prefix, remaining);
-
-//   printf("exec %s\n", exec);
-
-  g_free (prefix);
-
-  if (priv->panel_client)
-    {
-      if (!mpl_panel_client_launch_application (priv->panel_client, exec))
-        g_warning (G_STRLOC ": Error launching browser for url '%s'", esc_url);
-      else
-        mpl_panel_client_hide (priv->panel_client);
-    }
-
-  g_free (exec);
+  dawati_netbook_netpanel_launch_browser (netpanel, esc_url);
   g_free (esc_url);
 }
 
@@ -573,7 +600,8 @@ new_tab_clicked_cb (MxWidget *button, DawatiNetbookNetpanel *self)
   // -1 means open New Tab
   // FIXME: avoid hardcode here
   int id = -1;
-  if (!dawati_netbook_netpanel_open_tab (self, CMD_SELECT_TAB, &id))
+  if (!dawati_netbook_netpanel_open_tab (self, MWB_PLUGIN_CMD_SELECT_TAB, &id,
+                                         NEWTAB_URL))
     {
       dawati_netbook_netpanel_restore_tab (self, (gchar *) NEWTAB_URL);
     }
@@ -588,215 +616,89 @@ fav_button_clicked_cb (MxWidget *button, DawatiNetbookNetpanel *self)
   dawati_netbook_netpanel_launch_url (self, priv->fav_urls[fav], FALSE);
 }
 
-static void
-pipe_sendv (GIOChannel *channel, va_list args)
+typedef struct
 {
-  GType type;
-
-  /* FIXME: Add error handling */
-  /*g_debug ("Sending command: %d", command_id);*/
-
-  if (!channel)
-    {
-      g_warning ("Trying to send with NULL channel");
-      return;
-    }
-
-  while ((type = va_arg (args, GType)) != G_TYPE_INVALID)
-    {
-      gint int_val;
-      glong long_val;
-      gint64 int64_val;
-      gdouble double_val;
-      const gchar *buffer = NULL;
-      gssize size = 0;
-
-      switch (type)
-        {
-        case G_TYPE_UINT :
-        case G_TYPE_INT :
-        case G_TYPE_BOOLEAN :
-          int_val = va_arg (args, gint);
-          size = sizeof (gint);
-          buffer = (const gchar *)(&int_val);
-          break;
-
-        case G_TYPE_ULONG :
-        case G_TYPE_LONG :
-          long_val = va_arg (args, glong);
-          size = sizeof (glong);
-          buffer = (const gchar *)(&long_val);
-          break;
-
-        case G_TYPE_UINT64 :
-        case G_TYPE_INT64 :
-          int64_val = va_arg (args, gint64);
-          size = sizeof (gint64);
-          buffer = (const gchar *)(&int64_val);
-          break;
-
-        case G_TYPE_DOUBLE :
-          double_val = va_arg (args, gdouble);
-          size = sizeof (gdouble);
-          buffer = (const gchar *)(&double_val);
-          break;
-
-        case G_TYPE_STRING :
-          buffer = (gchar*)va_arg (args, gpointer);
-          if (buffer)
-            size = strlen (buffer) + 1;
-          else
-            size = 0;
-          g_io_channel_write_chars (channel,
-                                    (gchar *)(&size),
-                                    sizeof (size),
-                                    NULL,
-                                    NULL);
-          break;
-
-        case G_TYPE_NONE:
-          size = va_arg (args, gsize);
-          buffer = (const gchar *)va_arg (args, gpointer);
-          break;
-
-        default:
-          g_warning ("Trying to send unknown type");
-        }
-
-      if (!buffer)
-        {
-          g_warning ("No data to send");
-          continue;
-        }
-
-      if (size)
-        g_io_channel_write_chars (channel,
-                                  buffer,
-                                  size,
-                                  NULL,
-                                  NULL);
-    }
-
-  g_io_channel_flush (channel, NULL);
-}
+  DawatiNetbookNetpanel *self;
+  gint                   type;
+  gchar                 *fallback_url;
+} OpenTabReply;
 
 static void
-pipe_send (GIOChannel *channel, ...)
-{
-  va_list args;
-
-  va_start (args, channel);
-
-  pipe_sendv (channel, args);
-
-  va_end (args);
-}
-
-static gboolean
-dawati_netbook_netpanel_open_tab (DawatiNetbookNetpanel *self, const gint type, void *data)
+open_tab_reply_cb (gint status, gpointer data)
 {
-  DawatiNetbookNetpanelPrivate *priv = DAWATI_NETBOOK_NETPANEL (self)->priv;
-
-  gchar *plugin_pipe = g_strdup_printf ("%s/chrome-dawati-plugin.fifo",
-                                        g_get_tmp_dir ());
+  OpenTabReply *reply = (OpenTabReply *) data;
 
-  if (g_file_test (plugin_pipe, G_FILE_TEST_EXISTS))
+  if (status == -EPIPE)
     {
-      GError *error = NULL;
-      gint fd = open(plugin_pipe, O_WRONLY | O_NONBLOCK);
-      // pipe file might be not closed properly
-      // it will cause fd is -1. fallback to launch chrome.
-      if (fd == -1)
-        {
-          g_free (plugin_pipe);
-          return FALSE;
-        }
-      GIOChannel * output = g_io_channel_unix_new(fd);
-      g_io_channel_set_encoding (output, NULL, NULL);
-      g_io_channel_set_buffered (output, FALSE);
-      g_io_channel_set_close_on_unref (output, TRUE);
-
-      switch(type)
-        {
-          case CMD_SELECT_TAB:
-            pipe_send (output, G_TYPE_UINT, CMD_SELECT_TAB, G_TYPE_INT, *((gint*)data), G_TYPE_INVALID);
-            break;
-          case CMD_NEW_TAB:
-            pipe_send (output, G_TYPE_UINT, CMD_NEW_TAB, G_TYPE_STRING, (gchar*)data, G_TYPE_INVALID);
-            break;
-          default:
-            g_io_channel_unref (output);
-            g_free(plugin_pipe);
-            return FALSE;
-        }
-
-      if (g_io_channel_shutdown (output, FALSE, &error) ==
-          G_IO_STATUS_ERROR)
-        {
-          g_warning ("Error closing IO channel: %s", error->message);
-          g_error_free (error);
-        }
-
-      g_io_channel_unref (output);
-      output = NULL;
-      mpl_panel_client_hide (priv->panel_client);
-      g_free(plugin_pipe);
-      return TRUE;
-    }
-  else
-    {
-      g_free(plugin_pipe);
-      return FALSE;
+      /* The browser went away before it read the command, start it the
+       * way we would have had it not been running */
+      if (reply->type == MWB_PLUGIN_CMD_NEW_TAB)
+        dawati_netbook_netpanel_launch_browser (reply->self,
+                                                reply->fallback_url);
+      else
+        dawati_netbook_netpanel_restore_tab (reply->self,
+                                             reply->fallback_url);
     }
+  else if (status != 0 && status != -ECANCELED)
+    g_warning ("[netpanel] browser plugin failed to open the tab: %s",
+               g_strerror (status < 0 ? -status : status));
+
+  g_free (reply->fallback_url);
+  g_slice_free (OpenTabReply, reply);
 }
 
 /*
+ * Asks the running browser to show a tab; returns FALSE if the browser is
+ * not running, in which case it is up to the caller to start it. If the
+ * browser turns out to have gone away before reading the command, it is
+ * started on @fallback_url: as a new page for MWB_PLUGIN_CMD_NEW_TAB, as
+ * the tab to restore otherwise.
+ */
 static gboolean
-dawati_netbook_netpanel_select_tab (DawatiNetbookNetpanel *self, gint tab_id)
+dawati_netbook_netpanel_open_tab (DawatiNetbookNetpanel *self, const gint type,
+                                  void *data, const gchar *fallback_url)
 {
   DawatiNetbookNetpanelPrivate *priv = DAWATI_NETBOOK_NETPANEL (self)->priv;
+  OpenTabReply *reply;
+  guint32 serial;
 
-  gchar *plugin_pipe = g_strdup_printf ("%s/chrome-dawati-plugin.fifo",
-                                        g_get_tmp_dir ());
+  reply = g_slice_new (OpenTabReply);
+  reply->self = self;
+  reply->type = type;
+  reply->fallback_url = g_strdup (fallback_url);
 
-  if (g_file_test (plugin_pipe, G_FILE_TEST_EXISTS))
+  switch(type)
     {
-      GError *error = NULL;
-      gint fd = open(plugin_pipe, O_WRONLY | O_NONBLOCK);
-      // pipe file might be not closed properly
-      // it will cause fd is -1. fallback to launch chrome.
-      if (fd == -1)
+      case MWB_PLUGIN_CMD_SELECT_TAB:
         {
-          g_free (plugin_pipe);
-          return FALSE;
-        }
-      GIOChannel * output = g_io_channel_unix_new(fd);
-      g_io_channel_set_encoding (output, NULL, NULL);
-      g_io_channel_set_buffered (output, FALSE);
-      g_io_channel_set_close_on_unref (output, TRUE);
-
-      pipe_send (output, G_TYPE_UINT, CMD_SELECT_TAB, G_TYPE_INT, tab_id, G_TYPE_INVALID);
+          gint32 tab_id = *((gint*)data);
 
-      if (g_io_channel_shutdown (output, FALSE, &error) ==
-          G_IO_STATUS_ERROR)
-        {
-          g_warning ("Error closing IO channel: %s", error->message);
-          g_error_free (error);
+          serial = mwb_plugin_pipe_send (priv->plugin_pipe,
+                                         MWB_PLUGIN_CMD_SELECT_TAB,
+                                         &tab_id, sizeof (tab_id),
+                                         open_tab_reply_cb, reply);
+          break;
         }
-
-      g_io_channel_unref (output);
-      output = NULL;
-      mpl_panel_client_hide (priv->panel_client);
-      g_free(plugin_pipe);
-      return TRUE;
+      case MWB_PLUGIN_CMD_NEW_TAB:
+        serial = mwb_plugin_pipe_send (priv->plugin_pipe,
+                                       MWB_PLUGIN_CMD_NEW_TAB,
+                                       data, strlen ((gchar*)data),
+                                       open_tab_reply_cb, reply);
+        break;
+      default:
+        serial = 0;
     }
-  else
+
+  if (!serial)
     {
-      g_free(plugin_pipe);
+      g_free (reply->fallback_url);
+      g_slice_free (OpenTabReply, reply);
       return FALSE;
     }
+
+  mpl_panel_client_hide (priv->panel_client);
+  return TRUE;
 }
-*/
 
 static void
 dawati_netbook_netpanel_restore_tab (DawatiNetbookNetpanel *self, gchar* tab_url)
@@ -827,7 +729,8 @@ session_tab_button_clicked_cb (MxWidget *button, DawatiNetbookNetpanel *self)
   gchar *tab_url = (gchar *)g_object_get_data (G_OBJECT (button), "url");
   guint tab_id = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (button), "tab_id"));
 
-  if (!dawati_netbook_netpanel_open_tab (self, CMD_SELECT_TAB, (void*)&tab_id))
+  if (!dawati_netbook_netpanel_open_tab (self, MWB_PLUGIN_CMD_SELECT_TAB,
+                                         (void*)&tab_id, tab_url))
     {
       dawati_netbook_netpanel_restore_tab (self, tab_url);
     }
@@ -910,13 +813,6 @@ create_favs_placeholder (DawatiNetbookNetpanel *self)
   clutter_actor_set_parent (priv->favs_scrollview, CLUTTER_ACTOR (self));
 }
 
-typedef struct _TextureData{
-  ClutterActor *tex;
-  ClutterActor *favi;
-  gchar *url;
-  gchar *ff;
-}TextureData;
-
 #define NETPANEL_DIR ".config/internet-panel"
 
 static gchar *
@@ -968,72 +864,591 @@ get_favicon_filename(DawatiNetbookNetpanel *self, const char *url)
   return result;
 }
 
+/*
+ * Thumbnails and favicons are decoded on worker threads rather than in
+ * idle callbacks on the main loop, which used to hold the panel up until
+ * every image of the history and the tabs was loaded.
+ *
+ * Decoded images are kept on disk as RGBA data already scaled to the size
+ * they are shown at, in one file per source and size whose header records
+ * the modification time of the source; a thumbnail that has not changed
+ * since is just read back. The header also records the source path, so
+ * that when the loader starts a separate thread can drop the files whose
+ * source is gone or has changed, and then the least recently used ones
+ * until the cache fits in IMAGE_CACHE_MAX_SIZE. Only a bounded number of
+ * images is handed to
+ * the workers at a time, and both those and the finished images waiting
+ * to be uploaded are taken in order of visibility: images inside the
+ * visible part of their scroll view come first, then by the priority they
+ * were requested with.
+ */
+
+/* Images given to the workers at a time */
+#define IMAGE_QUEUE_MAX     8
+#define IMAGE_THREADS       2
+/* Time spent uploading textures per main loop iteration, in us */
+#define IMAGE_UPLOAD_SLICE  (8 * 1000)
+
+#define IMAGE_CACHE_MAGIC   0x44574932 /* "DWI2" */
+/* Size the cache directory is trimmed to, in bytes */
+#define IMAGE_CACHE_MAX_SIZE (64 * 1024 * 1024)
+/* A cache hit marks the file as used if it was last marked this long ago,
+ * in seconds */
+#define IMAGE_CACHE_TOUCH   (60 * 60)
+
+/* Followed by path_len bytes of source path, then the pixels */
+typedef struct
+{
+  guint32 magic;
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+  guint32 path_len;
+  guint32 padding;
+  gint64  mtime;
+} ImageCacheHeader;
+
+typedef struct
+{
+  gchar  *filename;
+  time_t  used;
+  goffset size;
+} ImageCacheEntry;
+
+typedef struct
+{
+  /* Main thread only */
+  ClutterActor *image;      /* weak */
+  ClutterActor *viewport;   /* weak */
+  gint          priority;
+
+  /* Read by the worker */
+  gchar        *path;
+  gchar        *fallback;
+  gint          width;
+  gint          height;
+
+  /* Written by the worker */
+  guchar       *pixels;
+  gint          pixels_width;
+  gint          pixels_height;
+  gint          rowstride;
+} ImageRequest;
+
+typedef struct
+{
+  GThreadPool *pool;
+  gchar       *cache_dir;
+  GList       *pending;     /* ImageRequest, not given to the workers yet */
+  guint        n_decoding;
+
+  GMutex       mutex;       /* Protects done and upload_id */
+  GList       *done;        /* ImageRequest, decoded */
+  guint        upload_id;
+} ImageLoader;
+
+static ImageLoader *image_loader = NULL;
+
+static void
+image_request_free (ImageRequest *request)
+{
+  if (request->image)
+    g_object_remove_weak_pointer (G_OBJECT (request->image),
+                                  (gpointer *) &request->image);
+  if (request->viewport)
+    g_object_remove_weak_pointer (G_OBJECT (request->viewport),
+                                  (gpointer *) &request->viewport);
+
+  g_free (request->path);
+  g_free (request->fallback);
+  g_free (request->pixels);
+  g_slice_free (ImageRequest, request);
+}
+
+/* Whether the image is in the part of its scroll view that is shown */
 static gboolean
-add_texture_to_scrollview(void*data)
+image_request_is_visible (ImageRequest *request)
 {
+  gfloat x, y, width, height;
+  gfloat vx, vy, vwidth, vheight;
 
-  ClutterActor *tex = ((TextureData*)data)->tex;
-  ClutterActor *favi = ((TextureData*)data)->favi;
-  gchar *url = ((TextureData*)data)->url;
-  gchar *ff = ((TextureData*)data)->ff;
+  if (!request->image || !CLUTTER_ACTOR_IS_MAPPED (request->image))
+    return FALSE;
 
-  gchar *csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, url, -1);
-  gchar *thumbnail_filename = g_strconcat (csum, ".png", NULL);
-  gchar *path = g_build_filename (g_get_home_dir (),
-                                  NETPANEL_DIR,
-                                  "thumbnails",
-                                  thumbnail_filename,
-                                  NULL);
-  g_free(csum);
-  g_free(thumbnail_filename);
-  GError *error = NULL;
+  if (!request->viewport)
+    return TRUE;
+
+  clutter_actor_get_transformed_position (request->image, &x, &y);
+  clutter_actor_get_transformed_size (request->image, &width, &height);
+  clutter_actor_get_transformed_position (request->viewport, &vx, &vy);
+  clutter_actor_get_transformed_size (request->viewport, &vwidth, &vheight);
+
+  return x < vx + vwidth && x + width > vx &&
+         y < vy + vheight && y + height > vy;
+}
+
+/* Takes the request that should be served first off @list */
+static ImageRequest *
+image_request_pop_next (GList **list)
+{
+  GList        *l, *best = NULL;
+  gboolean      best_visible = FALSE;
+
+  for (l = *list; l; l = l->next)
+    {
+      ImageRequest *request = (ImageRequest *) l->data;
+      gboolean      visible = image_request_is_visible (request);
+
+      if (!best ||
+          (visible && !best_visible) ||
+          (visible == best_visible &&
+           request->priority < ((ImageRequest *) best->data)->priority))
+        {
+          best = l;
+          best_visible = visible;
+        }
+    }
+
+  if (!best)
+    return NULL;
+
+  *list = g_list_delete_link (*list, best);
+  return (ImageRequest *) best->data;
+}
+
+static gchar *
+image_cache_filename (const gchar *cache_dir,
+                      const gchar *path,
+                      gint         width,
+                      gint         height)
+{
+  gchar *csum, *name, *filename;
+
+  csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+  name = g_strdup_printf ("%s-%dx%d.rgba", csum, width, height);
+  filename = g_build_filename (cache_dir, name, NULL);
+
+  g_free (csum);
+  g_free (name);
+
+  return filename;
+}
+
+/* Runs in a worker thread */
+static gboolean
+image_cache_load (ImageRequest *request,
+                  const gchar  *filename,
+                  const gchar  *path,
+                  gint64        mtime)
+{
+  ImageCacheHeader  header;
+  struct stat       st;
+  gchar            *contents;
+  gsize             length, offset;
+  gboolean          ok = FALSE;
+
+  if (g_stat (filename, &st) != 0)
+    return FALSE;
 
-  if (path)
+  if (!g_file_get_contents (filename, &contents, &length, NULL))
+    return FALSE;
+
+  if (length >= sizeof (header))
     {
-      mx_image_set_from_file_at_size (MX_IMAGE (tex), path,
-                                      CELL_WIDTH, CELL_HEIGHT,
-                                      &error);
+      memcpy (&header, contents, sizeof (header));
+      offset = sizeof (header) + header.path_len;
+
+      if (header.magic == IMAGE_CACHE_MAGIC &&
+          header.mtime == mtime &&
+          header.path_len == strlen (path) &&
+          header.rowstride >= header.width * 4 &&
+          length == offset + (gsize) header.rowstride * header.height &&
+          memcmp (contents + sizeof (header), path, header.path_len) == 0)
+        {
+          request->pixels = (guchar *) g_memdup (contents + offset,
+                                                 length - offset);
+          request->pixels_width = header.width;
+          request->pixels_height = header.height;
+          request->rowstride = header.rowstride;
+          ok = TRUE;
+        }
+    }
+
+  g_free (contents);
+
+  /* The file's mtime is its last use when the cache is trimmed */
+  if (ok && time (NULL) - st.st_mtime > IMAGE_CACHE_TOUCH)
+    g_utime (filename, NULL);
+
+  return ok;
+}
+
+/* Runs in a worker thread */
+static void
+image_cache_save (ImageRequest *request,
+                  const gchar  *filename,
+                  const gchar  *path,
+                  gint64        mtime)
+{
+  ImageCacheHeader  header;
+  gsize             size, offset;
+  gchar            *contents;
+
+  memset (&header, 0, sizeof (header));
+  header.magic = IMAGE_CACHE_MAGIC;
+  header.width = request->pixels_width;
+  header.height = request->pixels_height;
+  header.rowstride = request->rowstride;
+  header.path_len = strlen (path);
+  header.mtime = mtime;
+
+  offset = sizeof (header) + header.path_len;
+  size = (gsize) request->rowstride * request->pixels_height;
+  contents = (gchar *) g_malloc (offset + size);
+  memcpy (contents, &header, sizeof (header));
+  memcpy (contents + sizeof (header), path, header.path_len);
+  memcpy (contents + offset, request->pixels, size);
+
+  g_file_set_contents (filename, contents, offset + size, NULL);
+
+  g_free (contents);
+}
+
+/*
+ * Whether the cache file @filename still describes its source: it has the
+ * current format and its source exists with the mtime it was made from.
+ */
+static gboolean
+image_cache_is_current (const gchar *filename)
+{
+  ImageCacheHeader  header;
+  struct stat       st;
+  gchar            *path;
+  gboolean          ok = FALSE;
+  FILE             *file;
+
+  file = fopen (filename, "rb");
+  if (!file)
+    return FALSE;
+
+  if (fread (&header, sizeof (header), 1, file) == 1 &&
+      header.magic == IMAGE_CACHE_MAGIC &&
+      header.path_len > 0 && header.path_len < 4096)
+    {
+      path = (gchar *) g_malloc (header.path_len + 1);
+
+      if (fread (path, header.path_len, 1, file) == 1)
+        {
+          path[header.path_len] = '\0';
+          ok = g_stat (path, &st) == 0 && st.st_mtime == header.mtime;
+        }
+
       g_free (path);
-      if (error)
+    }
+
+  fclose (file);
+
+  return ok;
+}
+
+static gint
+image_cache_entry_compare (gconstpointer a,
+                           gconstpointer b)
+{
+  const ImageCacheEntry *entry_a = (const ImageCacheEntry *) a;
+  const ImageCacheEntry *entry_b = (const ImageCacheEntry *) b;
+
+  /* Most recently used first */
+  if (entry_a->used != entry_b->used)
+    return entry_a->used > entry_b->used ? -1 : 1;
+
+  return 0;
+}
+
+/* Runs in its own thread, once when the loader starts */
+static gpointer
+image_cache_trim_thread (gpointer data)
+{
+  gchar       *cache_dir = (gchar *) data;
+  GArray      *entries;
+  GDir        *dir;
+  const gchar *name;
+  goffset      total = 0;
+  guint        i, n_stale = 0, n_evicted = 0;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (!dir)
+    {
+      g_free (cache_dir);
+      return NULL;
+    }
+
+  entries = g_array_new (FALSE, FALSE, sizeof (ImageCacheEntry));
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      ImageCacheEntry  entry;
+      struct stat      st;
+      gchar           *filename;
+
+      if (!g_str_has_suffix (name, ".rgba"))
+        continue;
+
+      filename = g_build_filename (cache_dir, name, NULL);
+
+      if (g_stat (filename, &st) != 0)
         {
-          g_warning ("[netpanel] unable to open thumbnail: %s\n",
-                     error->message);
-          g_error_free (error);
+          g_free (filename);
+          continue;
         }
+
+      if (!image_cache_is_current (filename))
+        {
+          g_unlink (filename);
+          g_free (filename);
+          n_stale++;
+          continue;
+        }
+
+      entry.filename = filename;
+      entry.used = st.st_mtime;
+      entry.size = st.st_size;
+      g_array_append_val (entries, entry);
     }
-  if (!path || error)
+
+  g_dir_close (dir);
+
+  g_array_sort (entries, image_cache_entry_compare);
+
+  for (i = 0; i < entries->len; i++)
     {
-      error = NULL;
-      mx_image_set_from_file_at_size (MX_IMAGE (tex),
-                                      THEMEDIR "/fallback-page.png",
-                                      CELL_WIDTH, CELL_HEIGHT,
-                                      &error);
-      if (error)
+      ImageCacheEntry *entry = &g_array_index (entries, ImageCacheEntry, i);
+
+      total += entry->size;
+      if (total > IMAGE_CACHE_MAX_SIZE)
         {
-          g_warning ("[netpanel] unable to open fallback thumbnail: %s\n",
-                     error->message);
-          g_error_free (error);
+          g_unlink (entry->filename);
+          n_evicted++;
+        }
+
+      g_free (entry->filename);
+    }
+
+  g_debug ("[netpanel] image cache: %u files, %u stale, %u evicted",
+           entries->len + n_stale, n_stale, n_evicted);
+
+  g_array_free (entries, TRUE);
+  g_free (cache_dir);
+
+  return NULL;
+}
+
+/* Runs in a worker thread */
+static gboolean
+image_decode (ImageRequest *request,
+              const gchar  *path)
+{
+  GdkPixbuf *pixbuf, *rgba;
+  GError    *error = NULL;
+
+  pixbuf = gdk_pixbuf_new_from_file_at_size (path,
+                                             request->width,
+                                             request->height,
+                                             &error);
+  if (!pixbuf)
+    {
+      g_warning ("[netpanel] unable to open image %s: %s\n",
+                 path, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  rgba = gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
+  g_object_unref (pixbuf);
+
+  request->pixels_width = gdk_pixbuf_get_width (rgba);
+  request->pixels_height = gdk_pixbuf_get_height (rgba);
+  request->rowstride = gdk_pixbuf_get_rowstride (rgba);
+  request->pixels = (guchar *) g_memdup (gdk_pixbuf_get_pixels (rgba),
+                                         request->rowstride *
+                                         request->pixels_height);
+  g_object_unref (rgba);
+
+  return TRUE;
+}
+
+/* Runs in a worker thread */
+static gboolean
+image_load (ImageRequest *request,
+            const gchar  *path)
+{
+  struct stat  st;
+  gchar       *filename;
+  gboolean     ok;
+
+  if (g_stat (path, &st) != 0)
+    return FALSE;
+
+  filename = image_cache_filename (image_loader->cache_dir, path,
+                                   request->width, request->height);
+
+  ok = image_cache_load (request, filename, path, st.st_mtime);
+  if (!ok)
+    {
+      ok = image_decode (request, path);
+      if (ok)
+        image_cache_save (request, filename, path, st.st_mtime);
+    }
+
+  g_free (filename);
+
+  return ok;
+}
+
+static gboolean image_upload_cb (gpointer data);
+
+/* Runs in a worker thread */
+static void
+image_decode_cb (gpointer data,
+                 gpointer user_data)
+{
+  ImageRequest *request = (ImageRequest *) data;
+  ImageLoader  *loader = (ImageLoader *) user_data;
+
+  if (!(request->path && image_load (request, request->path)) &&
+      request->fallback)
+    image_load (request, request->fallback);
+
+  g_mutex_lock (&loader->mutex);
+  loader->done = g_list_prepend (loader->done, request);
+  if (!loader->upload_id)
+    loader->upload_id = clutter_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                                       image_upload_cb,
+                                                       loader, NULL);
+  g_mutex_unlock (&loader->mutex);
+}
+
+static void
+image_loader_dispatch (ImageLoader *loader)
+{
+  ImageRequest *request;
+
+  while (loader->n_decoding < IMAGE_QUEUE_MAX &&
+         (request = image_request_pop_next (&loader->pending)))
+    {
+      /* Nothing left to load it for */
+      if (!request->image)
+        {
+          image_request_free (request);
+          continue;
         }
+
+      loader->n_decoding++;
+      g_thread_pool_push (loader->pool, request, NULL);
     }
+}
+
+static gboolean
+image_upload_cb (gpointer data)
+{
+  ImageLoader  *loader = (ImageLoader *) data;
+  ImageRequest *request;
+  gint64        start = g_get_monotonic_time ();
+  gboolean      more;
+
+  g_mutex_lock (&loader->mutex);
 
-  error = NULL;
-  if(ff)
+  while (g_get_monotonic_time () - start < IMAGE_UPLOAD_SLICE &&
+         (request = image_request_pop_next (&loader->done)))
     {
-      mx_image_set_from_file_at_size (MX_IMAGE (favi), ff,
-                                      FAVI_SIZE, FAVI_SIZE,
-                                      &error);
-      if (error)
+      g_mutex_unlock (&loader->mutex);
+
+      loader->n_decoding--;
+
+      if (request->image && request->pixels)
         {
-          g_warning ("[netpanel] unable to open thumbnail: %s\n",
-                     error->message);
-          g_error_free (error);
+          GError *error = NULL;
+
+          if (!mx_image_set_from_data (MX_IMAGE (request->image),
+                                       request->pixels,
+                                       COGL_PIXEL_FORMAT_RGBA_8888,
+                                       request->pixels_width,
+                                       request->pixels_height,
+                                       request->rowstride,
+                                       &error))
+            {
+              g_warning ("[netpanel] unable to upload image: %s\n",
+                         error->message);
+              g_error_free (error);
+            }
         }
+
+      image_request_free (request);
+
+      g_mutex_lock (&loader->mutex);
     }
 
-  g_free(url);
-  g_free(ff);
-  g_free(data);
-  return FALSE;
+  more = loader->done != NULL;
+  if (!more)
+    loader->upload_id = 0;
+
+  g_mutex_unlock (&loader->mutex);
+
+  image_loader_dispatch (loader);
+
+  return more;
+}
+
+/*
+ * Loads @path into @image at @width x @height, or @fallback if @path cannot
+ * be loaded; @viewport is the actor whose area decides whether @image is
+ * visible.
+ */
+static void
+image_loader_request (ClutterActor *image,
+                      ClutterActor *viewport,
+                      const gchar  *path,
+                      const gchar  *fallback,
+                      gint          width,
+                      gint          height,
+                      gint          priority)
+{
+  ImageRequest *request;
+
+  if (G_UNLIKELY (image_loader == NULL))
+    {
+      image_loader = g_new0 (ImageLoader, 1);
+      image_loader->cache_dir = g_build_filename (g_get_user_cache_dir (),
+                                                  "dawati",
+                                                  "netpanel",
+                                                  NULL);
+      g_mkdir_with_parents (image_loader->cache_dir, 0700);
+      g_thread_unref (g_thread_new ("netpanel-cache-trim",
+                                    image_cache_trim_thread,
+                                    g_strdup (image_loader->cache_dir)));
+      g_mutex_init (&image_loader->mutex);
+      image_loader->pool = g_thread_pool_new (image_decode_cb,
+                                              image_loader,
+                                              IMAGE_THREADS,
+                                              FALSE,
+                                              NULL);
+    }
+
+  request = g_slice_new0 (ImageRequest);
+  request->image = image;
+  g_object_add_weak_pointer (G_OBJECT (image), (gpointer *) &request->image);
+  request->viewport = viewport;
+  if (viewport)
+    g_object_add_weak_pointer (G_OBJECT (viewport),
+                               (gpointer *) &request->viewport);
+  request->priority = priority;
+  request->path = g_strdup (path);
+  request->fallback = g_strdup (fallback);
+  request->width = width;
+  request->height = height;
+
+  image_loader->pending = g_list_prepend (image_loader->pending, request);
+  image_loader_dispatch (image_loader);
 }
 
 static MxWidget *
@@ -1092,13 +1507,25 @@ add_thumbnail_to_scrollview (ClutterActor *scrollview,
 
   clutter_container_add_actor (CLUTTER_CONTAINER (scrollview), vbox);
 
-  TextureData *tex_data = (TextureData*) g_malloc0 (sizeof (TextureData));
-  tex_data->tex = tex;
-  tex_data->favi = favi_tex;
-  tex_data->url = g_strdup (url);
-  tex_data->ff = g_strdup (favicon_filename);
-  clutter_threads_add_idle_full (priority, add_texture_to_scrollview,
-                                 (void*) tex_data, NULL);
+  gchar *csum = g_compute_checksum_for_string (G_CHECKSUM_MD5, url, -1);
+  gchar *thumbnail_filename = g_strconcat (csum, ".png", NULL);
+  path = g_build_filename (g_get_home_dir (),
+                           NETPANEL_DIR,
+                           "thumbnails",
+                           thumbnail_filename,
+                           NULL);
+  g_free(csum);
+  g_free(thumbnail_filename);
+
+  /* The box is inside a scroll view, which is what shows it */
+  image_loader_request (tex, clutter_actor_get_parent (scrollview),
+                        path, THEMEDIR "/fallback-page.png",
+                        CELL_WIDTH, CELL_HEIGHT, priority);
+  if (favicon_filename)
+    image_loader_request (favi_tex, clutter_actor_get_parent (scrollview),
+                          favicon_filename, NULL,
+                          FAVI_SIZE, FAVI_SIZE, priority);
+  g_free (path);
 
   return MX_WIDGET (button);
 }
@@ -1578,6 +2005,8 @@ dawati_netbook_netpanel_init (DawatiNetbookNetpanel *self)
   GError *error = NULL;
   DawatiNetbookNetpanelPrivate *priv = self->priv = NETPANEL_PRIVATE (self);
 
+  priv->plugin_pipe = mwb_plugin_pipe_new (NULL);
+
   /* Construct entry table */
   priv->entry_table = table = MX_WIDGET (mx_table_new ());
   mx_table_set_column_spacing (MX_TABLE (table), COL_SPACING);
@@ -0,0 +1,379 @@
+/*
+ * Dawati-Web-Browser: The web browser for Dawati
+ * Copyright (c) 2012, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The two ends of the browser plugin pipe.
+ *
+ *   test-plugin-pipe stub
+ *     stands in for the browser plugin: prints the commands it receives,
+ *     how many reads they took, and answers those that want a reply.
+ *
+ *   test-plugin-pipe legacy-stub
+ *     stands in for a plugin that predates the framed protocol: it only
+ *     listens on the legacy FIFO and prints the commands it receives.
+ *
+ *   test-plugin-pipe send [n-commands]
+ *     sends a batch of commands the way the panel does and waits for the
+ *     replies.
+ *
+ * Both use a directory of their own under the temporary directory, so a
+ * running browser is not disturbed.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "mwb-plugin-pipe.h"
+
+#define N_COMMANDS 100
+
+static GMainLoop *loop = NULL;
+static gchar     *dir = NULL;
+
+/* The stub plugin */
+
+static GByteArray *stub_buffer = NULL;
+static guint       stub_n_reads = 0;
+static guint       stub_n_frames = 0;
+
+static void
+stub_reply (guint32 serial, gint32 status)
+{
+  MwbPluginFrame  frame;
+  guint8          buffer[sizeof (frame) + sizeof (status)];
+  gchar          *path;
+  gint            fd;
+
+  path = g_build_filename (dir, MWB_PLUGIN_REPLY_PIPE_NAME, NULL);
+  fd = open (path, O_WRONLY | O_NONBLOCK);
+  g_free (path);
+
+  if (fd < 0)
+    {
+      g_warning ("Nobody to reply to: %s", g_strerror (errno));
+      return;
+    }
+
+  frame.length = sizeof (status);
+  frame.serial = serial;
+  frame.command = MWB_PLUGIN_CMD_REPLY;
+  frame.flags = 0;
+
+  memcpy (buffer, &frame, sizeof (frame));
+  memcpy (buffer + sizeof (frame), &status, sizeof (status));
+
+  if (write (fd, buffer, sizeof (buffer)) != sizeof (buffer))
+    g_warning ("Short reply: %s", g_strerror (errno));
+
+  close (fd);
+}
+
+static void
+stub_handle (const MwbPluginFrame *frame,
+             const guint8         *payload)
+{
+  gint32 tab_id;
+
+  stub_n_frames++;
+
+  switch (frame->command)
+    {
+    case MWB_PLUGIN_CMD_SELECT_TAB:
+      memcpy (&tab_id, payload, sizeof (tab_id));
+      printf ("#%u select tab %d\n", frame->serial, tab_id);
+      break;
+
+    case MWB_PLUGIN_CMD_NEW_TAB:
+      printf ("#%u new tab %.*s\n",
+              frame->serial, (int) frame->length, (const char *) payload);
+      break;
+
+    default:
+      printf ("#%u unknown command %u\n", frame->serial, frame->command);
+    }
+
+  if (frame->flags & MWB_PLUGIN_FLAG_REPLY)
+    stub_reply (frame->serial, 0);
+}
+
+static gboolean
+stub_read_cb (GIOChannel   *source,
+              GIOCondition  condition,
+              gpointer      data)
+{
+  gint            fd = g_io_channel_unix_get_fd (source);
+  MwbPluginFrame  frame;
+  guint8          buffer[4096];
+  gssize          n;
+
+  while ((n = read (fd, buffer, sizeof (buffer))) > 0)
+    {
+      stub_n_reads++;
+      g_byte_array_append (stub_buffer, buffer, n);
+    }
+
+  while (stub_buffer->len >= sizeof (frame))
+    {
+      memcpy (&frame, stub_buffer->data, sizeof (frame));
+
+      if (frame.length > MWB_PLUGIN_MAX_PAYLOAD)
+        {
+          g_warning ("Bad frame, giving up");
+          g_main_loop_quit (loop);
+          return FALSE;
+        }
+
+      if (stub_buffer->len < sizeof (frame) + frame.length)
+        break;
+
+      stub_handle (&frame, stub_buffer->data + sizeof (frame));
+      g_byte_array_remove_range (stub_buffer, 0, sizeof (frame) + frame.length);
+    }
+
+  printf ("%u commands in %u reads so far\n", stub_n_frames, stub_n_reads);
+  fflush (stdout);
+
+  return TRUE;
+}
+
+/* Returns the bytes used by the legacy command at the start of @data, or
+ * 0 if it is not complete yet */
+static gsize
+legacy_stub_handle (const guint8 *data,
+                    gsize         length)
+{
+  guint  command;
+  gint   tab_id;
+  gssize size;
+
+  if (length < sizeof (command))
+    return 0;
+
+  memcpy (&command, data, sizeof (command));
+
+  switch (command)
+    {
+    case MWB_PLUGIN_CMD_SELECT_TAB:
+      if (length < sizeof (command) + sizeof (tab_id))
+        return 0;
+      memcpy (&tab_id, data + sizeof (command), sizeof (tab_id));
+      printf ("legacy select tab %d\n", tab_id);
+      return sizeof (command) + sizeof (tab_id);
+
+    case MWB_PLUGIN_CMD_NEW_TAB:
+      if (length < sizeof (command) + sizeof (size))
+        return 0;
+      memcpy (&size, data + sizeof (command), sizeof (size));
+      if (size < 1 || size > MWB_PLUGIN_MAX_PAYLOAD)
+        break;
+      if (length < sizeof (command) + sizeof (size) + (gsize) size)
+        return 0;
+      printf ("legacy new tab %s\n",
+              (const char *) data + sizeof (command) + sizeof (size));
+      return sizeof (command) + sizeof (size) + size;
+    }
+
+  /* Nothing to resynchronise on in this encoding */
+  g_warning ("Bad legacy command %u, dropping %" G_GSIZE_FORMAT " bytes",
+             command, length);
+  return length;
+}
+
+static gboolean
+legacy_stub_read_cb (GIOChannel   *source,
+                     GIOCondition  condition,
+                     gpointer      data)
+{
+  gint    fd = g_io_channel_unix_get_fd (source);
+  guint8  buffer[4096];
+  gssize  n;
+  gsize   used;
+
+  while ((n = read (fd, buffer, sizeof (buffer))) > 0)
+    {
+      stub_n_reads++;
+      g_byte_array_append (stub_buffer, buffer, n);
+    }
+
+  while ((used = legacy_stub_handle (stub_buffer->data, stub_buffer->len)))
+    {
+      stub_n_frames++;
+      g_byte_array_remove_range (stub_buffer, 0, used);
+    }
+
+  printf ("%u commands in %u reads so far\n", stub_n_frames, stub_n_reads);
+  fflush (stdout);
+
+  return TRUE;
+}
+
+static int
+run_stub (gboolean legacy)
+{
+  GIOChannel *channel;
+  gchar      *path;
+  gint        fd;
+
+  path = g_build_filename (dir,
+                           legacy ? MWB_PLUGIN_LEGACY_PIPE_NAME
+                                  : MWB_PLUGIN_PIPE_NAME,
+                           NULL);
+
+  if (mkfifo (path, 0600) != 0 && errno != EEXIST)
+    {
+      g_warning ("Unable to create %s: %s", path, g_strerror (errno));
+      return EXIT_FAILURE;
+    }
+
+  /* Read and write, so that we don't see end of file between senders */
+  fd = open (path, O_RDWR | O_NONBLOCK);
+  if (fd < 0)
+    {
+      g_warning ("Unable to open %s: %s", path, g_strerror (errno));
+      return EXIT_FAILURE;
+    }
+
+  printf ("Listening on %s\n", path);
+  fflush (stdout);
+
+  stub_buffer = g_byte_array_new ();
+  channel = g_io_channel_unix_new (fd);
+  g_io_add_watch (channel, G_IO_IN,
+                  legacy ? legacy_stub_read_cb : stub_read_cb, NULL);
+
+  g_main_loop_run (loop);
+
+  g_io_channel_unref (channel);
+  close (fd);
+  g_unlink (path);
+  g_free (path);
+
+  return EXIT_SUCCESS;
+}
+
+/* The panel side */
+
+static guint   n_pending = 0;
+static guint   n_failed = 0;
+static GTimer *timer = NULL;
+
+static void
+reply_cb (gint status, gpointer data)
+{
+  if (status != 0)
+    {
+      printf ("Command %u failed: %s\n",
+              GPOINTER_TO_UINT (data),
+              g_strerror (status < 0 ? -status : status));
+      n_failed++;
+    }
+
+  if (--n_pending == 0)
+    g_main_loop_quit (loop);
+}
+
+static int
+run_send (guint n_commands)
+{
+  MwbPluginPipe *pipe;
+  const gchar   *url = "http://dawati.org/";
+  guint          i;
+
+  pipe = mwb_plugin_pipe_new (dir);
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_commands; i++)
+    {
+      guint32 serial;
+
+      if (i % 10 == 9)
+        serial = mwb_plugin_pipe_send (pipe, MWB_PLUGIN_CMD_NEW_TAB,
+                                       url, strlen (url),
+                                       reply_cb, GUINT_TO_POINTER (i));
+      else
+        {
+          gint32 tab_id = i;
+
+          serial = mwb_plugin_pipe_send (pipe, MWB_PLUGIN_CMD_SELECT_TAB,
+                                         &tab_id, sizeof (tab_id),
+                                         reply_cb, GUINT_TO_POINTER (i));
+        }
+
+      if (!serial)
+        {
+          printf ("The stub is not running, start it with "
+                  "'test-plugin-pipe stub' or 'test-plugin-pipe "
+                  "legacy-stub'\n");
+          mwb_plugin_pipe_free (pipe);
+          return EXIT_FAILURE;
+        }
+
+      n_pending++;
+    }
+
+  g_main_loop_run (loop);
+
+  printf ("%u commands answered in %.1f ms, %u failed\n",
+          n_commands, g_timer_elapsed (timer, NULL) * 1000, n_failed);
+
+  mwb_plugin_pipe_free (pipe);
+  g_timer_destroy (timer);
+
+  return n_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  int ret;
+
+  if (argc < 2 ||
+      (strcmp (argv[1], "stub") && strcmp (argv[1], "legacy-stub") &&
+       strcmp (argv[1], "send")))
+    {
+      printf ("Usage: %s stub|legacy-stub|send [n-commands]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  g_type_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+  dir = g_build_filename (g_get_tmp_dir (), "dawati-plugin-test", NULL);
+  g_mkdir_with_parents (dir, 0700);
+
+  if (!strcmp (argv[1], "stub"))
+    ret = run_stub (FALSE);
+  else if (!strcmp (argv[1], "legacy-stub"))
+    ret = run_stub (TRUE);
+  else
+    ret = run_send (argc > 2 ? MAX (atoi (argv[2]), 1) : N_COMMANDS);
+
+  g_main_loop_unref (loop);
+  g_free (dir);
+
+  return ret;
+}
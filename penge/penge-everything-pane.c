@@ -24,6 +24,7 @@
 #include <libsocialweb-client/sw-client.h>
 #include <gtk/gtk.h>
 #include <gio/gio.h>
+#include <dawati-panel/mpl-timer.h>
 #include <dawati-panel/mpl-utils.h>
 #include <gconf/gconf-client.h>
 
@@ -47,6 +48,7 @@ G_DEFINE_TYPE (PengeEverythingPane, penge_everything_pane, PENGE_TYPE_BLOCK_CONT
 #define TILE_WIDTH 164
 #define TILE_HEIGHT 170
 #define REFRESH_TIME (600) /* 10 minutes */
+#define REFRESH_SLACK (60) /* a refresh may be this late */
 
 static void _zeitgeist_monitor_events_inserted_signal (ZeitgeistMonitor *m,
       ZeitgeistTimeRange *time_range,
@@ -108,7 +110,7 @@ penge_everything_pane_dispose (GObject *object)
 
   if (priv->refresh_id != 0)
   {
-    g_source_remove (priv->refresh_id);
+    mpl_timer_remove (priv->refresh_id);
     priv->refresh_id = 0;
   }
 
@@ -1018,6 +1020,10 @@ penge_everything_pane_init (PengeEverythingPane *self)
     gconf_client_notify (priv->gconf_client, DAWATI_MYZONE_RATIO);
   }
 
-  priv->refresh_id = g_timeout_add_seconds (REFRESH_TIME, (GSourceFunc) _refresh_cb, self);
+  priv->refresh_id = mpl_timer_add (REFRESH_TIME * 1000,
+                                     REFRESH_SLACK * 1000,
+                                     CLUTTER_ACTOR (self),
+                                     (GSourceFunc) _refresh_cb,
+                                     self);
 }
 
@@ -34,8 +34,13 @@ static void mnb_alttab_overlay_app_origin_weak_notify (gpointer, GObject *);
 struct _MnbAlttabOverlayAppPrivate
 {
   MetaWindowActor *mcw;     /* MetaWindowActor we represent */
+  MetaWindow      *mw;      /* its window, weak; we have handlers on it */
+  ClutterActor    *thumbnail;
+  CoglHandle       texture;  /* window texture the thumbnail shows */
 
-  gboolean      active   : 1;
+  gboolean      active      : 1;
+  gboolean      title_dirty : 1;
+  gboolean      icon_dirty  : 1;
 };
 
 enum
@@ -52,11 +57,27 @@ G_DEFINE_TYPE (MnbAlttabOverlayApp, mnb_alttab_overlay_app, MPL_TYPE_APPLICATION
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MNB_TYPE_ALTTAB_OVERLAY_APP,\
                                 MnbAlttabOverlayAppPrivate))
 
+static void
+mnb_alttab_overlay_app_release_window (MnbAlttabOverlayApp *app)
+{
+  MnbAlttabOverlayAppPrivate *priv = app->priv;
+
+  if (!priv->mw)
+    return;
+
+  g_signal_handlers_disconnect_matched (priv->mw, G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL, app);
+  g_object_remove_weak_pointer (G_OBJECT (priv->mw), (gpointer *) &priv->mw);
+  priv->mw = NULL;
+}
+
 static void
 mnb_alttab_overlay_app_dispose (GObject *object)
 {
   MnbAlttabOverlayAppPrivate *priv = MNB_ALTTAB_OVERLAY_APP (object)->priv;
 
+  mnb_alttab_overlay_app_release_window (MNB_ALTTAB_OVERLAY_APP (object));
+
   if (priv->mcw)
     {
       g_object_weak_unref (G_OBJECT (priv->mcw),
@@ -113,12 +134,37 @@ mnb_alttab_overlay_app_get_property (GObject    *gobject,
 static void
 mnb_alttab_overlay_app_origin_weak_notify (gpointer data, GObject *obj)
 {
-  ClutterActor *self = data;
+  ClutterActor               *self = data;
+  ClutterActor               *parent = clutter_actor_get_parent (self);
+  MnbAlttabOverlayAppPrivate *priv = MNB_ALTTAB_OVERLAY_APP (self)->priv;
+
+  mnb_alttab_overlay_app_release_window (MNB_ALTTAB_OVERLAY_APP (self));
+
+  priv->mcw = NULL;
+  priv->texture = NULL;
 
   /*
-   * The original MutterWindow destroyed, destroy self.
+   * The original MutterWindow destroyed, remove self from the overlay; when
+   * not shown, the overlay pool drops us on its own.
    */
-  clutter_actor_remove_child (clutter_actor_get_parent (self), self);
+  if (parent)
+    clutter_actor_remove_child (parent, self);
+}
+
+static void
+mnb_alttab_overlay_app_title_notify_cb (MetaWindow          *mw,
+                                        GParamSpec          *pspec,
+                                        MnbAlttabOverlayApp *app)
+{
+  app->priv->title_dirty = TRUE;
+}
+
+static void
+mnb_alttab_overlay_app_icon_notify_cb (MetaWindow          *mw,
+                                       GParamSpec          *pspec,
+                                       MnbAlttabOverlayApp *app)
+{
+  app->priv->icon_dirty = TRUE;
 }
 
 static void
@@ -148,26 +194,11 @@ mnb_alttab_overlay_app_init (MnbAlttabOverlayApp *self)
   self->priv = MNB_ALTTAB_OVERLAY_APP_GET_PRIVATE (self);
 }
 
-MnbAlttabOverlayApp *
-mnb_alttab_overlay_app_new (MetaWindowActor *mcw)
+static ClutterActor *
+mnb_alttab_overlay_app_make_icon (MetaWindow *mw)
 {
-  MetaWindow   *mw;
   GdkPixbuf    *pixbuf = NULL;
-  CoglHandle    cogl_texture;
-  ClutterActor *meta_texture;
-  ClutterActor *icon = NULL, *thumbnail;
-
-  g_return_val_if_fail (META_IS_WINDOW_ACTOR (mcw), NULL);
-
-  mw = meta_window_actor_get_meta_window (mcw);
-
-  meta_texture = meta_window_actor_get_texture (mcw);
-  cogl_texture =
-    meta_shaped_texture_get_texture (META_SHAPED_TEXTURE (meta_texture));
-
-  thumbnail = clutter_texture_new ();
-  clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (thumbnail), cogl_texture);
-  clutter_texture_set_keep_aspect_ratio (CLUTTER_TEXTURE (thumbnail), TRUE);
+  ClutterActor *icon = NULL;
 
   g_object_get (mw, "icon", &pixbuf, NULL);
 
@@ -186,14 +217,96 @@ mnb_alttab_overlay_app_new (MetaWindowActor *mcw)
       g_object_unref (pixbuf);
     }
 
-  return g_object_new (MNB_TYPE_ALTTAB_OVERLAY_APP,
-                       "mutter-window", mcw,
-                       "icon", icon,
-                       "title", meta_window_get_description (mw),
-                       "subtitle", meta_window_get_title (mw),
-                       "thumbnail", thumbnail,
-                       "can-close", FALSE,
-                       NULL);
+  return icon;
+}
+
+MnbAlttabOverlayApp *
+mnb_alttab_overlay_app_new (MetaWindowActor *mcw)
+{
+  MnbAlttabOverlayApp *app;
+  MetaWindow          *mw;
+  ClutterActor        *thumbnail;
+
+  g_return_val_if_fail (META_IS_WINDOW_ACTOR (mcw), NULL);
+
+  mw = meta_window_actor_get_meta_window (mcw);
+
+  thumbnail = clutter_texture_new ();
+  clutter_texture_set_keep_aspect_ratio (CLUTTER_TEXTURE (thumbnail), TRUE);
+
+  app = g_object_new (MNB_TYPE_ALTTAB_OVERLAY_APP,
+                      "mutter-window", mcw,
+                      "icon", mnb_alttab_overlay_app_make_icon (mw),
+                      "title", meta_window_get_description (mw),
+                      "subtitle", meta_window_get_title (mw),
+                      "thumbnail", thumbnail,
+                      "can-close", FALSE,
+                      NULL);
+
+  app->priv->thumbnail = thumbnail;
+  app->priv->mw = mw;
+  g_object_add_weak_pointer (G_OBJECT (mw), (gpointer *) &app->priv->mw);
+
+  g_signal_connect (mw, "notify::title",
+                    G_CALLBACK (mnb_alttab_overlay_app_title_notify_cb), app);
+  g_signal_connect (mw, "notify::icon",
+                    G_CALLBACK (mnb_alttab_overlay_app_icon_notify_cb), app);
+
+  mnb_alttab_overlay_app_refresh (app);
+
+  return app;
+}
+
+/*
+ * Brings a pooled app up to date with its window before it is shown again.
+ *
+ * The thumbnail shares the window's own texture, so window damage shows up in
+ * it for free; it only needs rebinding when the window got a new pixmap (e.g.,
+ * after a resize). Title and icon are only redone if they changed.
+ */
+void
+mnb_alttab_overlay_app_refresh (MnbAlttabOverlayApp *app)
+{
+  MnbAlttabOverlayAppPrivate *priv;
+  MetaWindow                 *mw;
+  ClutterActor               *meta_texture;
+  CoglHandle                  cogl_texture;
+
+  g_return_if_fail (MNB_IS_ALTTAB_OVERLAY_APP (app));
+
+  priv = app->priv;
+
+  if (!priv->mcw)
+    return;
+
+  mw = meta_window_actor_get_meta_window (priv->mcw);
+
+  meta_texture = meta_window_actor_get_texture (priv->mcw);
+  cogl_texture =
+    meta_shaped_texture_get_texture (META_SHAPED_TEXTURE (meta_texture));
+
+  if (cogl_texture != priv->texture)
+    {
+      clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (priv->thumbnail),
+                                        cogl_texture);
+      priv->texture = cogl_texture;
+    }
+
+  if (priv->title_dirty)
+    {
+      mpl_application_view_set_title (MPL_APPLICATION_VIEW (app),
+                                      meta_window_get_description (mw));
+      mpl_application_view_set_subtitle (MPL_APPLICATION_VIEW (app),
+                                         meta_window_get_title (mw));
+      priv->title_dirty = FALSE;
+    }
+
+  if (priv->icon_dirty)
+    {
+      mpl_application_view_set_icon (MPL_APPLICATION_VIEW (app),
+                                     mnb_alttab_overlay_app_make_icon (mw));
+      priv->icon_dirty = FALSE;
+    }
 }
 
 void
@@ -62,6 +62,8 @@ GType mnb_alttab_overlay_app_get_type (void);
 
 MnbAlttabOverlayApp *mnb_alttab_overlay_app_new (MetaWindowActor *mcw);
 
+void             mnb_alttab_overlay_app_refresh    (MnbAlttabOverlayApp *app);
+
 void             mnb_alttab_overlay_app_set_active (MnbAlttabOverlayApp *app,
                                                     gboolean             active);
 gboolean         mnb_alttab_overlay_app_get_active (MnbAlttabOverlayApp *app);
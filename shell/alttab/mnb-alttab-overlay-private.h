@@ -43,6 +43,10 @@ struct _MnbAlttabOverlayPrivate
   /* gfloat               scroll_y; */
   guint                current_row;
 
+  GQueue               mru;        /* MetaWindow, most recently used first */
+  GHashTable          *mru_links;  /* MetaWindow -> link in mru */
+  GHashTable          *apps;       /* MetaWindow -> pooled MnbAlttabOverlayApp */
+
   gboolean disposed            : 1;
   gboolean in_alt_grab         : 1;
   gboolean alt_tab_down        : 1;
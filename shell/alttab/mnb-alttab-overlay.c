@@ -74,40 +74,147 @@ mnb_alttab_overlay_get_property (GObject    *gobject,
     }
 }
 
-static gint
-sort_windows_by_user_time (gconstpointer a, gconstpointer b)
+/*
+ * The MRU list is kept up to date as windows come, go and get focused, so
+ * that Alt+Tab does not need to collect and sort the windows every time.
+ */
+static void
+mnb_alttab_overlay_window_unmanaged_cb (MetaWindow       *window,
+                                        MnbAlttabOverlay *overlay)
 {
-  MetaWindowActor *m1 = (MetaWindowActor*) a;
-  MetaWindowActor *m2 = (MetaWindowActor*) b;
-  MetaWindow   *w1 = meta_window_actor_get_meta_window (m1);
-  MetaWindow   *w2 = meta_window_actor_get_meta_window (m2);
-  guint32       t1 = meta_window_get_user_time (w1);
-  guint32       t2 = meta_window_get_user_time (w2);
-
-  if (t1 > t2)
-    return -1;
-  else if (t2 > t1)
-    return 1;
-
-  return 0;
+  MnbAlttabOverlayPrivate *priv = overlay->priv;
+  GList                   *link;
+
+  if ((link = g_hash_table_lookup (priv->mru_links, window)))
+    {
+      g_queue_delete_link (&priv->mru, link);
+      g_hash_table_remove (priv->mru_links, window);
+    }
+
+  g_hash_table_remove (priv->apps, window);
+
+  g_signal_handlers_disconnect_by_func (window,
+                                        mnb_alttab_overlay_window_unmanaged_cb,
+                                        overlay);
 }
 
-GList *
-mnb_alttab_overlay_get_app_list (MnbAlttabOverlay *self)
+static void
+mnb_alttab_overlay_track_window (MnbAlttabOverlay *overlay,
+                                 MetaWindow       *window)
+{
+  MnbAlttabOverlayPrivate *priv = overlay->priv;
+  guint32                  user_time = meta_window_get_user_time (window);
+  GList                   *l;
+
+  if (g_hash_table_lookup (priv->mru_links, window))
+    return;
+
+  /*
+   * Slot in by user time; new windows normally end up at the head, and then
+   * get moved there by the focus change anyway.
+   */
+  for (l = priv->mru.head; l; l = l->next)
+    if (meta_window_get_user_time (l->data) < user_time)
+      break;
+
+  if (l)
+    {
+      g_queue_insert_before (&priv->mru, l, window);
+      l = l->prev;
+    }
+  else
+    {
+      g_queue_push_tail (&priv->mru, window);
+      l = priv->mru.tail;
+    }
+
+  g_hash_table_insert (priv->mru_links, window, l);
+
+  g_signal_connect (window, "unmanaged",
+                    G_CALLBACK (mnb_alttab_overlay_window_unmanaged_cb),
+                    overlay);
+}
+
+static void
+mnb_alttab_overlay_window_created_cb (MetaDisplay      *display,
+                                      MetaWindow       *window,
+                                      MnbAlttabOverlay *overlay)
 {
-  MetaPlugin   *plugin;
-  MetaScreen   *screen;
-  GList        *l, *filtered = NULL;
+  mnb_alttab_overlay_track_window (overlay, window);
+}
 
-  plugin = dawati_netbook_get_plugin_singleton ();
-  screen = meta_plugin_get_screen (plugin);
+static void
+mnb_alttab_overlay_focus_window_notify_cb (MetaDisplay      *display,
+                                           GParamSpec       *pspec,
+                                           MnbAlttabOverlay *overlay)
+{
+  MnbAlttabOverlayPrivate *priv = overlay->priv;
+  MetaWindow              *focus = meta_display_get_focus_window (display);
+  GList                   *link;
+
+  if (!focus)
+    return;
+
+  if (!(link = g_hash_table_lookup (priv->mru_links, focus)))
+    {
+      mnb_alttab_overlay_track_window (overlay, focus);
+      link = g_hash_table_lookup (priv->mru_links, focus);
+    }
+
+  if (link != priv->mru.head)
+    {
+      g_queue_unlink (&priv->mru, link);
+      g_queue_push_head_link (&priv->mru, link);
+    }
+}
+
+static void
+mnb_alttab_overlay_free_app (gpointer app)
+{
+  clutter_actor_destroy (app);
+  g_object_unref (app);
+}
+
+static void
+mnb_alttab_overlay_setup_mru (MnbAlttabOverlay *overlay)
+{
+  MnbAlttabOverlayPrivate *priv    = overlay->priv;
+  MetaPlugin              *plugin  = dawati_netbook_get_plugin_singleton ();
+  MetaScreen              *screen  = meta_plugin_get_screen (plugin);
+  MetaDisplay             *display = meta_screen_get_display (screen);
+  GList                   *l;
+
+  priv->mru_links = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->apps = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, mnb_alttab_overlay_free_app);
 
   for (l = meta_get_window_actors (screen); l; l = l->next)
+    mnb_alttab_overlay_track_window (overlay,
+                                     meta_window_actor_get_meta_window (l->data));
+
+  g_signal_connect (display, "window-created",
+                    G_CALLBACK (mnb_alttab_overlay_window_created_cb),
+                    overlay);
+  g_signal_connect (display, "notify::focus-window",
+                    G_CALLBACK (mnb_alttab_overlay_focus_window_notify_cb),
+                    overlay);
+}
+
+GList *
+mnb_alttab_overlay_get_app_list (MnbAlttabOverlay *self)
+{
+  MnbAlttabOverlayPrivate *priv = self->priv;
+  GList                   *l, *filtered = NULL;
+
+  for (l = priv->mru.head; l; l = l->next)
     {
-      MetaWindowActor *m = l->data;
-      MetaWindow      *w = meta_window_actor_get_meta_window (m);
+      MetaWindow      *w = l->data;
+      MetaWindowActor *m = (MetaWindowActor *) meta_window_get_compositor_private (w);
       MetaWindowType type;
 
+      if (!m)
+        continue;
+
       type = meta_window_get_window_type (w);
 
       if (meta_window_is_on_all_workspaces (w)   ||
@@ -139,12 +246,7 @@ mnb_alttab_overlay_get_app_list (MnbAlttabOverlay *self)
       return NULL;
     }
 
-  /*
-   * Sort the windows in MRU order
-   */
-  filtered = g_list_sort (filtered, sort_windows_by_user_time);
-
-  return filtered;
+  return g_list_reverse (filtered);
 }
 
 /*
@@ -168,9 +270,23 @@ mnb_alttab_overlay_populate (MnbAlttabOverlay *self)
   for (l = filtered; l; l = l->next)
     {
       MetaWindowActor     *m = l->data;
+      MetaWindow          *w = meta_window_actor_get_meta_window (m);
       MnbAlttabOverlayApp *app;
 
-      app = mnb_alttab_overlay_app_new (m);
+      /*
+       * Apps are built once per window and then reused.
+       */
+      if (!(app = g_hash_table_lookup (priv->apps, w)))
+        {
+          app = mnb_alttab_overlay_app_new (m);
+          g_object_ref_sink (app);
+          g_hash_table_insert (priv->apps, w, app);
+        }
+      else
+        {
+          mnb_alttab_overlay_app_refresh (app);
+          mnb_alttab_overlay_app_set_active (app, FALSE);
+        }
 
       if (!active)
         active = l->next;
@@ -196,7 +312,8 @@ mnb_alttab_overlay_populate (MnbAlttabOverlay *self)
 static void
 _remove_child (ClutterActor *child, ClutterActor *grid)
 {
-  clutter_actor_destroy (child);
+  /* The pool keeps hold of the app. */
+  clutter_actor_remove_child (grid, child);
 }
 
 static void
@@ -265,6 +382,8 @@ mnb_alttab_overlay_constructed (GObject *self)
 
   mx_stylable_set_style_class (MX_STYLABLE (self),"alttab-overlay");
 
+  mnb_alttab_overlay_setup_mru (MNB_ALTTAB_OVERLAY (self));
+
   g_signal_connect (meta_plugin_get_screen (plugin),
                     "notify::keyboard-grabbed",
                     G_CALLBACK (mnb_alttab_overlay_kbd_grab_notify_cb),
@@ -364,6 +483,50 @@ mnb_alttab_overlay_allocate (ClutterActor          *actor,
   clutter_actor_allocate (priv->scrollview, &child_box, flags);
 }
 
+static void
+mnb_alttab_overlay_dispose (GObject *object)
+{
+  MnbAlttabOverlay        *self    = MNB_ALTTAB_OVERLAY (object);
+  MnbAlttabOverlayPrivate *priv    = self->priv;
+  MetaPlugin              *plugin  = dawati_netbook_get_plugin_singleton ();
+  MetaScreen              *screen  = meta_plugin_get_screen (plugin);
+  MetaDisplay             *display = meta_screen_get_display (screen);
+  GList                   *l;
+
+  if (priv->disposed)
+    {
+      G_OBJECT_CLASS (mnb_alttab_overlay_parent_class)->dispose (object);
+      return;
+    }
+
+  priv->disposed = TRUE;
+
+  g_signal_handlers_disconnect_by_func (display,
+                                        mnb_alttab_overlay_window_created_cb,
+                                        self);
+  g_signal_handlers_disconnect_by_func (display,
+                                        mnb_alttab_overlay_focus_window_notify_cb,
+                                        self);
+  g_signal_handlers_disconnect_by_func (screen,
+                                        mnb_alttab_overlay_kbd_grab_notify_cb,
+                                        self);
+
+  for (l = priv->mru.head; l; l = l->next)
+    g_signal_handlers_disconnect_by_func (l->data,
+                                          mnb_alttab_overlay_window_unmanaged_cb,
+                                          self);
+  g_queue_clear (&priv->mru);
+
+  g_hash_table_destroy (priv->mru_links);
+  priv->mru_links = NULL;
+
+  priv->active = NULL;
+  g_hash_table_destroy (priv->apps);
+  priv->apps = NULL;
+
+  G_OBJECT_CLASS (mnb_alttab_overlay_parent_class)->dispose (object);
+}
+
 static void
 mnb_alttab_overlay_class_init (MnbAlttabOverlayClass *klass)
 {
@@ -373,6 +536,7 @@ mnb_alttab_overlay_class_init (MnbAlttabOverlayClass *klass)
   object_class->get_property         = mnb_alttab_overlay_get_property;
   object_class->set_property         = mnb_alttab_overlay_set_property;
   object_class->constructed          = mnb_alttab_overlay_constructed;
+  object_class->dispose              = mnb_alttab_overlay_dispose;
 
   actor_class->get_preferred_width   = mnb_alttab_overlay_get_preferred_width;
   actor_class->get_preferred_height  = mnb_alttab_overlay_get_preferred_height;
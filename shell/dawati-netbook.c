@@ -85,6 +85,8 @@ static const GDebugKey options_keys[] =
   { "disable-ws-clamp",           MNB_OPTION_DISABLE_WS_CLAMP },
   { "disable-panel-restart",      MNB_OPTION_DISABLE_PANEL_RESTART },
   { "composite-fullscreen-apps",  MNB_OPTION_COMPOSITE_FULLSCREEN_APPS },
+  { "live-zones-preview",         MNB_OPTION_LIVE_ZONES_PREVIEW },
+  { "show-effect-timing",         MNB_OPTION_SHOW_EFFECT_TIMING },
 };
 
 static MetaPlugin *plugin_singleton = NULL;
@@ -52,6 +52,8 @@ typedef enum
   MNB_OPTION_DISABLE_WS_CLAMP          = 1 << 1,
   MNB_OPTION_DISABLE_PANEL_RESTART     = 1 << 2,
   MNB_OPTION_COMPOSITE_FULLSCREEN_APPS = 1 << 3,
+  MNB_OPTION_LIVE_ZONES_PREVIEW        = 1 << 4,
+  MNB_OPTION_SHOW_EFFECT_TIMING        = 1 << 5,
 } MnbOptionFlag;
 
 #define DAWATI_TYPE_NETBOOK_PLUGIN            (dawati_netbook_plugin_get_type ())
@@ -25,13 +25,148 @@
 #include "mnb-switch-zones-effect.h"
 #include "mnb-fancy-bin.h"
 #include "mnb-zones-preview.h"
+#include "../dawati-netbook.h"
+
+/* How long the frame timing stays up after the effect. */
+#define TIMING_LINGER_MS 2000
+
+/* How often the frame timing is refreshed while the effect runs. */
+#define TIMING_UPDATE_MS 250
 
 static ClutterActor *zones_preview = NULL;
 static gint          running = 0;
 
+/*
+ * Frame timing, with the show-effect-timing compositor option: how long
+ * the frames of the effect took, shown in the corner of the screen.
+ */
+static ClutterActor *timing_overlay = NULL;
+static guint         timing_linger_id = 0;
+static guint         timing_update_id = 0;
+static gint64        timing_updated = 0;
+static gint64        timing_start = 0;
+static gint64        timing_last_frame = 0;
+static gint64        timing_worst = 0;
+static guint         timing_n_frames = 0;
+
+static void
+mnb_switch_zones_update_timing (gboolean done)
+{
+  gint64  elapsed = timing_last_frame - timing_start;
+  gdouble fps = 0, average = 0;
+  gchar  *text;
+
+  if (timing_n_frames > 1 && elapsed > 0)
+    {
+      fps = (timing_n_frames - 1) * (gdouble) G_USEC_PER_SEC / elapsed;
+      average = elapsed / 1000. / (timing_n_frames - 1);
+    }
+
+  text = g_strdup_printf ("%u frames, %.1f fps, %.1f ms average, "
+                          "%.1f ms worst, %u snapshots",
+                          timing_n_frames, fps, average,
+                          timing_worst / 1000.,
+                          zones_preview ?
+                            mnb_zones_preview_get_n_snapshots (
+                              MNB_ZONES_PREVIEW (zones_preview)) : 0);
+  clutter_text_set_text (CLUTTER_TEXT (timing_overlay), text);
+
+  if (done)
+    g_debug ("Switch zones effect: %s", text);
+
+  g_free (text);
+}
+
+static gboolean
+mnb_switch_zones_timing_update_cb (gpointer data)
+{
+  timing_update_id = 0;
+
+  if (timing_overlay)
+    mnb_switch_zones_update_timing (FALSE);
+
+  return FALSE;
+}
+
+static void
+mnb_switch_zones_paint_cb (ClutterActor *preview, gpointer data)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (timing_n_frames++ == 0)
+    timing_start = now;
+  else
+    timing_worst = MAX (timing_worst, now - timing_last_frame);
+
+  timing_last_frame = now;
+
+  /* The text is not changed from within the paint, the next frame shows
+   * it. */
+  if (!timing_update_id &&
+      now - timing_updated >= TIMING_UPDATE_MS * (gint64) 1000)
+    {
+      timing_updated = now;
+      timing_update_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                          mnb_switch_zones_timing_update_cb,
+                                          NULL, NULL);
+    }
+}
+
+static gboolean
+mnb_switch_zones_timing_linger_cb (gpointer data)
+{
+  clutter_actor_destroy (timing_overlay);
+  timing_overlay = NULL;
+  timing_linger_id = 0;
+
+  return FALSE;
+}
+
+static void
+mnb_switch_zones_start_timing (ClutterActor *stage)
+{
+  if (timing_linger_id)
+    {
+      g_source_remove (timing_linger_id);
+      timing_linger_id = 0;
+    }
+
+  if (!timing_overlay)
+    {
+      ClutterColor color = { 0xff, 0xff, 0x00, 0xff };
+
+      timing_overlay = clutter_text_new_full ("Monospace 10", "", &color);
+      clutter_actor_set_position (timing_overlay, 8, 8);
+      clutter_actor_add_child (stage, timing_overlay);
+    }
+
+  clutter_actor_set_child_above_sibling (stage, timing_overlay, NULL);
+
+  timing_n_frames = 0;
+  timing_worst = 0;
+  timing_updated = 0;
+
+  g_signal_connect_after (zones_preview, "paint",
+                          G_CALLBACK (mnb_switch_zones_paint_cb), NULL);
+}
+
 static void
 mnb_switch_zones_completed_cb (MnbZonesPreview *preview, MetaPlugin *plugin)
 {
+  if (timing_update_id)
+    {
+      g_source_remove (timing_update_id);
+      timing_update_id = 0;
+    }
+
+  if (timing_overlay)
+    {
+      mnb_switch_zones_update_timing (TRUE);
+      timing_linger_id = g_timeout_add (TIMING_LINGER_MS,
+                                        mnb_switch_zones_timing_linger_cb,
+                                        NULL);
+    }
+
   clutter_actor_destroy (zones_preview);
   zones_preview = NULL;
 
@@ -91,6 +226,7 @@ mnb_switch_zones_effect (MetaPlugin         *plugin,
   if (!zones_preview)
     {
       ClutterActor *stage;
+      guint32       flags = dawati_netbook_get_compositor_option_flags ();
 
       /* Construct the zones preview actor */
       zones_preview = mnb_zones_preview_new ();
@@ -98,10 +234,17 @@ mnb_switch_zones_effect (MetaPlugin         *plugin,
                     "workspace", (gdouble)from,
                     NULL);
 
+      if (flags & MNB_OPTION_LIVE_ZONES_PREVIEW)
+        mnb_zones_preview_set_use_snapshots (MNB_ZONES_PREVIEW (zones_preview),
+                                             FALSE);
+
       /* Add it to the stage */
       stage = meta_get_stage_for_screen (screen);
       clutter_actor_add_child (stage, zones_preview);
 
+      if (flags & MNB_OPTION_SHOW_EFFECT_TIMING)
+        mnb_switch_zones_start_timing (stage);
+
       /* Attach to completed signal */
       g_signal_connect (zones_preview, "switch-completed",
                         G_CALLBACK (mnb_switch_zones_completed_cb), plugin);
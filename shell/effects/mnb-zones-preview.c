@@ -54,6 +54,29 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+/* Zoom level while panning between workspaces. */
+#define ZONES_PAN_ZOOM 0.75
+
+/* Workspace snapshots are rendered at the size they are shown at while
+ * panning; they are a bit soft while zooming in and out, which is brief. */
+#define ZONES_SNAPSHOT_SCALE ZONES_PAN_ZOOM
+
+/*
+ * A workspace rendered once into a small texture, so that the animation
+ * paints a few small textures rather than every window at full size. It
+ * is rendered on first paint, when the clones are allocated, and again
+ * only when one of the windows on the workspace is damaged.
+ */
+typedef struct
+{
+  CoglHandle  texture;
+  CoglHandle  offscreen;
+  CoglHandle  material;
+  gboolean    valid;
+} ZoneSnapshot;
+
+static GQuark snapshot_quark = 0;
+
 typedef enum
 {
   MNB_ZP_STATIC,
@@ -73,6 +96,8 @@ struct _MnbZonesPreviewPrivate
   guint                 width;
   guint                 height;
   MnbZonesPreviewPhase  anim_phase;
+  gboolean              use_snapshots;
+  guint                 n_snapshots;   /* rendered, for the statistics */
 };
 
 static void
@@ -289,6 +314,8 @@ mnb_zones_preview_class_init (MnbZonesPreviewClass *klass)
 
   g_type_class_add_private (klass, sizeof (MnbZonesPreviewPrivate));
 
+  snapshot_quark = g_quark_from_static_string ("mnb-zones-preview-snapshot");
+
   object_class->get_property = mnb_zones_preview_get_property;
   object_class->set_property = mnb_zones_preview_set_property;
   object_class->dispose = mnb_zones_preview_dispose;
@@ -396,6 +423,7 @@ mnb_zones_preview_init (MnbZonesPreview *self)
 
   priv->zoom = 1.0;
   priv->spacing = 0;
+  priv->use_snapshots = TRUE;
   priv->dest_workspace = -1;
   priv->workspace_bg = meta_background_actor_new_for_screen (screen);
   clutter_actor_add_child (CLUTTER_ACTOR (self), priv->workspace_bg);
@@ -424,7 +452,7 @@ mnb_zones_preview_completed_cb (ClutterAnimation *animation,
       clutter_actor_animate (CLUTTER_ACTOR (preview),
                              CLUTTER_EASE_IN_SINE,
                              220,
-                             "zoom", 0.75,
+                             "zoom", ZONES_PAN_ZOOM,
                              NULL);
       break;
 
@@ -550,6 +578,121 @@ mnb_zones_preview_change_workspace (MnbZonesPreview *preview,
     }
 }
 
+static void
+zone_snapshot_free (ZoneSnapshot *snapshot)
+{
+  if (snapshot->material)
+    cogl_handle_unref (snapshot->material);
+  if (snapshot->offscreen)
+    cogl_handle_unref (snapshot->offscreen);
+  if (snapshot->texture)
+    cogl_handle_unref (snapshot->texture);
+  g_slice_free (ZoneSnapshot, snapshot);
+}
+
+static gboolean
+mnb_zones_preview_render_snapshot (MnbZonesPreview *preview,
+                                   ClutterActor    *group,
+                                   ZoneSnapshot    *snapshot)
+{
+  MnbZonesPreviewPrivate *priv = preview->priv;
+  CoglMatrix              identity;
+  CoglColor               transparent;
+  GList                  *children, *c;
+
+  if (!snapshot->texture)
+    {
+      guint width = MAX (1, priv->width * ZONES_SNAPSHOT_SCALE);
+      guint height = MAX (1, priv->height * ZONES_SNAPSHOT_SCALE);
+
+      snapshot->texture =
+        cogl_texture_new_with_size (width, height,
+                                    COGL_TEXTURE_NO_SLICING,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+      if (snapshot->texture == COGL_INVALID_HANDLE)
+        return FALSE;
+
+      snapshot->offscreen = cogl_offscreen_new_to_texture (snapshot->texture);
+      if (snapshot->offscreen == COGL_INVALID_HANDLE)
+        {
+          cogl_handle_unref (snapshot->texture);
+          snapshot->texture = COGL_INVALID_HANDLE;
+          return FALSE;
+        }
+
+      snapshot->material = cogl_material_new ();
+      cogl_material_set_layer (snapshot->material, 0, snapshot->texture);
+    }
+
+  /* Map the full workspace onto the small texture. */
+  cogl_push_framebuffer (snapshot->offscreen);
+  cogl_ortho (0, priv->width, priv->height, 0, -1, 1);
+  cogl_matrix_init_identity (&identity);
+  cogl_set_modelview_matrix (&identity);
+  cogl_color_init_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  children = clutter_actor_get_children (group);
+  for (c = children; c; c = c->next)
+    clutter_actor_paint (CLUTTER_ACTOR (c->data));
+  g_list_free (children);
+
+  cogl_pop_framebuffer ();
+
+  snapshot->valid = TRUE;
+  priv->n_snapshots++;
+
+  return TRUE;
+}
+
+/*
+ * Paints the snapshot in place of the windows, by stopping the emission
+ * before the group gets to paint its children.
+ */
+static void
+mnb_zones_preview_group_paint_cb (ClutterActor    *group,
+                                  MnbZonesPreview *preview)
+{
+  MnbZonesPreviewPrivate *priv = preview->priv;
+  ZoneSnapshot           *snapshot;
+  guint8                  opacity;
+
+  if (!priv->use_snapshots || !priv->width || !priv->height)
+    return;
+
+  snapshot = g_object_get_qdata (G_OBJECT (group), snapshot_quark);
+  if (!snapshot->valid &&
+      !mnb_zones_preview_render_snapshot (preview, group, snapshot))
+    return;
+
+  opacity = clutter_actor_get_paint_opacity (group);
+  cogl_material_set_color4ub (snapshot->material,
+                              opacity, opacity, opacity, opacity);
+  cogl_set_source (snapshot->material);
+  cogl_rectangle (0, 0, priv->width, priv->height);
+
+  g_signal_stop_emission_by_name (group, "paint");
+}
+
+/*
+ * Damage to a window shows up as a redraw queued on its clone; redraws of
+ * the group itself come from moving it around and do not change what is
+ * in it.
+ */
+static void
+mnb_zones_preview_group_queue_redraw_cb (ClutterActor    *group,
+                                         ClutterActor    *origin,
+                                         MnbZonesPreview *preview)
+{
+  ZoneSnapshot *snapshot;
+
+  if (origin == group)
+    return;
+
+  snapshot = g_object_get_qdata (G_OBJECT (group), snapshot_quark);
+  snapshot->valid = FALSE;
+}
+
 /* Gets the desired workspace and creates any workspaces
  * necessary before it.
  */
@@ -582,6 +725,16 @@ mnb_zones_preview_get_workspace_group (MnbZonesPreview *preview,
       clutter_actor_set_clip (group, 0, 0, priv->width, priv->height);
       mnb_fancy_bin_set_child (MNB_FANCY_BIN (bin), group);
 
+      g_object_set_qdata_full (G_OBJECT (group), snapshot_quark,
+                               g_slice_new0 (ZoneSnapshot),
+                               (GDestroyNotify) zone_snapshot_free);
+      g_signal_connect (group, "paint",
+                        G_CALLBACK (mnb_zones_preview_group_paint_cb),
+                        preview);
+      g_signal_connect (group, "queue-redraw",
+                        G_CALLBACK (mnb_zones_preview_group_queue_redraw_cb),
+                        preview);
+
       clutter_actor_add_child (CLUTTER_ACTOR (preview), bin);
 
       /* This is a bit of a hack, depending on the fact that GList
@@ -699,3 +852,29 @@ mnb_zones_preview_clear (MnbZonesPreview *preview)
   clutter_actor_queue_relayout (CLUTTER_ACTOR (preview));
 }
 
+/*
+ * Whether to paint workspaces from snapshots, which is the default, or
+ * paint the windows live in every frame.
+ */
+void
+mnb_zones_preview_set_use_snapshots (MnbZonesPreview *preview,
+                                     gboolean         use_snapshots)
+{
+  MnbZonesPreviewPrivate *priv = preview->priv;
+
+  if (priv->use_snapshots == use_snapshots)
+    return;
+
+  priv->use_snapshots = use_snapshots;
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (preview));
+}
+
+/*
+ * How many workspace snapshots have been rendered, including re-renders
+ * after damage.
+ */
+guint
+mnb_zones_preview_get_n_snapshots (MnbZonesPreview *preview)
+{
+  return preview->priv->n_snapshots;
+}
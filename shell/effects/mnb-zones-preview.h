@@ -83,6 +83,11 @@ void mnb_zones_preview_set_n_workspaces (MnbZonesPreview *preview,
 
 void mnb_zones_preview_clear (MnbZonesPreview *preview);
 
+void mnb_zones_preview_set_use_snapshots (MnbZonesPreview *preview,
+                                          gboolean         use_snapshots);
+
+guint mnb_zones_preview_get_n_snapshots (MnbZonesPreview *preview);
+
 G_END_DECLS
 
 #endif /* _MNB_ZONES_PREVIEW_H */
@@ -24,6 +24,7 @@
 
 #include "mnb-input-manager.h"
 
+#include <cairo.h>
 #include <meta/display.h>
 
 static MnbInputManager *mgr_singleton = NULL;
@@ -74,24 +75,46 @@ static GQuark           quark_mir;
  * Each region remains on the stack until it is explicitely removed, using the
  * region ID obtained during the stack push.
  *
+ * The stack is combined client-side: for each layer we keep the composite of
+ * that layer and all the layers below it, so a change only requires the
+ * changed layer and those above it to be recombined. Changes are not applied
+ * straight away, but collected and applied once per frame from an idle
+ * callback; the X server only hears about the result if it differs from
+ * what it already has.
+ *
  * The individual functions are commented on below.
  */
 
+#define N_LAYERS (MNB_INPUT_LAYER_TOP + 1)
+
 static void mnb_input_manager_apply_stack (void);
 
 struct MnbInputRegion
 {
   XRectangle    rect;
-  XserverRegion region;
   gboolean      inverse;
   MnbInputLayer layer;
 };
 
 struct MnbInputManager
 {
-  MetaPlugin   *plugin;
-  GList        *layers[MNB_INPUT_LAYER_TOP + 1];
-  XserverRegion current_region;
+  MetaPlugin     *plugin;
+  GList          *layers[N_LAYERS];
+  XserverRegion   current_region;
+
+  /* Composite of each layer and the layers below it. */
+  cairo_region_t *composites[N_LAYERS];
+  /* What current_region was last set to. */
+  cairo_region_t *applied;
+  /* Lowest layer that changed since the last update, N_LAYERS if none. */
+  gint            dirty_layer;
+  guint           update_id;
+
+  /* Statistics, reported with g_debug(). */
+  gint64          stats_start;
+  guint           n_changes;
+  guint           n_recomputes;
+  guint           n_server_updates;
 };
 
 void
@@ -105,6 +128,8 @@ mnb_input_manager_create (MetaPlugin *plugin)
   mgr_singleton = g_new0(MnbInputManager, 1);
 
   mgr_singleton->plugin = plugin;
+  mgr_singleton->dirty_layer = N_LAYERS;
+  mgr_singleton->stats_start = g_get_monotonic_time ();
 
   quark_mir = g_quark_from_static_string ("MNB-INPUT-MANAGER-mir");
 }
@@ -124,7 +149,10 @@ mnb_input_manager_destroy ()
   display = meta_screen_get_display (screen);
   xdpy = meta_display_get_xdisplay (display);
 
-  for (i = 0; i <= MNB_INPUT_LAYER_TOP; ++i)
+  if (mgr_singleton->update_id)
+    g_source_remove (mgr_singleton->update_id);
+
+  for (i = 0; i < N_LAYERS; ++i)
     {
       l = o = mgr_singleton->layers[i];
 
@@ -132,16 +160,20 @@ mnb_input_manager_destroy ()
         {
           MnbInputRegion *mir = l->data;
 
-          XFixesDestroyRegion (xdpy, mir->region);
-
           g_slice_free (MnbInputRegion, mir);
 
           l = l->next;
         }
 
       g_list_free (o);
+
+      if (mgr_singleton->composites[i])
+        cairo_region_destroy (mgr_singleton->composites[i]);
     }
 
+  if (mgr_singleton->applied)
+    cairo_region_destroy (mgr_singleton->applied);
+
   if (mgr_singleton->current_region)
     XFixesDestroyRegion (xdpy, mgr_singleton->current_region);
 
@@ -149,11 +181,88 @@ mnb_input_manager_destroy ()
   mgr_singleton = NULL;
 }
 
+static void
+mnb_input_manager_report_stats (void)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 elapsed = now - mgr_singleton->stats_start;
+
+  if (elapsed < G_USEC_PER_SEC)
+    return;
+
+  g_debug ("Input shape: %.1f region changes/s, %.1f recomputes/s, "
+           "%.1f server updates/s",
+           mgr_singleton->n_changes * (gdouble) G_USEC_PER_SEC / elapsed,
+           mgr_singleton->n_recomputes * (gdouble) G_USEC_PER_SEC / elapsed,
+           mgr_singleton->n_server_updates * (gdouble) G_USEC_PER_SEC / elapsed);
+
+  mgr_singleton->stats_start = now;
+  mgr_singleton->n_changes = 0;
+  mgr_singleton->n_recomputes = 0;
+  mgr_singleton->n_server_updates = 0;
+}
+
+static gboolean
+mnb_input_manager_update_cb (gpointer data)
+{
+  mgr_singleton->update_id = 0;
+
+  mnb_input_manager_apply_stack ();
+  mnb_input_manager_report_stats ();
+
+  return FALSE;
+}
+
+/*
+ * Marks the given layer as changed and schedules an update of the input
+ * shape. The update runs ahead of the next redraw, so all the changes made
+ * while laying out a frame result in a single update.
+ */
+static void
+mnb_input_manager_queue_update (MnbInputLayer layer)
+{
+  g_assert (mgr_singleton);
+
+  mgr_singleton->n_changes++;
+
+  if (layer < mgr_singleton->dirty_layer)
+    mgr_singleton->dirty_layer = layer;
+
+  if (!mgr_singleton->update_id)
+    mgr_singleton->update_id =
+      g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                       mnb_input_manager_update_cb,
+                       NULL, NULL);
+}
+
+/*
+ * Moves or resizes an existing region; nothing needs to happen if the
+ * geometry did not actually change, which is common with allocations.
+ */
+static void
+mnb_input_manager_set_region_rect (MnbInputRegion *mir,
+                                   gint            x,
+                                   gint            y,
+                                   guint           width,
+                                   guint           height)
+{
+  if (mir->rect.x == x && mir->rect.y == y &&
+      mir->rect.width == width && mir->rect.height == height)
+    return;
+
+  mir->rect.x       = x;
+  mir->rect.y       = y;
+  mir->rect.width   = width;
+  mir->rect.height  = height;
+
+  mnb_input_manager_queue_update (mir->layer);
+}
+
 /*
  * mnb_input_manager_push_region ()
  *
  * Pushes region of the given dimensions onto the input region stack; this is
- * immediately reflected in the actual input shape.
+ * reflected in the actual input shape before the next frame is drawn.
  *
  * x, y, width, height: region position and size (screen-relative)
  *
@@ -175,29 +284,21 @@ mnb_input_manager_push_region (gint          x,
                                MnbInputLayer layer)
 {
   MnbInputRegion *mir  = g_slice_alloc (sizeof (MnbInputRegion));
-  MetaScreen     *screen;
-  MetaDisplay    *display;
-  Display        *xdpy;
 
   g_assert (mgr_singleton && layer >= 0 && layer <= MNB_INPUT_LAYER_TOP);
 
-  screen = meta_plugin_get_screen (mgr_singleton->plugin);
-  display = meta_screen_get_display (screen);
-  xdpy = meta_display_get_xdisplay (display);
-
   mir->rect.x       = x;
   mir->rect.y       = y;
   mir->rect.width   = width;
   mir->rect.height  = height;
 
   mir->inverse = inverse;
-  mir->region  = XFixesCreateRegion (xdpy, &mir->rect, 1);
   mir->layer   = layer;
 
   mgr_singleton->layers[layer] =
     g_list_append (mgr_singleton->layers[layer], mir);
 
-  mnb_input_manager_apply_stack ();
+  mnb_input_manager_queue_update (layer);
 
   return mir;
 }
@@ -205,8 +306,9 @@ mnb_input_manager_push_region (gint          x,
 /*
  * mnb_input_manager_remove_region ()
  *
- * Removes region previously pushed onto the stack with This change is
- * immediately applied to the actual input shape.
+ * Removes region previously pushed onto the stack with
+ * mnb_input_manager_push_region(). This change is applied to the actual input
+ * shape before the next frame is drawn.
  *
  * mir: the region ID returned by mnb_input_manager_push_region().
  */
@@ -214,87 +316,126 @@ void
 mnb_input_manager_remove_region (MnbInputRegion  *mir)
 {
   mnb_input_manager_remove_region_without_update (mir);
-  mnb_input_manager_apply_stack ();
 }
 
 /*
  * mnb_input_manager_remove_region_without_update()
  *
- * Removes region previously pushed onto the stack.  This changes does not
- * immediately filter into the actual input shape; this is useful if you need to
- * replace an existing region, as it saves round trip to the server.
+ * Removes region previously pushed onto the stack. Since updates are batched
+ * per frame this is now the same as mnb_input_manager_remove_region(); it is
+ * kept for callers replacing an existing region.
  *
  * mir: the region ID returned by mnb_input_manager_push_region().
  */
 void
 mnb_input_manager_remove_region_without_update (MnbInputRegion *mir)
 {
-  MetaScreen  *screen;
-  MetaDisplay *display;
-  Display     *xdpy;
-
   g_assert (mgr_singleton);
 
-  screen = meta_plugin_get_screen (mgr_singleton->plugin);
-  display = meta_screen_get_display (screen);
-  xdpy = meta_display_get_xdisplay (display);
-
-  if (mir->region)
-    XFixesDestroyRegion (xdpy, mir->region);
-
   mgr_singleton->layers[mir->layer]
     = g_list_remove (mgr_singleton->layers[mir->layer], mir);
 
+  mnb_input_manager_queue_update (mir->layer);
+
   g_slice_free (MnbInputRegion, mir);
 }
 
 /*
- * Applies the current input shape base and stack to the stage input shape.
+ * Recombines the changed layers of the stack, and if the resulting shape
+ * differs from the current one, applies it to the stage input shape.
  * This function is for internal use only and should not be used outside of the
  * actual implementation of the input shape stack.
  */
 static void
 mnb_input_manager_apply_stack (void)
 {
-  MetaScreen    *screen;
-  MetaDisplay   *display;
-  Display       *xdpy;
-  GList         *l;
-  gint           i;
-  XserverRegion  result;
+  MetaScreen     *screen;
+  MetaDisplay    *display;
+  Display        *xdpy;
+  GList          *l;
+  gint            i;
+  cairo_region_t *result;
+  XRectangle     *rects;
+  gint            n_rects;
 
   g_assert (mgr_singleton);
 
-  screen = meta_plugin_get_screen (mgr_singleton->plugin);
-  display = meta_screen_get_display (screen);
-  xdpy = meta_display_get_xdisplay (display);
-
-  if (mgr_singleton->current_region)
-    XFixesDestroyRegion (xdpy, mgr_singleton->current_region);
+  if (mgr_singleton->dirty_layer >= N_LAYERS)
+    return;
 
-  result = mgr_singleton->current_region = XFixesCreateRegion (xdpy, NULL, 0);
+  mgr_singleton->n_recomputes++;
 
-  for (i = 0; i <= MNB_INPUT_LAYER_TOP; ++i)
+  for (i = mgr_singleton->dirty_layer; i < N_LAYERS; ++i)
     {
-      l = mgr_singleton->layers[i];
+      cairo_region_t *composite;
 
-      if (!l)
-        continue;
+      if (i == 0)
+        composite = cairo_region_create ();
+      else
+        composite = cairo_region_copy (mgr_singleton->composites[i - 1]);
 
-      while (l)
+      for (l = mgr_singleton->layers[i]; l; l = l->next)
         {
-          MnbInputRegion *mir = l->data;
+          MnbInputRegion        *mir = l->data;
+          cairo_rectangle_int_t  rect;
+
+          rect.x      = mir->rect.x;
+          rect.y      = mir->rect.y;
+          rect.width  = mir->rect.width;
+          rect.height = mir->rect.height;
 
           if (mir->inverse)
-            XFixesSubtractRegion (xdpy, result, result, mir->region);
+            cairo_region_subtract_rectangle (composite, &rect);
           else
-            XFixesUnionRegion (xdpy, result, result, mir->region);
-
-          l = l->next;
+            cairo_region_union_rectangle (composite, &rect);
         }
+
+      if (mgr_singleton->composites[i])
+        cairo_region_destroy (mgr_singleton->composites[i]);
+
+      mgr_singleton->composites[i] = composite;
     }
 
-  meta_set_stage_input_region (screen, result);
+  mgr_singleton->dirty_layer = N_LAYERS;
+
+  result = mgr_singleton->composites[MNB_INPUT_LAYER_TOP];
+
+  if (mgr_singleton->applied && cairo_region_equal (result, mgr_singleton->applied))
+    return;
+
+  screen = meta_plugin_get_screen (mgr_singleton->plugin);
+  display = meta_screen_get_display (screen);
+  xdpy = meta_display_get_xdisplay (display);
+
+  n_rects = cairo_region_num_rectangles (result);
+  rects = g_new (XRectangle, MAX (n_rects, 1));
+
+  for (i = 0; i < n_rects; ++i)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (result, i, &rect);
+
+      rects[i].x      = rect.x;
+      rects[i].y      = rect.y;
+      rects[i].width  = rect.width;
+      rects[i].height = rect.height;
+    }
+
+  if (!mgr_singleton->current_region)
+    mgr_singleton->current_region = XFixesCreateRegion (xdpy, rects, n_rects);
+  else
+    XFixesSetRegion (xdpy, mgr_singleton->current_region, rects, n_rects);
+
+  g_free (rects);
+
+  meta_set_stage_input_region (screen, mgr_singleton->current_region);
+
+  if (mgr_singleton->applied)
+    cairo_region_destroy (mgr_singleton->applied);
+
+  mgr_singleton->applied = cairo_region_reference (result);
+  mgr_singleton->n_server_updates++;
 }
 
 static void
@@ -302,30 +443,17 @@ actor_allocation_cb (ClutterActor *actor, GParamSpec *pspec, gpointer data)
 {
   ClutterActorBox  box;
   MnbInputRegion  *mir = g_object_get_qdata (G_OBJECT (actor), quark_mir);
-  XRectangle       rect;
-  MetaScreen      *screen;
-  MetaDisplay     *display;
-  Display         *xdpy;
 
   g_assert (mgr_singleton);
 
   if (!mir)
     return;
 
-  screen = meta_plugin_get_screen (mgr_singleton->plugin);
-  display = meta_screen_get_display (screen);
-  xdpy = meta_display_get_xdisplay (display);
-
   clutter_actor_get_allocation_box (actor, &box);
 
-  rect.x      = box.x1;
-  rect.y      = box.y1;
-  rect.width  = box.x2 - box.x1;
-  rect.height = box.y2 - box.y1;
-
-  XFixesSetRegion (xdpy, mir->region, &rect, 1);
-
-  mnb_input_manager_apply_stack ();
+  mnb_input_manager_set_region_rect (mir,
+                                     box.x1, box.y1,
+                                     box.x2 - box.x1, box.y2 - box.y1);
 }
 
 static void
@@ -333,11 +461,9 @@ panel_allocation_cb (ClutterActor *actor, GParamSpec *pspec, gpointer data)
 {
   ClutterGeometry  geom;
   MnbInputRegion  *mir = g_object_get_qdata (G_OBJECT (actor), quark_mir);
-  XRectangle       rect;
-  Display         *xdpy;
   gint             screen_width, screen_height;
+  gint             y;
   MetaScreen      *screen;
-  MetaDisplay     *display;
   MetaWorkspace   *workspace;
 
   g_assert (mgr_singleton);
@@ -346,7 +472,6 @@ panel_allocation_cb (ClutterActor *actor, GParamSpec *pspec, gpointer data)
     return;
 
   screen    = meta_plugin_get_screen (mgr_singleton->plugin);
-  display   = meta_screen_get_display (screen);
   workspace = meta_screen_get_active_workspace (screen);
 
   meta_screen_get_size (screen, &screen_width, &screen_height);
@@ -360,18 +485,12 @@ panel_allocation_cb (ClutterActor *actor, GParamSpec *pspec, gpointer data)
       screen_height = r.y + r.height;
     }
 
-  xdpy = meta_display_get_xdisplay (display);
-
   clutter_actor_get_geometry (actor, &geom);
 
-  rect.x      = 0;
-  rect.y      = MIN ((geom.y + geom.height), screen_height);
-  rect.width  = screen_width;
-  rect.height = screen_height - rect.y;
-
-  XFixesSetRegion (xdpy, mir->region, &rect, 1);
+  y = MIN ((geom.y + geom.height), screen_height);
 
-  mnb_input_manager_apply_stack ();
+  mnb_input_manager_set_region_rect (mir, 0, y,
+                                     screen_width, screen_height - y);
 }
 
 static void
@@ -392,16 +511,9 @@ actor_show_cb (ClutterActor *actor, MnbInputLayer layer)
 {
   ClutterActorBox  box;
   MnbInputRegion  *mir = g_object_get_qdata (G_OBJECT (actor), quark_mir);
-  MetaScreen      *screen;
-  MetaDisplay     *display;
-  Display         *xdpy;
 
   g_assert (mgr_singleton);
 
-  screen = meta_plugin_get_screen (mgr_singleton->plugin);
-  display = meta_screen_get_display (screen);
-  xdpy = meta_display_get_xdisplay (display);
-
   clutter_actor_get_allocation_box (actor, &box);
 
   if (!mir)
@@ -414,16 +526,9 @@ actor_show_cb (ClutterActor *actor, MnbInputLayer layer)
     }
   else
     {
-      XRectangle    rect;
-
-      rect.x      = box.x1;
-      rect.y      = box.y1;
-      rect.width  = box.x2 - box.x1;
-      rect.height = box.y2 - box.y1;
-
-      XFixesSetRegion (xdpy, mir->region, &rect, 1);
-
-      mnb_input_manager_apply_stack ();
+      mnb_input_manager_set_region_rect (mir,
+                                         box.x1, box.y1,
+                                         box.x2 - box.x1, box.y2 - box.y1);
     }
 }
 
@@ -432,16 +537,13 @@ panel_show_cb (ClutterActor *actor, MnbInputLayer layer)
 {
   ClutterGeometry  geom;
   MnbInputRegion  *mir  = g_object_get_qdata (G_OBJECT (actor), quark_mir);
-  Display         *xdpy;
   gint             screen_width, screen_height;
   MetaScreen      *screen;
-  MetaDisplay     *display;
   MetaWorkspace   *workspace;
 
   g_assert (mgr_singleton);
 
   screen    = meta_plugin_get_screen (mgr_singleton->plugin);
-  display   = meta_screen_get_display (screen);
   workspace = meta_screen_get_active_workspace (screen);
 
   meta_screen_get_size (screen, &screen_width, &screen_height);
@@ -455,8 +557,6 @@ panel_show_cb (ClutterActor *actor, MnbInputLayer layer)
       screen_height = r.y + r.height;
     }
 
-  xdpy = meta_display_get_xdisplay (display);
-
   clutter_actor_get_geometry (actor, &geom);
 
   if (!mir)
@@ -469,16 +569,9 @@ panel_show_cb (ClutterActor *actor, MnbInputLayer layer)
     }
   else
     {
-      XRectangle    rect;
-
-      rect.x      = 0;
-      rect.y      = geom.y + geom.height;
-      rect.width  = screen_width;
-      rect.height = screen_height;
-
-      XFixesSetRegion (xdpy, mir->region, &rect, 1);
-
-      mnb_input_manager_apply_stack ();
+      mnb_input_manager_set_region_rect (mir,
+                                         0, geom.y + geom.height,
+                                         screen_width, screen_height);
     }
 }
 
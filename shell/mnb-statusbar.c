@@ -24,6 +24,7 @@
 #include "mnb-statusbar.h"
 
 #include <glib/gi18n.h>
+#include <dawati-panel/mpl-timer.h>
 
 #include "mnb-input-manager.h"
 
@@ -206,19 +207,6 @@ mnb_statusbar_timeout_cb (MnbStatusbar *self)
   return TRUE;
 }
 
-static gboolean
-mnb_statusbar_initial_timeout_cb (MnbStatusbar *self)
-{
-  MnbStatusbarPrivate *priv = self->priv;
-
-  priv->timeout_id = g_timeout_add_seconds (60,
-                                            (GSourceFunc) mnb_statusbar_timeout_cb,
-                                            self);
-  mnb_statusbar_update_datetime (self);
-
-  return FALSE;
-}
-
 static void
 mnb_statusbar_get_preferred_height (ClutterActor *actor,
                                     gfloat        for_width,
@@ -317,7 +305,7 @@ mnb_statusbar_dispose (GObject *object)
 
   if (priv->timeout_id)
     {
-      g_source_remove (priv->timeout_id);
+      mpl_timer_remove (priv->timeout_id);
       priv->timeout_id = 0;
     }
 
@@ -378,7 +366,6 @@ static void
 mnb_statusbar_init (MnbStatusbar *self)
 {
   MnbStatusbarPrivate *priv;
-  GDateTime *datetime;
 
   priv = self->priv = STATUSBAR_PRIVATE (self);
 
@@ -391,11 +378,10 @@ mnb_statusbar_init (MnbStatusbar *self)
 
   mnb_statusbar_update_datetime (self);
 
-  datetime = g_date_time_new_now_local ();
-  g_timeout_add_seconds (60 - g_date_time_get_second (datetime),
-                         (GSourceFunc) mnb_statusbar_initial_timeout_cb,
-                         self);
-  g_date_time_unref (datetime);
+  /* Fires at the start of every minute, while the statusbar is shown */
+  priv->timeout_id = mpl_timer_add_seconds (60, CLUTTER_ACTOR (self),
+                                            (GSourceFunc) mnb_statusbar_timeout_cb,
+                                            self);
 }
 
 ClutterActor *
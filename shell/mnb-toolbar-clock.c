@@ -23,6 +23,7 @@
  */
 
 #include <glib/gi18n.h>
+#include <dawati-panel/mpl-timer.h>
 
 #include "mnb-toolbar-clock.h"
 #include "mnb-toolbar.h"
@@ -41,7 +42,6 @@ struct _MnbToolbarClockPrivate
   gulong        toolbar_show_id;
 
   guint disposed    : 1;
-  guint initialized : 1;
 };
 
 static void
@@ -56,7 +56,7 @@ mnb_toolbar_clock_dispose (GObject *object)
 
   if (priv->timeout_id)
     {
-      g_source_remove (priv->timeout_id);
+      mpl_timer_remove (priv->timeout_id);
       priv->timeout_id = 0;
     }
 
@@ -190,21 +190,8 @@ mnb_toolbar_clock_update_time_date (MnbToolbarClock *clock)
 static gboolean
 mnb_toolbar_clock_timeout_cb (MnbToolbarClock *clock)
 {
-  MnbToolbarClockPrivate *priv = clock->priv;
-
   mnb_toolbar_clock_update_time_date (clock);
 
-  if (!priv->initialized)
-    {
-      priv->initialized = TRUE;
-
-      priv->timeout_id =
-        g_timeout_add_seconds (60, (GSourceFunc) mnb_toolbar_clock_timeout_cb,
-                               clock);
-
-      return FALSE;
-    }
-
   return TRUE;
 }
 
@@ -213,7 +200,6 @@ mnb_toolbar_clock_constructed (GObject *self)
 {
   MnbToolbarClockPrivate     *priv = MNB_TOOLBAR_CLOCK (self)->priv;
   ClutterActor               *actor = CLUTTER_ACTOR (self);
-  time_t                      interval = 60 - (time(NULL) % 60);
 
   if (G_OBJECT_CLASS (mnb_toolbar_clock_parent_class)->constructed)
     G_OBJECT_CLASS (mnb_toolbar_clock_parent_class)->constructed (self);
@@ -224,21 +210,14 @@ mnb_toolbar_clock_constructed (GObject *self)
 
   mnb_toolbar_clock_update_time_date (MNB_TOOLBAR_CLOCK (self));
 
-  if (!interval)
-    {
-      priv->initialized = TRUE;
-      priv->timeout_id =
-        g_timeout_add_seconds (60,
-                               (GSourceFunc) mnb_toolbar_clock_timeout_cb,
-                               self);
-    }
-  else
-    {
-      priv->timeout_id =
-        g_timeout_add_seconds (interval,
-                               (GSourceFunc) mnb_toolbar_clock_timeout_cb,
-                               self);
-    }
+  /*
+   * The shared timer fires at the start of every minute, and not at all
+   * while the toolbar is hidden.
+   */
+  priv->timeout_id =
+    mpl_timer_add_seconds (60, actor,
+                           (GSourceFunc) mnb_toolbar_clock_timeout_cb,
+                           self);
 }
 
 static void
@@ -44,6 +44,7 @@
 #undef _
 #undef N_
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 
 #include "dawati-netbook.h"
@@ -95,6 +96,13 @@
 #define TOOLBAR_AUTOSTART_ATTEMPTS 10
 #define TOOLBAR_WAITING_FOR_PANEL_TIMEOUT 1 /* in seconds */
 #define TOOLBAR_PANEL_STUB_TIMEOUT 6        /* in seconds */
+
+/*
+ * Order in which panels were first used in the most recent sessions, used to
+ * decide which panels to start first; stored in the user cache dir.
+ */
+#define TOOLBAR_FIRST_USE_FILE "panel-first-use"
+
 #define DAWATI_BOOT_COUNT_KEY "/desktop/dawati/myzone/boot_count"
 
 #define CLOSE_BUTTON_GUARD_WIDTH 35
@@ -153,6 +161,8 @@ static void mnb_toolbar_activate_panel_internal (MnbToolbar *toolbar,
                                                  MnbToolbarPanel *tp,
                                                  MnbShowHideReason reason);
 static void mnb_toolbar_setup_settings (MnbToolbar *toolbar);
+static void mnb_toolbar_note_panel_use (MnbToolbar      *toolbar,
+                                        MnbToolbarPanel *tp);
 static gboolean mnb_toolbar_start_panel_service (MnbToolbar *toolbar,
                                                  MnbToolbarPanel *tp);
 static void mnb_toolbar_workarea_changed_cb (MetaScreen *screen,
@@ -205,6 +215,9 @@ struct _MnbToolbarPanel
   gboolean    required   : 1;
   gboolean    failed     : 1;
   gboolean    ready      : 1;
+
+  gint64      start_time; /* when started or found running, startup relative */
+  gint64      ready_time; /* when it first became ready, startup relative */
 };
 
 static void
@@ -303,6 +316,11 @@ struct _MnbToolbarPrivate
   guint            waiting_for_panel_hide_cb_id;
   guint            panel_stub_timeout_id;
   guint            trigger_cb_id;
+
+  gint64           startup_time;
+  GSList          *first_use;      /* panel names, first used first */
+  guint            n_first_used;   /* how many of those were used so far */
+  gboolean         first_use_dirty;
 };
 
 static GSList *
@@ -403,6 +421,9 @@ mnb_toolbar_finalize (GObject *object)
   g_slist_free (priv->pending_panels);
   priv->pending_panels = NULL;
 
+  g_slist_foreach (priv->first_use, (GFunc) g_free, NULL);
+  g_slist_free (priv->first_use);
+
   G_OBJECT_CLASS (mnb_toolbar_parent_class)->finalize (object);
 }
 
@@ -867,6 +888,45 @@ mnb_toolbar_dbus_hide_panel (MnbToolbar  *self,
   return TRUE;
 }
 
+static gboolean
+mnb_toolbar_dbus_get_startup_timeline (MnbToolbar  *self,
+                                       GPtrArray  **timeline,
+                                       GError     **error)
+{
+  MnbToolbarPrivate *priv = self->priv;
+  GList             *l;
+
+  *timeline = g_ptr_array_new ();
+
+  for (l = priv->panels; l; l = l->next)
+    {
+      MnbToolbarPanel *tp = l->data;
+      GValueArray     *entry;
+      GValue           value = { 0, };
+
+      if (!tp || !tp->service)
+        continue;
+
+      entry = g_value_array_new (3);
+
+      g_value_init (&value, G_TYPE_STRING);
+      g_value_set_string (&value, tp->name);
+      g_value_array_append (entry, &value);
+      g_value_unset (&value);
+
+      g_value_init (&value, G_TYPE_INT64);
+      g_value_set_int64 (&value, tp->start_time);
+      g_value_array_append (entry, &value);
+      g_value_set_int64 (&value, tp->ready_time);
+      g_value_array_append (entry, &value);
+      g_value_unset (&value);
+
+      g_ptr_array_add (*timeline, entry);
+    }
+
+  return TRUE;
+}
+
 #include "mnb-toolbar-dbus-glue.h"
 
 static void
@@ -1378,6 +1438,9 @@ mnb_toolbar_button_toggled_cb (MxButton *button,
          *      the button (see bug 5020)
          */
 
+        if (checked && button_click)
+          mnb_toolbar_note_panel_use (toolbar, tp);
+
         if (tp->panel)
           {
             if (checked && !mnb_panel_is_mapped (tp->panel))
@@ -2016,6 +2079,16 @@ mnb_toolbar_panel_ready_cb (MnbPanel *panel, MnbToolbar *toolbar)
 
       tp->ready = TRUE;
 
+      if (tp->ready_time < 0)
+        {
+          tp->ready_time = g_get_monotonic_time () - priv->startup_time;
+
+          g_debug ("Panel %s ready at %.1f ms, %.1f ms after start",
+                   tp->name,
+                   tp->ready_time / 1000.0,
+                   (tp->ready_time - MAX (tp->start_time, 0)) / 1000.0);
+        }
+
       button = tp->button;
 
       stylesheet = mnb_panel_get_stylesheet (panel);
@@ -2558,6 +2631,9 @@ mnb_toolbar_start_panel_service (MnbToolbar *toolbar, MnbToolbarPanel *tp)
       return FALSE;
     }
 
+  if (tp->start_time < 0)
+    tp->start_time = g_get_monotonic_time () - priv->startup_time;
+
   mnb_toolbar_ping_panel_oop (priv->dbus_conn, tp->service);
 
   return TRUE;
@@ -2602,6 +2678,161 @@ mnb_toolbar_autostart_panels_cb (gpointer toolbar)
 }
 #endif
 
+static gchar *
+mnb_toolbar_first_use_filename (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "dawati",
+                           TOOLBAR_FIRST_USE_FILE,
+                           NULL);
+}
+
+static void
+mnb_toolbar_load_first_use (MnbToolbar *toolbar)
+{
+  MnbToolbarPrivate  *priv = toolbar->priv;
+  gchar              *filename = mnb_toolbar_first_use_filename ();
+  gchar              *contents = NULL;
+
+  if (g_file_get_contents (filename, &contents, NULL, NULL))
+    {
+      gchar **names = g_strsplit (contents, "\n", -1);
+      gchar **p;
+
+      for (p = names; *p; p++)
+        if (**p)
+          priv->first_use = g_slist_prepend (priv->first_use, g_strdup (*p));
+
+      priv->first_use = g_slist_reverse (priv->first_use);
+
+      g_strfreev (names);
+      g_free (contents);
+    }
+
+  g_free (filename);
+}
+
+static gboolean
+mnb_toolbar_save_first_use_cb (gpointer data)
+{
+  MnbToolbarPrivate *priv = MNB_TOOLBAR (data)->priv;
+  GString           *contents = g_string_new (NULL);
+  gchar             *filename = mnb_toolbar_first_use_filename ();
+  gchar             *dirname = g_path_get_dirname (filename);
+  GSList            *l;
+
+  priv->first_use_dirty = FALSE;
+
+  for (l = priv->first_use; l; l = l->next)
+    {
+      g_string_append (contents, l->data);
+      g_string_append_c (contents, '\n');
+    }
+
+  g_mkdir_with_parents (dirname, 0700);
+  g_file_set_contents (filename, contents->str, contents->len, NULL);
+
+  g_string_free (contents, TRUE);
+  g_free (dirname);
+  g_free (filename);
+
+  return FALSE;
+}
+
+/*
+ * Moves the panel ahead of those not yet used in this session, so the
+ * stored order ends up being the order of first use, with panels not used
+ * lately drifting to the end.
+ */
+static void
+mnb_toolbar_note_panel_use (MnbToolbar *toolbar, MnbToolbarPanel *tp)
+{
+  MnbToolbarPrivate *priv = toolbar->priv;
+  GSList            *l;
+  guint              i;
+
+  for (l = priv->first_use, i = 0; l && i < priv->n_first_used;
+       l = l->next, i++)
+    if (!strcmp (l->data, tp->name))
+      return;
+
+  if ((l = g_slist_find_custom (l, tp->name, (GCompareFunc) strcmp)))
+    {
+      g_free (l->data);
+      priv->first_use = g_slist_delete_link (priv->first_use, l);
+    }
+
+  priv->first_use = g_slist_insert (priv->first_use, g_strdup (tp->name),
+                                    priv->n_first_used++);
+
+  if (!priv->first_use_dirty)
+    {
+      priv->first_use_dirty = TRUE;
+      g_timeout_add_seconds_full (G_PRIORITY_LOW, 5,
+                                  mnb_toolbar_save_first_use_cb,
+                                  g_object_ref (toolbar),
+                                  g_object_unref);
+    }
+}
+
+static gint
+mnb_toolbar_first_use_rank (MnbToolbar *toolbar, MnbToolbarPanel *tp)
+{
+  gint rank = g_slist_position (toolbar->priv->first_use,
+                                g_slist_find_custom (toolbar->priv->first_use,
+                                                     tp->name,
+                                                     (GCompareFunc) strcmp));
+
+  return rank < 0 ? G_MAXINT : rank;
+}
+
+static gint
+mnb_toolbar_compare_first_use (gconstpointer a,
+                               gconstpointer b,
+                               gpointer      toolbar)
+{
+  gint rank_a = mnb_toolbar_first_use_rank (toolbar, (MnbToolbarPanel *) a);
+  gint rank_b = mnb_toolbar_first_use_rank (toolbar, (MnbToolbarPanel *) b);
+
+  return rank_a < rank_b ? -1 : rank_a > rank_b;
+}
+
+/*
+ * Starts all the panels that are not running yet, without waiting for the
+ * user to ask for them. The pings are asynchronous, so they are all sent
+ * right away; dbus activates the services in the order the pings arrive,
+ * which is the order in which the panels were first used before.
+ */
+static void
+mnb_toolbar_prespawn_panels (MnbToolbar *toolbar)
+{
+  MnbToolbarPrivate *priv = toolbar->priv;
+  GList             *l, *to_start = NULL;
+
+  if (priv->no_autoloading)
+    return;
+
+  for (l = priv->panels; l; l = l->next)
+    {
+      MnbToolbarPanel *tp = l->data;
+
+      if (!tp || tp->panel || !tp->service || tp->windowless ||
+          tp->unloaded || tp->start_time >= 0)
+        continue;
+
+      to_start = g_list_prepend (to_start, tp);
+    }
+
+  to_start = g_list_sort_with_data (g_list_reverse (to_start),
+                                    mnb_toolbar_compare_first_use,
+                                    toolbar);
+
+  for (l = to_start; l; l = l->next)
+    mnb_toolbar_start_panel_service (toolbar, l->data);
+
+  g_list_free (to_start);
+}
+
 static void
 mnb_toolbar_dbus_list_names_cb (DBusGProxy  *proxy,
                                 char       **names,
@@ -2618,7 +2849,8 @@ mnb_toolbar_dbus_list_names_cb (DBusGProxy  *proxy,
     }
 
   /*
-   * Insert panels for any services already running.
+   * Insert panels for any services already running; ListNames only returns
+   * names that have an owner, so there is no need to ask about each of them.
    */
   if (!error)
     {
@@ -2628,18 +2860,15 @@ mnb_toolbar_dbus_list_names_cb (DBusGProxy  *proxy,
           if (!strncmp (*p, MPL_PANEL_DBUS_NAME_PREFIX,
                         strlen (MPL_PANEL_DBUS_NAME_PREFIX)))
             {
-              gboolean  has_owner = FALSE;
-
-              if (org_freedesktop_DBus_name_has_owner (priv->dbus_proxy,
-                                                       *p, &has_owner, NULL) &&
-                  has_owner)
-                {
-                  MnbToolbarPanel *tp;
+              MnbToolbarPanel *tp;
 
-                  tp = mnb_toolbar_panel_service_to_panel_internal (toolbar,*p);
+              tp = mnb_toolbar_panel_service_to_panel_internal (toolbar, *p);
 
-                  if (tp)
-                    mnb_toolbar_handle_dbus_name (toolbar, *p);
+              if (tp)
+                {
+                  tp->start_time =
+                    g_get_monotonic_time () - priv->startup_time;
+                  mnb_toolbar_handle_dbus_name (toolbar, *p);
                 }
             }
 
@@ -2659,6 +2888,8 @@ mnb_toolbar_dbus_list_names_cb (DBusGProxy  *proxy,
   dbus_g_proxy_connect_signal (priv->dbus_proxy, "NameOwnerChanged",
                                G_CALLBACK (mnb_toolbar_noc_cb),
                                toolbar, NULL);
+
+  mnb_toolbar_prespawn_panels (toolbar);
 }
 
 
@@ -2676,6 +2907,10 @@ mnb_toolbar_dbus_setup_panels (MnbToolbar *toolbar)
       return;
     }
 
+  priv->startup_time = g_get_monotonic_time ();
+
+  mnb_toolbar_load_first_use (toolbar);
+
   /*
    * Insert panels for any services already running. Like everything else,
    * do this asynchronously to avoid blocking the WM.
@@ -3577,6 +3812,8 @@ mnb_toolbar_make_panel_from_desktop (MnbToolbar *toolbar, const gchar *desktop)
       gboolean  builtin = FALSE;
 
       tp = g_new0 (MnbToolbarPanel, 1);
+      tp->start_time = -1;
+      tp->ready_time = -1;
 
       tp->name = g_strdup (desktop);
 
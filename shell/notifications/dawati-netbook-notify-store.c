@@ -24,6 +24,11 @@ G_DEFINE_TYPE (DawatiNetbookNotifyStore, dawati_netbook_notify_store, G_TYPE_OBJ
 #define GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), DAWATI_NETBOOK_TYPE_NOTIFY_STORE, DawatiNetbookNotifyStorePrivate))
 
+enum {
+  PROP_0,
+  PROP_MAX_NOTIFICATIONS
+};
+
 enum {
   ACTION_INVOKED,
   NOTIFICATION_ADDED,
@@ -36,10 +41,22 @@ static guint signals[N_SIGNALS];
 static DBusConnection *_dbus_conn = NULL;
 
 #define DEFAULT_TIMEOUT 7000
+#define DEFAULT_MAX_NOTIFICATIONS 100
 
 typedef struct {
   guint next_id;
-  GList *notifications;
+  /* Notifications, least recently updated first. */
+  GQueue notifications;
+  /* id -> link in notifications. */
+  GHashTable *by_id;
+  /* sender -> GList of notifications. */
+  GHashTable *by_source;
+  guint max_notifications;
+
+  /* Ids of notifications to emit ::notification-added for, in order. */
+  GQueue pending;
+  guint  pending_id;
+
   DBusGProxy *bus_proxy;
 } DawatiNetbookNotifyStorePrivate;
 
@@ -61,7 +78,6 @@ find_notification (DawatiNetbookNotifyStore  *notify,
                    guint                      id,
                    Notification             **found)
 {
-  /* TODO: should this return a GList*? */
   DawatiNetbookNotifyStorePrivate *priv;
   GList *l;
 
@@ -70,19 +86,50 @@ find_notification (DawatiNetbookNotifyStore  *notify,
 
   priv = GET_PRIVATE (notify);
 
-  for (l = priv->notifications; l ; l = l->next)
+  l = g_hash_table_lookup (priv->by_id, GUINT_TO_POINTER (id));
+  if (l)
     {
-      Notification *notification = l->data;
-      if (notification->id == id)
-        {
-          *found = notification;
-          return TRUE;
-        }
+      *found = l->data;
+      return TRUE;
     }
 
   return FALSE;
 }
 
+static void
+add_to_source (DawatiNetbookNotifyStore *notify,
+               Notification             *notification)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (notify);
+  GList *list;
+
+  if (!notification->sender)
+    return;
+
+  list = g_hash_table_lookup (priv->by_source, notification->sender);
+  list = g_list_prepend (list, notification);
+  g_hash_table_insert (priv->by_source, g_strdup (notification->sender), list);
+}
+
+static void
+remove_from_source (DawatiNetbookNotifyStore *notify,
+                    Notification             *notification)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (notify);
+  GList *list;
+
+  if (!notification->sender)
+    return;
+
+  list = g_hash_table_lookup (priv->by_source, notification->sender);
+  list = g_list_remove (list, notification);
+
+  if (list)
+    g_hash_table_insert (priv->by_source, g_strdup (notification->sender), list);
+  else
+    g_hash_table_remove (priv->by_source, notification->sender);
+}
+
 static void
 free_notification (Notification *n)
 {
@@ -93,6 +140,7 @@ free_notification (Notification *n)
   g_free (n->summary);
   g_free (n->body);
   g_free (n->icon_name);
+  g_free (n->sender);
 
   for (action = n->actions; action; action = g_list_next (action))
     g_free (action->data);
@@ -104,6 +152,81 @@ free_notification (Notification *n)
   g_slice_free (Notification, n);
 }
 
+static gboolean
+emit_pending_cb (DawatiNetbookNotifyStore *notify)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (notify);
+  gpointer id;
+
+  priv->pending_id = 0;
+
+  while ((id = g_queue_pop_head (&priv->pending)))
+    {
+      Notification *notification;
+
+      /* May have been closed in the meantime. */
+      if (find_notification (notify, GPOINTER_TO_UINT (id), &notification))
+        g_signal_emit (notify, signals[NOTIFICATION_ADDED], 0, notification);
+    }
+
+  return FALSE;
+}
+
+/*
+ * Schedules ::notification-added for the notification. Updates of the same
+ * notification arriving before the next frame are emitted only once, with
+ * the latest contents.
+ */
+static void
+queue_notification_added (DawatiNetbookNotifyStore *notify,
+                          Notification             *notification)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (notify);
+  gpointer id = GUINT_TO_POINTER (notification->id);
+
+  if (!g_queue_find (&priv->pending, id))
+    g_queue_push_tail (&priv->pending, id);
+
+  if (!priv->pending_id)
+    priv->pending_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                        (GSourceFunc) emit_pending_cb,
+                                        notify,
+                                        NULL);
+}
+
+/*
+ * Closes least recently updated notifications to get back within
+ * max_notifications. Urgent notifications are never evicted, nor is `keep'.
+ */
+static void
+evict_notifications (DawatiNetbookNotifyStore *notify,
+                     Notification             *keep)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (notify);
+
+  while (priv->notifications.length > priv->max_notifications)
+    {
+      Notification *victim = NULL;
+      GList        *l;
+
+      for (l = priv->notifications.head; l; l = l->next)
+        {
+          Notification *n = l->data;
+
+          if (n != keep && !n->is_urgent)
+            {
+              victim = n;
+              break;
+            }
+        }
+
+      if (!victim)
+        break;
+
+      dawati_netbook_notify_store_close (notify, victim->id, ClosedExpired);
+    }
+}
+
 /*
  * Notification Manager implementation.
  */
@@ -121,13 +244,22 @@ get_notification (DawatiNetbookNotifyStore *notify,
   DawatiNetbookNotifyStorePrivate *priv;
   Notification                    *notification;
   GList                           *action;
+  GList                           *link;
 
   g_return_val_if_fail (DAWATI_NETBOOK_IS_NOTIFY (notify), NULL);
 
   priv = GET_PRIVATE (notify);
 
-  if (id && find_notification (notify, id, &notification))
+  link = id ? g_hash_table_lookup (priv->by_id, GUINT_TO_POINTER (id)) : NULL;
+
+  if (link)
     {
+      notification = link->data;
+
+      /* Most recently used now. */
+      g_queue_unlink (&priv->notifications, link);
+      g_queue_push_tail_link (&priv->notifications, link);
+
       /* Found an existing notification, clear it */
       g_free (notification->summary);
       notification->summary = NULL;
@@ -155,8 +287,10 @@ get_notification (DawatiNetbookNotifyStore *notify,
       notification->id = id;
       notification->internal_data = internal_data;
 
-      /* TODO: use _insert_sorted with some magic sorting algorithm */
-      priv->notifications = g_list_append (priv->notifications, notification);
+      g_queue_push_tail (&priv->notifications, notification);
+      g_hash_table_insert (priv->by_id,
+                           GUINT_TO_POINTER (id),
+                           priv->notifications.tail);
     }
 
   return notification;
@@ -186,8 +320,7 @@ unix_process_id_reply_cb (DBusGProxy *proxy,
 
       notification->pid = pid;
 
-      g_signal_emit (pid_data->store,
-                     signals[NOTIFICATION_ADDED], 0, notification);
+      queue_notification_added (pid_data->store, notification);
     }
 
   g_slice_free (PidData, pid_data);
@@ -320,20 +453,36 @@ notification_manager_notify (DawatiNetbookNotifyStore  *notify,
 
   if (context)
     {
-      PidData *pid_data = g_slice_new0 (PidData);
+      gchar *sender = dbus_g_method_get_sender (context);
 
-      pid_data->store           = notify;
-      pid_data->notification_id = notification->id;
+      if (notification->pid && !g_strcmp0 (sender, notification->sender))
+        {
+          /* Update from the same client, we already know its pid. */
+          g_free (sender);
+          queue_notification_added (notify, notification);
+        }
+      else
+        {
+          PidData *pid_data = g_slice_new0 (PidData);
+
+          pid_data->store           = notify;
+          pid_data->notification_id = notification->id;
 
-      notification->sender = dbus_g_method_get_sender (context);
+          remove_from_source (notify, notification);
+          g_free (notification->sender);
+          notification->sender = sender;
+          add_to_source (notify, notification);
 
-      org_freedesktop_DBus_get_connection_unix_process_id_async (priv->bus_proxy,
-                                                                 notification->sender,
-                                                                 unix_process_id_reply_cb,
-                                                                 pid_data);
+          org_freedesktop_DBus_get_connection_unix_process_id_async (priv->bus_proxy,
+                                                                     notification->sender,
+                                                                     unix_process_id_reply_cb,
+                                                                     pid_data);
+        }
     }
   else
-    g_signal_emit (notify, signals[NOTIFICATION_ADDED], 0, notification);
+    queue_notification_added (notify, notification);
+
+  evict_notifications (notify, notification);
 
   if (context)
     dbus_g_method_return(context, notification->id);
@@ -438,13 +587,61 @@ notification_manager_get_server_information (DawatiNetbookNotifyStore  *notify,
  * GObject methods
  */
 
+static void
+dawati_netbook_notify_store_get_property (GObject    *object,
+                                          guint       property_id,
+                                          GValue     *value,
+                                          GParamSpec *pspec)
+{
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id)
+    {
+    case PROP_MAX_NOTIFICATIONS:
+      g_value_set_uint (value, priv->max_notifications);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+dawati_netbook_notify_store_set_property (GObject      *object,
+                                          guint         property_id,
+                                          const GValue *value,
+                                          GParamSpec   *pspec)
+{
+  switch (property_id)
+    {
+    case PROP_MAX_NOTIFICATIONS:
+      dawati_netbook_notify_store_set_max_notifications (
+                                  DAWATI_NETBOOK_NOTIFY_STORE (object),
+                                  g_value_get_uint (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
 static void
 dawati_netbook_notify_store_finalize (GObject *object)
 {
   DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (object);
+  GHashTableIter iter;
+  gpointer       list;
 
-  g_list_foreach (priv->notifications, (GFunc)free_notification, NULL);
-  g_list_free (priv->notifications);
+  if (priv->pending_id)
+    g_source_remove (priv->pending_id);
+  g_queue_clear (&priv->pending);
+
+  g_hash_table_iter_init (&iter, priv->by_source);
+  while (g_hash_table_iter_next (&iter, NULL, &list))
+    g_list_free (list);
+  g_hash_table_destroy (priv->by_source);
+  g_hash_table_destroy (priv->by_id);
+
+  g_queue_foreach (&priv->notifications, (GFunc)free_notification, NULL);
+  g_queue_clear (&priv->notifications);
 
   G_OBJECT_CLASS (dawati_netbook_notify_store_parent_class)->finalize (object);
 }
@@ -457,8 +654,21 @@ dawati_netbook_notify_store_class_init (DawatiNetbookNotifyStoreClass *klass)
 
   g_type_class_add_private (klass, sizeof (DawatiNetbookNotifyStorePrivate));
 
+  object_class->get_property = dawati_netbook_notify_store_get_property;
+  object_class->set_property = dawati_netbook_notify_store_set_property;
   object_class->finalize = dawati_netbook_notify_store_finalize;
 
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_NOTIFICATIONS,
+                                   g_param_spec_uint ("max-notifications",
+                                                      "Max notifications",
+                                                      "Number of notifications kept before the least recently updated ones are closed",
+                                                      1, G_MAXUINT,
+                                                      DEFAULT_MAX_NOTIFICATIONS,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_CONSTRUCT |
+                                                      G_PARAM_STATIC_STRINGS));
+
   /* TODO: implement ActionInvoked */
   signals[ACTION_INVOKED] =
     g_signal_new ("action-invoked",
@@ -540,6 +750,16 @@ connect_to_dbus (DawatiNetbookNotifyStore *self)
 static void
 dawati_netbook_notify_store_init (DawatiNetbookNotifyStore *self)
 {
+  DawatiNetbookNotifyStorePrivate *priv = GET_PRIVATE (self);
+
+  g_queue_init (&priv->notifications);
+  g_queue_init (&priv->pending);
+  priv->by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+  /* Lists are freed by hand, they get replaced as they change. */
+  priv->by_source = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, NULL);
+  priv->max_notifications = DEFAULT_MAX_NOTIFICATIONS;
+
   connect_to_dbus (self);
 }
 
@@ -563,7 +783,11 @@ dawati_netbook_notify_store_close (DawatiNetbookNotifyStore           *notify,
 
   if (find_notification (notify, id, &notification))
     {
-      priv->notifications = g_list_remove (priv->notifications, notification);
+      g_queue_delete_link (&priv->notifications,
+                           g_hash_table_lookup (priv->by_id,
+                                                GUINT_TO_POINTER (id)));
+      g_hash_table_remove (priv->by_id, GUINT_TO_POINTER (id));
+      remove_from_source (notify, notification);
       free_notification (notification);
       g_signal_emit (notify, signals[NOTIFICATION_CLOSED], 0, id, reason);
 
@@ -605,3 +829,64 @@ dawati_netbook_notify_store_action (DawatiNetbookNotifyStore *notify,
       dawati_netbook_notify_store_close (notify, id, ClosedProgramatically);
     }
 }
+
+/*
+ * Returns the notification with the given id, NULL if it has been closed.
+ */
+Notification *
+dawati_netbook_notify_store_lookup (DawatiNetbookNotifyStore *notify,
+                                    guint                     id)
+{
+  Notification *notification;
+
+  g_return_val_if_fail (DAWATI_NETBOOK_IS_NOTIFY (notify), NULL);
+
+  if (id && find_notification (notify, id, &notification))
+    return notification;
+
+  return NULL;
+}
+
+/*
+ * Sets how many notifications are kept; beyond that the least recently
+ * updated non-urgent ones are closed as expired.
+ */
+void
+dawati_netbook_notify_store_set_max_notifications (DawatiNetbookNotifyStore *notify,
+                                                   guint                     max)
+{
+  DawatiNetbookNotifyStorePrivate *priv;
+
+  g_return_if_fail (DAWATI_NETBOOK_IS_NOTIFY (notify) && max > 0);
+
+  priv = GET_PRIVATE (notify);
+
+  if (priv->max_notifications == max)
+    return;
+
+  priv->max_notifications = max;
+  evict_notifications (notify, NULL);
+
+  g_object_notify (G_OBJECT (notify), "max-notifications");
+}
+
+guint
+dawati_netbook_notify_store_get_max_notifications (DawatiNetbookNotifyStore *notify)
+{
+  g_return_val_if_fail (DAWATI_NETBOOK_IS_NOTIFY (notify), 0);
+
+  return GET_PRIVATE (notify)->max_notifications;
+}
+
+/*
+ * Returns the notifications sent by the given D-Bus client, most recent first.
+ * The list is owned by the store.
+ */
+GList *
+dawati_netbook_notify_store_get_notifications_for_source (DawatiNetbookNotifyStore *notify,
+                                                          const gchar              *sender)
+{
+  g_return_val_if_fail (DAWATI_NETBOOK_IS_NOTIFY (notify) && sender, NULL);
+
+  return g_hash_table_lookup (GET_PRIVATE (notify)->by_source, sender);
+}
@@ -77,6 +77,21 @@ dawati_netbook_notify_store_action (DawatiNetbookNotifyStore    *notify,
 				    guint                        id,
 				    gchar                       *action);
 
+Notification *
+dawati_netbook_notify_store_lookup (DawatiNetbookNotifyStore *notify,
+                                    guint                     id);
+
+void
+dawati_netbook_notify_store_set_max_notifications (DawatiNetbookNotifyStore *notify,
+                                                   guint                     max);
+
+guint
+dawati_netbook_notify_store_get_max_notifications (DawatiNetbookNotifyStore *notify);
+
+GList *
+dawati_netbook_notify_store_get_notifications_for_source (DawatiNetbookNotifyStore *notify,
+                                                          const gchar              *sender);
+
 guint
 notification_manager_notify_internal (DawatiNetbookNotifyStore *notify,
                                       guint id,
@@ -34,6 +34,25 @@
 
 #define DAWATI_KEY_PREFIX "dawati:"
 
+/*
+ * Regular notifications do not go to the tray straight away. Those arriving
+ * within COALESCE_WINDOW_MS of each other from the same source and with the
+ * same summary are collapsed into a single "N new messages" notification,
+ * and at most MAX_NEW_PER_FRAME notification actors are created per frame,
+ * so that bursts do not stall the compositor.
+ */
+#define COALESCE_WINDOW_MS 250
+#define FRAME_MS            16
+#define MAX_NEW_PER_FRAME    2
+
+typedef struct
+{
+  gchar  *key;      /* srcid and summary */
+  gchar  *srcid;
+  gint    pid;
+  GArray *ids;      /* store ids, oldest first */
+} PendingGroup;
+
 static guint32 subsystem_id = 0;
 static DawatiNetbookNotifyStore *store = NULL;
 
@@ -51,6 +70,12 @@ typedef struct
 static gint     n_notifiers;
 static gboolean overlay_focused;
 
+static GQueue      pending_groups = G_QUEUE_INIT;
+static GHashTable *pending_by_key = NULL;   /* key -> PendingGroup */
+static GHashTable *pending_ids = NULL;      /* id -> PendingGroup */
+static GHashTable *collapsed_ids = NULL;    /* id -> NtfNotification */
+static guint       flush_id = 0;
+
 static void
 free_action_data (gpointer action)
 {
@@ -105,6 +130,7 @@ ntf_libnotify_update_modal (void)
 static void
 ntf_libnotify_ntf_closed_cb (NtfNotification *ntf, gpointer dummy)
 {
+  GArray *ids;
 
   n_notifiers--;
   if (n_notifiers < 0)
@@ -114,11 +140,217 @@ ntf_libnotify_ntf_closed_cb (NtfNotification *ntf, gpointer dummy)
     }
 
   ntf_libnotify_update_modal ();
+
+  /* Dismissing a collapsed notification dismisses all it stands for. */
+  ids = g_object_get_data (G_OBJECT (ntf), "ntf-libnotify-ids");
+  if (ids)
+    {
+      guint i;
+
+      for (i = 0; i < ids->len; i++)
+        {
+          guint id = g_array_index (ids, guint, i);
+
+          g_hash_table_remove (collapsed_ids, GUINT_TO_POINTER (id));
+
+          if (id != ntf_notification_get_id (ntf))
+            dawati_netbook_notify_store_close (store, id, ClosedDismissed);
+        }
+    }
+
   dawati_netbook_notify_store_close (store,
                                      ntf_notification_get_id (ntf),
                                      ClosedDismissed);
 }
 
+static void
+free_pending_group (PendingGroup *group)
+{
+  g_free (group->key);
+  g_free (group->srcid);
+  if (group->ids)
+    g_array_free (group->ids, TRUE);
+  g_slice_free (PendingGroup, group);
+}
+
+/*
+ * Shows a notification as standing for the given ids.
+ */
+static void
+ntf_libnotify_collapse (NtfNotification *ntf, GArray *ids)
+{
+  gchar *body;
+
+  body = g_strdup_printf (ngettext ("%u new message",
+                                    "%u new messages",
+                                    ids->len),
+                          ids->len);
+  ntf_notification_set_body (ntf, body);
+  g_free (body);
+
+  /* Actions of individual notifications make no sense here. */
+  ntf_notification_remove_all_buttons (ntf);
+}
+
+static NtfNotification *
+ntf_libnotify_create (const gchar  *srcid,
+                      gint          pid,
+                      Notification *notification)
+{
+  NtfNotification *ntf = NULL;
+  NtfSource       *src;
+  const gchar     *machine = "local";
+
+  if (!(src = ntf_sources_find_for_id (srcid)))
+    {
+      if ((src = ntf_source_new_for_pid (machine, pid)))
+        ntf_sources_add (src);
+    }
+
+  if (src)
+    {
+      gboolean no_dismiss = (notification->no_dismiss_button != 0);
+
+      ntf = ntf_notification_new (src,
+                                  subsystem_id,
+                                  notification->id,
+                                  no_dismiss);
+    }
+
+  if (ntf)
+    {
+      n_notifiers++;
+      g_signal_connect_after (ntf, "closed",
+                              G_CALLBACK (ntf_libnotify_ntf_closed_cb),
+                              NULL);
+
+      ntf_libnotify_update (ntf, notification);
+    }
+
+  return ntf;
+}
+
+/*
+ * Turns a pending group into a notification actor in the regular tray.
+ */
+static void
+ntf_libnotify_flush_group (PendingGroup *group)
+{
+  NtfTray         *tray = ntf_overlay_get_tray (FALSE);
+  NtfNotification *ntf;
+  Notification    *last = NULL;
+  GArray          *live;
+  guint            i;
+
+  /* Skip whatever got closed while waiting. */
+  live = g_array_sized_new (FALSE, FALSE, sizeof (guint), group->ids->len);
+  for (i = 0; i < group->ids->len; i++)
+    {
+      guint         id = g_array_index (group->ids, guint, i);
+      Notification *notification = dawati_netbook_notify_store_lookup (store, id);
+
+      g_hash_table_remove (pending_ids, GUINT_TO_POINTER (id));
+
+      if (notification)
+        {
+          g_array_append_val (live, id);
+          last = notification;
+        }
+    }
+
+  if (!last)
+    {
+      g_array_free (live, TRUE);
+      return;
+    }
+
+  ntf = ntf_libnotify_create (group->srcid, group->pid, last);
+
+  if (ntf && live->len > 1)
+    {
+      ntf_libnotify_collapse (ntf, live);
+
+      for (i = 0; i < live->len; i++)
+        g_hash_table_insert (collapsed_ids,
+                             GUINT_TO_POINTER (g_array_index (live, guint, i)),
+                             ntf);
+
+      g_object_set_data_full (G_OBJECT (ntf), "ntf-libnotify-ids", live,
+                              (GDestroyNotify) g_array_unref);
+      live = NULL;
+    }
+
+  if (ntf)
+    {
+      ntf_tray_add_notification (tray, ntf);
+      ntf_libnotify_update_modal ();
+    }
+
+  if (live)
+    g_array_free (live, TRUE);
+}
+
+static gboolean
+ntf_libnotify_flush_cb (gpointer data)
+{
+  PendingGroup *group;
+  guint         n_created = 0;
+
+  flush_id = 0;
+
+  while (n_created < MAX_NEW_PER_FRAME &&
+         (group = g_queue_pop_head (&pending_groups)))
+    {
+      g_hash_table_remove (pending_by_key, group->key);
+      ntf_libnotify_flush_group (group);
+      free_pending_group (group);
+      n_created++;
+    }
+
+  /* Carry on with the backlog next frame. */
+  if (!g_queue_is_empty (&pending_groups))
+    flush_id = g_timeout_add (FRAME_MS, ntf_libnotify_flush_cb, NULL);
+
+  return FALSE;
+}
+
+static void
+ntf_libnotify_queue (Notification *notification,
+                     const gchar  *srcid,
+                     gint          pid)
+{
+  PendingGroup *group;
+  gchar        *key;
+
+  /* Already waiting, the latest contents get picked up on flush. */
+  if (g_hash_table_lookup (pending_ids, GUINT_TO_POINTER (notification->id)))
+    return;
+
+  key = g_strdup_printf ("%s\n%s",
+                         srcid,
+                         notification->summary ? notification->summary : "");
+
+  if (!(group = g_hash_table_lookup (pending_by_key, key)))
+    {
+      group = g_slice_new0 (PendingGroup);
+      group->key = key;
+      group->srcid = g_strdup (srcid);
+      group->pid = pid;
+      group->ids = g_array_new (FALSE, FALSE, sizeof (guint));
+
+      g_queue_push_tail (&pending_groups, group);
+      g_hash_table_insert (pending_by_key, group->key, group);
+    }
+  else
+    g_free (key);
+
+  g_array_append_val (group->ids, notification->id);
+  g_hash_table_insert (pending_ids, GUINT_TO_POINTER (notification->id), group);
+
+  if (!flush_id)
+    flush_id = g_timeout_add (COALESCE_WINDOW_MS, ntf_libnotify_flush_cb, NULL);
+}
+
 static void
 ntf_libnotify_notification_added_cb (DawatiNetbookNotifyStore *store,
                                      Notification             *notification,
@@ -126,46 +358,47 @@ ntf_libnotify_notification_added_cb (DawatiNetbookNotifyStore *store,
 {
   NtfTray         *tray;
   NtfNotification *ntf;
-  NtfSource       *src = NULL;
   gint             pid = notification->pid;
   const gchar     *machine = "local";
 
+  /* Shown as part of a collapsed notification already, the update must
+   * not replace what the collapsed notification says. */
+  ntf = g_hash_table_lookup (collapsed_ids, GUINT_TO_POINTER (notification->id));
+  if (ntf)
+    {
+      if (!ntf_notification_is_closed (ntf))
+        {
+          ntf_libnotify_update (ntf, notification);
+          ntf_libnotify_collapse (ntf,
+                                  g_object_get_data (G_OBJECT (ntf),
+                                                     "ntf-libnotify-ids"));
+        }
+      return;
+    }
+
   tray = ntf_overlay_get_tray (notification->is_urgent);
 
   ntf = ntf_tray_find_notification (tray, subsystem_id, notification->id);
 
   if (!ntf)
     {
-      gchar *srcid = g_strdup_printf ("application-%d@%s", pid, machine);
-
-      if (!(src = ntf_sources_find_for_id (srcid)))
-        {
-          if ((src = ntf_source_new_for_pid (machine, pid)))
-            ntf_sources_add (src);
-        }
-
-      if (src)
-        {
-          gboolean no_dismiss = (notification->no_dismiss_button != 0);
-
-          ntf = ntf_notification_new (src,
-                                      subsystem_id,
-                                      notification->id,
-                                      no_dismiss);
-        }
+      gchar *srcid;
 
+      srcid = g_strdup_printf ("application-%d@%s", pid, machine);
 
-      if (ntf)
+      if (notification->is_urgent)
         {
-          n_notifiers++;
-          g_signal_connect_after (ntf, "closed",
-                                  G_CALLBACK (ntf_libnotify_ntf_closed_cb),
-                                  NULL);
+          /* Urgent notifications are rare and must not wait. */
+          ntf = ntf_libnotify_create (srcid, pid, notification);
 
-          ntf_libnotify_update (ntf, notification);
-          ntf_tray_add_notification (tray, ntf);
-          ntf_libnotify_update_modal ();
+          if (ntf)
+            {
+              ntf_tray_add_notification (tray, ntf);
+              ntf_libnotify_update_modal ();
+            }
         }
+      else
+        ntf_libnotify_queue (notification, srcid, pid);
 
       g_free (srcid);
     }
@@ -183,14 +416,42 @@ ntf_libnotify_notification_closed_cb (DawatiNetbookNotifyStore *store,
   NtfNotification *ntf;
 
   /*
-   * Look first in the regular tray for this id, then the urgent one.
+   * A member of a collapsed notification only changes the count, unless
+   * it was the last one.
    */
-  tray = ntf_overlay_get_tray (FALSE);
+  if ((ntf = g_hash_table_lookup (collapsed_ids, GUINT_TO_POINTER (id))))
+    {
+      GArray *ids = g_object_get_data (G_OBJECT (ntf), "ntf-libnotify-ids");
+      guint   i;
+
+      g_hash_table_remove (collapsed_ids, GUINT_TO_POINTER (id));
 
-  if (!(ntf = ntf_tray_find_notification (tray, subsystem_id, id)))
+      for (i = 0; i < ids->len; i++)
+        if (g_array_index (ids, guint, i) == id)
+          {
+            g_array_remove_index (ids, i);
+            break;
+          }
+
+      if (ids->len > 0)
+        {
+          if (!ntf_notification_is_closed (ntf))
+            ntf_libnotify_collapse (ntf, ids);
+          return;
+        }
+    }
+  else
     {
-      tray = ntf_overlay_get_tray (TRUE);
-      ntf  = ntf_tray_find_notification (tray, subsystem_id, id);
+      /*
+       * Look first in the regular tray for this id, then the urgent one.
+       */
+      tray = ntf_overlay_get_tray (FALSE);
+
+      if (!(ntf = ntf_tray_find_notification (tray, subsystem_id, id)))
+        {
+          tray = ntf_overlay_get_tray (TRUE);
+          ntf  = ntf_tray_find_notification (tray, subsystem_id, id);
+        }
     }
 
   if (ntf && !ntf_notification_is_closed (ntf))
@@ -212,6 +473,10 @@ ntf_libnotify_init (void)
   n_notifiers = 0;
   overlay_focused = FALSE;
 
+  pending_by_key = g_hash_table_new (g_str_hash, g_str_equal);
+  pending_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  collapsed_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   store = dawati_netbook_notify_store_new ();
 
   subsystem_id = ntf_notification_get_subsystem_id ();
@@ -0,0 +1,257 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (c) 2012 Intel Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/*
+ * Stress test for the notification pipeline: floods the running shell with
+ * notifications and measures how responsive its main loop stays.
+ *
+ * The notifications go out in batches of N_PER_BATCH every frame. In the
+ * meantime GetServerInformation is sent every frame on a connection of its
+ * own, so it does not queue behind our own Notify calls; its round trip is
+ * dispatched by the same main loop that paints, so a slow reply means a
+ * stalled frame. The distribution of round trips is reported, a single slow
+ * sample is not a failure.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dbus/dbus-glib.h>
+
+#define N_NOTIFICATIONS  1000
+#define N_PER_BATCH        25
+#define N_SUMMARIES        10
+#define FRAME_MS           16
+#define STALL_MS           50
+
+static DBusGProxy *proxy = NULL;
+static DBusGProxy *ping_proxy = NULL;
+static GMainLoop  *loop = NULL;
+static GArray     *ids = NULL;
+static guint       n_sent = 0;
+static guint       n_replies = 0;
+static guint       ping_id = 0;
+
+static GArray     *samples = NULL;   /* round trips in ms */
+
+static void
+notify_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer data)
+{
+  GError *error = NULL;
+  guint   id;
+
+  if (dbus_g_proxy_end_call (proxy, call, &error,
+                             G_TYPE_UINT, &id,
+                             G_TYPE_INVALID))
+    g_array_append_val (ids, id);
+  else
+    {
+      g_warning ("Notify failed: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  if (++n_replies == N_NOTIFICATIONS)
+    {
+      /* Give the shell time to drain its queue while still measuring. */
+      g_timeout_add_seconds (2, (GSourceFunc) g_main_loop_quit, loop);
+    }
+}
+
+static void
+ping_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer data)
+{
+  GTimer  *timer = data;
+  gchar   *name = NULL, *vendor = NULL, *version = NULL, *spec = NULL;
+  gdouble  ms = g_timer_elapsed (timer, NULL) * 1000.0;
+
+  if (dbus_g_proxy_end_call (proxy, call, NULL,
+                             G_TYPE_STRING, &name,
+                             G_TYPE_STRING, &vendor,
+                             G_TYPE_STRING, &version,
+                             G_TYPE_STRING, &spec,
+                             G_TYPE_INVALID))
+    g_array_append_val (samples, ms);
+
+  g_free (name);
+  g_free (vendor);
+  g_free (version);
+  g_free (spec);
+}
+
+static gboolean
+ping_timeout_cb (gpointer data)
+{
+  dbus_g_proxy_begin_call (ping_proxy, "GetServerInformation",
+                           ping_cb, g_timer_new (),
+                           (GDestroyNotify) g_timer_destroy,
+                           G_TYPE_INVALID);
+  return TRUE;
+}
+
+static gboolean
+send_timeout_cb (gpointer data)
+{
+  GHashTable  *hints;
+  const gchar *actions[] = { NULL };
+  guint        i;
+
+  hints = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = n_sent; i < MIN (n_sent + N_PER_BATCH, N_NOTIFICATIONS); i++)
+    {
+      gchar *summary = g_strdup_printf ("Flood %u", i % N_SUMMARIES);
+      gchar *body = g_strdup_printf ("Message number %u", i);
+
+      dbus_g_proxy_begin_call (proxy, "Notify", notify_cb, NULL, NULL,
+                               G_TYPE_STRING, "test-notification-flood",
+                               G_TYPE_UINT, 0,
+                               G_TYPE_STRING, "",
+                               G_TYPE_STRING, summary,
+                               G_TYPE_STRING, body,
+                               G_TYPE_STRV, actions,
+                               dbus_g_type_get_map ("GHashTable",
+                                                    G_TYPE_STRING,
+                                                    G_TYPE_VALUE), hints,
+                               G_TYPE_INT, -1,
+                               G_TYPE_INVALID);
+      g_free (summary);
+      g_free (body);
+    }
+
+  g_hash_table_destroy (hints);
+
+  n_sent = i;
+  return n_sent < N_NOTIFICATIONS;
+}
+
+static gint
+compare_samples (gconstpointer a, gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a;
+  gdouble db = *(const gdouble *) b;
+
+  return da < db ? -1 : da > db;
+}
+
+static gdouble
+get_percentile (guint percent)
+{
+  if (!samples->len)
+    return 0.0;
+
+  return g_array_index (samples, gdouble,
+                        MIN (samples->len * percent / 100, samples->len - 1));
+}
+
+static void
+close_notifications (void)
+{
+  guint i;
+
+  for (i = 0; i < ids->len; i++)
+    dbus_g_proxy_call_no_reply (proxy, "CloseNotification",
+                                G_TYPE_UINT, g_array_index (ids, guint, i),
+                                G_TYPE_INVALID);
+}
+
+int
+main (int argc, char *argv[])
+{
+  DBusGConnection *conn;
+  DBusGConnection *ping_conn;
+  GTimer          *timer;
+  GError          *error = NULL;
+  gdouble          total_ms = 0.0;
+  guint            n_stalls = 0;
+  guint            i;
+  int              ret;
+
+  g_type_init ();
+
+  if (!(conn = dbus_g_bus_get (DBUS_BUS_SESSION, &error)) ||
+      !(ping_conn = dbus_g_bus_get_private (DBUS_BUS_SESSION, NULL, &error)))
+    {
+      g_warning ("Could not connect to the session bus: %s", error->message);
+      g_clear_error (&error);
+      return EXIT_FAILURE;
+    }
+
+  proxy = dbus_g_proxy_new_for_name (conn,
+                                     "org.freedesktop.Notifications",
+                                     "/org/freedesktop/Notifications",
+                                     "org.freedesktop.Notifications");
+  ping_proxy = dbus_g_proxy_new_for_name (ping_conn,
+                                          "org.freedesktop.Notifications",
+                                          "/org/freedesktop/Notifications",
+                                          "org.freedesktop.Notifications");
+
+  /* Allow for part of the flood being queued ahead of us. */
+  dbus_g_proxy_set_default_timeout (proxy, 60 * 1000);
+  dbus_g_proxy_set_default_timeout (ping_proxy, 60 * 1000);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  ids = g_array_new (FALSE, FALSE, sizeof (guint));
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  timer = g_timer_new ();
+
+  ping_id = g_timeout_add (FRAME_MS, ping_timeout_cb, NULL);
+  g_timeout_add (FRAME_MS, send_timeout_cb, NULL);
+
+  g_main_loop_run (loop);
+
+  g_source_remove (ping_id);
+
+  g_array_sort (samples, compare_samples);
+  for (i = 0; i < samples->len; i++)
+    {
+      gdouble ms = g_array_index (samples, gdouble, i);
+
+      total_ms += ms;
+      if (ms > STALL_MS)
+        n_stalls++;
+    }
+
+  printf ("%u notifications in %.2f s\n"
+          "%u frames sampled, avg %.2f ms, median %.2f ms, "
+          "95%% %.2f ms, max %.2f ms, %u over %u ms\n",
+          ids->len, g_timer_elapsed (timer, NULL),
+          samples->len,
+          samples->len ? total_ms / samples->len : 0.0,
+          get_percentile (50), get_percentile (95),
+          get_percentile (100),
+          n_stalls, STALL_MS);
+
+  close_notifications ();
+  dbus_connection_flush (dbus_g_connection_get_connection (conn));
+
+  g_timer_destroy (timer);
+  ret = ids->len == N_NOTIFICATIONS ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  g_array_free (ids, TRUE);
+  g_array_free (samples, TRUE);
+  g_object_unref (ping_proxy);
+  g_object_unref (proxy);
+  dbus_connection_close (dbus_g_connection_get_connection (ping_conn));
+  dbus_g_connection_unref (ping_conn);
+  g_main_loop_unref (loop);
+
+  return ret;
+}